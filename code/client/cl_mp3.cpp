@@ -12,13 +12,51 @@
 #include "../mp3code/mp3struct.h"	// keep this rather awful file secret from the rest of the program
 //#include "../mp3code/copyright.h"
 
+
+// the decoder keeps its state in globals, and the software mixer decodes channels on its own
+//	thread, so while that thread is running every C_MP3 call is made with this held...
+//
+static void *gpMP3DecoderLock = NULL;
+
+void MP3_EnableDecoderLock( qboolean bEnable )
+{
+	if (bEnable && !gpMP3DecoderLock)
+	{
+		gpMP3DecoderLock = Sys_CreateSemaphore( 1 );
+	}
+	else
+	if (!bEnable && gpMP3DecoderLock)
+	{
+		Sys_DestroySemaphore( gpMP3DecoderLock );
+		gpMP3DecoderLock = NULL;
+	}
+}
+
+void MP3_LockDecoder( void )
+{
+	if (gpMP3DecoderLock)
+	{
+		Sys_SemaphoreWait( gpMP3DecoderLock );
+	}
+}
+
+void MP3_UnlockDecoder( void )
+{
+	if (gpMP3DecoderLock)
+	{
+		Sys_SemaphorePost( gpMP3DecoderLock );
+	}
+}
+
 // expects data already loaded, filename arg is for error printing only
 //
 // returns success/fail
 //
 qboolean MP3_IsValid( const char *psLocalFilename, void *pvData, int iDataLen, qboolean bStereoDesired /* = qfalse */)
 {
+	MP3_LockDecoder();
 	char *psError = C_MP3_IsValid(pvData, iDataLen, bStereoDesired);
+	MP3_UnlockDecoder();
 
 	if (psError)
 	{
@@ -44,7 +82,9 @@ int MP3_GetUnpackedSize( const char *psLocalFilename, void *pvData, int iDataLen
 	//
 	if (1)//qbIgnoreID3Tag || !MP3_ReadSpecialTagInfo((byte *)pvData, iDataLen, NULL, &iUnpackedSize))
 	{	
+		MP3_LockDecoder();
 		char *psError = C_MP3_GetUnpackedSize( pvData, iDataLen, &iUnpackedSize, bStereoDesired);
+		MP3_UnlockDecoder();
 
 		if (psError)
 		{
@@ -65,7 +105,9 @@ int MP3_GetUnpackedSize( const char *psLocalFilename, void *pvData, int iDataLen
 int MP3_UnpackRawPCM( const char *psLocalFilename, void *pvData, int iDataLen, byte *pbUnpackBuffer, qboolean bStereoDesired /* = qfalse */)
 {
 	int iUnpackedSize;
+	MP3_LockDecoder();
 	char *psError = C_MP3_UnpackRawPCM( pvData, iDataLen, &iUnpackedSize, pbUnpackBuffer, bStereoDesired);
+	MP3_UnlockDecoder();
 
 	if (psError)
 	{
@@ -85,7 +127,9 @@ qboolean MP3Stream_InitPlayingTimeFields( LP_MP3STREAM lpMP3Stream, const char *
 
 	int iRate, iWidth, iChannels;
 
+	MP3_LockDecoder();
 	char *psError = C_MP3_GetHeaderData(pvData, iDataLen, &iRate, &iWidth, &iChannels, bStereoDesired );
+	MP3_UnlockDecoder();
 	if (psError)
 	{
 		Com_Printf(va(S_COLOR_RED"MP3Stream_InitPlayingTimeFields(): %s\n(File: %s)\n",psError, psLocalFilename));
@@ -141,7 +185,9 @@ qboolean MP3_FakeUpWAVInfo( const char *psLocalFilename, void *pvData, int iData
 
 	// some things need to be read...  (though the whole stereo flag thing is crap)
 	//
+	MP3_LockDecoder();
 	char *psError = C_MP3_GetHeaderData(pvData, iDataLen, &rate, &width, &channels, bStereoDesired );
+	MP3_UnlockDecoder();
 	if (psError)
 	{
 		Com_Printf(va(S_COLOR_RED"%s\n(File: %s)\n",psError, psLocalFilename));
@@ -273,11 +319,13 @@ qboolean MP3Stream_InitFromFile( sfx_t* sfx, byte *pbSrcData, int iSrcDatalen, c
 		// now init the low-level MP3 stuff...
 		//
 		MP3STREAM SFX_MP3Stream = {0};	// important to init to all zeroes!
+		MP3_LockDecoder();
 		char *psError = C_MP3Stream_DecodeInit( &SFX_MP3Stream, /*sfx->data*/ /*sfx->soundData*/ pbSrcData, iSrcDatalen,
 												dma.speed,//(s_khz->value == 44)?44100:(s_khz->value == 22)?22050:11025,
 												2/*sfx->width*/ * 8,
 												bStereoDesired
 												);
+		MP3_UnlockDecoder();
 		SFX_MP3Stream.pbSourceData = (byte *) sfx->pSoundData;
 		if (psError)
 		{
@@ -396,7 +444,11 @@ int MP3Stream_Decode( LP_MP3STREAM lpMP3Stream, qboolean bDoingMusic )
 	{
 		// SOF2 music, or EF1 anything...
 		//
-		return C_MP3Stream_Decode( lpMP3Stream, qfalse );	// bFastForwarding
+		MP3_LockDecoder();
+		const int iBytesDecoded = C_MP3Stream_Decode( lpMP3Stream, qfalse );	// bFastForwarding
+		MP3_UnlockDecoder();
+
+		return iBytesDecoded;
 	}
 }
 
@@ -427,7 +479,9 @@ qboolean MP3Stream_SeekTo( channel_t *ch, float fTimeToSeekTo )
 
 		// when decoding, use fast-forward until within 3 seconds, then slow-decode (which should init stuff properly?)...
 		//
+		MP3_LockDecoder();
 		int iBytesDecodedThisPacket = C_MP3Stream_Decode( &ch->MP3StreamHeader, (fAbsTimeDiff > 3.0f) );	// bFastForwarding
+		MP3_UnlockDecoder();
 		if (iBytesDecodedThisPacket == 0)
 			break;	// EOS		
 	}
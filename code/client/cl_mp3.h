@@ -34,6 +34,9 @@ extern const char sKEY_UNCOMP[];
 // (filenames are used purely for error reporting, all files should already be loaded before you get here)
 //
 void		MP3_InitCvars			( void );
+void		MP3_EnableDecoderLock	( qboolean bEnable );
+void		MP3_LockDecoder			( void );
+void		MP3_UnlockDecoder		( void );
 qboolean	MP3_IsValid				( const char *psLocalFilename, void *pvData, int iDataLen, qboolean bStereoDesired = qfalse );
 int			MP3_GetUnpackedSize		( const char *psLocalFilename, void *pvData, int iDataLen, qboolean qbIgnoreID3Tag = qfalse, qboolean bStereoDesired = qfalse );
 qboolean	MP3_UnpackRawPCM		( const char *psLocalFilename, void *pvData, int iDataLen, byte *pbUnpackBuffer, qboolean bStereoDesired = qfalse );
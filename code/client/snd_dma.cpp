@@ -158,6 +158,12 @@ cvar_t		*s_allowDynamicMusic;
 cvar_t		*s_show;
 cvar_t		*s_mixahead;
 cvar_t		*s_mixPreStep;
+cvar_t		*s_mixSIMD;
+cvar_t		*s_mixThread;
+cvar_t		*s_keepMP3s;
+cvar_t		*s_mp3HotPlays;
+cvar_t		*s_mp3HotKB;
+cvar_t		*s_mp3UnpackKB;
 cvar_t		*s_musicVolume;
 cvar_t		*s_separation;
 cvar_t		*s_lip_threshold_1;
@@ -330,19 +336,6 @@ const GUID EAX_REVERB_EFFECT = { 0xcf95c8f, 0xa3cc, 0x4849, { 0xb0, 0xb6, 0x83,
 *
 \**************************************************************************************************/
 
-// instead of clearing a whole channel_t struct, we're going to skip the MP3SlidingDecodeBuffer[] buffer in the middle...
-//
-static inline void Channel_Clear(channel_t *ch)
-{
-	// memset (ch, 0, sizeof(*ch));
-
-	memset(ch,0,offsetof(channel_t,MP3SlidingDecodeBuffer));
-
-	byte *const p = (byte *)ch + offsetof(channel_t,MP3SlidingDecodeBuffer) + sizeof(ch->MP3SlidingDecodeBuffer);
-
-	memset(p,0,(sizeof(*ch) - offsetof(channel_t,MP3SlidingDecodeBuffer)) - sizeof(ch->MP3SlidingDecodeBuffer));
-}
-
 // ====================================================================
 // User-setable variables
 // ====================================================================
@@ -455,6 +448,12 @@ void S_Init( void ) {
 	s_mixPreStep = Cvar_Get ("s_mixPreStep", "0.05", CVAR_ARCHIVE);
 	s_show = Cvar_Get ("s_show", "0", CVAR_CHEAT);
 	s_testsound = Cvar_Get ("s_testsound", "0", CVAR_CHEAT);
+	s_mixSIMD = Cvar_Get ("s_mixSIMD", "1", CVAR_ARCHIVE);
+	s_mixThread = Cvar_Get ("s_mixThread", "1", CVAR_ARCHIVE|CVAR_LATCH);
+	s_keepMP3s = Cvar_Get ("s_keepMP3s", "0", CVAR_ARCHIVE|CVAR_LATCH);
+	s_mp3HotPlays = Cvar_Get ("s_mp3HotPlays", "3", CVAR_ARCHIVE);
+	s_mp3HotKB = Cvar_Get ("s_mp3HotKB", "4096", CVAR_ARCHIVE);
+	s_mp3UnpackKB = Cvar_Get ("s_mp3UnpackKB", "256", CVAR_ARCHIVE);
 	s_debugdynamic = Cvar_Get("s_debugdynamic","0", 0);
 	s_lip_threshold_1 = Cvar_Get("s_threshold1" , "0.3",0);
 	s_lip_threshold_2 = Cvar_Get("s_threshold2" , "4",0);
@@ -467,12 +466,9 @@ void S_Init( void ) {
 
 	s_CPUType = Cvar_Get("sys_cpuid","",0);
 
-#if !((defined __linux__ || defined __APPLE__) && defined __i386__)
-#if	!id386
-#else
+#ifdef SND_MMX_ASM
 	extern unsigned int uiMMXAvailable;
 	uiMMXAvailable = !!(s_CPUType->integer >= CPUID_INTEL_MMX);
-#endif
 #endif
 
 	cv = Cvar_Get ("s_initsound", "1", CVAR_ROM);
@@ -490,6 +486,7 @@ void S_Init( void ) {
 	Cmd_AddCommand("soundstop", S_StopAllSounds);
 	Cmd_AddCommand("mp3_calcvols", S_MP3_CalcVols_f);
 	Cmd_AddCommand("s_dynamic", S_SetDynamicMusic_f);
+	Cmd_AddCommand("s_mixbench", S_MixBench_f);
 
 	cv = Cvar_Get("s_UseOpenAL" , "0",CVAR_ARCHIVE|CVAR_LATCH);
 	s_UseOpenAL = !!(cv->integer);
@@ -649,6 +646,8 @@ void S_Init( void ) {
 			s_soundtime = 0;
 			s_paintedtime = 0;
 
+			S_MixerInit();
+
 			S_StopAllSounds ();
 
 			//S_SoundInfo_f();
@@ -696,6 +695,9 @@ void S_Shutdown( void )
 		return;
 	}
 
+	// the mixer thread has to be gone before the sfx data and the dma buffer are
+	S_MixerShutdown();
+
 	S_FreeAllSFXMem();
 	S_UnCacheDynamicMusic();
 
@@ -753,6 +755,7 @@ void S_Shutdown( void )
 	Cmd_RemoveCommand("soundstop");
 	Cmd_RemoveCommand("mp3_calcvols");
 	Cmd_RemoveCommand("s_dynamic");
+	Cmd_RemoveCommand("s_mixbench");
 	AS_Free();
 }
 
@@ -1529,6 +1532,7 @@ void S_StartAmbientSound( const vec3_t origin, int entityNum, unsigned char volu
 
 	if (sfx->pMP3StreamHeader)
 	{
+		S_MP3_CountPlay( sfx );
 		memcpy(&ch->MP3StreamHeader,sfx->pMP3StreamHeader,	sizeof(ch->MP3StreamHeader));
 		//ch->iMP3SlidingDecodeWritePos = 0; // These will be zero from the memset in S_PickChannel(), but keep them here for reference...
 		//ch->iMP3SlidingDecodeWindowPos= 0; //
@@ -1537,6 +1541,8 @@ void S_StartAmbientSound( const vec3_t origin, int entityNum, unsigned char volu
 	{
 		memset(&ch->MP3StreamHeader,0,						sizeof(ch->MP3StreamHeader));
 	}
+
+	S_MixerStartChannel(ch);
 }
 
 /*
@@ -1656,6 +1662,7 @@ void S_StartSound(const vec3_t origin, int entityNum, soundChannel_t entchannel,
 
 	if (sfx->pMP3StreamHeader)
 	{
+		S_MP3_CountPlay( sfx );
 		memcpy(&ch->MP3StreamHeader,sfx->pMP3StreamHeader,	sizeof(ch->MP3StreamHeader));
 		//ch->iMP3SlidingDecodeWritePos = 0; // These will be zero from the memset in S_PickChannel(), but keep them here for reference...
 		//ch->iMP3SlidingDecodeWindowPos= 0; //
@@ -1664,6 +1671,8 @@ void S_StartSound(const vec3_t origin, int entityNum, soundChannel_t entchannel,
 	{
 		memset(&ch->MP3StreamHeader,0,						sizeof(ch->MP3StreamHeader));
 	}
+
+	S_MixerStartChannel(ch);
 }
 
 /*
@@ -1756,6 +1765,8 @@ void S_ClearSoundBuffer( void ) {
 		else
 			clear = 0;
 
+		S_MixerSync();
+
 		SNDDMA_BeginPainting ();
 		if (dma.buffer)
 			memset(dma.buffer, clear, dma.samples * dma.samplebits/8);
@@ -1792,6 +1803,7 @@ void S_CIN_StopSound(sfxHandle_t sfxHandle)
 			{
 				alSourceStop(s_channels[i].alSource);
 			}
+			S_MixerStopChannel(ch);
 			SND_FreeSFXMem(ch->thesfx);	// heh, may as well...
 			ch->thesfx = NULL;
 			memset(&ch->MP3StreamHeader, 0, sizeof(MP3STREAM));
@@ -1841,6 +1853,7 @@ void S_StopSounds(void)
 	else
 	{
 		memset(s_channels, 0, sizeof(s_channels));
+		S_MixerStopAll();
 	}
 
 	// clear out the lip synching override array
@@ -1927,7 +1940,12 @@ void S_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocit
 	if ( !sfx->iSoundLengthInSamples ) {
 		Com_Error( ERR_DROP, "%s has length 0", sfx->sSoundName );
 	}
-	assert(!sfx->pMP3StreamHeader);
+	if (sfx->pMP3StreamHeader)
+	{
+		// can't loop a stream, it'll be heard once S_MP3_UpdateUnpacks() has turned it into samples
+		S_MP3_RequestUnpack( sfx );
+		return;
+	}
 	VectorCopy( origin, loopSounds[numLoopSounds].origin );
 //	VectorCopy( velocity, loopSounds[numLoopSounds].velocity );
 	loopSounds[numLoopSounds].sfx = sfx;
@@ -1974,8 +1992,12 @@ void S_AddAmbientLoopingSound( const vec3_t origin, unsigned char volume, sfxHan
 		Com_Error( ERR_DROP, "%s has length 0", sfx->sSoundName );
 	}
 	VectorCopy( origin, loopSounds[numLoopSounds].origin );
+	if (sfx->pMP3StreamHeader)
+	{
+		S_MP3_RequestUnpack( sfx );
+		return;
+	}
 	loopSounds[numLoopSounds].sfx = sfx;
-	assert(!sfx->pMP3StreamHeader);
 	
 	//TODO: Calculate the distance falloff
 	loopSounds[numLoopSounds].volume = volume;
@@ -2051,6 +2073,8 @@ void S_AddLoopSounds (void)
 		{
 			memset(&ch->MP3StreamHeader,0,						sizeof(ch->MP3StreamHeader));
 		}
+
+		S_MixerStartChannel(ch);
 	}
 }
 
@@ -2576,9 +2600,13 @@ void S_Respatialize( int entityNum, const vec3_t head, vec3_t axis[3], qboolean
 			}
 			if ( ch->loopSound ) {	// loopSounds are regenerated fresh each frame
 				Channel_Clear(ch);	// memset (ch, 0, sizeof(*ch));
+				S_MixerStopChannel(ch);
 				continue;
 			}
 
+			const int iOldLeftVol	= ch->leftvol;
+			const int iOldRightVol	= ch->rightvol;
+
 			// anything coming from the view entity will always be full volume
 			if (ch->entnum == listener_number || ch->entchannel == CHAN_VOICE_GLOBAL || ch->entchannel == CHAN_ANNOUNCER) {
 				ch->leftvol = ch->master_vol;
@@ -2598,8 +2626,13 @@ void S_Respatialize( int entityNum, const vec3_t head, vec3_t axis[3], qboolean
 			//		so that tasks waiting for sound completion keep proper timing
 			if ( !( ch->entchannel == CHAN_VOICE || ch->entchannel == CHAN_VOICE_ATTEN || ch->entchannel == CHAN_VOICE_GLOBAL ) && !ch->leftvol && !ch->rightvol ) {
 				Channel_Clear(ch);	// memset (ch, 0, sizeof(*ch));
+				S_MixerStopChannel(ch);
 				continue;
 			}
+
+			if ( ch->leftvol != iOldLeftVol || ch->rightvol != iOldRightVol ) {
+				S_MixerSpatializeChannel(ch);
+			}
 		}
 
 		// add loopsounds
@@ -2617,13 +2650,13 @@ S_ScanChannelStarts
 Returns qtrue if any new sounds were started since the last mix
 ========================
 */
-qboolean S_ScanChannelStarts( void ) {
+qboolean S_ScanChannelStarts( channel_t *channels ) {
 	channel_t		*ch;
 	int				i;
 	qboolean		newSamples;
 
 	newSamples = qfalse;
-	ch = s_channels;
+	ch = channels;
 	for (i=0; i<MAX_CHANNELS ; i++, ch++) {
 		if ( !ch->thesfx ) {
 			continue;
@@ -2654,18 +2687,18 @@ qboolean S_ScanChannelStarts( void ) {
 // this is now called AFTER the DMA painting, since it's only the painter calls that cause the MP3s to be unpacked,
 //	and therefore to have data readable by the lip-sync volume calc code.
 //
-void S_DoLipSynchs( const int s_oldpaintedtime )
+// runs on the mixer, so the amplitudes go in the channels and S_MixerCollect() puts them in s_entityWavVol[]...
+//
+void S_DoLipSynchs( channel_t *channels, const int s_oldpaintedtime )
 {
 	channel_t		*ch;
 	int				i;
 	qboolean		newSamples;
 
-	// clear out the lip synching override array for this frame
-	memset(s_entityWavVol, 0,(MAX_GENTITIES * 4));
-
 	newSamples = qfalse;
-	ch = s_channels;
+	ch = channels;
 	for (i=0; i<MAX_CHANNELS ; i++, ch++) {
+		ch->iLipSyncVolume = 0;
 		if ( !ch->thesfx ) {
 			continue;
 		}
@@ -2678,10 +2711,7 @@ void S_DoLipSynchs( const int s_oldpaintedtime )
 		if ( ch->entchannel == CHAN_VOICE || ch->entchannel == CHAN_VOICE_ATTEN || ch->entchannel == CHAN_VOICE_GLOBAL )
 		{
 			// go away and work out amplitude for this sound we are playing right now.
-			s_entityWavVol[ ch->entnum ] = S_CheckAmplitude( ch, s_oldpaintedtime );
-			if ( s_show->integer == 3 ) {
-				Com_Printf( "(%i)%i %s vol = %i\n", ch->entnum, i, ch->thesfx->sSoundName, s_entityWavVol[ ch->entnum ] );
-			}
+			ch->iLipSyncVolume = S_CheckAmplitude( ch, s_oldpaintedtime );
 		}
 	}
 
@@ -2731,10 +2761,16 @@ void S_Update( void ) {
 	// The Open AL code, handles background music in the S_UpdateRawSamples function
 	if (!s_UseOpenAL)
 	{
+		// the last mix reads s_rawsamples[] and s_paintedtime, so let it finish first
+		S_MixerWait();
+
 		// add raw data from streamed samples
 		S_UpdateBackgroundTrack();
 	}
 
+	// turn a looped or much-played kept MP3 back into samples, if there's budget for it this frame
+	S_MP3_UpdateUnpacks();
+
 	// mix some sound
 	S_Update_();
 }
@@ -2759,7 +2795,7 @@ void S_GetSoundtime(void)
 		{	// time to chop things off to avoid 32 bit limits
 			buffers = 0;
 			s_paintedtime = fullsamples;
-			S_StopAllSounds ();
+			s_mixWrapped = qtrue;	// runs on the mixer, S_MixerCollect() will S_StopAllSounds()
 		}
 	}
 	oldsamplepos = samplepos;
@@ -2784,8 +2820,6 @@ void S_GetSoundtime(void)
 
 
 void S_Update_(void) {
-	unsigned        endtime;
-	int				samps;
 	channel_t		*ch;
 	int i,j;
 	int			source;
@@ -2949,6 +2983,14 @@ void S_Update_(void) {
 
 			if (ch->thesfx->pMP3StreamHeader)
 			{
+				// kept MP3s only get somewhere to put lipsync data (4 values per streaming AL buffer) once they're spoken
+				if (!ch->thesfx->lipSyncData &&
+					(ch->entchannel == CHAN_VOICE || ch->entchannel == CHAN_VOICE_ATTEN || ch->entchannel == CHAN_VOICE_GLOBAL) &&
+					strstr(ch->thesfx->sSoundName, "chars"))
+				{
+					ch->thesfx->lipSyncData = (char *)Z_Malloc(16, TAG_SND_RAWDATA, false);
+				}
+
 				memcpy(&ch->MP3StreamHeader, ch->thesfx->pMP3StreamHeader,	sizeof(ch->MP3StreamHeader));
 				ch->iMP3SlidingDecodeWritePos = 0;
 				ch->iMP3SlidingDecodeWindowPos= 0;
@@ -3082,35 +3124,7 @@ void S_Update_(void) {
 	}
 	else
 	{
-		// Updates s_soundtime
-		S_GetSoundtime();
-
-		const int s_oldpaintedtime = s_paintedtime;
-
-		// clear any sound effects that end before the current time,
-		// and start any new sounds
-		S_ScanChannelStarts();
-
-		// mix ahead of current position
-		endtime = (int)(s_soundtime + s_mixahead->value * dma.speed);
-
-		// mix to an even submission block size
-		endtime = (endtime + dma.submission_chunk-1)
-			& ~(dma.submission_chunk-1);
-
-		// never mix more than the complete buffer
-		samps = dma.samples >> (dma.channels-1);
-		if (endtime - s_soundtime > samps)
-			endtime = s_soundtime + samps;
-
-
-		SNDDMA_BeginPainting ();
-
-		S_PaintChannels (endtime);
-
-		SNDDMA_Submit ();
-
-		S_DoLipSynchs( s_oldpaintedtime );
+		S_MixerUpdate();
 	}
 }
 
@@ -4186,11 +4200,13 @@ static qboolean S_StartBackgroundTrack_Actual( MusicInfo_t *pMusicInfo, qboolean
 			// init stream struct...
 			//
 			memset(&pMusicInfo->streamMP3_Bgrnd,0,sizeof(pMusicInfo->streamMP3_Bgrnd));
+			MP3_LockDecoder();
 			char *psError = C_MP3Stream_DecodeInit( &pMusicInfo->streamMP3_Bgrnd, pbMP3DataSegment, pMusicInfo->iLoadedDataLen,
 													dma.speed,
 													16,		// sfx->width * 8,
 													qtrue	// bStereoDesired
 													);
+			MP3_UnlockDecoder();
 
 
 			if (psError == NULL)
@@ -5126,6 +5142,11 @@ static int SND_FreeSFXMem(sfx_t *sfx)
 {
 	int iBytesFreed = 0;
 
+	// the mixer may still be painting from this
+	S_MixerSync();
+
+	S_MP3_ForgetSFX( sfx );
+
 	if (s_UseOpenAL)
 	{
 		alGetError();
@@ -5270,6 +5291,48 @@ int SND_FreeOldestSound(void)
 	return SND_FreeOldestSound(NULL);	// I had to add a void-arg version of this because of link issues, sigh
 }
 
+// same again, but only considers kept MP3s that S_MP3_UpdateUnpacks() turned into samples, so they go back to
+//	being MP3s when they're next played...
+//
+int SND_FreeOldestUnpackedSound(sfx_t *pButNotThisOne)
+{
+	sfx_t *sfx;
+
+	int	iOldest = Com_Milliseconds();
+	int	iUsed	= 0;
+
+	for (int i=1 ; i < s_numSfx ; i++) 
+	{
+		sfx = &s_knownSfx[i];
+
+		if (sfx != pButNotThisOne && sfx->bMP3Unpacked && sfx->bInMemory && sfx->iLastTimeUsed < iOldest) 
+		{
+			int iChannel;
+			for (iChannel=0; iChannel<MAX_CHANNELS; iChannel++)
+			{
+				if (s_channels[iChannel].thesfx == sfx)
+					break;	// being used
+			}
+			if (iChannel == MAX_CHANNELS)
+			{
+				iUsed = i;
+				iOldest = sfx->iLastTimeUsed;
+			}
+		}
+	}
+
+	if (iUsed)
+	{
+		sfx = &s_knownSfx[ iUsed ];
+
+		Com_DPrintf("SND_FreeOldestUnpackedSound: freeing sound %s\n", sfx->sSoundName);
+
+		return SND_FreeSFXMem(sfx);
+	}
+
+	return 0;
+}
+
 
 // just before we drop into a level, ensure the audio pool is under whatever the maximum
 //	pool size is (but not by dropping out sounds used by the current level)...
@@ -27,6 +27,15 @@ extern void AS_Free( void );
 
 #define	PAINTBUFFER_SIZE	1024
 
+// SND_SSE2_MIX when the compiler targets SSE2 (the intrinsics mixer in snd_mix.cpp), else
+//	SND_MMX_ASM for the old inline asm clamp where the compiler takes MSVC asm...
+//
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SND_SSE2_MIX
+#elif id386 && !((defined __linux__ || defined __APPLE__) && defined __i386__)
+#define SND_MMX_ASM
+#endif
+
 
 // !!! if this is changed, the asm code must change !!!
 typedef struct {
@@ -58,6 +67,8 @@ typedef struct sfx_s {
 	char 			sSoundName[MAX_QPATH];
 	int				iLastTimeUsed;
 	float			fVolRange;				// used to set the highest volume this sample has at load time - used for lipsynching
+	int				iMP3Plays;				// times started while kept as an MP3, see S_MP3_CountPlay()
+	bool			bMP3Unpacked;			// was kept as an MP3 until S_MP3_UpdateUnpacks() turned it into samples
 
 	// Open AL
 	ALuint		Buffer;
@@ -111,6 +122,8 @@ typedef struct
 	qboolean	fixed_origin;	// use origin instead of fetching entnum's origin
 	sfx_t		*thesfx;		// sfx structure
 	qboolean	loopSound;		// from an S_AddLoopSound call, cleared each frame
+	int			iMixSequence;	// which S_MixerStartChannel() this is, so the main thread can tell the mixer's copy is the same sound
+	int			iLipSyncVolume;	// written by the mixer for voice channels, read back into s_entityWavVol[]
 	//
 	MP3STREAM	MP3StreamHeader;
 	byte		MP3SlidingDecodeBuffer[50000/*12000*/];	// typical back-request = -3072, so roughly double is 6000 (safety), then doubled again so the 6K pos is in the middle of the buffer)
@@ -195,13 +208,59 @@ extern cvar_t	*s_mixahead;
 
 extern cvar_t	*s_testsound;
 extern cvar_t	*s_separation;
+extern cvar_t	*s_mixSIMD;
+extern cvar_t	*s_mixThread;
+extern cvar_t	*s_keepMP3s;
+extern cvar_t	*s_mp3HotPlays;
+extern cvar_t	*s_mp3HotKB;
+extern cvar_t	*s_mp3UnpackKB;
 
 wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength);
 
 qboolean S_LoadSound( sfx_t *sfx );
 
+// kept MP3s that are looped or played a lot get turned back into samples, a little each frame...
+//
+void	S_MP3_RequestUnpack( sfx_t *sfx );
+void	S_MP3_CountPlay( sfx_t *sfx );
+void	S_MP3_ForgetSFX( sfx_t *sfx );
+void	S_MP3_UpdateUnpacks( void );
+
+
+void S_PaintChannels(channel_t *channels, int endtime, int rawend);
+void S_MixBench_f( void );
+
+// the mixer side of snd_dma.cpp, called from S_MixerRun() with the mixer's own channels
+void		S_GetSoundtime( void );
+qboolean	S_ScanChannelStarts( channel_t *channels );
+void		S_DoLipSynchs( channel_t *channels, const int s_oldpaintedtime );
+extern qboolean	s_mixWrapped;	// S_GetSoundtime() chopped the painted time, main thread must stop all sounds
+
+// software mixing runs on its own thread (s_mixThread), fed by commands from the main thread.
+//	s_channels[] stays the main thread's view, the mixer paints its own copies...
+//
+void S_MixerInit( void );
+void S_MixerShutdown( void );
+void S_MixerStartChannel( channel_t *ch );	// ch in s_channels[], after S_PickChannel() and the fields are set
+void S_MixerStopChannel( channel_t *ch );
+void S_MixerSpatializeChannel( channel_t *ch );
+void S_MixerStopAll( void );
+void S_MixerWait( void );	// returns once the last mix has finished
+void S_MixerSync( void );	// as above, then applies any queued commands, for anything that touches sfx data or the dma buffer
+void S_MixerUpdate( void );	// reads back the last mix then starts the next one, from S_Update_()
+
+// instead of clearing a whole channel_t struct, we're going to skip the MP3SlidingDecodeBuffer[] buffer in the middle...
+//
+static inline void Channel_Clear(channel_t *ch)
+{
+	// memset (ch, 0, sizeof(*ch));
+
+	memset(ch,0,offsetof(channel_t,MP3SlidingDecodeBuffer));
+
+	byte *const p = (byte *)ch + offsetof(channel_t,MP3SlidingDecodeBuffer) + sizeof(ch->MP3SlidingDecodeBuffer);
 
-void S_PaintChannels(int endtime);
+	memset(p,0,(sizeof(*ch) - offsetof(channel_t,MP3SlidingDecodeBuffer)) - sizeof(ch->MP3SlidingDecodeBuffer));
+}
 
 // picks a channel based on priorities, empty slots, number of channels
 channel_t *S_PickChannel(int entnum, int entchannel);
@@ -217,6 +276,7 @@ void S_Spatialize(channel_t *ch);
 byte	*SND_malloc(int iSize, sfx_t *sfx);
 void	 SND_setup();
 int		 SND_FreeOldestSound(sfx_t *pButNotThisOne = NULL);
+int		 SND_FreeOldestUnpackedSound(sfx_t *pButNotThisOne);
 void	 SND_TouchSFX(sfx_t *sfx);
 
 void S_DisplayFreeMemory(void);
@@ -704,6 +704,14 @@ static qboolean S_LoadSound_DirIsAllowedToKeepMP3s(const char *psFilename)
 //		"sound/chr_d/"	// no need for this now, or any other language, since we'll always compare against english
 	};
 
+	// s_keepMP3s lets anything stay compressed (if it's worth it, MP3Stream_InitFromFile() still decides that), the
+	//	looping problem above is taken care of by S_MP3_RequestUnpack() now...
+	//
+	if (s_keepMP3s->integer)
+	{
+		return qtrue;
+	}
+
 	int i;
 	for (i=0; i< (sizeof(psAllowedDirs) / sizeof(psAllowedDirs[0])); i++)
 	{
@@ -784,14 +792,8 @@ static qboolean S_LoadSound_Actual( sfx_t *sfx )
 			{
 //				Com_DPrintf("(Keeping file \"%s\" as MP3)\n",sLoadName);
 
-				if (s_UseOpenAL)
-				{
-					// Create space for lipsync data (4 lip sync values per streaming AL buffer)
-					if (strstr(sfx->sSoundName, "chars") )
-						sfx->lipSyncData = (char *)Z_Malloc(16, TAG_SND_RAWDATA, false);
-					else
-						sfx->lipSyncData = NULL;
-				}
+				// (Open AL lipsync data for these is now made the first time one's played on a voice channel)
+				sfx->lipSyncData = NULL;
 			}
 			else
 			{
@@ -1019,3 +1021,211 @@ void S_PreProcessLipSync(sfx_t *sfx)
 	sfx->lipSyncData[j] = sample;
 }
 
+
+
+/*
+===============================================================================
+
+COMPRESSED-RESIDENT SOUNDS
+
+A kept MP3 costs its compressed size and is decoded as it plays, into each
+channel's sliding buffer (software mixer) or streaming buffers (Open AL).
+Streams only play forwards though, so a looped sound has to be turned back
+into samples, and so does one that's played over and over, since it would
+otherwise be decoded again every time.  S_MP3_UpdateUnpacks() does that with
+MP3_UnpackRawPCM(), same as S_LoadSound_Actual() does for the MP3s it doesn't
+keep, but only s_mp3UnpackKB of samples a frame on average.
+
+Sounds unpacked like this are held to s_mp3HotKB, past that the least
+recently used one is freed, and comes back as an MP3 next time it's played.
+
+===============================================================================
+*/
+
+#define MAX_MP3_UNPACKS	32
+
+static sfx_t	*s_mp3Unpacks[MAX_MP3_UNPACKS];	// kept MP3s waiting to be unpacked, oldest request first
+static int		s_iMP3NumUnpacks;
+static int		s_iMP3UnpackCredit;	// bytes of samples we're allowed to make before the next unpack
+static int		s_iMP3UnpackedBytes;// in sounds that S_MP3_UpdateUnpacks() unpacked
+
+
+// loops call this every frame until it's done, so it doesn't matter if the list is full...
+//
+void S_MP3_RequestUnpack( sfx_t *sfx )
+{
+	if (!sfx->pMP3StreamHeader || s_iMP3NumUnpacks == MAX_MP3_UNPACKS)
+	{
+		return;
+	}
+
+	for (int i=0; i<s_iMP3NumUnpacks; i++)
+	{
+		if (s_mp3Unpacks[i] == sfx)
+			return;
+	}
+
+	s_mp3Unpacks[s_iMP3NumUnpacks++] = sfx;
+}
+
+
+// called when a kept MP3 is started on a channel...
+//
+void S_MP3_CountPlay( sfx_t *sfx )
+{
+	sfx->iMP3Plays++;
+
+	if (s_mp3HotPlays->integer > 0 && sfx->iMP3Plays >= s_mp3HotPlays->integer)
+	{
+		S_MP3_RequestUnpack( sfx );
+	}
+}
+
+
+// called when an sfx's memory is freed...
+//
+void S_MP3_ForgetSFX( sfx_t *sfx )
+{
+	for (int i=0; i<s_iMP3NumUnpacks; i++)
+	{
+		if (s_mp3Unpacks[i] == sfx)
+		{
+			memmove(&s_mp3Unpacks[i], &s_mp3Unpacks[i+1], (s_iMP3NumUnpacks - (i+1)) * sizeof(s_mp3Unpacks[0]));
+			s_iMP3NumUnpacks--;
+			break;
+		}
+	}
+
+	if (sfx->bMP3Unpacked)
+	{
+		s_iMP3UnpackedBytes -= sfx->iSoundLengthInSamples * 2;
+		sfx->bMP3Unpacked = false;
+	}
+	sfx->iMP3Plays = 0;
+}
+
+
+static qboolean S_MP3_InUse( const sfx_t *sfx )
+{
+	for (int i=0; i<MAX_CHANNELS; i++)
+	{
+		if (s_channels[i].thesfx == sfx)
+			return qtrue;
+	}
+
+	return qfalse;
+}
+
+
+// swaps a kept MP3's data for 16 bit samples...
+//
+static qboolean S_MP3_Unpack( sfx_t *sfx )
+{
+	wavinfo_t	info;
+	byte		*pbMP3Data	= (byte *) sfx->pSoundData;
+	const int	iMP3DataLen	= Z_Size( pbMP3Data );
+
+	int iRawPCMDataSize = MP3_GetUnpackedSize( sfx->sSoundName, pbMP3Data, iMP3DataLen, qfalse, qfalse );
+	byte *pbUnpackBuffer = (byte *) Z_Malloc( iRawPCMDataSize+10 +2304 /* <g> */, TAG_TEMP_WORKSPACE, qfalse );	// won't return if fails
+
+	int iResultBytes = MP3_UnpackRawPCM( sfx->sSoundName, pbMP3Data, iMP3DataLen, pbUnpackBuffer, qfalse );
+	if (!iResultBytes ||
+		!MP3_FakeUpWAVInfo( sfx->sSoundName, pbMP3Data, iMP3DataLen, iResultBytes,
+							// these params are all references...
+							info.format, info.rate, info.width, info.channels, info.samples, info.dataofs,
+							qfalse
+							)
+		)
+	{
+		Z_Free(pbUnpackBuffer);
+		return qfalse;
+	}
+
+	Z_Free(sfx->pMP3StreamHeader);
+	sfx->pMP3StreamHeader	= NULL;
+	sfx->pSoundData			= NULL;
+
+	S_LoadSound_Finalize(&info,sfx,pbUnpackBuffer);
+
+	Z_Free(pbUnpackBuffer);
+	Z_Free(pbMP3Data);
+
+	if (s_UseOpenAL)
+	{
+		// if it's been lip-synched while streaming then it gets a table for the whole sample, like any other
+		//	sound that's played on a voice channel...
+		//
+		if (sfx->lipSyncData)
+		{
+			Z_Free(sfx->lipSyncData);
+			sfx->lipSyncData = (char *)Z_Malloc((sfx->iSoundLengthInSamples / 1000) + 1, TAG_SND_RAWDATA, false);
+			S_PreProcessLipSync(sfx);
+		}
+
+		// Clear Open AL Error state
+		alGetError();
+
+		// Generate AL Buffer
+		ALuint Buffer;
+		alGenBuffers(1, &Buffer);
+		if (alGetError() == AL_NO_ERROR)
+		{
+			// Copy audio data to AL Buffer
+			alBufferData(Buffer, AL_FORMAT_MONO16, sfx->pSoundData, sfx->iSoundLengthInSamples*2, 22050);
+			if (alGetError() == AL_NO_ERROR)
+			{
+				sfx->Buffer = Buffer;
+				Z_Free(sfx->pSoundData);
+				sfx->pSoundData = NULL;
+			}
+		}
+	}
+
+	return qtrue;
+}
+
+
+// called once a frame, unpacks at most one sound, and only when enough credit has built up for it...
+//
+void S_MP3_UpdateUnpacks( void )
+{
+	if (!s_iMP3NumUnpacks)
+	{
+		s_iMP3UnpackCredit = 0;
+		return;
+	}
+
+	s_iMP3UnpackCredit += s_mp3UnpackKB->integer * 1024;
+
+	for (int i=0; i<s_iMP3NumUnpacks; i++)
+	{
+		sfx_t *sfx = s_mp3Unpacks[i];
+
+		if (S_MP3_InUse(sfx))
+			continue;	// still streaming, try again once it stops
+
+		const int iBytes = sfx->iSoundLengthInSamples * 2;
+		if (s_iMP3UnpackCredit < iBytes)
+			return;
+
+		memmove(&s_mp3Unpacks[i], &s_mp3Unpacks[i+1], (s_iMP3NumUnpacks - (i+1)) * sizeof(s_mp3Unpacks[0]));
+		s_iMP3NumUnpacks--;
+
+		// the mixer may still have a command queued that reads this MP3
+		S_MixerSync();
+
+		if (!S_MP3_Unpack(sfx))
+			return;	// MP3_UnpackRawPCM() will have said why, leave it as an MP3
+
+		s_iMP3UnpackCredit -= iBytes;
+		s_iMP3UnpackedBytes += sfx->iSoundLengthInSamples * 2;
+		sfx->bMP3Unpacked = true;
+
+		while (s_iMP3UnpackedBytes > s_mp3HotKB->integer * 1024)
+		{
+			if (!SND_FreeOldestUnpackedSound(sfx))
+				break;	// everything else unpacked is playing
+		}
+		return;
+	}
+}
@@ -12,11 +12,133 @@ portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE];
 int 	*snd_p, snd_linear_count, snd_vol;
 short	*snd_out;
 
+// cvar values for the mix in progress, copied by S_MixerKick() so the mixer thread never reads a cvar being set...
+//
+static int		snd_normalVol;
+static int		snd_voiceVol;
+static int		snd_testSound;
+static int		snd_mixSIMD;		// s_mixSIMD, s_mixbench sets it directly
+static float	snd_mixAhead;
+static int		snd_rawEnd;			// s_rawend, cinematics keep adding to that while we mix
+
+/*
+===============================================================================
+
+SIMD MIXING
+
+Channels are added into the paint buffer by S_MixMono16, and the paint
+buffer is clamped into the dma buffer by S_WriteLinearBlastStereo16.  Both
+have SSE2 versions that give the same samples as the scalar loops, which
+stay as the reference.  The volume multiply only has 16 bit lanes, so each
+volume is split into its high and low bytes:
+
+  ( data * vol ) >> 8 == data * ( vol >> 8 ) + ( ( data * ( vol & 255 ) ) >> 8 )
+
+and the clamp is the same shift followed by a saturating pack.  s_mixSIMD 0
+goes back to the scalar loops, s_mixbench times one against the other.
+
+===============================================================================
+*/
+
+#ifdef SND_SSE2_MIX
+#include <emmintrin.h>
+#endif
+
+static void S_MixMono16_C( portable_samplepair_t *dest, const short *src, int count, int leftvol, int rightvol )
+{
+	int		i;
+	int		data;
+
+	for ( i = 0 ; i < count ; i++ )
+	{
+		data = src[i];
+		dest[i].left  += (data * leftvol )>>8;
+		dest[i].right += (data * rightvol)>>8;
+	}
+}
+
+#ifdef SND_SSE2_MIX
+// 32 bit ( data * vol ) >> 8 for 8 samples, vol passed as its high and low bytes
+static inline void S_MulVol16_SSE2( __m128i data, __m128i volHigh, __m128i volLow, __m128i &lo, __m128i &hi )
+{
+	__m128i	productLow, productHigh, byteLow, byteHigh;
+
+	productLow = _mm_mullo_epi16( data, volHigh );
+	productHigh = _mm_mulhi_epi16( data, volHigh );
+	byteLow = _mm_mullo_epi16( data, volLow );
+	byteHigh = _mm_mulhi_epi16( data, volLow );
+
+	lo = _mm_add_epi32( _mm_unpacklo_epi16( productLow, productHigh ),
+		_mm_srai_epi32( _mm_unpacklo_epi16( byteLow, byteHigh ), 8 ) );
+	hi = _mm_add_epi32( _mm_unpackhi_epi16( productLow, productHigh ),
+		_mm_srai_epi32( _mm_unpackhi_epi16( byteLow, byteHigh ), 8 ) );
+}
+
+static void S_MixMono16_SSE2( portable_samplepair_t *dest, const short *src, int count, int leftvol, int rightvol )
+{
+	const __m128i	leftHigh = _mm_set1_epi16( (short)( leftvol >> 8 ) );
+	const __m128i	leftLow = _mm_set1_epi16( (short)( leftvol & 255 ) );
+	const __m128i	rightHigh = _mm_set1_epi16( (short)( rightvol >> 8 ) );
+	const __m128i	rightLow = _mm_set1_epi16( (short)( rightvol & 255 ) );
+	__m128i			data, left0, left1, right0, right1;
+	__m128i			*out;
+	int				i;
+
+	for ( i = 0 ; i + 8 <= count ; i += 8 )
+	{
+		data = _mm_loadu_si128( (const __m128i *)( src + i ) );
+		S_MulVol16_SSE2( data, leftHigh, leftLow, left0, left1 );
+		S_MulVol16_SSE2( data, rightHigh, rightLow, right0, right1 );
+
+		// interleave back into left/right pairs, two pairs per register
+		out = (__m128i *)( dest + i );
+		_mm_storeu_si128( out + 0, _mm_add_epi32( _mm_loadu_si128( out + 0 ), _mm_unpacklo_epi32( left0, right0 ) ) );
+		_mm_storeu_si128( out + 1, _mm_add_epi32( _mm_loadu_si128( out + 1 ), _mm_unpackhi_epi32( left0, right0 ) ) );
+		_mm_storeu_si128( out + 2, _mm_add_epi32( _mm_loadu_si128( out + 2 ), _mm_unpacklo_epi32( left1, right1 ) ) );
+		_mm_storeu_si128( out + 3, _mm_add_epi32( _mm_loadu_si128( out + 3 ), _mm_unpackhi_epi32( left1, right1 ) ) );
+	}
+
+	S_MixMono16_C( dest + i, src + i, count - i, leftvol, rightvol );
+}
+
+// clamps whole groups of 8 paint buffer values, returns how many it did
+static int S_WriteLinearBlastStereo16_SSE2 (void)
+{
+	__m128i	a, b;
+	int		i;
+
+	for ( i = 0 ; i + 8 <= snd_linear_count ; i += 8 )
+	{
+		a = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( snd_p + i ) ), 8 );
+		b = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( snd_p + i + 4 ) ), 8 );
+		_mm_storeu_si128( (__m128i *)( snd_out + i ), _mm_packs_epi32( a, b ) );
+	}
+	return i;
+}
+#endif
 
+/*
+===================
+S_MixMono16
 
+Adds count mono samples into dest at leftvol and rightvol, which are
+256 for full volume
+===================
+*/
+static void S_MixMono16( portable_samplepair_t *dest, const short *src, int count, int leftvol, int rightvol )
+{
+#ifdef SND_SSE2_MIX
+	if ( snd_mixSIMD ) {
+		S_MixMono16_SSE2( dest, src, count, leftvol, rightvol );
+		return;
+	}
+#endif
+	S_MixMono16_C( dest, src, count, leftvol, rightvol );
+}
 
-#if !((defined __linux__ || defined __APPLE__) && defined __i386__)
-#if	!id386
+
+
+#ifndef SND_MMX_ASM
 
 
 void S_WriteLinearBlastStereo16 (void)
@@ -24,7 +146,14 @@ void S_WriteLinearBlastStereo16 (void)
 	int		i;
 	int		val;
 
-	for (i=0 ; i<snd_linear_count ; i+=2)
+	i = 0;
+#ifdef SND_SSE2_MIX
+	if ( snd_mixSIMD ) {
+		i = S_WriteLinearBlastStereo16_SSE2 ();
+	}
+#endif
+
+	for ( ; i<snd_linear_count ; i+=2)
 	{
 		val = snd_p[i]>>8;
 		if (val > 0x7fff)
@@ -132,33 +261,6 @@ LExit:
 }
 
 #endif
-#else
-
-void S_WriteLinearBlastStereo16 (void)
-{
-	int		i;
-	int		val;
-
-	for (i=0 ; i<snd_linear_count ; i+=2)
-	{
-		val = snd_p[i]>>8;
-		if (val > 0x7fff)
-			snd_out[i] = 0x7fff;
-		else if (val < (short)0x8000)
-			snd_out[i] = (short)0x8000;
-		else
-			snd_out[i] = val;
-
-		val = snd_p[i+1]>>8;
-		if (val > 0x7fff)
-			snd_out[i+1] = 0x7fff;
-		else if (val < (short)0x8000)
-			snd_out[i+1] = (short)0x8000;
-		else
-			snd_out[i+1] = val;
-	}
-}
-#endif
 
 
 
@@ -210,7 +312,7 @@ void S_TransferPaintBuffer(int endtime)
 	pbuf = (unsigned long *)dma.buffer;
 
 
-	if ( s_testsound->integer ) {
+	if ( snd_testSound ) {
 		int		i;
 		int		count;
 
@@ -276,70 +378,20 @@ CHANNEL MIXING
 */
 static void S_PaintChannelFrom16( channel_t *ch, const sfx_t *sfx, int count, int sampleOffset, int bufferOffset ) 
 {
-	portable_samplepair_t	*pSamplesDest;	
-	int iData;
-
-
 	int iLeftVol	= ch->leftvol  * snd_vol;
 	int iRightVol	= ch->rightvol * snd_vol;
 
-	pSamplesDest	= &paintbuffer[ bufferOffset ];
-	
-	for ( int i=0 ; i<count ; i++ ) 
-	{
-		iData = sfx->pSoundData[ sampleOffset++ ];
-
-		pSamplesDest[i].left  += (iData * iLeftVol )>>8;
-		pSamplesDest[i].right += (iData * iRightVol)>>8;
-	}
+	S_MixMono16( &paintbuffer[ bufferOffset ], sfx->pSoundData + sampleOffset, count, iLeftVol, iRightVol );
 }
 
 
 void S_PaintChannelFromMP3( channel_t *ch, const sfx_t *sc, int count, int sampleOffset, int bufferOffset ) 
 {
-	int data;
-	int leftvol, rightvol;
-	signed short *sfx;
-	int	i;
-	portable_samplepair_t	*samp;
 	static short tempMP3Buffer[PAINTBUFFER_SIZE];
 
 	MP3Stream_GetSamples( ch, sampleOffset, count, tempMP3Buffer, qfalse );	// qfalse = not stereo
 
-	leftvol = ch->leftvol*snd_vol;
-	rightvol = ch->rightvol*snd_vol;
-	sfx = tempMP3Buffer;
-
-	samp = &paintbuffer[ bufferOffset ];
-
-
-	while ( count & 3 ) {
-		data = *sfx;
-		samp->left += (data * leftvol)>>8;
-		samp->right += (data * rightvol)>>8;
-
-		sfx++;
-		samp++;
-		count--;
-	}
-
-	for ( i=0 ; i<count ; i += 4 ) {
-		data = sfx[i];
-		samp[i].left += (data * leftvol)>>8;
-		samp[i].right += (data * rightvol)>>8;
-
-		data = sfx[i+1];
-		samp[i+1].left += (data * leftvol)>>8;
-		samp[i+1].right += (data * rightvol)>>8;
-
-		data = sfx[i+2];
-		samp[i+2].left += (data * leftvol)>>8;
-		samp[i+2].right += (data * rightvol)>>8;
-
-		data = sfx[i+3];
-		samp[i+3].left += (data * leftvol)>>8;
-		samp[i+3].right += (data * rightvol)>>8;
-	}
+	S_MixMono16( &paintbuffer[ bufferOffset ], tempMP3Buffer, count, ch->leftvol*snd_vol, ch->rightvol*snd_vol );
 }
 
 
@@ -368,7 +420,9 @@ void ChannelPaint(channel_t *ch, sfx_t *sc, int count, int sampleOffset, int buf
 
 
 
-void S_PaintChannels( int endtime ) {
+// channels is always MAX_CHANNELS long, rawend is how far s_rawsamples[] was filled when this mix started
+//
+void S_PaintChannels( channel_t *channels, int endtime, int rawend ) {
 	int 	i;
 	int 	end;
 	channel_t *ch;
@@ -377,8 +431,8 @@ void S_PaintChannels( int endtime ) {
 	int		sampleOffset;
 	int	normal_vol,voice_vol;
 
-	snd_vol = normal_vol = s_volume->value*256.0f;
-	voice_vol  = (s_volumeVoice->value*256.0f);
+	snd_vol = normal_vol = snd_normalVol;
+	voice_vol  = snd_voiceVol;
 
 //Com_Printf ("%i to %i\n", s_paintedtime, endtime);
 	while ( s_paintedtime < endtime ) {
@@ -390,8 +444,8 @@ void S_PaintChannels( int endtime ) {
 		}
 
 		// clear the paint buffer to either music or zeros
-		if ( s_rawend < s_paintedtime ) {
-			if ( s_rawend ) {
+		if ( rawend < s_paintedtime ) {
+			if ( rawend ) {
 				//Com_DPrintf ("background sound underrun\n");
 			}
 			memset(paintbuffer, 0, (end - s_paintedtime) * sizeof(portable_samplepair_t));
@@ -400,7 +454,7 @@ void S_PaintChannels( int endtime ) {
 			int		s;
 			int		stop;
 
-			stop = (end < s_rawend) ? end : s_rawend;
+			stop = (end < rawend) ? end : rawend;
 
 			for ( i = s_paintedtime ; i < stop ; i++ ) {
 				s = i&(MAX_RAW_SAMPLES-1);
@@ -417,7 +471,7 @@ void S_PaintChannels( int endtime ) {
 		}
 
 		// paint in the channels.
-		ch = s_channels;
+		ch = channels;
 		for ( i = 0; i < MAX_CHANNELS ; i++, ch++ ) {		
 			if ( !ch->thesfx || (ch->leftvol<0.25 && ch->rightvol<0.25 )) {
 				continue;
@@ -496,3 +550,562 @@ void S_PaintChannels( int endtime ) {
 		s_paintedtime = end;
 	}
 }
+
+
+/*
+===============================================================================
+
+MIXER THREAD
+
+s_channels[] belongs to the main thread, which picks, spatializes and
+stops channels exactly as before, and tells the mixer what it did through
+a ring of commands.  The mixer paints its own copy of every channel, so
+MP3 decoding, lip sync amplitudes and the dma buffer are all done off the
+main thread.  The ring has one writer and one reader, the main thread only
+moves the head and the mixer only moves the tail.
+
+S_Update_() reads the last mix back and starts the next one, which then
+runs alongside the rest of the frame, and S_Update() waits for it before
+touching the background track.  A mix only applies the commands queued
+before it started, so loop sounds that are stopped and restarted each
+frame never drop out.  Anything that frees sfx data or touches the dma
+buffer calls S_MixerSync() first.  With s_mixThread 0, or if the thread
+couldn't be started, the same code runs inline in S_Update_().
+
+===============================================================================
+*/
+
+typedef enum
+{
+	MIXCMD_START,
+	MIXCMD_STOP,
+	MIXCMD_SPATIALIZE,
+	MIXCMD_STOPALL
+} mixCommandType_t;
+
+typedef struct
+{
+	mixCommandType_t	type;
+	int					channel;		// index into s_channels[], the mixer's copy has the same index
+	int					sequence;
+	sfx_t				*sfx;
+	int					startSample;
+	int					entnum;
+	soundChannel_t		entchannel;
+	int					leftvol;
+	int					rightvol;
+	qboolean			loopSound;
+} mixCommand_t;
+
+#define	MAX_MIX_COMMANDS	1024	// must be a power of 2
+
+static mixCommand_t	s_mixCommands[MAX_MIX_COMMANDS];
+static volatile int	s_mixCommandHead;	// only moved by the main thread
+static volatile int	s_mixCommandTail;	// only moved by whoever is mixing
+static int			s_mixCommandFence;	// head when the mix was started
+
+static channel_t	s_mixChannels[MAX_CHANNELS];
+static int			s_mixSequence;
+
+static qboolean		s_mixActive;		// S_MixerInit() was called, so the dma path is in use
+static qboolean		s_mixRunning;		// a mix has been started and not waited for yet
+static void			*s_mixThreadHandle;
+static void			*s_mixWake;
+static void			*s_mixDone;
+static volatile int	s_mixQuit;
+
+qboolean			s_mixWrapped;
+
+extern int			s_soundtime;
+extern int			s_entityWavVol[MAX_GENTITIES];
+
+
+static void S_MixerRunCommands( int fence )
+{
+	mixCommand_t	*cmd;
+	channel_t		*ch;
+	int				i;
+
+	while ( s_mixCommandTail != fence )
+	{
+		cmd = &s_mixCommands[ s_mixCommandTail & (MAX_MIX_COMMANDS-1) ];
+		ch = &s_mixChannels[ cmd->channel ];
+
+		switch ( cmd->type )
+		{
+			case MIXCMD_START:
+
+				Channel_Clear( ch );
+				ch->thesfx		= cmd->sfx;
+				ch->startSample	= cmd->startSample;
+				ch->entnum		= cmd->entnum;
+				ch->entchannel	= cmd->entchannel;
+				ch->leftvol		= cmd->leftvol;
+				ch->rightvol	= cmd->rightvol;
+				ch->loopSound	= cmd->loopSound;
+				ch->iMixSequence= cmd->sequence;
+				if (cmd->sfx->pMP3StreamHeader)
+				{
+					memcpy(&ch->MP3StreamHeader, cmd->sfx->pMP3StreamHeader, sizeof(ch->MP3StreamHeader));
+				}
+				break;
+
+			case MIXCMD_STOP:
+
+				Channel_Clear( ch );
+				break;
+
+			case MIXCMD_SPATIALIZE:
+
+				ch->leftvol		= cmd->leftvol;
+				ch->rightvol	= cmd->rightvol;
+				break;
+
+			case MIXCMD_STOPALL:
+
+				for ( i = 0 ; i < MAX_CHANNELS ; i++ ) {
+					Channel_Clear( &s_mixChannels[i] );
+				}
+				break;
+		}
+
+		Sys_AtomicAdd( &s_mixCommandTail, 1 );
+	}
+}
+
+/*
+===================
+S_MixerRun
+
+One mix, on the mixer thread or inline.  Only touches s_mixChannels[],
+the dma buffer and the sample times
+===================
+*/
+static void S_MixerRun( void )
+{
+	int		endtime;
+	int		samps;
+	int		i;
+
+	S_MixerRunCommands( s_mixCommandFence );
+
+	// Updates s_soundtime
+	S_GetSoundtime();
+	if ( s_mixWrapped ) {
+		// the main thread stops everything else when it reads this mix back
+		for ( i = 0 ; i < MAX_CHANNELS ; i++ ) {
+			Channel_Clear( &s_mixChannels[i] );
+		}
+	}
+
+	const int s_oldpaintedtime = s_paintedtime;
+
+	// clear any sound effects that end before the current time,
+	// and start any new sounds
+	S_ScanChannelStarts( s_mixChannels );
+
+	// mix ahead of current position
+	endtime = (int)(s_soundtime + snd_mixAhead * dma.speed);
+
+	// mix to an even submission block size
+	endtime = (endtime + dma.submission_chunk-1)
+		& ~(dma.submission_chunk-1);
+
+	// never mix more than the complete buffer
+	samps = dma.samples >> (dma.channels-1);
+	if (endtime - s_soundtime > samps)
+		endtime = s_soundtime + samps;
+
+
+	SNDDMA_BeginPainting ();
+
+	S_PaintChannels (s_mixChannels, endtime, snd_rawEnd);
+
+	SNDDMA_Submit ();
+
+	S_DoLipSynchs( s_mixChannels, s_oldpaintedtime );
+}
+
+static void S_MixerThread( void *data )
+{
+	while ( 1 )
+	{
+		Sys_SemaphoreWait( s_mixWake );
+		if ( s_mixQuit ) {
+			break;
+		}
+
+		S_MixerRun();
+
+		Sys_SemaphorePost( s_mixDone );
+	}
+}
+
+void S_MixerInit( void )
+{
+	int		i;
+
+	for ( i = 0 ; i < MAX_CHANNELS ; i++ ) {
+		Channel_Clear( &s_mixChannels[i] );
+	}
+	s_mixCommandHead = s_mixCommandTail = s_mixCommandFence = 0;
+	s_mixWrapped = qfalse;
+	s_mixRunning = qfalse;
+	s_mixActive = qtrue;
+
+	if ( !s_mixThread->integer ) {
+		return;
+	}
+
+	s_mixQuit = 0;
+	s_mixWake = Sys_CreateSemaphore( 0 );
+	s_mixDone = Sys_CreateSemaphore( 0 );
+	if ( s_mixWake && s_mixDone ) {
+		s_mixThreadHandle = Sys_CreateThread( S_MixerThread, NULL );
+	}
+
+	if ( !s_mixThreadHandle ) {
+		Com_Printf( S_COLOR_YELLOW "S_MixerInit: couldn't start the mixer thread, mixing on the main thread\n" );
+		if ( s_mixWake ) {
+			Sys_DestroySemaphore( s_mixWake );
+			s_mixWake = NULL;
+		}
+		if ( s_mixDone ) {
+			Sys_DestroySemaphore( s_mixDone );
+			s_mixDone = NULL;
+		}
+		return;
+	}
+
+	MP3_EnableDecoderLock( qtrue );
+}
+
+void S_MixerShutdown( void )
+{
+	if ( !s_mixActive ) {
+		return;
+	}
+
+	S_MixerWait();
+	s_mixActive = qfalse;
+
+	if ( !s_mixThreadHandle ) {
+		return;
+	}
+
+	s_mixQuit = 1;
+	Sys_SemaphorePost( s_mixWake );
+	Sys_JoinThread( s_mixThreadHandle );
+	s_mixThreadHandle = NULL;
+
+	Sys_DestroySemaphore( s_mixWake );
+	Sys_DestroySemaphore( s_mixDone );
+	s_mixWake = s_mixDone = NULL;
+
+	MP3_EnableDecoderLock( qfalse );
+}
+
+void S_MixerWait( void )
+{
+	if ( s_mixRunning ) {
+		Sys_SemaphoreWait( s_mixDone );
+		s_mixRunning = qfalse;
+	}
+}
+
+void S_MixerSync( void )
+{
+	if ( !s_mixActive ) {
+		return;
+	}
+
+	S_MixerWait();
+	S_MixerRunCommands( s_mixCommandHead );
+}
+
+static mixCommand_t *S_MixerAllocCommand( mixCommandType_t type, int channel )
+{
+	mixCommand_t	*cmd;
+
+	if ( s_mixCommandHead - s_mixCommandTail >= MAX_MIX_COMMANDS ) {
+		// a whole ring queued in one frame, so catch the mixer up here
+		S_MixerSync();
+	}
+
+	cmd = &s_mixCommands[ s_mixCommandHead & (MAX_MIX_COMMANDS-1) ];
+	cmd->type = type;
+	cmd->channel = channel;
+	return cmd;
+}
+
+static void S_MixerPostCommand( void )
+{
+	Sys_AtomicAdd( &s_mixCommandHead, 1 );
+}
+
+void S_MixerStartChannel( channel_t *ch )
+{
+	mixCommand_t	*cmd;
+
+	if ( !s_mixActive ) {
+		return;
+	}
+
+	if ( !++s_mixSequence ) {
+		++s_mixSequence;	// 0 is a cleared channel
+	}
+	ch->iMixSequence = s_mixSequence;
+
+	cmd = S_MixerAllocCommand( MIXCMD_START, ch - s_channels );
+	cmd->sequence	= ch->iMixSequence;
+	cmd->sfx		= ch->thesfx;
+	cmd->startSample= ch->startSample;
+	cmd->entnum		= ch->entnum;
+	cmd->entchannel	= ch->entchannel;
+	cmd->leftvol	= ch->leftvol;
+	cmd->rightvol	= ch->rightvol;
+	cmd->loopSound	= ch->loopSound;
+	S_MixerPostCommand();
+}
+
+void S_MixerStopChannel( channel_t *ch )
+{
+	if ( !s_mixActive ) {
+		return;
+	}
+
+	S_MixerAllocCommand( MIXCMD_STOP, ch - s_channels );
+	S_MixerPostCommand();
+}
+
+void S_MixerSpatializeChannel( channel_t *ch )
+{
+	mixCommand_t	*cmd;
+
+	if ( !s_mixActive ) {
+		return;
+	}
+
+	cmd = S_MixerAllocCommand( MIXCMD_SPATIALIZE, ch - s_channels );
+	cmd->leftvol	= ch->leftvol;
+	cmd->rightvol	= ch->rightvol;
+	S_MixerPostCommand();
+}
+
+void S_MixerStopAll( void )
+{
+	if ( !s_mixActive ) {
+		return;
+	}
+
+	S_MixerAllocCommand( MIXCMD_STOPALL, 0 );
+	S_MixerPostCommand();
+}
+
+/*
+===================
+S_MixerCollect
+
+Reads the finished mix back into s_channels[] and s_entityWavVol[].  A
+channel whose start is still queued keeps what the main thread gave it
+===================
+*/
+static void S_MixerCollect( void )
+{
+	channel_t	*ch, *mix;
+	int			i;
+
+	if ( s_mixWrapped ) {
+		s_mixWrapped = qfalse;
+		S_StopAllSounds ();
+		return;
+	}
+
+	// clear out the lip synching override array for this frame
+	memset(s_entityWavVol, 0, sizeof(s_entityWavVol));
+
+	ch = s_channels;
+	mix = s_mixChannels;
+	for ( i = 0 ; i < MAX_CHANNELS ; i++, ch++, mix++ ) {
+		if ( !ch->thesfx ) {
+			continue;
+		}
+
+		const qboolean bVoice = (qboolean)( !ch->loopSound && ( ch->entchannel == CHAN_VOICE || ch->entchannel == CHAN_VOICE_ATTEN || ch->entchannel == CHAN_VOICE_GLOBAL ) );
+
+		if ( ch->iMixSequence != mix->iMixSequence ) {
+			if ( bVoice ) {
+				s_entityWavVol[ ch->entnum ] = -1;	//we've started the sound but it's silent for now
+			}
+			continue;
+		}
+
+		// if it is completely finished by now, clear it
+		if ( !mix->thesfx ) {
+			Channel_Clear( ch );
+			continue;
+		}
+
+		ch->startSample = mix->startSample;
+
+		if ( bVoice ) {
+			s_entityWavVol[ ch->entnum ] = mix->iLipSyncVolume;
+			if ( s_show->integer == 3 ) {
+				Com_Printf( "(%i)%i %s vol = %i\n", ch->entnum, i, ch->thesfx->sSoundName, s_entityWavVol[ ch->entnum ] );
+			}
+		}
+	}
+}
+
+static void S_MixerKick( void )
+{
+	snd_normalVol	= s_volume->value*256.0f;
+	snd_voiceVol	= (s_volumeVoice->value*256.0f);
+	snd_testSound	= s_testsound->integer;
+	snd_mixSIMD		= s_mixSIMD->integer;
+	snd_mixAhead	= s_mixahead->value;
+	snd_rawEnd		= s_rawend;
+
+	s_mixCommandFence = s_mixCommandHead;
+}
+
+void S_MixerUpdate( void )
+{
+	if ( !s_mixActive ) {
+		return;
+	}
+
+	S_MixerWait();
+
+	if ( s_mixThreadHandle ) {
+		S_MixerCollect();
+		S_MixerKick();
+		s_mixRunning = qtrue;
+		Sys_SemaphorePost( s_mixWake );
+	} else {
+		S_MixerKick();
+		S_MixerRun();
+		S_MixerCollect();
+	}
+}
+
+
+/*
+===================
+S_MixBench_Run
+
+Paints every channel through S_PaintChannels into the scratch dma buffer,
+returns the msec it took
+===================
+*/
+static int S_MixBench_Run( channel_t *channels, int samples, int passes, int simd )
+{
+	int		pass, start;
+
+	snd_mixSIMD = simd;
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		s_paintedtime = 0;
+		S_PaintChannels( channels, samples, 0 );
+	}
+	return Sys_Milliseconds() - start;
+}
+
+/*
+===================
+S_MixBench_f
+
+s_mixbench [channels] [seconds] [passes]
+
+Mixes synthetic 22khz channels through S_PaintChannels into a scratch
+buffer instead of the dma buffer, once with the scalar loops and once
+with SSE2, and checks both gave the same samples.  Doesn't need a sound
+device.
+===================
+*/
+void S_MixBench_f( void )
+{
+	channel_t	*channels;
+	sfx_t		sfx;
+	dma_t		dmaSaved;
+	short		*out[2];
+	int			numChannels, samples, passes, bufferSamples, i, msec[2];
+	qboolean	same;
+
+	numChannels = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : MAX_CHANNELS;
+	samples = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) * 22050 : 22050;
+	passes = Cmd_Argc() > 3 ? atoi( Cmd_Argv( 3 ) ) : 10;
+	if ( numChannels < 1 || numChannels > MAX_CHANNELS || samples < 1 || passes < 1 ) {
+		Com_Printf( "usage: s_mixbench [channels (1-%i)] [seconds] [passes]\n", MAX_CHANNELS );
+		return;
+	}
+
+	// the mixer's globals are ours until the next S_Update
+	S_MixerWait();
+
+	// every channel reads the same noise from its own offset
+	memset( &sfx, 0, sizeof( sfx ) );
+	sfx.eSoundCompressionMethod = ct_16;
+	sfx.iSoundLengthInSamples = samples + numChannels;
+	sfx.pSoundData = (short *)Z_Malloc( sfx.iSoundLengthInSamples * sizeof( short ), TAG_TEMP_WORKSPACE, qfalse );
+	channels = (channel_t *)Z_Malloc( MAX_CHANNELS * sizeof( channel_t ), TAG_TEMP_WORKSPACE, qtrue );
+
+	srand( 0 );
+	for ( i = 0 ; i < sfx.iSoundLengthInSamples ; i++ ) {
+		sfx.pSoundData[i] = (short)( ( rand() & 0xffff ) - 0x8000 );
+	}
+	for ( i = 0 ; i < numChannels ; i++ ) {
+		channels[i].thesfx = &sfx;
+		channels[i].startSample = -i;
+		channels[i].entchannel = CHAN_AUTO;
+		channels[i].leftvol = 1 + ( rand() % 255 );	// 1-255, as spatialized
+		channels[i].rightvol = 1 + ( rand() % 255 );
+	}
+
+	// a stereo 16 bit "device" big enough to hold the whole mix
+	for ( bufferSamples = 1 ; bufferSamples < samples ; bufferSamples <<= 1 ) {
+	}
+	out[0] = (short *)Z_Malloc( bufferSamples * 2 * sizeof( short ), TAG_TEMP_WORKSPACE, qtrue );
+	out[1] = (short *)Z_Malloc( bufferSamples * 2 * sizeof( short ), TAG_TEMP_WORKSPACE, qtrue );
+
+	const int iPaintedTimeSaved = s_paintedtime;
+	dmaSaved = dma;
+	dma.channels = 2;
+	dma.samplebits = 16;
+	dma.speed = 22050;
+	dma.samples = bufferSamples * 2;
+	dma.submission_chunk = 1;
+
+	snd_normalVol = snd_voiceVol = 256;
+	snd_testSound = 0;
+
+	dma.buffer = (byte *)out[0];
+	msec[0] = S_MixBench_Run( channels, samples, passes, 0 );
+#ifdef SND_SSE2_MIX
+	dma.buffer = (byte *)out[1];
+	msec[1] = S_MixBench_Run( channels, samples, passes, 1 );
+	same = (qboolean)!memcmp( out[0], out[1], bufferSamples * 2 * sizeof( short ) );
+#else
+	msec[1] = 0;
+	same = qtrue;
+#endif
+
+	dma = dmaSaved;
+	s_paintedtime = iPaintedTimeSaved;
+
+	Z_Free( out[1] );
+	Z_Free( out[0] );
+	Z_Free( channels );
+	Z_Free( sfx.pSoundData );
+
+	Com_Printf( "%i channels, %i samples, %i passes\n", numChannels, samples, passes );
+	Com_Printf( "scalar : %5i msec\n", msec[0] );
+#ifdef SND_SSE2_MIX
+	Com_Printf( "sse2   : %5i msec\n", msec[1] );
+#else
+	Com_Printf( "sse2   : not compiled in\n" );
+#endif
+	if ( !same ) {
+		Com_Printf( S_COLOR_RED "s_mixbench: sse2 and scalar mixes differ\n" );
+	}
+}
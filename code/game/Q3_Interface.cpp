@@ -8134,7 +8134,7 @@ int		CQuake3GameInterface::GetTag( int entID, const char *name, int lookup, vec3
 //	 void	CQuake3GameInterface::Lerp2Start( int taskID, int entID, float duration ) {}
 //	 void	CQuake3GameInterface::Lerp2End( int taskID, int entID, float duration ) {}
 
-void	CQuake3GameInterface::Set( int taskID, int entID, const char *type_name, const char *data )
+void	CQuake3GameInterface::Set( int taskID, int entID, const char *type_name, const char *data, int setID )
 {
 	gentity_t	*ent = &g_entities[entID];
 	float		float_data;
@@ -8142,7 +8142,7 @@ void	CQuake3GameInterface::Set( int taskID, int entID, const char *type_name, co
 	vec3_t		vector_data;
 
 	//Set this for callbacks
-	toSet = GetIDForString( setTable, type_name );
+	toSet = ( setID != SETID_UNRESOLVED ) ? setID : GetIDForString( setTable, type_name );
 
 	//TODO: Throw in a showscript command that will list each command and what they're doing...
 	//		maybe as simple as printing that line of the script to the console preceeded by the person's name?
@@ -9754,7 +9754,7 @@ void	CQuake3GameInterface::CameraShake( float intensity, int duration )
 	CGCam_Shake( intensity, duration );
 }
 
-int		CQuake3GameInterface::GetFloat( int entID, const char *name, float *value )
+int		CQuake3GameInterface::GetFloat( int entID, const char *name, float *value, int setID )
 {
 	gentity_t	*ent = &g_entities[entID];
 //	gclient_t	*client;
@@ -9764,7 +9764,7 @@ int		CQuake3GameInterface::GetFloat( int entID, const char *name, float *value )
 		return false;
 	}
 
-	int toGet = GetIDForString( setTable, name );	//FIXME: May want to make a "getTable" as well
+	int toGet = ( setID != SETID_UNRESOLVED ) ? setID : GetIDForString( setTable, name );	//FIXME: May want to make a "getTable" as well
 	//FIXME: I'm getting really sick of these huge switch statements!
 
 	//NOTENOTE: return true if the value was correctly obtained
@@ -10387,7 +10387,12 @@ int		CQuake3GameInterface::GetFloat( int entID, const char *name, float *value )
 	return true;
 }
 
-int		CQuake3GameInterface::GetVector( int entID, const char *name, vec3_t value )
+int		CQuake3GameInterface::GetSetID( const char *name )
+{
+	return GetIDForString( setTable, name );
+}
+
+int		CQuake3GameInterface::GetVector( int entID, const char *name, vec3_t value, int setID )
 {
 	gentity_t	*ent = &g_entities[entID];
 	if ( !ent )
@@ -10395,7 +10400,7 @@ int		CQuake3GameInterface::GetVector( int entID, const char *name, vec3_t value
 		return false;
 	}
 
-	int toGet = GetIDForString( setTable, name );	//FIXME: May want to make a "getTable" as well
+	int toGet = ( setID != SETID_UNRESOLVED ) ? setID : GetIDForString( setTable, name );	//FIXME: May want to make a "getTable" as well
 	//FIXME: I'm getting really sick of these huge switch statements!
 
 	//NOTENOTE: return true if the value was correctly obtained
@@ -10444,7 +10449,7 @@ int		CQuake3GameInterface::GetVector( int entID, const char *name, vec3_t value
 	return true;
 }
 
-int		CQuake3GameInterface::GetString( int entID, const char *name, char **value )
+int		CQuake3GameInterface::GetString( int entID, const char *name, char **value, int setID )
 {
 	gentity_t	*ent = &g_entities[entID];
 	if ( !ent )
@@ -10452,7 +10457,7 @@ int		CQuake3GameInterface::GetString( int entID, const char *name, char **value
 		return false;
 	}
 
-	int toGet = GetIDForString( setTable, name );	//FIXME: May want to make a "getTable" as well
+	int toGet = ( setID != SETID_UNRESOLVED ) ? setID : GetIDForString( setTable, name );	//FIXME: May want to make a "getTable" as well
 
 	switch ( toGet )
 	{
@@ -640,7 +640,7 @@ public:
 	int		GetTag( int entID, const char *name, int lookup, vec3_t info );
 	//void	Lerp2Start( int taskID, int entID, float duration );
 	//void	Lerp2End( int taskID, int entID, float duration );
-	void	Set( int taskID, int entID, const char *type_name, const char *data );
+	void	Set( int taskID, int entID, const char *type_name, const char *data, int setID = SETID_UNRESOLVED );
 	void	Use( int entID, const char *name );
 	void	Activate( int entID, const char *name );
 	void	Deactivate( int entID, const char *name );
@@ -663,9 +663,10 @@ public:
 	void	CameraDisable( void );
 	void	CameraShake( float intensity, int duration );
 
-	int		GetFloat( int entID, const char *name, float *value );
-	int		GetVector( int entID, const char *name, vec3_t value );
-	int		GetString( int entID, const char *name, char **value );
+	int		GetFloat( int entID, const char *name, float *value, int setID = SETID_UNRESOLVED );
+	int		GetVector( int entID, const char *name, vec3_t value, int setID = SETID_UNRESOLVED );
+	int		GetString( int entID, const char *name, char **value, int setID = SETID_UNRESOLVED );
+	int		GetSetID( const char *name );
 
 	int		Evaluate( int p1Type, const char *p1, int p2Type, const char *p2, int operatorType );
 
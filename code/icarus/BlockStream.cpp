@@ -25,6 +25,8 @@ inline CBlockMember::CBlockMember( void )
 	m_id = -1;
 	m_size = -1;
 	m_data = NULL;
+	m_shared = false;
+	m_setID = IGameInterface::SETID_UNRESOLVED;
 }
 
 inline CBlockMember::~CBlockMember( void )
@@ -41,7 +43,8 @@ void CBlockMember::Free(IGameInterface* game)
 {
 	if ( m_data != NULL )
 	{
-		game->Free ( m_data );
+		if ( !m_shared )
+			game->Free ( m_data );
 		m_data = NULL;
 
 		m_id = m_size = -1;
@@ -81,48 +84,35 @@ void CBlockMember::SetData( vec3_t data , CIcarus* icarus)
 void CBlockMember::SetData( void *data, int size, CIcarus* icarus)
 {
 	IGameInterface* game = icarus->GetGame();
-	if ( m_data )
+	if ( m_data && !m_shared )
 		game->Free( m_data );
 
 	m_data = game->Malloc( size );
 	memcpy( m_data, data, size );
 	m_size = size;
+	m_shared = false;
+	m_setID = IGameInterface::SETID_UNRESOLVED;
 }
 
-//	Member I/O functions
-
 /*
 -------------------------
-ReadMember
+SetShared
 -------------------------
 */
 
-int CBlockMember::ReadMember( char **stream, long *streamPos, CIcarus* icarus )
+void CBlockMember::SetShared( int id, int size, void *data, int setID )
 {
-	IGameInterface* game = icarus->GetGame();
-	m_id = *(int *) (*stream + *streamPos);
-	*streamPos += sizeof( int );
-
-	if ( m_id == CIcarus::ID_RANDOM )
-	{//special case, need to initialize this member's data to Q3_INFINITE so we can randomize the number only the first time random is checked when inside a wait
-		m_size = sizeof( float );
-		*streamPos += sizeof( long );
-		m_data = game->Malloc( m_size );
-		float infinite = game->MaxFloat();
-		memcpy( m_data, &infinite, m_size );
-	}
-	else
-	{
-		m_size = *(long *) (*stream + *streamPos);
-		*streamPos += sizeof( long );
-		m_data = game->Malloc( m_size );
-		memcpy( m_data, (*stream + *streamPos), m_size );
-	}
-	*streamPos += m_size;
-	
-	return true;
+	assert( m_data == NULL );
+
+	m_id = id;
+	m_size = size;
+	m_data = data;
+	m_shared = true;
+	m_setID = setID;
 }
 
+//	Member I/O functions
+
 /*
 -------------------------
 WriteMember
@@ -151,6 +141,13 @@ CBlockMember *CBlockMember::Duplicate( CIcarus* icarus )
 	if ( newblock == NULL )
 		return NULL;
 
+	//Nothing writes to compiled script data, so the copy can point at it too
+	if ( m_shared )
+	{
+		newblock->SetShared( m_id, m_size, m_data, m_setID );
+		return newblock;
+	}
+
 	newblock->SetData( m_data, m_size, icarus );
 	newblock->SetSize( m_size );
 	newblock->SetID( m_id );
@@ -391,7 +388,8 @@ int CBlockStream::Free( void )
 	//			That's why this doesn't free the memory, it only clears its internal pointer
 
 	m_stream = NULL;
-	m_streamPos = 0;
+	m_script = NULL;
+	m_blockNum = 0;
 
 	return true;
 }
@@ -445,7 +443,8 @@ int CBlockStream::Init( void )
 	memset(m_fileName, 0, sizeof(m_fileName));
 
 	m_stream = NULL;
-	m_streamPos = 0;
+	m_script = NULL;
+	m_blockNum = 0;
 
 	return true;
 }
@@ -488,7 +487,7 @@ BlockAvailable
 
 int CBlockStream::BlockAvailable( void )
 {
-	if ( m_streamPos >= m_fileSize )
+	if ( m_script == NULL || m_blockNum >= m_script->GetNumBlocks() )
 		return false;
 
 	return true;
@@ -502,27 +501,17 @@ ReadBlock
 
 int CBlockStream::ReadBlock( CBlock *get, CIcarus* icarus )
 {
-	CBlockMember	*bMember;
-	int				b_id, numMembers;
-	unsigned char	flags;
+	const compiledBlock_t	*block;
+	const compiledMember_t	*member;
+	CBlockMember			*bMember;
 
 	if (!BlockAvailable())
 		return false;
 
-	b_id		= *(int *) (m_stream + m_streamPos);
-	m_streamPos += sizeof( b_id );
+	block = m_script->GetBlock( m_blockNum++ );
 
-	numMembers	= *(int *) (m_stream + m_streamPos);
-	m_streamPos += sizeof( numMembers );
-
-	flags		= *(unsigned char*) (m_stream + m_streamPos);
-	m_streamPos += sizeof( flags );
-
-	if (numMembers < 0)
-		return false;
-
-	get->Create( b_id );
-	get->SetFlags( flags );
+	get->Create( block->id );
+	get->SetFlags( block->flags );
 
 	// Stream blocks are generally temporary as they
 	// are just used in an initial parsing phase...
@@ -531,10 +520,13 @@ int CBlockStream::ReadBlock( CBlock *get, CIcarus* icarus )
 	Z_SetNewDeleteTemporary(true);
 #endif
 
-	while ( numMembers-- > 0)
-	{	
+	//The members only point at the compiled data, nothing is copied unless it's written to
+	for ( int i = 0; i < block->numMembers; i++ )
+	{
+		member = m_script->GetMember( block, i );
+
 		bMember = new CBlockMember;
-		bMember->ReadMember( &m_stream, &m_streamPos, icarus );
+		bMember->SetShared( member->id, member->size, m_script->GetData( member ), member->setID );
 		get->AddMember( bMember );
 	}
 
@@ -547,38 +539,57 @@ int CBlockStream::ReadBlock( CBlock *get, CIcarus* icarus )
 
 /*
 -------------------------
-Open
+ReadHeader
 -------------------------
 */
 
-int CBlockStream::Open( char *buffer, long size )
+int CBlockStream::ReadHeader( char *buffer, long size, long *streamPos )
 {
 	char	id_header[sizeof(s_IBI_HEADER_ID)];
 	float	version;
-	
-	Init();
 
-	m_fileSize = size;
+	*streamPos = 0;
 
-	m_stream = buffer;
+	if ( size < (long) ( sizeof( id_header ) + sizeof( version ) ) )
+		return false;
 
 	for ( int i = 0; i < sizeof( id_header ); i++ )
 	{
-		id_header[i] = *(m_stream + m_streamPos++);
+		id_header[i] = *(buffer + (*streamPos)++);
 	}
 
-	version = *(float *) (m_stream + m_streamPos);
-	m_streamPos += sizeof( version );
+	version = *(float *) (buffer + *streamPos);
+	*streamPos += sizeof( version );
 
 	//Check for valid header
 	if ( strcmp( id_header, s_IBI_HEADER_ID ) )
-	{
-		Free();
 		return false;
-	}
 
 	//Check for valid version
 	if ( version != s_IBI_VERSION )
+		return false;
+
+	return true;
+}
+
+/*
+-------------------------
+Open
+-------------------------
+*/
+
+int CBlockStream::Open( char *buffer, long size, CIcarus* icarus )
+{
+	Init();
+
+	m_fileSize = size;
+
+	m_stream = buffer;
+
+	//Compiled the first time anything runs or precaches it, then shared
+	m_script = icarus->GetCompiledScript( buffer, size );
+
+	if ( m_script == NULL )
 	{
 		Free();
 		return false;
@@ -586,3 +597,193 @@ int CBlockStream::Open( char *buffer, long size )
 
 	return true;
 }
+
+/*
+===================================================================================================
+
+  CCompiledScript
+
+===================================================================================================
+*/
+
+/*
+-------------------------
+Compile
+
+Reads the IBI blocks the way the interpreter used to on every run
+-------------------------
+*/
+
+CCompiledScript *CCompiledScript::Compile( char *buffer, long size, CIcarus* icarus )
+{
+	typedef map < string, int >	intern_m;
+
+	IGameInterface*				game = icarus->GetGame();
+	vector < compiledBlock_t >	blocks;
+	vector < compiledMember_t >	members;
+	string						pool;
+	intern_m					interned;
+	long						streamPos;
+
+	if ( CBlockStream::ReadHeader( buffer, size, &streamPos ) == false )
+		return NULL;
+
+	const float	infinite = game->MaxFloat();
+
+	while ( streamPos < size )
+	{
+		compiledBlock_t	block;
+		int				numMembers;
+		int				getName = -1;	//Member that names the field of a get() inline
+
+		if ( streamPos + (long) ( sizeof( int ) * 2 + sizeof( unsigned char ) ) > size )
+			return NULL;
+
+		block.id	= *(int *) (buffer + streamPos);
+		streamPos += sizeof( block.id );
+
+		numMembers	= *(int *) (buffer + streamPos);
+		streamPos += sizeof( numMembers );
+
+		block.flags	= *(unsigned char*) (buffer + streamPos);
+		streamPos += sizeof( block.flags );
+
+		if ( numMembers < 0 )
+			return NULL;
+
+		block.firstMember	= members.size();
+		block.numMembers	= numMembers;
+
+		for ( int i = 0; i < numMembers; i++ )
+		{
+			compiledMember_t	member;
+			const char			*data;
+
+			if ( streamPos + (long) ( sizeof( int ) + sizeof( long ) ) > size )
+				return NULL;
+
+			member.id = *(int *) (buffer + streamPos);
+			streamPos += sizeof( int );
+
+			if ( member.id == CIcarus::ID_RANDOM )
+			{//special case, need to initialize this member's data to Q3_INFINITE so we can randomize the number only the first time random is checked when inside a wait
+				member.size = sizeof( float );
+				streamPos += sizeof( long );
+				data = (const char *) &infinite;
+			}
+			else
+			{
+				member.size = *(long *) (buffer + streamPos);
+				streamPos += sizeof( long );
+				data = buffer + streamPos;
+			}
+
+			if ( member.size < 0 || streamPos + member.size > size )
+				return NULL;
+
+			streamPos += member.size;
+
+			//Store each distinct value once, 4 byte aligned for the floats
+			string				value( data, member.size );
+			intern_m::iterator	ii = interned.find( value );
+
+			if ( ii != interned.end() )
+			{
+				member.offset = (*ii).second;
+			}
+			else
+			{
+				pool.append( ( 4 - ( pool.size() & 3 ) ) & 3, '\0' );
+				member.offset = pool.size();
+				pool.append( value );
+				interned[ value ] = member.offset;
+			}
+
+			//set( NAME, VALUE ) and get( TYPE, NAME ) names are looked up here, once
+			member.setID = IGameInterface::SETID_UNRESOLVED;
+
+			if ( member.id == CIcarus::ID_GET )
+			{
+				getName = i + 2;
+			}
+			else if ( ( ( block.id == CIcarus::ID_SET && i == 0 ) || i == getName ) &&
+					  ( member.id == CIcarus::TK_STRING || member.id == CIcarus::TK_IDENTIFIER ) &&
+					  member.size > 0 && data[ member.size - 1 ] == '\0' )
+			{
+				member.setID = game->GetSetID( data );
+			}
+
+			members.push_back( member );
+		}
+
+		blocks.push_back( block );
+	}
+
+	//All in one allocation
+	int	blocksSize	= blocks.size() * sizeof( compiledBlock_t );
+	int	membersSize	= members.size() * sizeof( compiledMember_t );
+
+	CCompiledScript	*script = new CCompiledScript;
+
+	script->m_numBlocks		= blocks.size();
+	script->m_numMembers	= members.size();
+	script->m_size			= size;
+	script->m_blocks		= (compiledBlock_t *) game->Malloc( blocksSize + membersSize + pool.size() + sizeof( int ) );
+	script->m_members		= (compiledMember_t *) ( (char *) script->m_blocks + blocksSize );
+	script->m_pool			= (char *) script->m_members + membersSize;
+
+	if ( blocksSize )
+		memcpy( script->m_blocks, &blocks[0], blocksSize );
+	if ( membersSize )
+		memcpy( script->m_members, &members[0], membersSize );
+	if ( pool.size() )
+		memcpy( script->m_pool, pool.data(), pool.size() );
+
+	return script;
+}
+
+/*
+-------------------------
+GetMember
+-------------------------
+*/
+
+const compiledMember_t *CCompiledScript::GetMember( const compiledBlock_t *block, int memberNum ) const
+{
+	if ( memberNum > block->numMembers-1 )
+	{
+		return NULL;
+	}
+	return &m_members[ block->firstMember + memberNum ];
+}
+
+/*
+-------------------------
+GetMemberData
+-------------------------
+*/
+
+void *CCompiledScript::GetMemberData( const compiledBlock_t *block, int memberNum ) const
+{
+	const compiledMember_t	*member = GetMember( block, memberNum );
+
+	if ( member == NULL )
+	{
+		return NULL;
+	}
+	return GetData( member );
+}
+
+/*
+-------------------------
+Free
+-------------------------
+*/
+
+void CCompiledScript::Free( IGameInterface* game )
+{
+	game->Free( m_blocks );
+	m_blocks = NULL;
+
+	delete this;
+}
@@ -24,10 +24,10 @@ public:
 	void Free(IGameInterface* game);
 
 	int WriteMember ( FILE * );				//Writes the member's data, in block format, to FILE *
-	int	ReadMember( char **, long *, CIcarus* icarus );		//Reads the member's data, in block format, from FILE *
 
 	void SetID( int id )		{	m_id = id;		}	//Set the ID member variable
 	void SetSize( int size )	{	m_size = size;	}	//Set the size member variable
+	void SetShared( int id, int size, void *data, int setID );	//Point at a compiled script's data instead of owning a copy
 
 	void GetInfo( int *, int *, void **);
 
@@ -39,6 +39,7 @@ public:
 	int	GetID( void )		const	{	return m_id;	}	//Get ID member variables
 	void *GetData( void )	const	{	return m_data;	}	//Get data member variable
 	int	GetSize( void )		const	{	return m_size;	}	//Get size member variable
+	int	GetSetID( void )	const	{	return m_setID;	}	//Get the set table ID of a set() / get() name
 
 	// Overloaded new operator.
 	inline void *operator new( size_t size )
@@ -57,7 +58,7 @@ public:
 	template <class T> void WriteData(T &data, CIcarus* icarus)
 	{
 		IGameInterface* game = icarus->GetGame();
-		if ( m_data )
+		if ( m_data && !m_shared )
 		{
 			game->Free( m_data );
 		}
@@ -65,12 +66,14 @@ public:
 		m_data = game->Malloc( sizeof(T) );
 		*((T *) m_data) = data;
 		m_size = sizeof(T);
+		m_shared = false;
+		m_setID = IGameInterface::SETID_UNRESOLVED;
 	}
 
 	template <class T> void WriteDataPointer(const T *data, int num, CIcarus* icarus)
 	{
 		IGameInterface* game =icarus->GetGame();
-		if ( m_data )
+		if ( m_data && !m_shared )
 		{
 			game->Free( m_data );
 		}
@@ -78,6 +81,8 @@ public:
 		m_data = game->Malloc( num*sizeof(T) );
 		memcpy( m_data, data, num*sizeof(T) );
 		m_size = num*sizeof(T);
+		m_shared = false;
+		m_setID = IGameInterface::SETID_UNRESOLVED;
 	}
 
 protected:
@@ -85,6 +90,8 @@ protected:
 	int		m_id;		//ID of the value contained in data
 	int		m_size;		//Size of the data member variable
 	void	*m_data;	//Data for this member
+	bool	m_shared;	//m_data belongs to a compiled script, copied the first time it's written to
+	int		m_setID;	//Set table ID, if this is a set() / get() name from a compiled script
 
 };
 	
@@ -158,6 +165,70 @@ protected:
 	unsigned char				m_flags;
 };
 
+// CCompiledScript
+
+// An IBI buffer lowered once into a single flat allocation, which every sequencer running the script reads from:
+//
+//	compiledBlock_t[numBlocks] | compiledMember_t[numMembers] | data pool
+//
+// Member data is interned in the pool, so each distinct string or value is stored once, and set() / get()
+// names carry their set table ID.
+
+typedef struct compiledBlock_s
+{
+	int				id;
+	int				firstMember;
+	int				numMembers;
+	unsigned char	flags;
+} compiledBlock_t;
+
+typedef struct compiledMember_s
+{
+	int				id;
+	int				size;
+	int				offset;		//Into the data pool
+	int				setID;		//IGameInterface::SETID_UNRESOLVED unless it's a set() / get() name
+} compiledMember_t;
+
+class CCompiledScript
+{
+public:
+
+	static CCompiledScript *Compile( char *buffer, long size, CIcarus* icarus );
+
+	void Free( IGameInterface* game );
+
+	int	GetNumBlocks( void )	const	{	return m_numBlocks;	}
+	int	GetSize( void )			const	{	return m_size;		}
+
+	const compiledBlock_t	*GetBlock( int blockNum )		const	{	return &m_blocks[ blockNum ];		}
+	void	*GetData( const compiledMember_t *member )		const	{	return m_pool + member->offset;	}
+
+	const compiledMember_t	*GetMember( const compiledBlock_t *block, int memberNum ) const;
+	void	*GetMemberData( const compiledBlock_t *block, int memberNum ) const;
+
+	// Overloaded new operator.
+	static void *operator new( size_t size )
+	{	// Allocate the memory.
+		return IGameInterface::GetGame()->Malloc( size );
+	}
+
+	// Overloaded delete operator.
+	static void operator delete( void *pRawData )
+	{	// Free the Memory.
+		IGameInterface::GetGame()->Free( pRawData );
+	}
+
+protected:
+
+	int					m_numBlocks;
+	int					m_numMembers;
+	int					m_size;			//Source buffer size, to spot a reused buffer
+	compiledBlock_t		*m_blocks;		//Start of the one allocation
+	compiledMember_t	*m_members;
+	char				*m_pool;
+};
+
 // CBlockStream
 
 class CBlockStream
@@ -167,7 +238,8 @@ public:
 	CBlockStream()
 	{
 		m_stream = NULL;
-		m_streamPos = 0;
+		m_script = NULL;
+		m_blockNum = 0;
 	}
 	~CBlockStream() {};
 
@@ -183,7 +255,9 @@ public:
 	int WriteBlock( CBlock *, CIcarus* icarus );	//Write the block out
 	int ReadBlock( CBlock *, CIcarus* icarus );	//Read the block in
 	
-	int Open( char *, long );	//Open a stream for reading / writing
+	int Open( char *, long, CIcarus* icarus );	//Open a stream for reading, from its compiled script
+
+	static int ReadHeader( char *, long, long * );	//Checks the IBI header and version, returns the position after them
 
 	// Overloaded new operator.
 	static void *operator new( size_t size )
@@ -203,7 +277,9 @@ protected:
 	char	m_fileName[CIcarus::MAX_FILENAME_LENGTH];	//Name of the current file
 
 	char	*m_stream;							//Stream of data to be parsed
-	long	m_streamPos;
+
+	CCompiledScript	*m_script;					//m_stream, compiled, which is what's actually read
+	int				m_blockNum;
 
 	static char*			s_IBI_EXT;
 	static char*			s_IBI_HEADER_ID;
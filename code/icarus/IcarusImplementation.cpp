@@ -76,6 +76,10 @@ CIcarus::CIcarus(int flavor) :
 
 	m_GUID = 0;
 
+	memset( m_timers, 0, sizeof( m_timers ) );
+	m_timerTime		= 0;
+	m_timerStarted	= false;
+
 #ifdef _DEBUG
 
 	m_DEBUG_NumSequencerAlloc		= 0;
@@ -139,6 +143,22 @@ void CIcarus::Delete( void )
 void CIcarus::Signal( const char *identifier )
 {
 	m_signals[ identifier ] = 1;
+
+	//Wake anything waiting for it, the first to run takes the signal as before
+	signalWait_m::iterator	swi = m_signalWaits.find( identifier );
+
+	if ( swi == m_signalWaits.end() )
+		return;
+
+	taskManager_v	waiting;
+	waiting.swap( (*swi).second );
+	m_signalWaits.erase( swi );
+
+	for ( int i = 0; i < waiting.size(); i++ )
+	{
+		waiting[i]->m_sleepSignal.erase();
+		WakeTaskManager( waiting[i] );
+	}
 }
 
 bool CIcarus::CheckSignal( const char *identifier )
@@ -162,6 +182,9 @@ void CIcarus::Free( void )
 {
 	sequencer_l::iterator	sri;
 
+	//Nothing is scheduled past this point
+	WakeAll();
+
 	//Delete any residual sequencers
 	STL_ITERATE( sri, m_sequencers )
 	{
@@ -197,6 +220,24 @@ void CIcarus::Free( void )
 	m_sequences.clear();
 
 	m_sequencerMap.clear();
+
+	//Nothing's pointing at the compiled scripts now
+	IGameInterface* game = IGameInterface::GetGame(m_flavor);
+	compiledScript_m::iterator	csi;
+
+	STL_ITERATE( csi, m_compiledScripts )
+	{
+		(*csi).second->Free( game );
+	}
+
+	m_compiledScripts.clear();
+
+	for ( int i = 0; i < m_oldCompiledScripts.size(); i++ )
+	{
+		m_oldCompiledScripts[i]->Free( game );
+	}
+
+	m_oldCompiledScripts.clear();
 }
 
 int CIcarus::GetIcarusID( int gameID )
@@ -330,32 +371,29 @@ int CIcarus::AllocateSequences( int numSequences, int *idTable )
 void CIcarus::Precache(char* buffer, long length)
 {
 	IGameInterface* game = IGameInterface::GetGame(m_flavor);
-	CBlockStream	stream;
-	CBlockMember	*blockMember;
-	CBlock			block;
+	CCompiledScript	*script = GetCompiledScript( buffer, length );
 
-	if ( stream.Open( buffer, length ) == 0 )
+	if ( script == NULL )
 		return;
 
+	const compiledBlock_t	*block;
 	const char	*sVal1, *sVal2;
 
-	//Now iterate through all blocks of the script, searching for keywords
-	while ( stream.BlockAvailable() )
+	//Now iterate through all blocks of the script, searching for keywords, straight from the compiled script
+	for ( int i = 0; i < script->GetNumBlocks(); i++ )
 	{
-		//Get a block
-		if ( stream.ReadBlock( &block, this ) == 0 )
-			return;
+		block = script->GetBlock( i );
 
 		//Determine what type of block this is
-		switch( block.GetBlockID() )
+		switch( block->id )
 		{
 		case ID_CAMERA:	// to cache ROFF files
 			{
-				float f = *(float *) block.GetMemberData( 0 );
+				float f = *(float *) script->GetMemberData( block, 0 );
 
 				if (f == TYPE_PATH)
 				{
-					sVal1 = (const char *) block.GetMemberData( 1 );
+					sVal1 = (const char *) script->GetMemberData( block, 1 );
 
 					game->PrecacheRoff(sVal1);
 				}
@@ -364,11 +402,11 @@ void CIcarus::Precache(char* buffer, long length)
 
 		case ID_PLAY:	// to cache ROFF files
 			
-			sVal1 = (const char *) block.GetMemberData( 0 );
+			sVal1 = (const char *) script->GetMemberData( block, 0 );
 
 			if (!stricmp(sVal1,"PLAY_ROFF"))
 			{
-				sVal1 = (const char *) block.GetMemberData( 1 );
+				sVal1 = (const char *) script->GetMemberData( block, 1 );
 
 				game->PrecacheRoff(sVal1);
 			}			
@@ -376,25 +414,23 @@ void CIcarus::Precache(char* buffer, long length)
 
 		//Run commands
 		case ID_RUN:
-			sVal1 = (const char *) block.GetMemberData( 0 );
+			sVal1 = (const char *) script->GetMemberData( block, 0 );
 			game->PrecacheScript( sVal1 );
 			break;
 		
 		case ID_SOUND:
-			sVal1 = (const char *) block.GetMemberData( 1 );	//0 is channel, 1 is filename
+			sVal1 = (const char *) script->GetMemberData( block, 1 );	//0 is channel, 1 is filename
 			game->PrecacheSound(sVal1);
 			break;
 
 		case ID_SET:
-			blockMember = block.GetMember( 0 );
-
 			//NOTENOTE: This will not catch special case get() inlines! (There's not really a good way to do that)
 
 			//Make sure we're testing against strings
-			if ( blockMember->GetID() == TK_STRING )
+			if ( script->GetMember( block, 0 )->id == TK_STRING )
 			{
-				sVal1 = (const char *) block.GetMemberData( 0 );
-				sVal2 = (const char *) block.GetMemberData( 1 );
+				sVal1 = (const char *) script->GetMemberData( block, 0 );
+				sVal2 = (const char *) script->GetMemberData( block, 1 );
 		
 				game->PrecacheFromSet( sVal1 , sVal2);
 			}
@@ -403,13 +439,40 @@ void CIcarus::Precache(char* buffer, long length)
 		default:
 			break;
 		}
+	}
+}
+
+/*
+-------------------------
+GetCompiledScript
+
+The buffers come from the game's script cache, so each one is compiled once and shared by every
+sequencer that runs it, for as long as this instance is around
+-------------------------
+*/
 
-		//Clean out the block for the next pass
-		block.Free(this);
+CCompiledScript *CIcarus::GetCompiledScript( char *buffer, long length )
+{
+	compiledScript_m::iterator	csi = m_compiledScripts.find( buffer );
+
+	if ( csi != m_compiledScripts.end() )
+	{
+		if ( (*csi).second->GetSize() == length )
+			return (*csi).second;
+
+		//Not the script it was, blocks from the old one may still be around though
+		m_oldCompiledScripts.push_back( (*csi).second );
+		m_compiledScripts.erase( csi );
 	}
 
-	//All done
-	stream.Free();
+	CCompiledScript	*script = CCompiledScript::Compile( buffer, length, this );
+
+	if ( script == NULL )
+		return NULL;
+
+	m_compiledScripts[ buffer ] = script;
+
+	return script;
 }
 
 CSequencer* CIcarus::FindSequencer(int sequencerID)
@@ -727,6 +790,9 @@ int CIcarus::Update(int icarusID)
 	CSequencer* sequencer = FindSequencer(icarusID);
 	if(sequencer)
 	{
+		//The first update of a frame wakes the task managers whose wait() is up
+		UpdateTimers( (int) GetGame()->GetTime() );
+
 		return sequencer->GetTaskManager()->Update(this);
 	}
 	return -1;
@@ -811,3 +877,191 @@ void CIcarus::BufferRead( void *pDstBuff, unsigned long ulNumBytesToRead )
 		m_ulBytesRead += ulNumBytesToRead;
 	}
 }
+
+/*
+=================================================
+
+  Scheduling
+
+  A task manager whose current wait() or waitsignal() can't complete
+  sleeps until its time comes up in the timer wheel, its signal is sent,
+  or one of its tasks completes.  Update does nothing while it sleeps,
+  so idle scripted ents don't cost anything each frame.
+
+=================================================
+*/
+
+void CIcarus::AddTimer( CTaskManager *taskManager )
+{
+	int	time = taskManager->m_sleepTime;
+	int	level;
+
+	//Beyond the wheel it wakes early and goes back to sleep
+	if ( time - m_timerTime >= ( 1 << ( TIMER_BITS * TIMER_LEVELS ) ) )
+	{
+		time = m_timerTime + ( 1 << ( TIMER_BITS * TIMER_LEVELS ) ) - 1;
+	}
+
+	//The first level whose slot for the time hasn't been passed yet
+	for ( level = 0; level < TIMER_LEVELS - 1; level++ )
+	{
+		if ( ( time >> ( TIMER_BITS * level ) ) - ( m_timerTime >> ( TIMER_BITS * level ) ) < TIMER_SLOTS )
+			break;
+	}
+
+	CTaskManager	**slot = &m_timers[level][( time >> ( TIMER_BITS * level ) ) & TIMER_MASK];
+
+	taskManager->m_timerNext = *slot;
+	taskManager->m_timerPrev = slot;
+	if ( *slot )
+	{
+		(*slot)->m_timerPrev = &taskManager->m_timerNext;
+	}
+	*slot = taskManager;
+}
+
+void CIcarus::RemoveTimer( CTaskManager *taskManager )
+{
+	if ( taskManager->m_timerPrev == NULL )
+		return;
+
+	*taskManager->m_timerPrev = taskManager->m_timerNext;
+	if ( taskManager->m_timerNext )
+	{
+		taskManager->m_timerNext->m_timerPrev = taskManager->m_timerPrev;
+	}
+
+	taskManager->m_timerNext = NULL;
+	taskManager->m_timerPrev = NULL;
+}
+
+//Moves the current slot of a level down to the finer levels
+void CIcarus::CascadeTimers( int level )
+{
+	CTaskManager	**slot = &m_timers[level][( m_timerTime >> ( TIMER_BITS * level ) ) & TIMER_MASK];
+	CTaskManager	*taskManager = *slot;
+	CTaskManager	*next;
+
+	*slot = NULL;
+
+	for ( ; taskManager; taskManager = next )
+	{
+		next = taskManager->m_timerNext;
+		taskManager->m_timerNext = NULL;
+		taskManager->m_timerPrev = NULL;
+		AddTimer( taskManager );
+	}
+}
+
+void CIcarus::UpdateTimers( int time )
+{
+	if ( time == m_timerTime && m_timerStarted )
+		return;
+
+	//First call, or time jumped (a load, say), everyone checks their wait again
+	if ( m_timerStarted == false || time < m_timerTime || time - m_timerTime >= ( 1 << ( TIMER_BITS * 2 ) ) )
+	{
+		WakeAll();
+		m_timerTime		= time;
+		m_timerStarted	= true;
+		return;
+	}
+
+	while ( m_timerTime < time )
+	{
+		m_timerTime++;
+
+		if ( ( m_timerTime & TIMER_MASK ) == 0 )
+		{
+			if ( ( ( m_timerTime >> TIMER_BITS ) & TIMER_MASK ) == 0 )
+			{
+				CascadeTimers( 2 );
+			}
+			CascadeTimers( 1 );
+		}
+
+		CTaskManager	**slot = &m_timers[0][m_timerTime & TIMER_MASK];
+
+		while ( *slot )
+		{
+			WakeTaskManager( *slot );
+		}
+	}
+}
+
+void CIcarus::SleepTaskManager( CTaskManager *taskManager )
+{
+	switch ( taskManager->m_sleepType )
+	{
+	case TASK_SLEEP_TIMER:
+
+		if ( m_timerStarted == false || taskManager->m_sleepTime <= m_timerTime )
+			return;	//close enough to poll
+
+		taskManager->m_sleeping = true;
+		AddTimer( taskManager );
+		break;
+
+	case TASK_SLEEP_TASK:
+
+		taskManager->m_sleeping = true;
+		break;
+
+	case TASK_SLEEP_SIGNAL:
+
+		taskManager->m_sleeping = true;
+		m_signalWaits[ taskManager->m_sleepSignal ].push_back( taskManager );
+		break;
+	}
+}
+
+void CIcarus::WakeTaskManager( CTaskManager *taskManager )
+{
+	RemoveTimer( taskManager );
+
+	if ( taskManager->m_sleepSignal.empty() == false )
+	{
+		signalWait_m::iterator	swi = m_signalWaits.find( taskManager->m_sleepSignal );
+
+		if ( swi != m_signalWaits.end() )
+		{
+			taskManager_v	&waiting = (*swi).second;
+
+			taskManager_v::iterator	wi = std::find( waiting.begin(), waiting.end(), taskManager );
+			if ( wi != waiting.end() )
+			{
+				waiting.erase( wi );
+			}
+
+			if ( waiting.empty() )
+			{
+				m_signalWaits.erase( swi );
+			}
+		}
+
+		taskManager->m_sleepSignal.erase();
+	}
+
+	taskManager->m_sleeping = false;
+}
+
+void CIcarus::WakeAll( void )
+{
+	sequencer_l::iterator	sri;
+
+	STL_ITERATE( sri, m_sequencers )
+	{
+		CTaskManager	*taskManager = (*sri)->GetTaskManager();
+
+		if ( taskManager )
+		{
+			taskManager->m_sleeping		= false;
+			taskManager->m_timerNext	= NULL;
+			taskManager->m_timerPrev	= NULL;
+			taskManager->m_sleepSignal.erase();
+		}
+	}
+
+	memset( m_timers, 0, sizeof( m_timers ) );
+	m_signalWaits.clear();
+}
@@ -24,6 +24,8 @@ class CSequencer;
 
 class CIcarusSequencer;
 class CIcarusSequence;
+class CTaskManager;
+class CCompiledScript;
 
 class CIcarus : public IIcarusInterface
 {
@@ -39,6 +41,15 @@ public:
 		MAX_FILENAME_LENGTH		= 1024,
 	};
 
+	//Hierarchical timer wheel, level n slots are 1 << ( TIMER_BITS * n ) msec apart
+	enum
+	{
+		TIMER_BITS				= 8,
+		TIMER_SLOTS				= 1 << TIMER_BITS,
+		TIMER_MASK				= TIMER_SLOTS - 1,
+		TIMER_LEVELS			= 3,
+	};
+
 protected:
 	int						m_flavor;
 	int						m_nextSequencerID;
@@ -56,6 +67,22 @@ protected:
 	typedef std::map < string, unsigned char >	signal_m;
 	signal_m				m_signals;
 
+	//Timer wheel of task managers sleeping in a timed wait()
+	CTaskManager			*m_timers[TIMER_LEVELS][TIMER_SLOTS];
+	int						m_timerTime;
+	bool					m_timerStarted;
+
+	//Scripts compiled so far, by the game's buffer for them, shared by everything that runs them
+	typedef std::map < char *, CCompiledScript * >	compiledScript_m;
+	typedef std::vector < CCompiledScript * >		compiledScript_v;
+	compiledScript_m		m_compiledScripts;
+	compiledScript_v		m_oldCompiledScripts;	//Replaced but maybe still in use, freed with the rest
+
+	//Task managers sleeping in a waitsignal(), by signal name
+	typedef std::vector < CTaskManager * >			taskManager_v;
+	typedef std::map < string, taskManager_v >	signalWait_m;
+	signalWait_m			m_signalWaits;
+
 	static double ICARUS_VERSION;
 
 #ifdef _DEBUG
@@ -99,6 +126,7 @@ public:
 	int AllocateSequences( int numSequences, int *idTable );
 	CSequencer* FindSequencer(int sequencerID);
 	CSequence* GetSequence();
+	CCompiledScript* GetCompiledScript( char* buffer, long length );
 
 protected:
 	int SaveSequenceIDTable();
@@ -116,6 +144,18 @@ public:
 	bool CheckSignal( const char *identifier );
 	void ClearSignal( const char *identifier );
 
+	void UpdateTimers( int time );
+	void SleepTaskManager( CTaskManager *taskManager );
+	void WakeTaskManager( CTaskManager *taskManager );
+
+protected:
+	void AddTimer( CTaskManager *taskManager );
+	void RemoveTimer( CTaskManager *taskManager );
+	void CascadeTimers( int level );
+	void WakeAll();
+
+public:
+
 	// Overloaded new operator.
 	inline void *operator new( size_t size )
 	{
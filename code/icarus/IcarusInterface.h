@@ -55,6 +55,9 @@ public:
 	//For system-wide prints
 	enum e_DebugPrintLevel { WL_ERROR = 1, WL_WARNING, WL_VERBOSE, WL_DEBUG };
 
+	// A set() or get() name that hasn't been looked up with GetSetID() (which returns -1 for names it doesn't know).
+	enum { SETID_UNRESOLVED = -2 };
+
 	// How many flavors are needed.
 	static int s_IcarusFlavorsNeeded;
 
@@ -85,7 +88,7 @@ public:
 	virtual void	Lerp2Pos( int taskID, int gameID, float origin[3], float angles[3], float duration ) = 0;
 	virtual void	Lerp2Angles( int taskID, int gameID, float angles[3], float duration ) = 0;
 	virtual int		GetTag( int gameID, const char *name, int lookup, float info[3] ) = 0;
-	virtual void	Set( int taskID, int gameID, const char *type_name, const char *data ) = 0;
+	virtual void	Set( int taskID, int gameID, const char *type_name, const char *data, int setID = SETID_UNRESOLVED ) = 0;
 	virtual void	Use( int gameID, const char *name ) = 0;
 	virtual void	Activate( int gameID, const char *name ) = 0;
 	virtual void	Deactivate( int gameID, const char *name ) = 0;
@@ -108,10 +111,12 @@ public:
 	virtual void	CameraDisable( void ) = 0;
 	virtual void	CameraShake( float intensity, int duration ) = 0;
 
-	virtual int		GetFloat( int gameID, const char *name, float *value ) = 0;
+	virtual int		GetFloat( int gameID, const char *name, float *value, int setID = SETID_UNRESOLVED ) = 0;
 	// Should be float return type?
-	virtual int		GetVector( int gameID, const char *name, float value[3] ) = 0;
-	virtual int		GetString( int gameID, const char *name, char **value ) = 0;
+	virtual int		GetVector( int gameID, const char *name, float value[3], int setID = SETID_UNRESOLVED ) = 0;
+	virtual int		GetString( int gameID, const char *name, char **value, int setID = SETID_UNRESOLVED ) = 0;
+	// Looks a set() / get() name up once, when the script using it is compiled, so the calls above don't have to.
+	virtual int		GetSetID( const char *name ) = 0;
 
 	virtual int		Evaluate( int p1Type, const char *p1, int p2Type, const char *p2, int operatorType ) = 0;
 
@@ -370,7 +370,7 @@ int CSequencer::Run( char *buffer, long size, CIcarus* icarus )
 	blockStream = AddStream();
 	
 	//Open the stream as an IBI stream
-	if (!blockStream->stream->Open( buffer, size ))
+	if (!blockStream->stream->Open( buffer, size, icarus ))
 	{
 		game->DebugPrint(IGameInterface::WL_ERROR, "invalid stream" );
 		return SEQ_FAILED;
@@ -424,7 +424,7 @@ int CSequencer::ParseRun( CBlock *block , CIcarus* icarus)
 	new_stream = AddStream();
 
 	//Begin streaming the file
-	if (!new_stream->stream->Open( buffer, buffer_size ))
+	if (!new_stream->stream->Open( buffer, buffer_size, icarus ))
 	{
 		game->DebugPrint(IGameInterface::WL_ERROR, "invalid stream" );
 		block->Free(icarus);
@@ -677,6 +677,7 @@ int CSequencer::ParseAffect( CBlock *block, bstream_t *bstream, CIcarus* icarus
 		int				id;
 		char			*p1 = NULL;
 		char			*name = 0;
+		int				setID = IGameInterface::SETID_UNRESOLVED;
 		CBlockMember	*bm = NULL;
 		//
 		//	Get the first parameter (this should be the get)
@@ -700,13 +701,14 @@ int CSequencer::ParseAffect( CBlock *block, bstream_t *bstream, CIcarus* icarus
 				//get( TYPE, NAME )
 				type = (int) (*(float *) block->GetMemberData( 1 ));
 				name = (char *) block->GetMemberData( 2 );
+				setID = (block->GetMember( 2 ))->GetSetID();
 
 				switch ( type ) // what type are they attempting to get
 				{
 			
 				case CIcarus::TK_STRING:
 						//only string is acceptable for affect, store result in p1
-						if ( game->GetString( m_ownerID, name, &p1 ) == false)
+						if ( game->GetString( m_ownerID, name, &p1, setID ) == false)
 						{
 							block->Free(icarus);
 							delete block;
@@ -1173,10 +1175,12 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 	{
 			int		type;
 			char	*name;
+			int		setID;
 
 			//get( TYPE, NAME )
 			type = (int) (*(float *) block->GetMemberData( memberNum++ ));
-			name = (char *) block->GetMemberData( memberNum++ );
+			name = (char *) block->GetMemberData( memberNum );
+			setID = (block->GetMember( memberNum++ ))->GetSetID();
 
 			//Get the type returned and hold onto it
 			t1 = type;
@@ -1187,7 +1191,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 				{
 					float	fVal;
 
-					if ( game->GetFloat( m_ownerID, name, &fVal ) == false)
+					if ( game->GetFloat( m_ownerID, name, &fVal, setID ) == false)
 						return false;
 
 					sprintf( (char *) tempString1, "%.3f", fVal );
@@ -1200,7 +1204,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 				{
 					float	fVal;
 
-					if ( game->GetFloat( m_ownerID, name, &fVal ) == false)
+					if ( game->GetFloat( m_ownerID, name, &fVal, setID ) == false)
 						return false;
 
 					sprintf( (char *) tempString1, "%d", (int) fVal );
@@ -1210,7 +1214,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 
 			case CIcarus::TK_STRING:
 
-				if ( game->GetString( m_ownerID, name, &p1 ) == false)
+				if ( game->GetString( m_ownerID, name, &p1, setID ) == false)
 					return false;
 			
 				break;
@@ -1219,7 +1223,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 				{
 					vec3_t	vVal;
 
-					if ( game->GetVector( m_ownerID, name, vVal ) == false)
+					if ( game->GetVector( m_ownerID, name, vVal, setID ) == false)
 						return false;
 
 					sprintf( (char *) tempString1, "%.3f %.3f %.3f", vVal[0], vVal[1], vVal[2] );
@@ -1343,10 +1347,12 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 	{
 			int		type;
 			char	*name;
+			int		setID;
 
 			//get( TYPE, NAME )
 			type = (int) (*(float *) block->GetMemberData( memberNum++ ));
-			name = (char *) block->GetMemberData( memberNum++ );
+			name = (char *) block->GetMemberData( memberNum );
+			setID = (block->GetMember( memberNum++ ))->GetSetID();
 
 			//Get the type returned and hold onto it
 			t2 = type;
@@ -1357,7 +1363,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 				{
 					float	fVal;
 
-					if ( game->GetFloat( m_ownerID, name, &fVal ) == false)
+					if ( game->GetFloat( m_ownerID, name, &fVal, setID ) == false)
 						return false;
 
 					sprintf( (char *) tempString2, "%.3f", fVal );
@@ -1370,7 +1376,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 				{
 					float	fVal;
 
-					if ( game->GetFloat( m_ownerID, name, &fVal ) == false)
+					if ( game->GetFloat( m_ownerID, name, &fVal, setID ) == false)
 						return false;
 
 					sprintf( (char *) tempString2, "%d", (int) fVal );
@@ -1380,7 +1386,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 
 			case CIcarus::TK_STRING:
 
-				if ( game->GetString( m_ownerID, name, &p2 ) == false)
+				if ( game->GetString( m_ownerID, name, &p2, setID ) == false)
 					return false;
 			
 				break;
@@ -1389,7 +1395,7 @@ int CSequencer::EvaluateConditional( CBlock *block , CIcarus* icarus)
 				{
 					vec3_t	vVal;
 
-					if ( game->GetVector( m_ownerID, name, vVal ) == false)
+					if ( game->GetVector( m_ownerID, name, vVal, setID ) == false)
 						return false;
 
 					sprintf( (char *) tempString2, "%.3f %.3f %.3f", vVal[0], vVal[1], vVal[2] );
@@ -1828,6 +1834,7 @@ void CSequencer::CheckAffect( CBlock **command , CIcarus* icarus)
 			int				id;
 			char			*p1 = NULL;
 			char			*name = 0;
+			int				setID = IGameInterface::SETID_UNRESOLVED;
 			CBlockMember	*bm = NULL;
 			//
 			//	Get the first parameter (this should be the get)
@@ -1850,14 +1857,15 @@ void CSequencer::CheckAffect( CBlock **command , CIcarus* icarus)
 
 					//get( TYPE, NAME )
 					type = (int) (*(float *) block->GetMemberData( memberNum++ ));
-					name = (char *) block->GetMemberData( memberNum++ );
+					name = (char *) block->GetMemberData( memberNum );
+					setID = (block->GetMember( memberNum++ ))->GetSetID();
 
 					switch ( type ) // what type are they attempting to get
 					{
 				
 						case CIcarus::TK_STRING:
 							//only string is acceptable for affect, store result in p1
-							if ( game->GetString( m_ownerID, name, &p1 ) == false)
+							if ( game->GetString( m_ownerID, name, &p1, setID ) == false)
 							{
 								return;
 							}
@@ -149,6 +149,14 @@ CTaskManager::CTaskManager( void )
 {
 	static int uniqueID = 0;
 	m_id = uniqueID++;
+
+	m_owner			= NULL;
+	m_sleeping		= false;
+	m_sleepType		= TASK_SLEEP_NONE;
+	m_sleepTime		= 0;
+	m_sleepIcarus	= NULL;
+	m_timerNext		= NULL;
+	m_timerPrev		= NULL;
 }
 
 CTaskManager::~CTaskManager( void )
@@ -178,6 +186,8 @@ int	CTaskManager::Init( CSequencer *owner )
 	if ( owner == NULL )
 		return TASK_FAILED;
 
+	Wake();
+
 	m_tasks.clear();
 	m_owner		= owner;
 	m_ownerID	= owner->GetOwnerID();
@@ -199,6 +209,9 @@ int CTaskManager::Free( void )
 	tasks_l::iterator		ti;
 
 	assert(!m_resident);	//don't free me, i'm currently running!
+
+	Wake();
+
 	//Clear out all pending tasks
 	for ( ti = m_tasks.begin(); ti != m_tasks.end(); ti++ )
 	{
@@ -327,6 +340,13 @@ int CTaskManager::Update( CIcarus* icarus )
 	{
 		return TASK_FAILED;
 	}
+
+	//Nothing to do until its wait is over
+	if ( m_sleeping )
+	{
+		return TASK_OK;
+	}
+
 	m_count = 0;	//Needed for runaway init
 	m_resident = true;
 
@@ -337,6 +357,39 @@ int CTaskManager::Update( CIcarus* icarus )
 	return returnVal;
 }
 
+/*
+-------------------------
+Sleep
+
+Called with the wait() or waitsignal() that couldn't complete back on the task list
+-------------------------
+*/
+
+void CTaskManager::Sleep( CIcarus* icarus )
+{
+	m_sleepIcarus = icarus;
+	icarus->SleepTaskManager( this );
+}
+
+/*
+-------------------------
+Wake
+
+Makes the next Update look at the tasks again
+-------------------------
+*/
+
+void CTaskManager::Wake( void )
+{
+	if ( m_sleepIcarus == NULL )
+		return;
+
+	if ( m_sleeping || m_timerPrev || m_sleepSignal.empty() == false )
+	{
+		m_sleepIcarus->WakeTaskManager( this );
+	}
+}
+
 /*
 -------------------------
 Check
@@ -360,6 +413,7 @@ GetFloat
 int CTaskManager::GetFloat( int entID, CBlock *block, int &memberNum, float &value, CIcarus* icarus )
 {
 	char	*name;
+	int		setID;
 	int		type;
 
 	//See if this is a get() command replacement
@@ -370,7 +424,8 @@ int CTaskManager::GetFloat( int entID, CBlock *block, int &memberNum, float &val
 
 		//get( TYPE, NAME )
 		type = (int) (*(float *) block->GetMemberData( memberNum++ ));
-		name = (char *) block->GetMemberData( memberNum++ );
+		name = (char *) block->GetMemberData( memberNum );
+		setID = (block->GetMember( memberNum++ ))->GetSetID();
 
 		//TODO: Emit warning
 		if ( type != CIcarus::TK_FLOAT )
@@ -379,7 +434,7 @@ int CTaskManager::GetFloat( int entID, CBlock *block, int &memberNum, float &val
 			return false; 
 		}
 
-		return icarus->GetGame()->GetFloat( entID, name, &value );
+		return icarus->GetGame()->GetFloat( entID, name, &value, setID );
 	}
 
 	//Look for a randomLava() inline call
@@ -433,6 +488,7 @@ GetVector
 int CTaskManager::GetVector( int entID, CBlock *block, int &memberNum, vec3_t &value, CIcarus* icarus )
 {
 	char	*name;
+	int		setID;
 	int		type, i;
 
 	//See if this is a get() command replacement
@@ -443,7 +499,8 @@ int CTaskManager::GetVector( int entID, CBlock *block, int &memberNum, vec3_t &v
 
 		//get( TYPE, NAME )
 		type = (int) (*(float *) block->GetMemberData( memberNum++ ));
-		name = (char *) block->GetMemberData( memberNum++ );
+		name = (char *) block->GetMemberData( memberNum );
+		setID = (block->GetMember( memberNum++ ))->GetSetID();
 
 		//TODO: Emit warning
 		if ( type != CIcarus::TK_VECTOR )
@@ -451,7 +508,7 @@ int CTaskManager::GetVector( int entID, CBlock *block, int &memberNum, vec3_t &v
 			icarus->GetGame()->DebugPrint(IGameInterface::WL_ERROR, "Get() call tried to return a non-VECTOR parameter!\n" );
 		}
 
-		return icarus->GetGame()->GetVector( entID, name, value );
+		return icarus->GetGame()->GetVector( entID, name, value, setID );
 	}
 
 	//Look for a randomLava() inline call
@@ -528,6 +585,7 @@ int CTaskManager::Get( int entID, CBlock *block, int &memberNum, char **value, C
 	static	char	tempBuffer[128];	//FIXME: EEEK!
 	vec3_t			vector;
 	char			*name, *tagName;
+	int				setID;
 	float			tagLookup;
 	int				type;
 
@@ -539,7 +597,8 @@ int CTaskManager::Get( int entID, CBlock *block, int &memberNum, char **value, C
 
 		//get( TYPE, NAME )
 		type = (int) (*(float *) block->GetMemberData( memberNum++ ));
-		name = (char *) block->GetMemberData( memberNum++ );
+		name = (char *) block->GetMemberData( memberNum );
+		setID = (block->GetMember( memberNum++ ))->GetSetID();
 
 		//Format the return properly
 		//FIXME: This is probably doing double formatting in certain cases...
@@ -547,7 +606,7 @@ int CTaskManager::Get( int entID, CBlock *block, int &memberNum, char **value, C
 		switch ( type )
 		{
 		case CIcarus::TK_STRING:
-			if ( icarus->GetGame()->GetString( entID, name, value ) == false )
+			if ( icarus->GetGame()->GetString( entID, name, value, setID ) == false )
 			{
 				icarus->GetGame()->DebugPrint(IGameInterface::WL_ERROR, "Get() parameter \"%s\" could not be found!\n", name );
 				return false;
@@ -560,7 +619,7 @@ int CTaskManager::Get( int entID, CBlock *block, int &memberNum, char **value, C
 			{
 				float	temp;
 
-				if ( icarus->GetGame()->GetFloat( entID, name, &temp ) == false )
+				if ( icarus->GetGame()->GetFloat( entID, name, &temp, setID ) == false )
 				{
 					icarus->GetGame()->DebugPrint(IGameInterface::WL_ERROR, "Get() parameter \"%s\" could not be found!\n", name );	
 					return false;
@@ -577,7 +636,7 @@ int CTaskManager::Get( int entID, CBlock *block, int &memberNum, char **value, C
 			{
 				vec3_t	vval;
 
-				if ( icarus->GetGame()->GetVector( entID, name, vval )  == false )
+				if ( icarus->GetGame()->GetVector( entID, name, vval, setID )  == false )
 				{
 					icarus->GetGame()->DebugPrint(IGameInterface::WL_ERROR, "Get() parameter \"%s\" could not be found!\n", name );	
 					return false;
@@ -733,6 +792,7 @@ int	CTaskManager::Go( CIcarus* icarus )
 			if ( completed == false )
 			{
 				PushTask( task, CSequence::PUSH_BACK );
+				Sleep( icarus );
 				return TASK_OK;
 			}
 
@@ -748,6 +808,7 @@ int	CTaskManager::Go( CIcarus* icarus )
 			if ( completed == false )
 			{
 				PushTask( task, CSequence::PUSH_BACK );
+				Sleep( icarus );
 				return TASK_OK;
 			}
 
@@ -836,6 +897,8 @@ int	CTaskManager::SetCommand( CBlock *command, int type, CIcarus* icarus )
 {
 	CTask	*task = CTask::Create( m_GUID++, command );
 
+	Wake();
+
 	//If this is part of a task group, add it in
 	if ( m_curGroup )
 	{
@@ -907,6 +970,9 @@ int CTaskManager::Completed( int id )
 {
 	taskGroup_v::iterator	tgi;
 
+	//A wait() on its task group may be over
+	Wake();
+
 	//Mark the task as completed
 	for ( tgi = m_taskGroups.begin(); tgi != m_taskGroups.end(); tgi++ )
 	{
@@ -945,6 +1011,8 @@ CBlock *CTaskManager::RecallTask( void )
 {
 	CTask	*task;
 
+	Wake();
+
 	task = PopTask( CSequence::POP_BACK );
 
 	if ( task )
@@ -1033,6 +1101,8 @@ GetCurrentTask
 
 CBlock *CTaskManager::GetCurrentTask( void )
 {
+	Wake();
+
 	CTask *task = PopTask( CSequence::POP_BACK );
 
 	if ( task == NULL )
@@ -1062,6 +1132,7 @@ int CTaskManager::Wait( CTask *task, bool &completed , CIcarus* icarus )
 	int				memberNum = 0;
 
 	completed = false;
+	m_sleepType = TASK_SLEEP_NONE;
 
 	bm = block->GetMember( 0 );
 
@@ -1086,6 +1157,9 @@ int CTaskManager::Wait( CTask *task, bool &completed , CIcarus* icarus )
 		}
 
 		completed = group->Complete();
+
+		//Its tasks completing wake it
+		m_sleepType = TASK_SLEEP_TASK;
 	}
 	else	//Otherwise it's a time completion wait
 	{
@@ -1126,6 +1200,11 @@ int CTaskManager::Wait( CTask *task, bool &completed , CIcarus* icarus )
 				bm->SetData( &dwtime, sizeof( dwtime ), icarus );
 			}
 		}
+		else if ( bm->GetID() == CIcarus::ID_RANDOM || bm->GetID() == CIcarus::TK_FLOAT || bm->GetID() == CIcarus::TK_INT )
+		{//a get() could change, so only fixed times sleep, until the first time the check above passes
+			m_sleepType = TASK_SLEEP_TIMER;
+			m_sleepTime = task->GetTimeStamp() + (int) dwtime + 1;
+		}
 	}
 
 	return TASK_OK;
@@ -1144,6 +1223,7 @@ int CTaskManager::WaitSignal( CTask *task, bool &completed , CIcarus* icarus )
 	int		memberNum = 0;
 
 	completed = false;
+	m_sleepType = TASK_SLEEP_NONE;
 
 	ICARUS_VALIDATE( Get( m_ownerID, block, memberNum, &sVal , icarus) );
 
@@ -1158,6 +1238,11 @@ int CTaskManager::WaitSignal( CTask *task, bool &completed , CIcarus* icarus )
 		completed = true;
 		icarus->ClearSignal( sVal );
 	}
+	else if ( (block->GetMember( 0 ))->GetID() == CIcarus::TK_STRING )
+	{//a get() could change, so only fixed names sleep
+		m_sleepType		= TASK_SLEEP_SIGNAL;
+		m_sleepSignal	= sVal;
+	}
 
 	return TASK_OK;
 }
@@ -1479,12 +1564,13 @@ int CTaskManager::Set( CTask *task, CIcarus* icarus )
 	CBlock			*block = task->GetBlock();
 	char			*sVal, *sVal2;
 	int				memberNum = 0;
+	int				setID = (block->GetMember( 0 ))->GetSetID();
 
 	ICARUS_VALIDATE( Get( m_ownerID, block, memberNum, &sVal, icarus ) );
 	ICARUS_VALIDATE( Get( m_ownerID, block, memberNum, &sVal2, icarus ) );
 
 	icarus->GetGame()->DebugPrint(IGameInterface::WL_DEBUG, "%4d set( \"%s\", \"%s\" ); [%d]", m_ownerID, sVal, sVal2, task->GetTimeStamp() );
-	icarus->GetGame()->Set( task->GetGUID(), m_ownerID, sVal, sVal2 );
+	icarus->GetGame()->Set( task->GetGUID(), m_ownerID, sVal, sVal2, setID );
 
 	return TASK_OK;
 }
@@ -15,6 +15,15 @@ enum
 	TASK_RETURN_FAILED,
 };
 
+//How a task manager is waiting for its current wait() or waitsignal()
+enum
+{
+	TASK_SLEEP_NONE,	//poll it every frame
+	TASK_SLEEP_TIMER,	//until m_sleepTime
+	TASK_SLEEP_TASK,	//until one of its tasks completes
+	TASK_SLEEP_SIGNAL,	//until m_sleepSignal is signalled
+};
+
 enum 
 {
 	TASK_OK,
@@ -115,6 +124,7 @@ class CSequencer;
 
 class CTaskManager
 {
+	friend class CIcarus;	//schedules the sleeping task managers
 
 	typedef	map < int, CTask * >			taskID_m;
 	typedef map < string, CTaskGroup * >	taskGroupName_m;
@@ -144,6 +154,8 @@ public:
 	int Update( CIcarus* icarus );
 	int IsRunning( void ) const { return(!m_tasks.empty()); };
 	bool IsResident( void ) const { return m_resident;};
+	bool IsSleeping( void ) const { return m_sleeping;};
+	void Wake( void );
 
 	CTaskGroup *AddTaskGroup( const char *name , CIcarus* icarus);
 	CTaskGroup *GetTaskGroup( const char *name, CIcarus* icarus);
@@ -201,6 +213,8 @@ protected:
 
 	int	SaveCommand( CBlock *block );
 
+	void Sleep( CIcarus* icarus );
+
 	// Variables
 
 	CSequencer				*m_owner;
@@ -221,6 +235,15 @@ protected:
 
 	int						m_id;
 
+	//Set while the current wait can't complete, Update does nothing until something wakes it
+	bool					m_sleeping;
+	int						m_sleepType;
+	int						m_sleepTime;
+	string					m_sleepSignal;
+	CIcarus					*m_sleepIcarus;		//whose timer wheel or signal wait list it's in
+	CTaskManager			*m_timerNext;
+	CTaskManager			**m_timerPrev;
+
 	//CTask	*m_waitTask;		//Global pointer to the current task that is waiting for callback completion
 };
 
@@ -123,6 +123,19 @@ qboolean Sys_CopyFile(const char* lpExistingFileName, const char* lpNewFileName,
 	return bOk;
 }
 
+/*
+==================
+Sys_ReplaceFile
+
+Moves the file over any existing one in a single step, so readers only ever
+see the old file or the new one.  Safe to call from a Sys_CreateThread thread
+==================
+*/
+qboolean Sys_ReplaceFile( const char *psSrcFileName, const char *psDstFileName )
+{
+	return (qboolean)( rename( psSrcFileName, psDstFileName ) == 0 );
+}
+
 /*
 ==================
 Sys_LowPhysicalMemory()
@@ -133,6 +146,90 @@ qboolean Sys_LowPhysicalMemory()
 	return qfalse;
 }
 
+/*
+================
+Sys_CreateThread
+
+Threads must not call Com_Error, Com_Printf or Z_Malloc
+================
+*/
+typedef struct {
+	threadFunc_t	function;
+	void			*data;
+} threadStart_t;
+
+static void *Sys_ThreadStart( void *arg )
+{
+	threadStart_t	start = *(threadStart_t *)arg;
+
+	free( arg );
+	start.function( start.data );
+	return NULL;
+}
+
+void *Sys_CreateThread( threadFunc_t function, void *data )
+{
+	pthread_t		*thread;
+	threadStart_t	*start;
+
+	thread = (pthread_t *)malloc( sizeof( *thread ) );
+	start = (threadStart_t *)malloc( sizeof( *start ) );
+	start->function = function;
+	start->data = data;
+
+	if ( pthread_create( thread, NULL, Sys_ThreadStart, start ) ) {
+		free( thread );
+		free( start );
+		return NULL;
+	}
+	return thread;
+}
+
+void Sys_JoinThread( void *thread )
+{
+	pthread_join( *(pthread_t *)thread, NULL );
+	free( thread );
+}
+
+void *Sys_CreateSemaphore( int initialCount )
+{
+	sem_t	*sem;
+
+	sem = (sem_t *)malloc( sizeof( *sem ) );
+	if ( sem_init( sem, 0, initialCount ) ) {
+		free( sem );
+		return NULL;
+	}
+	return sem;
+}
+
+void Sys_DestroySemaphore( void *semaphore )
+{
+	sem_destroy( (sem_t *)semaphore );
+	free( semaphore );
+}
+
+void Sys_SemaphoreWait( void *semaphore )
+{
+	while ( sem_wait( (sem_t *)semaphore ) && errno == EINTR ) {
+	}
+}
+
+void Sys_SemaphorePost( void *semaphore )
+{
+	sem_post( (sem_t *)semaphore );
+}
+
+int Sys_AtomicAdd( volatile int *value, int add )
+{
+	return __sync_add_and_fetch( value, add );
+}
+
+int Sys_AtomicCompareExchange( volatile int *value, int exchange, int comparand )
+{
+	return __sync_val_compare_and_swap( value, comparand, exchange );
+}
+
 
 /*
 ==================
@@ -127,6 +127,19 @@ qboolean Sys_CopyFile(const char* lpExistingFileName, const char* lpNewFileName,
 	return bOk;
 }
 
+/*
+==================
+Sys_ReplaceFile
+
+Moves the file over any existing one in a single step, so readers only ever
+see the old file or the new one.  Safe to call from a Sys_CreateThread thread
+==================
+*/
+qboolean Sys_ReplaceFile( const char *psSrcFileName, const char *psDstFileName )
+{
+	return (qboolean)( rename( psSrcFileName, psDstFileName ) == 0 );
+}
+
 /*
 ==================
 Sys_LowPhysicalMemory()
@@ -137,6 +150,110 @@ qboolean Sys_LowPhysicalMemory()
 	return qfalse;
 }
 
+/*
+================
+Sys_CreateThread
+
+Threads must not call Com_Error, Com_Printf or Z_Malloc
+================
+*/
+typedef struct {
+	threadFunc_t	function;
+	void			*data;
+} threadStart_t;
+
+static void *Sys_ThreadStart( void *arg )
+{
+	threadStart_t	start = *(threadStart_t *)arg;
+
+	free( arg );
+	start.function( start.data );
+	return NULL;
+}
+
+void *Sys_CreateThread( threadFunc_t function, void *data )
+{
+	pthread_t		*thread;
+	threadStart_t	*start;
+
+	thread = (pthread_t *)malloc( sizeof( *thread ) );
+	start = (threadStart_t *)malloc( sizeof( *start ) );
+	start->function = function;
+	start->data = data;
+
+	if ( pthread_create( thread, NULL, Sys_ThreadStart, start ) ) {
+		free( thread );
+		free( start );
+		return NULL;
+	}
+	return thread;
+}
+
+void Sys_JoinThread( void *thread )
+{
+	pthread_join( *(pthread_t *)thread, NULL );
+	free( thread );
+}
+
+// OS X doesn't implement unnamed sem_t, so build one from a condition
+typedef struct {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	int				count;
+} semaphore_t;
+
+void *Sys_CreateSemaphore( int initialCount )
+{
+	semaphore_t	*sem;
+
+	sem = (semaphore_t *)malloc( sizeof( *sem ) );
+	pthread_mutex_init( &sem->mutex, NULL );
+	pthread_cond_init( &sem->cond, NULL );
+	sem->count = initialCount;
+	return sem;
+}
+
+void Sys_DestroySemaphore( void *semaphore )
+{
+	semaphore_t	*sem = (semaphore_t *)semaphore;
+
+	pthread_cond_destroy( &sem->cond );
+	pthread_mutex_destroy( &sem->mutex );
+	free( sem );
+}
+
+void Sys_SemaphoreWait( void *semaphore )
+{
+	semaphore_t	*sem = (semaphore_t *)semaphore;
+
+	pthread_mutex_lock( &sem->mutex );
+	while ( !sem->count ) {
+		pthread_cond_wait( &sem->cond, &sem->mutex );
+	}
+	sem->count--;
+	pthread_mutex_unlock( &sem->mutex );
+}
+
+void Sys_SemaphorePost( void *semaphore )
+{
+	semaphore_t	*sem = (semaphore_t *)semaphore;
+
+	pthread_mutex_lock( &sem->mutex );
+	sem->count++;
+	pthread_cond_signal( &sem->cond );
+	pthread_mutex_unlock( &sem->mutex );
+}
+
+int Sys_AtomicAdd( volatile int *value, int add )
+{
+	return __sync_add_and_fetch( value, add );
+}
+
+int Sys_AtomicCompareExchange( volatile int *value, int exchange, int comparand )
+{
+	return __sync_val_compare_and_swap( value, comparand, exchange );
+}
+
 
 /*
 ==================
@@ -264,6 +264,29 @@ qboolean FS_MoveUserGenFile( const char *filename_src, const char *filename_dst
 	}
 }
 
+// returns the OS path FS_FOpenFileWrite() would use for "filename" (eg "saves/blah.sav"), having created its
+//	directories, for code that writes the file itself off the main thread. Result is a temp buffer, copy it...
+//
+char *FS_UserGenOSPath( const char *filename )
+{
+	char		*ospath;
+
+	if ( !fs_searchpaths ) 
+	{
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
+	}
+
+	ospath = FS_BuildOSPath( fs_basepath->string, fs_gamedir, filename );
+
+	if ( fs_debug->integer ) 
+	{
+		Com_Printf( "FS_UserGenOSPath: %s\n", ospath );
+	}
+
+	FS_CreatePath( ospath );	// (also lowercases it on linux, same as FS_FOpenFileWrite)
+	return ospath;
+}
+
 /*
 ===========
 FS_FOpenFileWrite
@@ -479,6 +479,7 @@ int		FS_Seek( fileHandle_t f, long offset, int origin );
 //
 void		FS_DeleteUserGenFile( const char *filename );
 qboolean	FS_MoveUserGenFile  ( const char *filename_src, const char *filename_dst );
+char		*FS_UserGenOSPath   ( const char *filename );
 
 /*
 ==============================================================
@@ -799,6 +800,19 @@ void	Sys_EndProfiling( void );
 qboolean Sys_LowPhysicalMemory();
 qboolean Sys_FileOutOfDate( LPCSTR psFinalFileName /* dest */, LPCSTR psDataFileName /* src */ );
 qboolean Sys_CopyFile(LPCSTR lpExistingFileName, LPCSTR lpNewFileName, qboolean bOverwrite);
+qboolean Sys_ReplaceFile( LPCSTR psSrcFileName, LPCSTR psDstFileName );	// atomic rename over an existing file
+
+// threads for work that shouldn't hold up the main loop,
+// handles are opaque and returned as NULL on failure
+typedef void (*threadFunc_t)( void *data );
+void	*Sys_CreateThread( threadFunc_t function, void *data );
+void	Sys_JoinThread( void *thread );
+void	*Sys_CreateSemaphore( int initialCount );
+void	Sys_DestroySemaphore( void *semaphore );
+void	Sys_SemaphoreWait( void *semaphore );
+void	Sys_SemaphorePost( void *semaphore );
+int		Sys_AtomicAdd( volatile int *value, int add );	// returns the new value
+int		Sys_AtomicCompareExchange( volatile int *value, int exchange, int comparand );	// returns the old value
 
 
 //byte*	SCR_GetScreenshot(qboolean *qValid);
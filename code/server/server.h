@@ -167,6 +167,7 @@ extern	cvar_t	*sv_mapChecksum;
 extern	cvar_t	*sv_serverid;
 extern  cvar_t	*sv_testsave;
 extern  cvar_t	*sv_compress_saved_games;
+extern  cvar_t	*sv_saveThread;
 
 //===========================================================
 
@@ -296,13 +297,17 @@ void SV_LoadTransition_f(void);
 void SV_SaveGame_f(void);
 void SV_WipeGame_f(void);
 qboolean SV_TryLoadTransition( const char *mapname );
-qboolean SG_WriteSavegame(const char *psPathlessBaseName, qboolean qbAutosave);
+typedef void (*saveGameDone_t)(const char *psPathlessBaseName, qboolean qbWritten);
+qboolean SG_WriteSavegame(const char *psPathlessBaseName, qboolean qbAutosave, saveGameDone_t pfnDone = NULL);
 qboolean SG_ReadSavegame(const char *psPathlessBaseName);
 void SG_WipeSavegame(const char *psPathlessBaseName);
 qboolean SG_Append(unsigned long chid, const void *data, int length);
 int SG_Read			(unsigned long chid, void *pvAddress, int iLength, void **ppvAddressPtr = NULL);
 int SG_ReadOptional	(unsigned long chid, void *pvAddress, int iLength, void **ppvAddressPtr = NULL);
 void SG_Shutdown();
+void SG_UpdateWrites(void);
+void SG_FinishWrites(void);
+void SG_ShutdownWrites(void);
 void SG_TestSave(void);
 //
 // note that this version number does not mean that a savegame with the same version can necessarily be loaded,
@@ -310,7 +315,8 @@ void SG_TestSave(void);
 // What it's used for is for things like mission pack etc if we need to distinguish "street-copy" savegames from
 //	any new enhanced ones that need to ask for new chunks during loading.
 //
-#define iSAVEGAME_VERSION 1
+#define iSAVEGAME_VERSION 2
+#define iSAVEGAME_VERSION_RLE 1	// before chunks could be LZ compressed, still loads fine
 int SG_Version(void);	// call this to know what version number a successfully-opened savegame file was
 //
 extern SavedGameJustLoaded_e eSavedGameJustLoaded;
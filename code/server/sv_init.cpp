@@ -510,6 +510,7 @@ void SV_Init (void) {
 	sv_mapChecksum = Cvar_Get ("sv_mapChecksum", "", CVAR_ROM);
 	sv_testsave = Cvar_Get ("sv_testsave", "0", 0);
 	sv_compress_saved_games = Cvar_Get ("sv_compress_saved_games", "1", 0);
+	sv_saveThread = Cvar_Get ("sv_saveThread", "1", 0);
 
 	// Only allocated once, no point in moving it around and fragmenting
 	// create a heap for Ghoul2 to use for game side model vertex transforms used in collision detection
@@ -567,6 +568,9 @@ void SV_Shutdown( char *finalmsg ) {
 
 	//Com_Printf( "----- Server Shutdown -----\n" );
 
+	// any saves still being written have to reach the disk first
+	SG_ShutdownWrites();
+
 	if ( svs.clients && !com_errorEntered ) {
 		SV_FinalMessage( finalmsg );
 	}
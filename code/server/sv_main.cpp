@@ -30,7 +30,8 @@ cvar_t	*sv_spawntarget;
 cvar_t	*sv_mapChecksum;
 cvar_t	*sv_serverid;
 cvar_t	*sv_testsave;			// Run the savegame enumeration every game frame
-cvar_t	*sv_compress_saved_games;	// compress the saved games on the way out (only affect saver, loader can read both)
+cvar_t	*sv_compress_saved_games;	// compress the saved games on the way out (only affect saver, loader can read both), 1 = LZ, 2 = RLE
+cvar_t	*sv_saveThread;				// compress and write saved games on their own thread
 
 /*
 =============================================================================
@@ -482,6 +483,9 @@ void SV_Frame( int msec,float fractionMsec ) {
 		return;
 	}
 
+	// report any saves the writer thread has finished, even while paused
+	SG_UpdateWrites();
+
  	extern void SE_CheckForLanguageUpdates(void);
 	SE_CheckForLanguageUpdates();	// will fast-return else load different language if menu changed it
 
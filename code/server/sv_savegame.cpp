@@ -85,7 +85,14 @@ typedef const char * LPCSTR;
 
 
 static char *SG_GetSaveGameMapName(const char *psPathlessBaseName);
+#ifdef _XBOX
 static void CompressMem_FreeScratchBuffer(void);
+#else
+static void SG_BeginWrite(LPCSTR psPathlessBaseName);
+static void SG_AppendToWrite(unsigned long chid, const void *pvData, int iLength);
+static qboolean SG_CloseWrite(saveGameDone_t pfnDone);
+static void SG_AbandonWrite(void);
+#endif
 
 
 #ifdef SG_PROFILE
@@ -173,6 +180,7 @@ void SG_WipeSavegame( LPCSTR psPathlessBaseName )
 #ifndef _XBOX
 	LPCSTR psLocalFilename  = SG_AddSavePath( psPathlessBaseName );
 	
+	SG_FinishWrites();	// else a save still on its way out could put it back
 	FS_DeleteUserGenFile( psLocalFilename );
 #else
 	unsigned short namebuffer[filepathlength];
@@ -183,24 +191,9 @@ void SG_WipeSavegame( LPCSTR psPathlessBaseName )
 #endif
 }
 
+#ifdef _XBOX
 static qboolean SG_Move( LPCSTR psPathlessBaseName_Src, LPCSTR psPathlessBaseName_Dst )
 {
-
-
-#ifndef _XBOX
-	LPCSTR psLocalFilename_Src = SG_AddSavePath( psPathlessBaseName_Src );
-	LPCSTR psLocalFilename_Dst = SG_AddSavePath( psPathlessBaseName_Dst );
-
-	qboolean qbCopyWentOk = FS_MoveUserGenFile( psLocalFilename_Src, psLocalFilename_Dst );
-
-	if (!qbCopyWentOk)
-	{
-		Com_Printf(S_COLOR_RED "Error during savegame-rename. Check \"%s\" for write-protect or disk full!\n", psLocalFilename_Dst );
-		return qfalse;
-	}
-
-	return qtrue;
-#else
 	char psLocalFilenameSrc[filepathlength];
 	char psLocalFilenameDest[filepathlength];
 	unsigned short widecharstring[filepathlength];
@@ -223,8 +216,8 @@ static qboolean SG_Move( LPCSTR psPathlessBaseName_Src, LPCSTR psPathlessBaseNam
 	
 	return qtrue;
 	
-#endif
 }
+#endif
 
 
 /* JLFSAVEGAME used to find if there is a file on the xbox */
@@ -294,21 +287,16 @@ static qboolean SG_Create( LPCSTR psPathlessBaseName )
 		CopyFile("d:\\base\\media\\defaultsaveimage.xbx", psScreenshotFilename, FALSE);
 	}
 
-#else
-	SG_WipeSavegame( psPathlessBaseName );
-	LPCSTR psLocalFilename = SG_AddSavePath( psPathlessBaseName );		
-	fhSaveGame = FS_FOpenFileWrite( psLocalFilename );
-#endif
-
-#ifdef _XBOX
 	if (!sg_Handle)
-#else
-	if(!fhSaveGame)
-#endif
 	{
 		Com_Printf(GetString_FailedToOpenSaveGame(psLocalFilename,qfalse));//S_COLOR_RED "Failed to create new savegame file \"%s\"\n", psLocalFilename );
 		return qfalse;
 	}
+#else
+	// chunks go to memory from here, SG_CloseWrite() hands them over to be written...
+	//
+	SG_BeginWrite( psPathlessBaseName );
+#endif
 
 #ifdef SG_PROFILE
 	assert( save_info.empty() );
@@ -331,6 +319,10 @@ void SG_Shutdown()
 		fhSaveGame = NULL;
 	}
 
+#ifndef _XBOX
+	SG_AbandonWrite();	// in case the error came while the game was writing its chunks
+#endif
+
 	eSavedGameJustLoaded = eNO;	// important to do this if we ERR_DROP during loading, else next map you load after
 								//	a bad save-file you'll arrive at dead :-)
 
@@ -374,19 +366,9 @@ qboolean SG_CloseWrite()
 
 
 
-qboolean SG_Close()
-{
-#ifdef _XBOX
-	CloseHandle(sg_Handle);
-	sg_Handle = NULL;
-
-#else
-	assert( fhSaveGame );	
-	FS_FCloseFile( fhSaveGame );
-#endif
-	fhSaveGame = NULL;
-
 #ifdef SG_PROFILE
+static void SG_PrintProfile(void)
+{
 	if (!sv_testsave->integer)
 	{
 		CChidInfo_t::iterator it;
@@ -404,9 +386,28 @@ qboolean SG_Close()
 		Com_DPrintf(S_COLOR_CYAN "================================\n");
 		save_info.clear();
 	}
+}
+#endif
+
+qboolean SG_Close()
+{
+#ifdef _XBOX
+	CloseHandle(sg_Handle);
+	sg_Handle = NULL;
+
+#else
+	assert( fhSaveGame );	
+	FS_FCloseFile( fhSaveGame );
+#endif
+	fhSaveGame = NULL;
+
+#ifdef SG_PROFILE
+	SG_PrintProfile();
 #endif
 
+#ifdef _XBOX
 	CompressMem_FreeScratchBuffer();
+#endif
 	return qtrue;
 }
 
@@ -422,6 +423,9 @@ qboolean SG_Open( LPCSTR psPathlessBaseName )
 	{
 		return qfalse;
 	}
+#ifndef _XBOX
+	SG_FinishWrites();	// it may be one that's still being written
+#endif
 //JLFSAVEGAME
 
 #ifdef _XBOX
@@ -470,7 +474,7 @@ qboolean SG_Open( LPCSTR psPathlessBaseName )
 #endif
 	giSaveGameVersion=-1;//jic
 	SG_Read('_VER', &giSaveGameVersion, sizeof(giSaveGameVersion));
-	if (giSaveGameVersion != iSAVEGAME_VERSION)
+	if (giSaveGameVersion != iSAVEGAME_VERSION && giSaveGameVersion != iSAVEGAME_VERSION_RLE)
 	{
 		SG_Close();
 		Com_Printf (S_COLOR_RED "File \"%s\" has version # %d (expecting %d)\n",psPathlessBaseName, giSaveGameVersion, iSAVEGAME_VERSION);
@@ -627,6 +631,20 @@ void SV_LoadGame_f(void)
 
 qboolean SG_GameAllowedToSaveHere(qboolean inCamera);
 
+// called once the save is on disk (or isn't), which may be a few frames after SG_WriteSavegame() returns...
+//
+static void SV_SaveGame_Done(const char *psPathlessBaseName, qboolean qbWritten)
+{
+	if (qbWritten)
+	{
+		Com_Printf (S_COLOR_CYAN "%s.\n",SE_GetString("MENUS_DONE"));
+	}
+	else
+	{
+		Com_Printf (S_COLOR_RED "%s.\n",SE_GetString("MENUS_FAILED_TO_OPEN_SAVEGAME"));
+	}
+}
+
 
 //JLF notes
 //	save game will be in charge of creating a new directory
@@ -699,11 +717,7 @@ void SV_SaveGame_f(void)
 
 	Com_Printf (S_COLOR_CYAN "%s \"%s\"...\n", SE_GetString("CON_TEXT_SAVING_GAME"), psFilename);
 
-	if (SG_WriteSavegame(psFilename, qfalse))
-	{
-		Com_Printf (S_COLOR_CYAN "%s.\n",SE_GetString("MENUS_DONE"));
-	}
-	else
+	if (!SG_WriteSavegame(psFilename, qfalse, SV_SaveGame_Done))
 	{
 		Com_Printf (S_COLOR_RED "%s.\n",SE_GetString("MENUS_FAILED_TO_OPEN_SAVEGAME"));
 	}
@@ -1173,7 +1187,10 @@ qboolean SG_GameAllowedToSaveHere(qboolean inCamera)
 	return ge->GameAllowedToSaveHere();
 }
 
-qboolean SG_WriteSavegame(const char *psPathlessBaseName, qboolean qbAutosave)
+// with sv_saveThread the file is compressed and written on the writer thread, so a qtrue return only means
+//	the game's state has been captured, pfnDone (if any) gets told whether it actually made it to disk...
+//
+qboolean SG_WriteSavegame(const char *psPathlessBaseName, qboolean qbAutosave, saveGameDone_t pfnDone /* = NULL */)
 {	
 	if (!qbAutosave && !SG_GameAllowedToSaveHere(qfalse))	//full check
 		return qfalse;	// this prevents people saving via quick-save now during cinematics
@@ -1218,10 +1235,9 @@ qboolean SG_WriteSavegame(const char *psPathlessBaseName, qboolean qbAutosave)
 		SG_StoreSaveGameComment(va("--> %s <--",psMapName));
 	}
 
-	if(!SG_Create( "current" ))
+	if(!SG_Create( psPathlessBaseName ))
 			{
-		Com_Printf (GetString_FailedToOpenSaveGame("current",qfalse));//S_COLOR_RED "Failed to create savegame\n");
-		SG_WipeSavegame( "current" );
+		Com_Printf (GetString_FailedToOpenSaveGame(psPathlessBaseName,qfalse));//S_COLOR_RED "Failed to create savegame\n");
 		sv_testsave->integer = iPrevTestSave;
 		return qfalse;
 	}
@@ -1250,19 +1266,27 @@ qboolean SG_WriteSavegame(const char *psPathlessBaseName, qboolean qbAutosave)
 	ge->WriteLevel(qbAutosave);	// always done now, but ent saver only does player if auto
 #ifdef _XBOX
 	SG_CloseWrite();
-#else
-	SG_Close();
-#endif
 	if (gbSGWriteFailed)
 	{
 		Com_Printf (GetString_FailedToOpenSaveGame("current",qfalse));//S_COLOR_RED "Failed to write savegame!\n");
 		SG_WipeSavegame( "current" );
 		sv_testsave->integer = iPrevTestSave;
+		if (pfnDone)
+		{
+			pfnDone(psPathlessBaseName, qfalse);
+		}
 		return qfalse;
 	}
 
 	SG_Move( "current", psPathlessBaseName );
 
+	if (pfnDone)
+	{
+		pfnDone(psPathlessBaseName, qtrue);
+	}
+#else
+	SG_CloseWrite( pfnDone );
+#endif
 
 	sv_testsave->integer = iPrevTestSave;
 	return qtrue;
@@ -1432,6 +1456,199 @@ qboolean Verify_RLE(const byte *pOut, const byte *pIn, int iDecompressedBytesRem
 }
 
 
+// LZ77 along the lines of LZ4, a lot better than RLE on entity data and still quick. Each sequence is a token byte
+//	(literal count << 4 | match length - iLZ_MIN_MATCH), more count bytes while they're 255 if the literal count was
+//	15+, the literals, the match offset (16 bit, little endian), then more length bytes if the match length was 15+.
+//	The last sequence is literals only...
+//
+#define iLZ_MIN_MATCH	4
+#define iLZ_MAX_OFFSET	65535
+#define iLZ_HASH_BITS	14
+#define iLZ_HASH_SIZE	(1<<iLZ_HASH_BITS)
+
+// marks an LZ block in a compressed chunk's length field, else it's RLE...
+//
+#define iSG_COMPRESSED_LZ	0x80000000
+
+static unsigned int LZ_Read32(const byte *p)
+{
+	unsigned int ui;
+	memcpy(&ui, p, sizeof(ui));
+	return ui;
+}
+
+static byte *LZ_WriteLength(byte *pOut, int iLength)
+{
+	for (iLength -= 15; iLength >= 255; iLength -= 255)
+	{
+		*pOut++ = 255;
+	}
+	*pOut++ = (byte) iLength;
+	return pOut;
+}
+
+// fails as soon as the length passes iMaxLength, so a run of 255s can't overflow it...
+//
+static qboolean LZ_ReadLength(const byte *&pIn, const byte *pInEnd, int &iLength, int iMaxLength)
+{
+	int b;
+	do
+	{
+		if (pIn >= pInEnd)
+			return qfalse;
+		b = *pIn++;
+		iLength += b;
+		if (iLength > iMaxLength)
+			return qfalse;
+	}
+	while (b == 255);
+
+	return qtrue;
+}
+
+// returns the compressed length, or -1 if it wouldn't fit in iMaxOut bytes...
+//
+int Compress_LZ(const byte *pIn, int iLength, byte *pOut, int iMaxOut, int *piHashTable)
+{
+	const byte	*pInEnd		= pIn + iLength;
+	const byte	*pAnchor	= pIn;	// start of the literals not written yet
+	const byte	*p			= pIn;
+	const byte	*pOutStart	= pOut;
+	const byte	*pOutEnd	= pOut + iMaxOut;
+	int			iLiterals;
+
+	for (int i=0; i<iLZ_HASH_SIZE; i++)
+	{
+		piHashTable[i] = -1;
+	}
+
+	while (p + iLZ_MIN_MATCH <= pInEnd)
+	{
+		unsigned int	uiSeq	= LZ_Read32(p);
+		int				iHash	= (int)((uiSeq * 2654435761U) >> (32 - iLZ_HASH_BITS));
+		int				iRef	= piHashTable[iHash];
+
+		piHashTable[iHash] = p - pIn;
+
+		if (iRef < 0 || (p - pIn) - iRef > iLZ_MAX_OFFSET || LZ_Read32(pIn + iRef) != uiSeq)
+		{
+			p++;
+			continue;
+		}
+
+		// got one, see how far it goes...
+		//
+		const byte *pMatch	= pIn + iRef + iLZ_MIN_MATCH;
+		const byte *pEnd	= p + iLZ_MIN_MATCH;
+		while (pEnd < pInEnd && *pEnd == *pMatch)
+		{
+			pEnd++;
+			pMatch++;
+		}
+
+		iLiterals		= p - pAnchor;
+		int iMatch		= (pEnd - p) - iLZ_MIN_MATCH;
+		int iOffset		= (p - pIn) - iRef;
+
+		if (pOutEnd - pOut < 1 + iLiterals/255 + 1 + iLiterals + 2 + iMatch/255 + 1)
+			return -1;
+
+		*pOut++ = (byte)(((iLiterals < 15 ? iLiterals : 15) << 4) | (iMatch < 15 ? iMatch : 15));
+		if (iLiterals >= 15)
+		{
+			pOut = LZ_WriteLength(pOut, iLiterals);
+		}
+		memcpy(pOut, pAnchor, iLiterals);
+		pOut += iLiterals;
+		*pOut++ = (byte)(iOffset & 0xFF);
+		*pOut++ = (byte)(iOffset >> 8);
+		if (iMatch >= 15)
+		{
+			pOut = LZ_WriteLength(pOut, iMatch);
+		}
+
+		p = pAnchor = pEnd;
+	}
+
+	// and whatever's left...
+	//
+	iLiterals = pInEnd - pAnchor;
+
+	if (pOutEnd - pOut < 1 + iLiterals/255 + 1 + iLiterals)
+		return -1;
+
+	*pOut++ = (byte)((iLiterals < 15 ? iLiterals : 15) << 4);
+	if (iLiterals >= 15)
+	{
+		pOut = LZ_WriteLength(pOut, iLiterals);
+	}
+	memcpy(pOut, pAnchor, iLiterals);
+	pOut += iLiterals;
+
+	return pOut - pOutStart;
+}
+
+// returns qfalse if the block's bad, but never writes past iDecompressedLength either way...
+//
+qboolean DeCompress_LZ(byte *pOut, const byte *pIn, int iCompressedLength, int iDecompressedLength)
+{
+	const byte	*pInEnd		= pIn + iCompressedLength;
+	const byte	*pOutStart	= pOut;
+	const byte	*pOutEnd	= pOut + iDecompressedLength;
+
+	while (pIn < pInEnd)
+	{
+		int iToken = *pIn++;
+		int iCount = iToken >> 4;
+		int iMaxLiterals = (pInEnd - pIn < pOutEnd - pOut) ? (pInEnd - pIn) : (pOutEnd - pOut);
+
+		if (iCount == 15 && !LZ_ReadLength(pIn, pInEnd, iCount, iMaxLiterals))
+			return qfalse;
+		if (iCount > pInEnd - pIn || iCount > pOutEnd - pOut)
+			return qfalse;
+		memcpy(pOut, pIn, iCount);
+		pOut += iCount;
+		pIn  += iCount;
+
+		if (pIn == pInEnd)
+			break;	// last sequence, no match
+
+		if (pInEnd - pIn < 2)
+			return qfalse;
+		int iOffset = pIn[0] | (pIn[1] << 8);
+		pIn += 2;
+		if (iOffset == 0 || iOffset > pOut - pOutStart)
+			return qfalse;
+
+		iCount = iToken & 15;
+		if (iCount == 15 && !LZ_ReadLength(pIn, pInEnd, iCount, (pOutEnd - pOut) - iLZ_MIN_MATCH))
+			return qfalse;
+		iCount += iLZ_MIN_MATCH;
+		if (iCount > pOutEnd - pOut)
+			return qfalse;
+
+		// (can overlap what it's writing, so a byte at a time)
+		const byte *pMatch = pOut - iOffset;
+		while (iCount--)
+		{
+			*pOut++ = *pMatch++;
+		}
+	}
+
+	return (qboolean)(pOut == pOutEnd);
+}
+
+
+// sv_compress_saved_games values...
+//
+enum
+{
+	SG_CODEC_NONE = 0,
+	SG_CODEC_LZ,
+	SG_CODEC_RLE
+};
+
+#ifdef _XBOX
 byte *gpbCompBlock = NULL;
 int   giCompBlockSize = 0;
 static void CompressMem_FreeScratchBuffer(void)
@@ -1458,35 +1675,466 @@ static byte *CompressMem_AllocScratchBuffer(int iSize)
 
 	return gpbCompBlock;
 }
+#endif
 
 // returns -1 for compression-not-worth-it, else compressed length...
 //
-int CompressMem(byte *pbData, int iLength, byte *&pbOut)
+// pbOut needs room for iLength*2 bytes (it'll never grow to 2* size, but the LZ check decompresses into the
+//	second half), piHashTable for iLZ_HASH_SIZE ints. Touches nothing else, so the writer thread can use it.
+//
+static int CompressMem(const byte *pbData, int iLength, byte *pbOut, int *piHashTable, int iCodec)
 { 	
-	if (!sv_compress_saved_games->integer)
-		return -1;
+	int iOutputLength;
 
-	// malloc enough to cope with uncompressable data (it'll never grow to 2* size, so)...
-	//
-	pbOut = CompressMem_AllocScratchBuffer(iLength*2);	
-	//
-	// compress it...
-	//
-	int iOutputLength = Compress_RLE(pbData, iLength, pbOut);
-	//
-	// worth compressing?...
-	//
-	if (iOutputLength >= iLength)
-		return -1;
+	switch (iCodec)
+	{
+		case SG_CODEC_LZ:
+			//
+			// compress it, only worth it if it shrinks...
+			//
+			iOutputLength = Compress_LZ(pbData, iLength, pbOut, iLength - 1, piHashTable);
+			if (iOutputLength == -1)
+				return -1;
+			//
+			// compression code works? (decompress it again and compare, for safety)...
+			//
+			if (!DeCompress_LZ(pbOut + iLength, pbOut, iOutputLength, iLength) || memcmp(pbOut + iLength, pbData, iLength))
+				return -1;
+
+			return iOutputLength;
+
+		case SG_CODEC_RLE:
+			//
+			// compress it...
+			//
+			iOutputLength = Compress_RLE(pbData, iLength, pbOut);
+			//
+			// worth compressing?...
+			//
+			if (iOutputLength >= iLength)
+				return -1;
+			//
+			// compression code works? (I'd hope this is always the case, but for safety)...
+			//
+			if (!Verify_RLE(pbData, pbOut, iLength))
+				return -1;
+
+			return iOutputLength;
+	}
+
+	return -1;
+}
+
+#ifndef _XBOX
+/*
+Savegame writer
+
+SG_Create() takes one of two write slots, and every SG_Append() chunk goes into its arena as
+[chid][length][data], uncompressed.  SG_CloseWrite() queues the slot for the writer thread, which
+checksums, compresses and writes the chunks exactly as SG_Append() used to, into "<save>.tmp", then
+Sys_ReplaceFile()s that over the real save, so a failed or interrupted save leaves the old one alone.
+The next save fills the other slot meanwhile and only waits if both are still queued.
+
+Each save's done callback runs on the main thread, from SG_UpdateWrites() every server frame, or from
+whatever has to wait for the writer: SG_Open(), SG_WipeSavegame(), SG_ShutdownWrites().  The writer
+never touches the zone, the filesystem or cvars, the main thread sets up everything it needs.  With
+sv_saveThread 0, or if the thread can't start, the same writes happen on the spot.
+*/
+
+#define iSG_WRITE_SLOTS		2
+#define iSG_ARENA_MIN_SIZE	(256*1024)
+
+typedef struct
+{
+	char			sPathlessBaseName[MAX_QPATH];
+	char			sOSPath[MAX_OSPATH];
+	char			sOSPathTemp[MAX_OSPATH];
+	saveGameDone_t	pfnDone;
+
+	byte			*pbArena;			// chunks as [chid][length][data]
+	int				iArenaSize;
+	int				iArenaUsed;
+	int				iLargestChunk;
+
+	byte			*pbScratch;			// writer's compression workspace, iLargestChunk*2...
+	int				*piHashTable;		// ... then iLZ_HASH_SIZE ints
+	int				iCodec;				// sv_compress_saved_games, when it was queued
+
+	qboolean		qbInUse;			// main thread only
+	qboolean		qbWritten;			// set by the writer
+} sgWrite_t;
+
+static sgWrite_t	sg_write[iSG_WRITE_SLOTS];
+static sgWrite_t	*sg_pWriteFilling;					// slot SG_Append() is filling, NULL if not saving
+static sgWrite_t	*sg_pWriteQueue[iSG_WRITE_SLOTS];	// ring, in the order they were queued
+static int			sg_iWritesQueued;					// main thread only
+static int			sg_iWritesReaped;					// main thread only
+static int			sg_iWritesTaken;					// writer thread only
+static volatile int	sg_iWritesDone;						// only moved by the writer thread
+static volatile int	sg_iWriteQuit;
+static int			sg_iArenaSize = iSG_ARENA_MIN_SIZE;	// grows to fit, so next time's one alloc
+static void			*sg_writeThread;
+static void			*sg_writeWake;						// posted per queued slot
+static void			*sg_writeDone;						// posted per written slot
+static qboolean		sg_qbWriteThreadFailed;
+
+/*
+-------------------------
+SG_WriteFile
+
+Writer thread (or main thread, inline)
+-------------------------
+*/
+static void SG_WriteFile( sgWrite_t *pWrite )
+{
+	FILE		*f = fopen( pWrite->sOSPathTemp, "wb" );
+	qboolean	qbOk = (qboolean)(f != NULL);
+	const byte	*pb = pWrite->pbArena;
+	const byte	*pbEnd = pb + pWrite->iArenaUsed;
+
+	while ( qbOk && pb < pbEnd )
+	{
+		unsigned long	chid;
+		int				iLength;
+		unsigned int	uiCksum;
+		unsigned int	uiSaved;
+
+		memcpy( &chid, pb, sizeof(chid) );
+		pb += sizeof(chid);
+		memcpy( &iLength, pb, sizeof(iLength) );
+		pb += sizeof(iLength);
+
+		const byte *pvData = pb;
+		pb += iLength;
+
+		uiCksum = Com_BlockChecksum (pvData, iLength);
+
+		uiSaved  = fwrite( &chid, 1, sizeof(chid), f );
+
+		int iCompressedLength = CompressMem( pvData, iLength, pWrite->pbScratch, pWrite->piHashTable, pWrite->iCodec );
+		if (iCompressedLength != -1)
+		{
+			// compressed...  (write length field out as -ve, and say which codec in the compressed length)
+			//
+			int				iNegLength = -iLength;
+			unsigned int	uiCompressedLength = iCompressedLength | (pWrite->iCodec == SG_CODEC_LZ ? iSG_COMPRESSED_LZ : 0);
+
+			uiSaved += fwrite( &iNegLength,			1, sizeof(iNegLength),			f );
+			uiSaved += fwrite( &uiCompressedLength, 1, sizeof(uiCompressedLength),	f );
+			uiSaved += fwrite( pWrite->pbScratch,	1, iCompressedLength,			f );
+			uiSaved += fwrite( &uiCksum,			1, sizeof(uiCksum),				f );
+
+			qbOk = (qboolean)(uiSaved == sizeof(chid) + sizeof(iLength) + sizeof(uiCksum) + sizeof(uiCompressedLength) + iCompressedLength);
+		}
+		else
+		{
+			// uncompressed...
+			//
+			uiSaved += fwrite( &iLength,	1, sizeof(iLength),		f );
+			uiSaved += fwrite( pvData,		1, iLength,				f );
+			uiSaved += fwrite( &uiCksum,	1, sizeof(uiCksum),		f );
+
+			qbOk = (qboolean)(uiSaved == sizeof(chid) + sizeof(iLength) + sizeof(uiCksum) + iLength);
+		}
+	}
+
+	if ( f && fclose( f ) )
+	{
+		qbOk = qfalse;
+	}
+
+	if ( qbOk )
+	{
+		qbOk = Sys_ReplaceFile( pWrite->sOSPathTemp, pWrite->sOSPath );
+	}
+
+	if ( !qbOk )
+	{
+		remove( pWrite->sOSPathTemp );
+	}
+
+	pWrite->qbWritten = qbOk;
+}
+
+static void SG_WriteThread( void *data )
+{
+	for (;;)
+	{
+		Sys_SemaphoreWait( sg_writeWake );
+
+		if ( sg_iWriteQuit )
+			break;
+
+		SG_WriteFile( sg_pWriteQueue[ sg_iWritesTaken++ % iSG_WRITE_SLOTS ] );
+
+		Sys_AtomicAdd( &sg_iWritesDone, 1 );
+		Sys_SemaphorePost( sg_writeDone );
+	}
+}
+
+static void SG_StartWriteThread( void )
+{
+	sg_writeWake = Sys_CreateSemaphore( 0 );
+	sg_writeDone = Sys_CreateSemaphore( 0 );
+
+	if ( sg_writeWake && sg_writeDone )
+	{
+		sg_writeThread = Sys_CreateThread( SG_WriteThread, NULL );
+	}
+
+	if ( !sg_writeThread )
+	{
+		Com_Printf( S_COLOR_YELLOW "SG_StartWriteThread: couldn't start the savegame writer, saving on the main thread\n" );
+		sg_qbWriteThreadFailed = qtrue;
+
+		if ( sg_writeWake )
+		{
+			Sys_DestroySemaphore( sg_writeWake );
+			sg_writeWake = NULL;
+		}
+		if ( sg_writeDone )
+		{
+			Sys_DestroySemaphore( sg_writeDone );
+			sg_writeDone = NULL;
+		}
+	}
+}
+
+// a write has finished, give the slot back and tell whoever asked for it...
+//
+static void SG_ReapWrite( sgWrite_t *pWrite )
+{
+	char			sPathlessBaseName[MAX_QPATH];
+	saveGameDone_t	pfnDone		= pWrite->pfnDone;
+	qboolean		qbWritten	= pWrite->qbWritten;
+
+	Q_strncpyz( sPathlessBaseName, pWrite->sPathlessBaseName, sizeof(sPathlessBaseName) );
+
+	Z_Free( pWrite->pbArena );
+	pWrite->pbArena = NULL;
+	if ( pWrite->pbScratch )
+	{
+		Z_Free( pWrite->pbScratch );
+		pWrite->pbScratch	= NULL;
+		pWrite->piHashTable	= NULL;
+	}
+	pWrite->qbInUse = qfalse;
+
+	if ( !qbWritten )
+	{
+		Com_Printf( GetString_FailedToOpenSaveGame( sPathlessBaseName, qfalse ) );
+	}
+
+	// last, since it's free to start another save...
 	//
-	// compression code works? (I'd hope this is always the case, but for safety)...
+	if ( pfnDone )
+	{
+		pfnDone( sPathlessBaseName, qbWritten );
+	}
+}
+
+static void SG_WaitForOldestWrite( void )
+{
+	Sys_SemaphoreWait( sg_writeDone );
+	SG_ReapWrite( sg_pWriteQueue[ sg_iWritesReaped++ % iSG_WRITE_SLOTS ] );
+}
+
+// reports any saves the writer's finished, without waiting...
+//
+void SG_UpdateWrites( void )
+{
+	while ( sg_iWritesReaped < sg_iWritesQueued && sg_iWritesReaped < Sys_AtomicAdd( &sg_iWritesDone, 0 ) )
+	{
+		SG_WaitForOldestWrite();
+	}
+}
+
+// waits until every queued save is on disk (or has failed)...
+//
+void SG_FinishWrites( void )
+{
+	while ( sg_iWritesReaped < sg_iWritesQueued )
+	{
+		SG_WaitForOldestWrite();
+	}
+}
+
+void SG_ShutdownWrites( void )
+{
+	SG_FinishWrites();
+
+	if ( sg_writeThread )
+	{
+		sg_iWriteQuit = 1;
+		Sys_SemaphorePost( sg_writeWake );
+		Sys_JoinThread( sg_writeThread );
+		sg_writeThread = NULL;
+		sg_iWriteQuit = 0;
+
+		Sys_DestroySemaphore( sg_writeWake );
+		Sys_DestroySemaphore( sg_writeDone );
+		sg_writeWake = NULL;
+		sg_writeDone = NULL;
+	}
+
+	sg_iWritesQueued = sg_iWritesReaped = sg_iWritesTaken = sg_iWritesDone = 0;
+	sg_qbWriteThreadFailed = qfalse;
+}
+
+static void SG_BeginWrite( LPCSTR psPathlessBaseName )
+{
+	sgWrite_t	*pWrite = NULL;
+
+	assert( !sg_pWriteFilling );
+
+	if ( !sv_saveThread->integer )
+	{
+		SG_ShutdownWrites();	// (lets anything still queued land first, so saves stay in order)
+	}
+	else if ( !sg_writeThread && !sg_qbWriteThreadFailed )
+	{
+		SG_StartWriteThread();
+	}
+
+	// take a free slot, waiting for the oldest write if they're both queued...
 	//
-	if (!Verify_RLE(pbData, pbOut, iLength))
-		return -1;
+	while ( !pWrite )
+	{
+		for ( int i = 0; i < iSG_WRITE_SLOTS; i++ )
+		{
+			if ( !sg_write[i].qbInUse )
+			{
+				pWrite = &sg_write[i];
+				break;
+			}
+		}
+
+		if ( !pWrite )
+		{
+			SG_WaitForOldestWrite();
+		}
+	}
+
+	Q_strncpyz( pWrite->sPathlessBaseName, psPathlessBaseName, sizeof(pWrite->sPathlessBaseName) );
+	Q_strncpyz( pWrite->sOSPath, FS_UserGenOSPath( SG_AddSavePath( psPathlessBaseName ) ), sizeof(pWrite->sOSPath) );
+	Com_sprintf( pWrite->sOSPathTemp, sizeof(pWrite->sOSPathTemp), "%s.tmp", pWrite->sOSPath );
 
-	return iOutputLength;
+	pWrite->pfnDone			= NULL;
+	pWrite->pbArena			= (byte *) Z_Malloc( sg_iArenaSize, TAG_TEMP_WORKSPACE, qfalse );
+	pWrite->iArenaSize		= sg_iArenaSize;
+	pWrite->iArenaUsed		= 0;
+	pWrite->iLargestChunk	= 0;
+	pWrite->pbScratch		= NULL;
+	pWrite->piHashTable		= NULL;
+	pWrite->iCodec			= SG_CODEC_NONE;
+	pWrite->qbWritten		= qfalse;
+	pWrite->qbInUse			= qtrue;
+
+	sg_pWriteFilling = pWrite;
 }
 
+static void SG_AppendToWrite( unsigned long chid, const void *pvData, int iLength )
+{
+	sgWrite_t	*pWrite = sg_pWriteFilling;
+	int			iRecordSize = sizeof(chid) + sizeof(iLength) + iLength;
+
+	assert( pWrite );
+
+	if ( pWrite->iArenaUsed + iRecordSize > pWrite->iArenaSize )
+	{
+		int iSize = pWrite->iArenaSize * 2;
+		while ( iSize < pWrite->iArenaUsed + iRecordSize )
+		{
+			iSize *= 2;
+		}
+
+		byte *pbArena = (byte *) Z_Malloc( iSize, TAG_TEMP_WORKSPACE, qfalse );
+		memcpy( pbArena, pWrite->pbArena, pWrite->iArenaUsed );
+		Z_Free( pWrite->pbArena );
+
+		pWrite->pbArena		= pbArena;
+		pWrite->iArenaSize	= iSize;
+		sg_iArenaSize		= iSize;
+	}
+
+	byte *pb = pWrite->pbArena + pWrite->iArenaUsed;
+	memcpy( pb, &chid, sizeof(chid) );
+	pb += sizeof(chid);
+	memcpy( pb, &iLength, sizeof(iLength) );
+	pb += sizeof(iLength);
+	memcpy( pb, pvData, iLength );
+
+	pWrite->iArenaUsed += iRecordSize;
+
+	if ( pWrite->iLargestChunk < iLength )
+	{
+		pWrite->iLargestChunk = iLength;
+	}
+}
+
+// the game's done writing, hand the chunks over...
+//
+static qboolean SG_CloseWrite( saveGameDone_t pfnDone )
+{
+	sgWrite_t	*pWrite = sg_pWriteFilling;
+
+	assert( pWrite );
+	sg_pWriteFilling = NULL;
+
+#ifdef SG_PROFILE
+	SG_PrintProfile();
+#endif
+
+	pWrite->pfnDone = pfnDone;
+	pWrite->iCodec	= sv_compress_saved_games->integer;
+
+	if ( pWrite->iCodec != SG_CODEC_LZ && pWrite->iCodec != SG_CODEC_RLE )
+	{
+		pWrite->iCodec = pWrite->iCodec ? SG_CODEC_LZ : SG_CODEC_NONE;
+	}
+
+	if ( pWrite->iCodec != SG_CODEC_NONE )
+	{
+		int iScratchSize = ((pWrite->iLargestChunk * 2) + 3) & ~3;
+
+		pWrite->pbScratch	= (byte *) Z_Malloc( iScratchSize + (iLZ_HASH_SIZE * sizeof(int)), TAG_TEMP_WORKSPACE, qfalse );
+		pWrite->piHashTable	= (int *) (pWrite->pbScratch + iScratchSize);
+	}
+
+	if ( sg_writeThread )
+	{
+		sg_pWriteQueue[ sg_iWritesQueued++ % iSG_WRITE_SLOTS ] = pWrite;
+		Sys_SemaphorePost( sg_writeWake );
+	}
+	else
+	{
+		SG_WriteFile( pWrite );
+		SG_ReapWrite( pWrite );
+	}
+
+	return qtrue;
+}
+
+// an ERR_DROP during the save, drop what the game had written so far...
+//
+static void SG_AbandonWrite( void )
+{
+	sgWrite_t	*pWrite = sg_pWriteFilling;
+
+	if ( pWrite )
+	{
+		Z_Free( pWrite->pbArena );
+		pWrite->pbArena = NULL;
+		pWrite->qbInUse = qfalse;
+		sg_pWriteFilling = NULL;
+	}
+
+#ifdef SG_PROFILE
+	save_info.clear();
+#endif
+}
+#endif	// !_XBOX
+
 
 #ifdef _XBOX// function for xbox
 /*
@@ -1574,8 +2222,10 @@ int SG_Write(const void * chid, const int bytesize, fileHandle_t fhSaveGame)
 
 qboolean SG_Append(unsigned long chid, const void *pvData, int iLength)
 {	
+#ifdef _XBOX
 	unsigned int	uiCksum;
 	unsigned int	uiSaved;
+#endif
 	
 #ifdef _DEBUG
 	int				i;
@@ -1596,12 +2246,17 @@ qboolean SG_Append(unsigned long chid, const void *pvData, int iLength)
 	//
 	if (!sv_testsave->integer)
 	{
+#ifndef _XBOX
+		// checksummed, compressed and written by SG_WriteFile()...
+		//
+		SG_AppendToWrite(chid, pvData, iLength);
+#else
 		uiCksum = Com_BlockChecksum (pvData, iLength);
 
 		uiSaved  = SG_Write(&chid,		sizeof(chid),		fhSaveGame);
 
-		byte *pbCompressedData = NULL;
-		int iCompressedLength = CompressMem((byte*)pvData, iLength, pbCompressedData);
+		byte *pbCompressedData = CompressMem_AllocScratchBuffer(iLength*2);
+		int iCompressedLength = CompressMem((byte*)pvData, iLength, pbCompressedData, NULL, sv_compress_saved_games->integer ? SG_CODEC_RLE : SG_CODEC_NONE);
 		if (iCompressedLength != -1)
 		{
 			// compressed...  (write length field out as -ve)
@@ -1650,6 +2305,7 @@ qboolean SG_Append(unsigned long chid, const void *pvData, int iLength)
 				return qfalse;
 			}
 		}
+#endif
 		
 		#ifdef SG_PROFILE
 		save_info[chid].Add(iLength);
@@ -1906,6 +2562,8 @@ static int SG_Read_Actual(unsigned long chid, void *pvAddress, int iLength, void
 		// read compressed data length...
 		//
 		uiLoaded += SG_ReadBytes( &uiCompressedLength, sizeof(uiCompressedLength),fhSaveGame);
+		qboolean bBlockIsLZ = (qboolean)((uiCompressedLength & iSG_COMPRESSED_LZ) != 0);
+		uiCompressedLength &= ~iSG_COMPRESSED_LZ;
 		//
 		// alloc space...
 		//	
@@ -1915,9 +2573,16 @@ static int SG_Read_Actual(unsigned long chid, void *pvAddress, int iLength, void
 		//
 		uiLoaded += SG_ReadBytes( pTempRLEData,  uiCompressedLength, fhSaveGame );
 		//
-		// decompress it...
+		// decompress it (a bad LZ block just fails the checksum below)...
 		//
-		DeCompress_RLE((byte *)pvAddress, pTempRLEData, iLength);
+		if (bBlockIsLZ)
+		{
+			DeCompress_LZ((byte *)pvAddress, pTempRLEData, uiCompressedLength, iLength);
+		}
+		else
+		{
+			DeCompress_RLE((byte *)pvAddress, pTempRLEData, iLength);
+		}
 		//
 		// free workspace...
 		//
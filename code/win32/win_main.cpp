@@ -133,6 +133,19 @@ qboolean Sys_CopyFile(LPCSTR lpExistingFileName, LPCSTR lpNewFileName, qboolean
 	return bOk;
 }
 
+/*
+==================
+Sys_ReplaceFile
+
+Moves the file over any existing one in a single step, so readers only ever
+see the old file or the new one.  Safe to call from a Sys_CreateThread thread
+==================
+*/
+qboolean Sys_ReplaceFile( LPCSTR psSrcFileName, LPCSTR psDstFileName )
+{
+	return (qboolean)( MoveFileEx( psSrcFileName, psDstFileName, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0 );
+}
+
 /*
 ==================
 Sys_LowPhysicalMemory()
@@ -278,4 +278,79 @@ char *Sys_GetCurrentUser( void )
 
 	return s_userName;
 #endif
-}
\ No newline at end of file
+}
+
+/*
+================
+Sys_CreateThread
+
+Threads must not call Com_Error, Com_Printf or Z_Malloc
+================
+*/
+typedef struct {
+	threadFunc_t	function;
+	void			*data;
+} threadStart_t;
+
+static DWORD WINAPI Sys_ThreadStart( LPVOID arg )
+{
+	threadStart_t	start = *(threadStart_t *)arg;
+
+	free( arg );
+	start.function( start.data );
+	return 0;
+}
+
+void *Sys_CreateThread( threadFunc_t function, void *data )
+{
+	HANDLE			thread;
+	DWORD			threadId;
+	threadStart_t	*start;
+
+	start = (threadStart_t *)malloc( sizeof( *start ) );
+	start->function = function;
+	start->data = data;
+
+	thread = CreateThread( NULL, 0, Sys_ThreadStart, start, 0, &threadId );
+	if ( !thread ) {
+		free( start );
+		return NULL;
+	}
+	return thread;
+}
+
+void Sys_JoinThread( void *thread )
+{
+	WaitForSingleObject( (HANDLE)thread, INFINITE );
+	CloseHandle( (HANDLE)thread );
+}
+
+void *Sys_CreateSemaphore( int initialCount )
+{
+	return CreateSemaphore( NULL, initialCount, 0x7fffffff, NULL );
+}
+
+void Sys_DestroySemaphore( void *semaphore )
+{
+	CloseHandle( (HANDLE)semaphore );
+}
+
+void Sys_SemaphoreWait( void *semaphore )
+{
+	WaitForSingleObject( (HANDLE)semaphore, INFINITE );
+}
+
+void Sys_SemaphorePost( void *semaphore )
+{
+	ReleaseSemaphore( (HANDLE)semaphore, 1, NULL );
+}
+
+int Sys_AtomicAdd( volatile int *value, int add )
+{
+	return InterlockedExchangeAdd( (volatile LONG *)value, add ) + add;
+}
+
+int Sys_AtomicCompareExchange( volatile int *value, int exchange, int comparand )
+{
+	return InterlockedCompareExchange( (volatile LONG *)value, exchange, comparand );
+}
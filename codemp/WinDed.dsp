@@ -180,7 +180,15 @@ SOURCE=.\qcommon\disablewarnings.h
 # End Source File
 # Begin Source File
 
-SOURCE=.\qcommon\files.cpp
+SOURCE=.\qcommon\files.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\qcommon\files_common.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\qcommon\files_pc.cpp
 # End Source File
 # Begin Source File
 
@@ -200,6 +208,10 @@ SOURCE=.\qcommon\huffman.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\qcommon\jobs.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\qcommon\md4.cpp
 # End Source File
 # Begin Source File
@@ -216,6 +228,10 @@ SOURCE=.\qcommon\net_chan.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\qcommon\profile.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\game\q_math.c
 # End Source File
 # Begin Source File
@@ -276,12 +292,20 @@ SOURCE=.\qcommon\vm_interpreted.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\qcommon\vm_compare.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\qcommon\vm_local.h
 # End Source File
 # Begin Source File
 
 SOURCE=.\qcommon\vm_x86.cpp
 # End Source File
+# Begin Source File
+
+SOURCE=.\qcommon\vm_x86_64.cpp
+# End Source File
 # End Group
 # Begin Group "Ghoul2"
 
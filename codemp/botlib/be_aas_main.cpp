@@ -249,8 +249,10 @@ int AAS_StartFrame(float time)
 		} //end if
 	} //end if
 	//
-	if (saveroutingcache->value)
+	if (saveroutingcache->value && aasworld.initialized)
 	{
+		//2 = create the complete routing cache before writing it
+		if (saveroutingcache->value >= 2) AAS_CreateAllRoutingCache();
 		AAS_WriteRouteCache();
 		LibVarSet("saveroutingcache", "0");
 	} //end if
@@ -66,6 +66,8 @@ int numportalcacheupdates;
 
 int routingcachesize;
 int max_routingcachesize;
+//set while all routing cache is created, no cache is evicted
+int creatingallroutingcache;
 
 //===========================================================================
 //
@@ -218,6 +220,8 @@ void AAS_LinkCache(aas_routingcache_t *cache)
 //===========================================================================
 void AAS_FreeRoutingCache(aas_routingcache_t *cache)
 {
+	//resident cache is part of the block read from the route cache file
+	if (cache->resident) return;
 	AAS_UnlinkCache(cache);
 	routingcachesize -= cache->size;
 	FreeMemory(cache);
@@ -869,9 +873,12 @@ void AAS_InitRoutingUpdate(void)
 //===========================================================================
 void AAS_CreateAllRoutingCache(void)
 {
-	int i, j, t;
+	int i, j, t, initialized;
 
+	initialized = aasworld.initialized;
 	aasworld.initialized = qtrue;
+	//keep all the cache, it's created to be written to the route cache file
+	creatingallroutingcache = qtrue;
 	botimport.Print(PRT_MESSAGE, "AAS_CreateAllRoutingCache\n");
 	for (i = 1; i < aasworld.numareas; i++)
 	{
@@ -884,7 +891,8 @@ void AAS_CreateAllRoutingCache(void)
 			//Log_Write("traveltime from %d to %d is %d", i, j, t);
 		} //end for
 	} //end for
-	aasworld.initialized = qfalse;
+	creatingallroutingcache = qfalse;
+	aasworld.initialized = initialized;
 } //end of the function AAS_CreateAllRoutingCache
 //===========================================================================
 //
@@ -894,41 +902,121 @@ void AAS_CreateAllRoutingCache(void)
 //===========================================================================
 
 //the route cache header
-//this header is followed by numportalcache + numareacache aas_routingcache_t
-//structures that store routing cache
+//this header is followed by numportalcache + numareacache routecacherecord_t
+//records, each followed by the travel times and reachabilities of the cache
 typedef struct routecacheheader_s
 {
 	int ident;
 	int version;
+	int bspchecksum;
 	int numareas;
 	int numclusters;
+	int numportals;
 	int areacrc;
 	int clustercrc;
+	int reachabilitycrc;
 	int numportalcache;
 	int numareacache;
+	int numtraveltimes;							//total travel times stored in all cache
 } routecacheheader_t;
 
+//a single stored routing cache
+//the pointers and the access time of aas_routingcache_t are not stored
+//so the file does not depend on the struct layout of the build that wrote it
+typedef struct routecacherecord_s
+{
+	int cluster;
+	int areanum;
+	vec3_t origin;
+	float starttraveltime;
+	int travelflags;
+	int numtraveltimes;
+} routecacherecord_t;
+
 #define RCID						(('C'<<24)+('R'<<16)+('E'<<8)+'M')
-#define RCVERSION					2
+#define RCVERSION					3
 
 //void AAS_DecompressVis(byte *in, int numareas, byte *decompressed);
 //int AAS_CompressVis(byte *vis, int numareas, byte *dest);
 
+//===========================================================================
+// fills in the fields used to match a route cache file with the loaded AAS
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_RouteCacheHeader(routecacheheader_t *header)
+{
+	memset(header, 0, sizeof(routecacheheader_t));
+	header->ident = RCID;
+	header->version = RCVERSION;
+	header->bspchecksum = aasworld.bspchecksum;
+	header->numareas = aasworld.numareas;
+	header->numclusters = aasworld.numclusters;
+	header->numportals = aasworld.numportals;
+	header->areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
+	header->clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
+	header->reachabilitycrc = CRC_ProcessString( (unsigned char *)aasworld.reachability, sizeof(aas_reachability_t) * aasworld.reachabilitysize );
+} //end of the function AAS_RouteCacheHeader
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int AAS_RoutingCacheNumTravelTimes(aas_routingcache_t *cache)
+{
+	return (cache->size - sizeof(aas_routingcache_t)) / (sizeof(unsigned short int) + sizeof(unsigned char));
+} //end of the function AAS_RoutingCacheNumTravelTimes
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_WriteCache(fileHandle_t fp, aas_routingcache_t *cache)
+{
+	routecacherecord_t record;
+
+	record.cluster = cache->cluster;
+	record.areanum = cache->areanum;
+	VectorCopy(cache->origin, record.origin);
+	record.starttraveltime = cache->starttraveltime;
+	record.travelflags = cache->travelflags;
+	record.numtraveltimes = AAS_RoutingCacheNumTravelTimes(cache);
+	botimport.FS_Write(&record, sizeof(routecacherecord_t), fp);
+	botimport.FS_Write(cache->traveltimes, record.numtraveltimes * sizeof(unsigned short int), fp);
+	botimport.FS_Write(cache->reachabilities, record.numtraveltimes * sizeof(unsigned char), fp);
+} //end of the function AAS_WriteCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void AAS_WriteRouteCache(void)
 {
-	int i, j, numportalcache, numareacache, totalsize;
+	int i, j, numportalcache, numareacache, numtraveltimes, totalsize;
 	aas_routingcache_t *cache;
 	aas_cluster_t *cluster;
 	fileHandle_t fp;
 	char filename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
 
+	if (!aasworld.initialized)
+	{
+		botimport.Print(PRT_ERROR, "AAS not initialized, can't write route cache\n");
+		return;
+	} //end if
 	numportalcache = 0;
+	numtraveltimes = 0;
 	for (i = 0; i < aasworld.numareas; i++)
 	{
 		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
 		{
 			numportalcache++;
+			numtraveltimes += AAS_RoutingCacheNumTravelTimes(cache);
 		} //end for
 	} //end for
 	numareacache = 0;
@@ -940,6 +1028,7 @@ void AAS_WriteRouteCache(void)
 			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
 			{
 				numareacache++;
+				numtraveltimes += AAS_RoutingCacheNumTravelTimes(cache);
 			} //end for
 		} //end for
 	} //end for
@@ -952,25 +1041,20 @@ void AAS_WriteRouteCache(void)
 		return;
 	} //end if
 	//create the header
-	routecacheheader.ident = RCID;
-	routecacheheader.version = RCVERSION;
-	routecacheheader.numareas = aasworld.numareas;
-	routecacheheader.numclusters = aasworld.numclusters;
-	routecacheheader.areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
-	routecacheheader.clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
+	AAS_RouteCacheHeader(&routecacheheader);
 	routecacheheader.numportalcache = numportalcache;
 	routecacheheader.numareacache = numareacache;
+	routecacheheader.numtraveltimes = numtraveltimes;
 	//write the header
 	botimport.FS_Write(&routecacheheader, sizeof(routecacheheader_t), fp);
 	//
-	totalsize = 0;
+	totalsize = sizeof(routecacheheader_t);
 	//write all the cache
 	for (i = 0; i < aasworld.numareas; i++)
 	{
 		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
 		{
-			botimport.FS_Write(cache, cache->size, fp);
-			totalsize += cache->size;
+			AAS_WriteCache(fp, cache);
 		} //end for
 	} //end for
 	for (i = 0; i < aasworld.numclusters; i++)
@@ -980,11 +1064,12 @@ void AAS_WriteRouteCache(void)
 		{
 			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
 			{
-				botimport.FS_Write(cache, cache->size, fp);
-				totalsize += cache->size;
+				AAS_WriteCache(fp, cache);
 			} //end for
 		} //end for
 	} //end for
+	totalsize += (numportalcache + numareacache) * sizeof(routecacherecord_t) +
+					numtraveltimes * (sizeof(unsigned short int) + sizeof(unsigned char));
 	// write the visareas
 	/*
 	for (i = 0; i < aasworld.numareas; i++)
@@ -1003,28 +1088,63 @@ void AAS_WriteRouteCache(void)
 	//
 	botimport.FS_FCloseFile(fp);
 	botimport.Print(PRT_MESSAGE, "\nroute cache written to %s\n", filename);
-	botimport.Print(PRT_MESSAGE, "written %d bytes of routing cache\n", totalsize);
+	botimport.Print(PRT_MESSAGE, "written %d bytes of routing cache (%d portal, %d area)\n",
+												totalsize, numportalcache, numareacache);
 } //end of the function AAS_WriteRouteCache
 //===========================================================================
+// reads one cache record into the resident block
+// returns NULL if the record doesn't fit the loaded AAS
 //
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
+aas_routingcache_t *AAS_ReadCache(fileHandle_t fp, int type, byte **ptr, byte *end)
 {
-	int size;
+	int numtraveltimes, clusterareanum, size;
+	routecacherecord_t record;
 	aas_routingcache_t *cache;
 
-	botimport.FS_Read(&size, sizeof(size), fp);
-	cache = (aas_routingcache_t *) GetMemory(size);
+	botimport.FS_Read(&record, sizeof(routecacherecord_t), fp);
+	if (record.areanum <= 0 || record.areanum >= aasworld.numareas) return NULL;
+	if (record.cluster <= 0 || record.cluster >= aasworld.numclusters) return NULL;
+	if (type == CACHETYPE_AREA)
+	{
+		numtraveltimes = aasworld.clusters[record.cluster].numreachabilityareas;
+		clusterareanum = AAS_ClusterAreaNum(record.cluster, record.areanum);
+		if (clusterareanum < 0 || clusterareanum >= aasworld.clusters[record.cluster].numareas) return NULL;
+	} //end if
+	else
+	{
+		numtraveltimes = aasworld.numportals;
+	} //end else
+	if (record.numtraveltimes != numtraveltimes) return NULL;
+	//
+	size = sizeof(aas_routingcache_t)
+				+ numtraveltimes * sizeof(unsigned short int)
+				+ numtraveltimes * sizeof(unsigned char);
+	if (*ptr + size > end) return NULL;
+	cache = (aas_routingcache_t *) *ptr;
+	*ptr += size;
+	//
+	cache->type = type;
+	cache->resident = qtrue;
 	cache->size = size;
-	botimport.FS_Read((unsigned char *)cache + sizeof(size), size - sizeof(size), fp);
-	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t) - sizeof(unsigned short) +
-		(size - sizeof(aas_routingcache_t) + sizeof(unsigned short)) / 3 * 2;
+	cache->cluster = record.cluster;
+	cache->areanum = record.areanum;
+	VectorCopy(record.origin, cache->origin);
+	cache->starttraveltime = record.starttraveltime;
+	cache->travelflags = record.travelflags;
+	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t)
+								+ numtraveltimes * sizeof(unsigned short int);
+	botimport.FS_Read(cache->traveltimes, numtraveltimes * sizeof(unsigned short int), fp);
+	botimport.FS_Read(cache->reachabilities, numtraveltimes * sizeof(unsigned char), fp);
 	return cache;
 } //end of the function AAS_ReadCache
 //===========================================================================
+// reads the complete route cache into one resident block
+// the cache read from file is never evicted and only released with
+// the other routing cache in AAS_FreeRoutingCaches
 //
 // Parameter:			-
 // Returns:				-
@@ -1032,11 +1152,12 @@ aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
 //===========================================================================
 int AAS_ReadRouteCache(void)
 {
-	int i, clusterareanum;//, size;
+	int i, numcache, size, clusterareanum;
 	fileHandle_t fp;
 	char filename[MAX_QPATH];
-	routecacheheader_t routecacheheader;
+	routecacheheader_t routecacheheader, expected;
 	aas_routingcache_t *cache;
+	byte *ptr, *end;
 
 	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
 	botimport.FS_FOpenFile( filename, &fp, FS_READ );
@@ -1045,59 +1166,64 @@ int AAS_ReadRouteCache(void)
 		return qfalse;
 	} //end if
 	botimport.FS_Read(&routecacheheader, sizeof(routecacheheader_t), fp );
+	AAS_RouteCacheHeader(&expected);
 	if (routecacheheader.ident != RCID)
 	{
-		AAS_Error("%s is not a route cache dump\n");
+		botimport.FS_FCloseFile(fp);
+		AAS_Error("%s is not a route cache dump\n", filename);
 		return qfalse;
 	} //end if
 	if (routecacheheader.version != RCVERSION)
 	{
-		AAS_Error("route cache dump has wrong version %d, should be %d", routecacheheader.version, RCVERSION);
+		botimport.FS_FCloseFile(fp);
+		botimport.Print(PRT_WARNING, "%s has wrong version %d, should be %d\n", filename, routecacheheader.version, RCVERSION);
 		return qfalse;
 	} //end if
-	if (routecacheheader.numareas != aasworld.numareas)
-	{
-		//AAS_Error("route cache dump has wrong number of areas\n");
+	//the route cache is only valid for the AAS file it was created with
+	if (routecacheheader.bspchecksum != expected.bspchecksum ||
+		routecacheheader.numareas != expected.numareas ||
+		routecacheheader.numclusters != expected.numclusters ||
+		routecacheheader.numportals != expected.numportals ||
+		routecacheheader.areacrc != expected.areacrc ||
+		routecacheheader.clustercrc != expected.clustercrc ||
+		routecacheheader.reachabilitycrc != expected.reachabilitycrc)
+	{
+		botimport.FS_FCloseFile(fp);
+		botimport.Print(PRT_WARNING, "%s is out of date\n", filename);
 		return qfalse;
 	} //end if
-	if (routecacheheader.numclusters != aasworld.numclusters)
+	numcache = routecacheheader.numportalcache + routecacheheader.numareacache;
+	if (routecacheheader.numportalcache < 0 || routecacheheader.numareacache < 0 ||
+		routecacheheader.numtraveltimes < 0 || numcache <= 0)
 	{
-		//AAS_Error("route cache dump has wrong number of clusters\n");
+		botimport.FS_FCloseFile(fp);
 		return qfalse;
 	} //end if
-	if (routecacheheader.areacrc !=
-		CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas ))
-	{
-		//AAS_Error("route cache dump area CRC incorrect\n");
-		return qfalse;
-	} //end if
-	if (routecacheheader.clustercrc !=
-		CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters ))
-	{
-		//AAS_Error("route cache dump cluster CRC incorrect\n");
+	//allocate all the cache in one block
+	size = numcache * sizeof(aas_routingcache_t)
+				+ routecacheheader.numtraveltimes * sizeof(unsigned short int)
+				+ routecacheheader.numtraveltimes * sizeof(unsigned char);
+	ptr = (byte *) GetClearedMemory(size);
+	end = ptr + size;
+	aasworld.residentcache = ptr;
+	//read all the cache before linking any of it
+	for (i = 0; i < numcache; i++)
+	{
+		if (!AAS_ReadCache(fp, i < routecacheheader.numportalcache ? CACHETYPE_PORTAL : CACHETYPE_AREA, &ptr, end))
+		{
+			break;
+		} //end if
+	} //end for
+	//the records have to fill the block exactly, a travel time count in the
+	//header that doesn't match them would leave a zeroed tail to link
+	if (i < numcache || ptr != end)
+	{
+		botimport.FS_FCloseFile(fp);
+		FreeMemory(aasworld.residentcache);
+		aasworld.residentcache = NULL;
+		botimport.Print(PRT_WARNING, "%s is corrupt\n", filename);
 		return qfalse;
 	} //end if
-	//read all the portal cache
-	for (i = 0; i < routecacheheader.numportalcache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		cache->next = aasworld.portalcache[cache->areanum];
-		cache->prev = NULL;
-		if (aasworld.portalcache[cache->areanum])
-			aasworld.portalcache[cache->areanum]->prev = cache;
-		aasworld.portalcache[cache->areanum] = cache;
-	} //end for
-	//read all the cluster area cache
-	for (i = 0; i < routecacheheader.numareacache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
-		cache->next = aasworld.clusterareacache[cache->cluster][clusterareanum];
-		cache->prev = NULL;
-		if (aasworld.clusterareacache[cache->cluster][clusterareanum])
-			aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
-		aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
-	} //end for
 	// read the visareas
 	/*
 	aasworld.areavisibility = (byte **) GetClearedMemory(aasworld.numareas * sizeof(byte *));
@@ -1113,6 +1239,34 @@ int AAS_ReadRouteCache(void)
 	*/
 	//
 	botimport.FS_FCloseFile(fp);
+	//link the cache in the portal and cluster area cache
+	for (ptr = (byte *) aasworld.residentcache; ptr < end; ptr += cache->size)
+	{
+		cache = (aas_routingcache_t *) ptr;
+		//never loop on or walk past a bad record
+		if (cache->size <= 0 || cache->size > end - ptr)
+		{
+			AAS_Error("AAS_ReadRouteCache: bad cache size %d\n", cache->size);
+			break;
+		} //end if
+		cache->prev = NULL;
+		if (cache->type == CACHETYPE_PORTAL)
+		{
+			cache->next = aasworld.portalcache[cache->areanum];
+			if (aasworld.portalcache[cache->areanum])
+				aasworld.portalcache[cache->areanum]->prev = cache;
+			aasworld.portalcache[cache->areanum] = cache;
+		} //end if
+		else
+		{
+			clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
+			cache->next = aasworld.clusterareacache[cache->cluster][clusterareanum];
+			if (aasworld.clusterareacache[cache->cluster][clusterareanum])
+				aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
+			aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
+		} //end else
+	} //end for
+	botimport.Print(PRT_MESSAGE, "loaded %d bytes of routing cache from %s\n", size, filename);
 	return qtrue;
 } //end of the function AAS_ReadRouteCache
 //===========================================================================
@@ -1222,6 +1376,7 @@ void AAS_InitRouting(void)
 	//
 	routingcachesize = 0;
 	max_routingcachesize = 1024 * (int) LibVarValue("max_routingcache", "4096");
+	creatingallroutingcache = qfalse;
 	// read any routing cache if available
 	AAS_ReadRouteCache();
 } //end of the function AAS_InitRouting
@@ -1237,6 +1392,9 @@ void AAS_FreeRoutingCaches(void)
 	AAS_FreeAllClusterAreaCache();
 	// free all the existing portal cache
 	AAS_FreeAllPortalCache();
+	// free the resident cache read from the route cache file
+	if (aasworld.residentcache) FreeMemory(aasworld.residentcache);
+	aasworld.residentcache = NULL;
 	// free cached travel times within areas
 	if (aasworld.areatraveltimes) FreeMemory(aasworld.areatraveltimes);
 	aasworld.areatraveltimes = NULL;
@@ -1409,14 +1567,15 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 		aasworld.clusterareacache[clusternum][clusterareanum] = cache;
 		AAS_UpdateAreaRoutingCache(cache);
 	} //end if
-	else
+	else if (!cache->resident)
 	{
 		AAS_UnlinkCache(cache);
 	} //end else
 	//the cache has been accessed
 	cache->time = AAS_RoutingTime();
 	cache->type = CACHETYPE_AREA;
-	AAS_LinkCache(cache);
+	//resident cache is never evicted so it isn't kept in the time sorted list
+	if (!cache->resident) AAS_LinkCache(cache);
 	return cache;
 } //end of the function AAS_GetAreaRoutingCache
 //===========================================================================
@@ -1549,14 +1708,14 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 		//update the cache
 		AAS_UpdatePortalRoutingCache(cache);
 	} //end if
-	else
+	else if (!cache->resident)
 	{
 		AAS_UnlinkCache(cache);
 	} //end else
 	//the cache has been accessed
 	cache->time = AAS_RoutingTime();
 	cache->type = CACHETYPE_PORTAL;
-	AAS_LinkCache(cache);
+	if (!cache->resident) AAS_LinkCache(cache);
 	return cache;
 } //end of the function AAS_GetPortalRoutingCache
 //===========================================================================
@@ -1600,7 +1759,7 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		return qfalse;
 	} //end if
 	// make sure the routing cache doesn't grow to large
-	while(AvailableMemory() < 1 * 1024 * 1024) {
+	while(!creatingallroutingcache && AvailableMemory() < 1 * 1024 * 1024) {
 		if (!AAS_FreeOldestCache()) break;
 	}
 	//
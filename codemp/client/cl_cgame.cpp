@@ -1733,6 +1733,48 @@ Ghoul2 Insert End
 }
 
 
+/*
+====================
+CL_PrefetchLevelAssets
+
+Queue the map and the model and sound configstrings so the pk3 reads
+run in the background while the cgame registers them
+====================
+*/
+static void CL_PrefetchLevelAssets( void ) {
+	const char	*name;
+	char		stripped[MAX_QPATH];
+	int			i;
+
+	// a listen server's CM_LoadMap has already read the BSP and
+	// keeps it for the renderer
+	if ( !com_sv_running->integer ) {
+		FS_PrefetchFile( cl.mapname );
+	}
+
+	for ( i = 1 ; i < MAX_MODELS ; i++ ) {
+		name = cl.gameState.stringData + cl.gameState.stringOffsets[ CS_MODELS + i ];
+		if ( !name[0] || name[0] == '*' ) {
+			continue;
+		}
+		FS_PrefetchFile( name );
+	}
+
+	for ( i = 1 ; i < MAX_SOUNDS ; i++ ) {
+		name = cl.gameState.stringData + cl.gameState.stringOffsets[ CS_SOUNDS + i ];
+		if ( !name[0] || name[0] == '*' ) {
+			continue;
+		}
+		// the sound loader falls back to an mp3 of the same name
+		COM_StripExtension( name, stripped );
+		if ( FS_FileIsInPAK( va( "%s.wav", stripped ), NULL ) != -1 ) {
+			FS_PrefetchFile( va( "%s.wav", stripped ) );
+		} else {
+			FS_PrefetchFile( va( "%s.mp3", stripped ) );
+		}
+	}
+}
+
 /*
 ====================
 CL_InitCGame
@@ -1756,6 +1798,9 @@ void CL_InitCGame( void ) {
 	mapname = Info_ValueForKey( info, "mapname" );
 	Com_sprintf( cl.mapname, sizeof( cl.mapname ), "maps/%s.bsp", mapname );
 
+	// start pulling level data out of the paks while the cgame loads
+	CL_PrefetchLevelAssets();
+
 	// load the dll or bytecode
 	if ( cl_connectedToPureServer != 0 ) {
 #if 0
@@ -1791,6 +1836,9 @@ void CL_InitCGame( void ) {
 	// on the card even if the driver does deferred loading
 	re.EndRegistration();
 
+	// everything the cgame wanted has been read by now
+	FS_PrefetchFlush();
+
 	// make sure everything is paged in
 //	if (!Sys_LowPhysicalMemory()) 
 	{
@@ -2702,6 +2702,8 @@ void S_Update( void ) {
 	int			total;
 	channel_t	*ch;
 
+	PROFILE_ZONE( "S_Update" );
+
 	if ( !s_soundStarted || s_soundMuted ) {
 		return;
 	}
@@ -1533,6 +1533,8 @@ Called once each time through the main loop
 ============
 */
 void S_Update( void ) {
+	PROFILE_ZONE( "S_Update" );
+
 	if ( !s_soundStarted ) {
 		return;
 	}
@@ -75,6 +75,7 @@ vmCvar_t bot_debugmessages;
 
 vmCvar_t bot_attachments;
 vmCvar_t bot_camp;
+vmCvar_t bot_maxThinks;
 
 vmCvar_t bot_wp_info;
 vmCvar_t bot_wp_edit;
@@ -1100,14 +1101,70 @@ qboolean BotPVSCheck( const vec3_t p1, const vec3_t p2 )
 	return trap_InPVS(p1, p2);
 }
 
+//nearest visible waypoint answers, shared by every bot that thinks this
+//frame. bots going after the same flag carrier, jedi master or enemy all ask
+//about the same spot, and nothing moves until the thinks are all done.
+#define MAX_WP_QUERY_CACHE	32
+
+typedef struct wpQuery_s
+{
+	vec3_t org;
+	int ignore;
+	int result;
+} wpQuery_t;
+
+static wpQuery_t wpQueryCache[MAX_WP_QUERY_CACHE];
+static int wpQueryCacheNum = 0;
+static qboolean wpQueryCacheActive = qfalse;
+
+//only while the bots think, anywhere else the world may move between calls
+static void BotFrameQueries(qboolean active)
+{
+	wpQueryCacheNum = 0;
+	wpQueryCacheActive = active;
+}
+
+static int GetNearestVisibleWP_Uncached(vec3_t org, int ignore);
+
 //get the index to the nearest visible waypoint in the global trail
 int GetNearestVisibleWP(vec3_t org, int ignore)
+{
+	int i;
+	int result;
+
+	if (!wpQueryCacheActive)
+	{
+		return GetNearestVisibleWP_Uncached(org, ignore);
+	}
+
+	for (i = 0; i < wpQueryCacheNum; i++)
+	{
+		if (wpQueryCache[i].ignore == ignore && VectorCompare(wpQueryCache[i].org, org))
+		{
+			return wpQueryCache[i].result;
+		}
+	}
+
+	result = GetNearestVisibleWP_Uncached(org, ignore);
+
+	if (wpQueryCacheNum < MAX_WP_QUERY_CACHE)
+	{
+		VectorCopy(org, wpQueryCache[wpQueryCacheNum].org);
+		wpQueryCache[wpQueryCacheNum].ignore = ignore;
+		wpQueryCache[wpQueryCacheNum].result = result;
+		wpQueryCacheNum++;
+	}
+
+	return result;
+}
+
+static int GetNearestVisibleWP_Uncached(vec3_t org, int ignore)
 {
 	int i;
 	float bestdist;
-	float flLen;
-	int bestindex;
-	vec3_t a, mins, maxs;
+	int numCandidates;
+	wpCandidate_t *candidates;
+	vec3_t mins, maxs;
 
 	i = 0;
 	if (g_RMG.integer)
@@ -1119,7 +1176,6 @@ int GetNearestVisibleWP(vec3_t org, int ignore)
 		bestdist = 800;//99999;
 				   //don't trace over 800 units away to avoid GIANT HORRIBLE SPEED HITS ^_^
 	}
-	bestindex = -1;
 
 	mins[0] = -15;
 	mins[1] = -15;
@@ -1128,24 +1184,22 @@ int GetNearestVisibleWP(vec3_t org, int ignore)
 	maxs[1] = 15;
 	maxs[2] = 1;
 
-	while (i < gWPNum)
+	//nearest first, so the first one we can see is the one
+	numCandidates = BotWPGridCollect(org, bestdist, &candidates);
+
+	while (i < numCandidates)
 	{
-		if (gWPArray[i] && gWPArray[i]->inuse)
-		{
-			VectorSubtract(org, gWPArray[i]->origin, a);
-			flLen = VectorLength(a);
+		wpobject_t *wp = gWPArray[candidates[i].index];
 
-			if (flLen < bestdist && (g_RMG.integer || BotPVSCheck(org, gWPArray[i]->origin)) && OrgVisibleBox(org, mins, maxs, gWPArray[i]->origin, ignore))
-			{
-				bestdist = flLen;
-				bestindex = i;
-			}
+		if ((g_RMG.integer || BotPVSCheck(org, wp->origin)) && OrgVisibleBox(org, mins, maxs, wp->origin, ignore))
+		{
+			return candidates[i].index;
 		}
 
 		i++;
 	}
 
-	return bestindex;
+	return -1;
 }
 
 //wpDirection
@@ -7490,8 +7544,10 @@ BotAIStartFrame
 ==================
 */
 int BotAIStartFrame(int time) {
-	int i;
+	int i, j;
 	int elapsed_time, thinktime;
+	int numThinking;
+	int thinking[MAX_CLIENTS];
 	static int local_time;
 	static int botlib_residual;
 	static int lastbotthink_time;
@@ -7503,6 +7559,7 @@ int BotAIStartFrame(int time) {
 		trap_Cvar_Update(&bot_attachments);
 		trap_Cvar_Update(&bot_forgimmick);
 		trap_Cvar_Update(&bot_honorableduelacceptance);
+		trap_Cvar_Update(&bot_maxThinks);
 #ifndef FINAL_BUILD
 		trap_Cvar_Update(&bot_getinthecarrr);
 #endif
@@ -7534,7 +7591,8 @@ int BotAIStartFrame(int time) {
 	if (elapsed_time > BOT_THINK_TIME) thinktime = elapsed_time;
 	else thinktime = BOT_THINK_TIME;
 
-	// execute scheduled bot AI
+	// work out who thinks this frame, the ones held back longest first
+	numThinking = 0;
 	for( i = 0; i < MAX_CLIENTS; i++ ) {
 		if( !botstates[i] || !botstates[i]->inuse ) {
 			continue;
@@ -7546,11 +7604,35 @@ int BotAIStartFrame(int time) {
 			botstates[i]->botthink_residual -= thinktime;
 
 			if (g_entities[i].client->pers.connected == CON_CONNECTED) {
-				BotAI(i, (float) thinktime / 1000);
+				for (j = numThinking; j > 0 && botstates[thinking[j-1]]->botthink_deferred < botstates[i]->botthink_deferred; j--) {
+					thinking[j] = thinking[j-1];
+				}
+				thinking[j] = i;
+				numThinking++;
 			}
 		}
 	}
 
+	// bot_maxThinks spreads a crowd of bots over several frames instead of
+	// letting them all land on one, the rest catch up on the time next frame
+	if (bot_maxThinks.integer > 0 && numThinking > bot_maxThinks.integer) {
+		for (j = bot_maxThinks.integer; j < numThinking; j++) {
+			botstates[thinking[j]]->botthink_deferred += thinktime;
+		}
+		numThinking = bot_maxThinks.integer;
+	}
+
+	// execute scheduled bot AI. nothing moves until the user commands go in
+	// below, so what the bots learn about the world can be shared between them
+	BotFrameQueries(qtrue);
+	for (j = 0; j < numThinking; j++) {
+		i = thinking[j];
+
+		BotAI(i, (float) (thinktime + botstates[i]->botthink_deferred) / 1000);
+		botstates[i]->botthink_deferred = 0;
+	}
+	BotFrameQueries(qfalse);
+
 	// execute bot user commands every frame
 	for( i = 0; i < MAX_CLIENTS; i++ ) {
 		if( !botstates[i] || !botstates[i]->inuse ) {
@@ -7589,6 +7671,7 @@ int BotAISetup( int restart ) {
 
 	trap_Cvar_Register(&bot_attachments, "bot_attachments", "1", 0);
 	trap_Cvar_Register(&bot_camp, "bot_camp", "1", 0);
+	trap_Cvar_Register(&bot_maxThinks, "bot_maxThinks", "0", 0);
 
 	trap_Cvar_Register(&bot_wp_info, "bot_wp_info", "1", 0);
 	trap_Cvar_Register(&bot_wp_edit, "bot_wp_edit", "0", CVAR_CHEAT);
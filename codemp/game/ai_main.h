@@ -149,6 +149,7 @@ typedef struct bot_state_s
 {
 	int inuse;										//true if this state is used by a bot client
 	int botthink_residual;							//residual for the bot thinks
+	int botthink_deferred;							//think time owed from frames bot_maxThinks held it back
 	int client;										//client number of the bot
 	int entitynum;									//entity number of the bot
 	playerState_t cur_ps;							//current player state
@@ -399,6 +400,15 @@ extern wpobject_t *gWPArray[MAX_WPARRAY_SIZE];
 extern int gWPNum;
 #include "../namespace_end.h"
 
+typedef struct wpCandidate_s
+{
+	float dist;
+	int index;
+} wpCandidate_t;
+
+void BotWPGridDirty(void);
+int BotWPGridCollect(vec3_t org, float radius, wpCandidate_t **candidates);
+
 extern int gLastPrintedIndex;
 #ifndef _XBOX
 extern nodeobject_t nodetable[MAX_NODETABLE_SIZE];
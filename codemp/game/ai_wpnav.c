@@ -346,8 +346,149 @@ checkprint:
 	}
 }
 
+//waypoints hashed into WPGRID_SIZE columns on x and y, so the nearest
+//waypoint searches only look at the ones around them. rebuilt the next time
+//it's used after anything adds, removes or moves a waypoint.
+#define WPGRID_SIZE		256
+#define WPGRID_HASH		1024 //power of two
+
+static int wpGridHead[WPGRID_HASH];
+static int wpGridNext[MAX_WPARRAY_SIZE];
+static qboolean wpGridValid = qfalse;
+static wpCandidate_t wpGridCandidates[MAX_WPARRAY_SIZE];
+
+static int BotWPGridCell(float coord)
+{
+	return (int)floor(coord / WPGRID_SIZE);
+}
+
+static int BotWPGridHash(int x, int y)
+{
+	return ((x * 73856093) ^ (y * 19349663)) & (WPGRID_HASH - 1);
+}
+
+void BotWPGridDirty(void)
+{
+	wpGridValid = qfalse;
+}
+
+static void BotWPGridBuild(void)
+{
+	int i;
+	int hash;
+
+	for (i = 0; i < WPGRID_HASH; i++)
+	{
+		wpGridHead[i] = -1;
+	}
+
+	for (i = 0; i < gWPNum; i++)
+	{
+		wpGridNext[i] = -1;
+
+		if (gWPArray[i] && gWPArray[i]->inuse)
+		{
+			hash = BotWPGridHash(BotWPGridCell(gWPArray[i]->origin[0]), BotWPGridCell(gWPArray[i]->origin[1]));
+			wpGridNext[i] = wpGridHead[hash];
+			wpGridHead[hash] = i;
+		}
+	}
+
+	wpGridValid = qtrue;
+}
+
+static int QDECL BotWPCandidateCompare(const void *a, const void *b)
+{
+	const wpCandidate_t *ca = (const wpCandidate_t *)a;
+	const wpCandidate_t *cb = (const wpCandidate_t *)b;
+
+	if (ca->dist != cb->dist)
+	{
+		return (ca->dist < cb->dist) ? -1 : 1;
+	}
+	return ca->index - cb->index;
+}
+
+//every waypoint in use less than radius from org, nearest first (lowest index
+//first when they're as near), so the expensive checks can stop at the first
+//one that passes. the list is only good until the next call.
+int BotWPGridCollect(vec3_t org, float radius, wpCandidate_t **candidates)
+{
+	int buckets[WPGRID_HASH];
+	char bucketSeen[WPGRID_HASH];
+	int numBuckets = 0;
+	int count = 0;
+	int minX, maxX, minY, maxY;
+	int x, y, i, j, hash;
+	vec3_t a;
+	float flLen;
+
+	if (!wpGridValid)
+	{
+		BotWPGridBuild();
+	}
+
+	minX = BotWPGridCell(org[0] - radius);
+	maxX = BotWPGridCell(org[0] + radius);
+	minY = BotWPGridCell(org[1] - radius);
+	maxY = BotWPGridCell(org[1] + radius);
+
+	if ((double)(maxX - minX + 1) * (double)(maxY - minY + 1) >= WPGRID_HASH)
+	{ //touches at least as many cells as there are buckets, just take them all
+		for (j = 0; j < WPGRID_HASH; j++)
+		{
+			buckets[j] = j;
+		}
+		numBuckets = WPGRID_HASH;
+	}
+	else
+	{ //every cell the radius touches, each hash bucket only once
+		memset(bucketSeen, 0, sizeof(bucketSeen));
+
+		for (x = minX; x <= maxX; x++)
+		{
+			for (y = minY; y <= maxY; y++)
+			{
+				hash = BotWPGridHash(x, y);
+
+				if (!bucketSeen[hash])
+				{
+					bucketSeen[hash] = 1;
+					buckets[numBuckets++] = hash;
+				}
+			}
+		}
+	}
+
+	for (j = 0; j < numBuckets; j++)
+	{
+		for (i = wpGridHead[buckets[j]]; i != -1; i = wpGridNext[i])
+		{
+			VectorSubtract(org, gWPArray[i]->origin, a);
+			flLen = VectorLength(a);
+
+			if (flLen < radius)
+			{
+				wpGridCandidates[count].dist = flLen;
+				wpGridCandidates[count].index = i;
+				count++;
+			}
+		}
+	}
+
+	if (count > 1)
+	{
+		qsort(wpGridCandidates, count, sizeof(wpGridCandidates[0]), BotWPCandidateCompare);
+	}
+
+	*candidates = wpGridCandidates;
+	return count;
+}
+
 void TransferWPData(int from, int to)
 {
+	BotWPGridDirty();
+
 	if (!gWPArray[to])
 	{
 		gWPArray[to] = (wpobject_t *)B_Alloc(sizeof(wpobject_t));
@@ -370,6 +511,8 @@ void TransferWPData(int from, int to)
 
 void CreateNewWP(vec3_t origin, int flags)
 {
+	BotWPGridDirty();
+
 	if (gWPNum >= MAX_WPARRAY_SIZE)
 	{
 		if (!g_RMG.integer)
@@ -404,6 +547,8 @@ void CreateNewWP_FromObject(wpobject_t *wp)
 {
 	int i;
 
+	BotWPGridDirty();
+
 	if (gWPNum >= MAX_WPARRAY_SIZE)
 	{
 		return;
@@ -455,6 +600,8 @@ void CreateNewWP_FromObject(wpobject_t *wp)
 
 void RemoveWP(void)
 {
+	BotWPGridDirty();
+
 	if (gWPNum <= 0)
 	{
 		return;
@@ -495,6 +642,8 @@ void RemoveWP_InTrail(int afterindex)
 	int didchange;
 	int i;
 
+	BotWPGridDirty();
+
 	foundindex = 0;
 	foundanindex = 0;
 	didchange = 0;
@@ -562,6 +711,8 @@ int CreateNewWP_InTrail(vec3_t origin, int flags, int afterindex)
 	int foundanindex;
 	int i;
 
+	BotWPGridDirty();
+
 	foundindex = 0;
 	foundanindex = 0;
 	i = 0;
@@ -640,6 +791,8 @@ int CreateNewWP_InsertUnder(vec3_t origin, int flags, int afterindex)
 	int foundanindex;
 	int i;
 
+	BotWPGridDirty();
+
 	foundindex = 0;
 	foundanindex = 0;
 	i = 0;
@@ -1818,13 +1971,13 @@ int GetNearestVisibleWPToItem(vec3_t org, int ignore)
 {
 	int i;
 	float bestdist;
-	float flLen;
-	int bestindex;
-	vec3_t a, mins, maxs;
+	int numCandidates;
+	wpCandidate_t *candidates;
+	wpobject_t *wp;
+	vec3_t mins, maxs;
 
 	i = 0;
 	bestdist = 64; //has to be less than 64 units to the item or it isn't safe enough
-	bestindex = -1;
 
 	mins[0] = -15;
 	mins[1] = -15;
@@ -1833,26 +1986,23 @@ int GetNearestVisibleWPToItem(vec3_t org, int ignore)
 	maxs[1] = 15;
 	maxs[2] = 0;
 
-	while (i < gWPNum)
+	numCandidates = BotWPGridCollect(org, bestdist, &candidates);
+
+	while (i < numCandidates)
 	{
-		if (gWPArray[i] && gWPArray[i]->inuse &&
-			gWPArray[i]->origin[2]-15 < org[2] &&
-			gWPArray[i]->origin[2]+15 > org[2])
-		{
-			VectorSubtract(org, gWPArray[i]->origin, a);
-			flLen = VectorLength(a);
+		wp = gWPArray[candidates[i].index];
 
-			if (flLen < bestdist && trap_InPVS(org, gWPArray[i]->origin) && OrgVisibleBox(org, mins, maxs, gWPArray[i]->origin, ignore))
-			{
-				bestdist = flLen;
-				bestindex = i;
-			}
+		if (wp->origin[2]-15 < org[2] &&
+			wp->origin[2]+15 > org[2] &&
+			trap_InPVS(org, wp->origin) && OrgVisibleBox(org, mins, maxs, wp->origin, ignore))
+		{
+			return candidates[i].index;
 		}
 
 		i++;
 	}
 
-	return bestindex;
+	return -1;
 }
 
 void CalculateWeightGoals(void)
@@ -2121,9 +2121,177 @@ void G2API_CollisionDetectCache(CollisionRecord_t *collRecMap, CGhoul2Info_v &gh
 }
 
 
+/*
+=======================
+Collision cache
+
+Saber blades, shots and force powers trace the same few models many times a frame.  What
+G2API_CollisionDetect skins stays in the vert space until the frame moves on, and the next
+trace at the same instance, pose, lod and scale carries on from it rather than starting over.
+=======================
+*/
+#define G2_COLLISION_CACHE_SIZE		256		// power of two, indexed by ghoul2 handle
+#define G2_COLLISION_CACHE_MODELS	8
+
+static struct
+{
+	int			traces;
+	int			reused;
+	int			uncached;		// zone allocated verts or too many models
+	int			resets;			// vert space ran low and was emptied
+} g2CollisionStats;
+
+#ifndef _XBOX
+typedef struct
+{
+	int			handle;
+	CMiniHeap	*vertSpace;
+	int			resetCount;		// the vert space's, when these verts went in
+	int			frameNum;
+	int			useLod;
+	vec3_t		scale;
+	unsigned	poseHash;
+	int			numModels;
+	int			*vertArrays[G2_COLLISION_CACHE_MODELS];
+} g2CollisionCache_t;
+
+static g2CollisionCache_t	g2CollisionCache[G2_COLLISION_CACHE_SIZE];
+
+static unsigned G2_HashBytes(unsigned hash, const void *data, int size)
+{
+	const byte *b = (const byte *)data;
+
+	while (size--)
+	{
+		hash = (hash ^ *b++) * 16777619;
+	}
+	return hash;
+}
+
+// everything but the time that decides the pose, so changing a bone override changes this
+static unsigned G2_CollisionPoseHash(CGhoul2Info_v &ghoul2)
+{
+	unsigned	hash = 2166136261u;
+	int			i, j;
+
+	for (i = 0; i < ghoul2.size(); i++)
+	{
+		CGhoul2Info &g = ghoul2[i];
+
+		hash = G2_HashBytes(hash, &g.currentModel, sizeof(g.currentModel));
+		hash = G2_HashBytes(hash, &g.mBoneCache, sizeof(g.mBoneCache));
+		hash = G2_HashBytes(hash, &g.mValid, sizeof(g.mValid));
+		hash = G2_HashBytes(hash, &g.mFlags, sizeof(g.mFlags));
+		hash = G2_HashBytes(hash, &g.mModelBoltLink, sizeof(g.mModelBoltLink));
+		hash = G2_HashBytes(hash, &g.mNewOrigin, sizeof(g.mNewOrigin));
+		hash = G2_HashBytes(hash, &g.mLodBias, sizeof(g.mLodBias));
+		for (j = 0; j < g.mBlist.size(); j++)
+		{
+			// the override itself, not the lerp and ragdoll state kept after it
+			const boneInfo_t &bone = g.mBlist[j];
+			hash = G2_HashBytes(hash, &bone, (const byte *)&bone.newMatrix - (const byte *)&bone);
+		}
+	}
+	return hash;
+}
+
+// get the model ready for G2_TraceModels, reusing what an earlier trace this frame skinned if we can
+static void G2_CollisionTransform(CGhoul2Info_v &ghoul2, int frameNumber, vec3_t scale, CMiniHeap *G2VertSpace, int useLod)
+{
+	g2CollisionCache_t	*c = &g2CollisionCache[ghoul2.mItem & (G2_COLLISION_CACHE_SIZE - 1)];
+	bool				cacheable;
+	unsigned			poseHash;
+	int					i;
+
+	g2CollisionStats.traces++;
+
+	cacheable = com_g2CollisionCache && com_g2CollisionCache->integer && ghoul2.size() <= G2_COLLISION_CACHE_MODELS;
+	for (i = 0; cacheable && i < ghoul2.size(); i++)
+	{
+		// G2API_CollisionDetectCache owns these and fills them its own way
+		if (ghoul2[i].mFlags & GHOUL2_ZONETRANSALLOC)
+		{
+			cacheable = false;
+		}
+	}
+	if (!cacheable)
+	{
+		g2CollisionStats.uncached++;
+		G2VertSpace->ResetHeap();
+		G2_TransformModelDeferred(ghoul2, frameNumber, scale, G2VertSpace);
+		return;
+	}
+
+	// the trace may yet skin the whole model, leave it room to
+	if (G2VertSpace->FreeSpace() < G2VertSpace->Size() / 2)
+	{
+		g2CollisionStats.resets++;
+		G2VertSpace->ResetHeap();
+	}
+
+	poseHash = G2_CollisionPoseHash(ghoul2);
+	if (c->handle == ghoul2.mItem &&
+		c->vertSpace == G2VertSpace &&
+		c->resetCount == G2VertSpace->ResetCount() &&
+		c->frameNum == frameNumber &&
+		c->useLod == useLod &&
+		VectorCompare(c->scale, scale) &&
+		c->poseHash == poseHash &&
+		c->numModels == ghoul2.size())
+	{
+		for (i = 0; i < c->numModels; i++)
+		{
+			// something else transformed it since
+			if (ghoul2[i].mTransformedVertsArray != c->vertArrays[i])
+			{
+				break;
+			}
+		}
+		if (i == c->numModels)
+		{
+			g2CollisionStats.reused++;
+			G2_ResumeDeferredTransform(scale, G2VertSpace);
+			return;
+		}
+	}
+
+	G2_TransformModelDeferred(ghoul2, frameNumber, scale, G2VertSpace);
+
+	c->handle = ghoul2.mItem;
+	c->vertSpace = G2VertSpace;
+	c->resetCount = G2VertSpace->ResetCount();
+	c->frameNum = frameNumber;
+	c->useLod = useLod;
+	VectorCopy(scale, c->scale);
+	c->poseHash = poseHash;
+	c->numModels = ghoul2.size();
+	for (i = 0; i < c->numModels; i++)
+	{
+		c->vertArrays[i] = ghoul2[i].mTransformedVertsArray;
+	}
+}
+#endif // _XBOX
+
+void G2API_CollisionCacheInfo(qboolean reset)
+{
+	Com_Printf("%i ghoul2 collision traces, %i reused this frame's skinning", g2CollisionStats.traces, g2CollisionStats.reused);
+	if (g2CollisionStats.traces)
+	{
+		Com_Printf(" (%.1f%%)", 100.0f * g2CollisionStats.reused / g2CollisionStats.traces);
+	}
+	Com_Printf(", %i uncacheable, %i vert space resets\n", g2CollisionStats.uncached, g2CollisionStats.resets);
+
+	if (reset)
+	{
+		memset(&g2CollisionStats, 0, sizeof(g2CollisionStats));
+	}
+}
+
 void G2API_CollisionDetect(CollisionRecord_t *collRecMap, CGhoul2Info_v &ghoul2, const vec3_t angles, const vec3_t position,
 										  int frameNumber, int entNum, vec3_t rayStart, vec3_t rayEnd, vec3_t scale, CMiniHeap *G2VertSpace, int traceFlags, int useLod, float fRadius)
 {
+	PROFILE_ZONE( "G2API_CollisionDetect" );
+
 	/*
 	if (1)
 	{
@@ -2143,13 +2311,18 @@ void G2API_CollisionDetect(CollisionRecord_t *collRecMap, CGhoul2Info_v &ghoul2,
 		// pre generate the world matrix - used to transform the incoming ray
 		G2_GenerateWorldMatrix(angles, position);
 
-		G2VertSpace->ResetHeap();
-
 		// now having done that, time to build the model
+#ifndef _XBOX
+		// the trace skins surfaces as it reaches them, and only the parts the ray could touch,
+		// carrying on from whatever earlier traces at this pose left
+		G2_CollisionTransform(ghoul2, frameNumber, scale, G2VertSpace, useLod);
+#else
+		G2VertSpace->ResetHeap();
 #ifdef _G2_GORE
 		G2_TransformModel(ghoul2, frameNumber, scale, G2VertSpace, useLod, false);
 #else
 		G2_TransformModel(ghoul2, frameNumber, scale, G2VertSpace, useLod);
+#endif
 #endif
 
 		// model is built. Lets check to see if any triangles are actually hit.
@@ -2162,6 +2335,9 @@ void G2API_CollisionDetect(CollisionRecord_t *collRecMap, CGhoul2Info_v &ghoul2,
 		G2_TraceModels(ghoul2, transRayStart, transRayEnd, collRecMap, entNum, traceFlags, useLod, fRadius,0,0,0,0,0,qfalse);
 #else
 		G2_TraceModels(ghoul2, transRayStart, transRayEnd, collRecMap, entNum, traceFlags, useLod, fRadius);
+#endif
+#ifndef _XBOX
+		G2_EndDeferredTransform();
 #endif
 		int i;
 		for ( i = 0; i < MAX_G2_COLLISIONS && collRecMap[i].mEntityNum != -1; i ++ );
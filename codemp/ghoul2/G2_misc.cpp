@@ -185,6 +185,7 @@ extern mdxaBone_t		worldMatrix;
 extern mdxaBone_t		worldMatrixInv;
 
 const mdxaBone_t &EvalBoneCache(int index,CBoneCache *boneCache);
+qboolean G2_SkinCollisionSurface(const mdxmSurface_t *surface, CBoneCache *boneCache, const vec3_t scale, float *out);
 
 #pragma warning(disable : 4512)		//assignment op could not be genereated
 class CTraceSurface
@@ -202,6 +203,7 @@ public:
 	skin_t				*skin;
 	shader_t			*cust_shader;
 	int					*TransformedVertsArray;
+	CBoneCache			*boneCache;		// to skin what G2_TransformModelDeferred didn't
 	int					traceFlags;
 	bool				hitOne;
 	float				m_fRadius;
@@ -269,6 +271,7 @@ public:
 	{
 		VectorCopy(initrayStart, rayStart);
 		VectorCopy(initrayEnd, rayEnd);
+		boneCache = NULL;
 		hitOne = false;
 	}         
 
@@ -400,11 +403,48 @@ int G2_DecideTraceLod(CGhoul2Info &ghoul2, int useLod)
 #ifdef _XBOX
 // This is in tr_ghoul2 for various reasons.
 extern void R_TransformEachSurface( const mdxmSurface_t *surface, vec3_t scale, CMiniHeap *G2VertSpace, int *TransformedVertsArray,CBoneCache *boneCache);
+
+// the collision bounds don't know the xbox vertex format
+void G2_BuildCollisionVolumes(model_t *mod)
+{
+	mod->g2Collision = NULL;
+}
 #else
+// skin one vertex into the five floats a trace wants, position and then texture coords
+static void G2_SkinTraceVert(const mdxmVertex_t *v, const mdxmVertexTexCoord_t *texCoord, const int *piBoneReferences, CBoneCache *boneCache, const vec3_t scale, float *out)
+{
+	vec3_t	tempVert;
+	int		k;
+
+	VectorClear( tempVert );
+
+	const int iNumWeights = G2_GetVertWeights( v );
+
+	float fTotalWeight = 0.0f;
+	for ( k = 0 ; k < iNumWeights ; k++ ) 
+	{
+		int		iBoneIndex	= G2_GetVertBoneIndex( v, k );
+		float	fBoneWeight	= G2_GetVertBoneWeight( v, k, fTotalWeight, iNumWeights );
+
+		const mdxaBone_t &bone=EvalBoneCache(piBoneReferences[iBoneIndex],boneCache);
+
+		tempVert[0] += fBoneWeight * ( DotProduct( bone.matrix[0], v->vertCoords ) + bone.matrix[0][3] );
+		tempVert[1] += fBoneWeight * ( DotProduct( bone.matrix[1], v->vertCoords ) + bone.matrix[1][3] );
+		tempVert[2] += fBoneWeight * ( DotProduct( bone.matrix[2], v->vertCoords ) + bone.matrix[2][3] );
+	}
+
+	// copy tranformed verts into temp space
+	out[0] = tempVert[0] * scale[0];
+	out[1] = tempVert[1] * scale[1];
+	out[2] = tempVert[2] * scale[2];
+	// we will need the S & T coors too for hitlocation and hitmaterial stuff
+	out[3] = texCoord->texCoords[0];
+	out[4] = texCoord->texCoords[1];
+}
+
 void R_TransformEachSurface( const mdxmSurface_t *surface, vec3_t scale, CMiniHeap *G2VertSpace, int *TransformedVertsArray,CBoneCache *boneCache) 
 {
-	int				 j, k;
-	mdxmVertex_t 	*v;
+	int				 j;
 	float			*TransformedVerts;
 
 	//
@@ -420,98 +460,356 @@ void R_TransformEachSurface( const mdxmSurface_t *surface, vec3_t scale, CMiniHe
 		Com_Error(ERR_DROP, "Ran out of transform space for Ghoul2 Models. Adjust MiniHeapSize in SV_SpawnServer.\n");
 	}
 
+	if (G2_SkinCollisionSurface(surface, boneCache, scale, TransformedVerts))
+	{
+		return;
+	}
+
 	// whip through and actually transform each vertex
 	const int numVerts = surface->numVerts;
-	v = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
-	mdxmVertexTexCoord_t *pTexCoords = (mdxmVertexTexCoord_t *) &v[numVerts];
+	const mdxmVertex_t *v = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
+	const mdxmVertexTexCoord_t *pTexCoords = (mdxmVertexTexCoord_t *) &v[numVerts];
 
-	// optimisation issue
-	if ((scale[0] != 1.0) || (scale[1] != 1.0) || (scale[2] != 1.0))
+	for ( j = 0; j < numVerts; j++ ) 
 	{
-		for ( j = 0; j < numVerts; j++ ) 
+		G2_SkinTraceVert(&v[j], &pTexCoords[j], piBoneReferences, boneCache, scale, &TransformedVerts[j * 5]);
+	}
+}
+
+/*
+==============================================================================
+
+Collision bounds
+
+Skinning every vertex of every surface just to test one ray against it is
+most of the cost of a trace.  When a model loads, each surface gets a bind
+pose sphere per bone it references, around the verts that bone moves, and
+its triangles are cut into runs of G2_CLUSTER_TRIS with spheres of their own.
+A skinned vertex is a weighted average of where each of its bones puts it,
+so it lies inside the box around those bones' posed spheres.  A trace can
+skip any surface or run whose box it misses and skin only what is left.
+
+==============================================================================
+*/
+
+#define G2_CLUSTER_TRIS		32
+#define G2_BOUNDS_EPSILON	0.5f	// slack for float error, in model units
+
+typedef struct {
+	int				boneRef;		// index into the surface's bone references
+	vec3_t			center;			// bind pose
+	float			radius;
+} g2BoneSphere_t;
+
+typedef struct {
+	int				firstTri;
+	int				numTris;
+	int				firstVert;		// into g2SurfCollision_t verts, the verts these tris use
+	int				numVerts;
+	int				firstSphere;	// into g2SurfCollision_t spheres
+	int				numSpheres;
+} g2TriCluster_t;
+
+typedef struct {
+	qboolean		valid;			// false if the weights can't be bounded this way, trace it the old way
+	int				numSpheres;		// the whole surface's spheres come first
+	g2BoneSphere_t	*spheres;
+	int				numClusters;
+	g2TriCluster_t	*clusters;
+	short			*verts;
+} g2SurfCollision_t;
+
+typedef struct g2Collision_s {
+	int					numSurfaces;
+	g2SurfCollision_t	*surfaces;		// [lod * numSurfaces + surface]
+} g2Collision_t;
+
+static bool G2_VertUsesBone(const mdxmVertex_t *v, int boneRef)
+{
+	const int iNumWeights = G2_GetVertWeights( v );
+	int k;
+
+	for ( k = 0 ; k < iNumWeights ; k++ ) 
+	{
+		if (G2_GetVertBoneIndex( v, k ) == boneRef)
 		{
-			vec3_t			tempVert, tempNormal;
-//			mdxmWeight_t	*w;
+			return true;
+		}
+	}
+	return false;
+}
 
-			VectorClear( tempVert );
-			VectorClear( tempNormal );
-//			w = v->weights;
+// sphere around the verts in the list that boneRef moves, false if it moves none of them
+static bool G2_BuildBoneSphere(const mdxmVertex_t *verts, const short *list, int numList, int boneRef, g2BoneSphere_t *sphere)
+{
+	vec3_t	mins, maxs;
+	float	d;
+	int		i, count;
 
-			const int iNumWeights = G2_GetVertWeights( v );
+	count = 0;
+	ClearBounds(mins, maxs);
+	for (i = 0; i < numList; i++)
+	{
+		if (G2_VertUsesBone(&verts[list[i]], boneRef))
+		{
+			AddPointToBounds(verts[list[i]].vertCoords, mins, maxs);
+			count++;
+		}
+	}
+	if (!count)
+	{
+		return false;
+	}
 
-			float fTotalWeight = 0.0f;
-			for ( k = 0 ; k < iNumWeights ; k++ ) 
+	sphere->boneRef = boneRef;
+	VectorAdd(mins, maxs, sphere->center);
+	VectorScale(sphere->center, 0.5f, sphere->center);
+	sphere->radius = 0;
+	for (i = 0; i < numList; i++)
+	{
+		if (G2_VertUsesBone(&verts[list[i]], boneRef))
+		{
+			d = Distance(verts[list[i]].vertCoords, sphere->center);
+			if (d > sphere->radius)
 			{
-				int		iBoneIndex	= G2_GetVertBoneIndex( v, k );
-				float	fBoneWeight	= G2_GetVertBoneWeight( v, k, fTotalWeight, iNumWeights );
+				sphere->radius = d;
+			}
+		}
+	}
+	return true;
+}
 
-				const mdxaBone_t &bone=EvalBoneCache(piBoneReferences[iBoneIndex],boneCache);
+static void G2_BuildSurfaceCollision(const mdxmSurface_t *surface, g2SurfCollision_t *sc)
+{
+	static short	list[SHADER_MAX_VERTEXES];
+	static byte		used[SHADER_MAX_VERTEXES];
+	const mdxmVertex_t		*verts = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
+	const mdxmTriangle_t	*tris = (mdxmTriangle_t *) ((byte *)surface + surface->ofsTriangles);
+	const int		numVerts = surface->numVerts;
+	const int		numBoneRefs = surface->numBoneReferences;
+	g2BoneSphere_t	*spheres;
+	g2TriCluster_t	*clusters;
+	short			*clusterVerts;
+	int				i, j, k, numClusters, numSpheres, numClusterVerts, maxClusterVerts;
+
+	memset(sc, 0, sizeof(*sc));
+	if (numVerts > SHADER_MAX_VERTEXES)
+	{
+		return;
+	}
 
-				tempVert[0] += fBoneWeight * ( DotProduct( bone.matrix[0], v->vertCoords ) + bone.matrix[0][3] );
-				tempVert[1] += fBoneWeight * ( DotProduct( bone.matrix[1], v->vertCoords ) + bone.matrix[1][3] );
-				tempVert[2] += fBoneWeight * ( DotProduct( bone.matrix[2], v->vertCoords ) + bone.matrix[2][3] );
+	// the last weight is whatever the others leave, so a vertex is only a blend of its bones if they leave something
+	for (i = 0; i < numVerts; i++)
+	{
+		const int iNumWeights = G2_GetVertWeights( &verts[i] );
+		float fTotalWeight = 0.0f;
 
-				tempNormal[0] += fBoneWeight * DotProduct( bone.matrix[0], v->normal );
-				tempNormal[1] += fBoneWeight * DotProduct( bone.matrix[1], v->normal );
-				tempNormal[2] += fBoneWeight * DotProduct( bone.matrix[2], v->normal );
+		for (k = 0; k < iNumWeights; k++)
+		{
+			if (G2_GetVertBoneIndex( &verts[i], k ) >= numBoneRefs)
+			{
+				return;
 			}
-			int pos = j * 5;
+			G2_GetVertBoneWeight( &verts[i], k, fTotalWeight, iNumWeights );
+		}
+		if (fTotalWeight > 1.001f)
+		{
+			return;
+		}
+	}
 
-			// copy tranformed verts into temp space
-			TransformedVerts[pos++] = tempVert[0] * scale[0];
-			TransformedVerts[pos++] = tempVert[1] * scale[1];
-			TransformedVerts[pos++] = tempVert[2] * scale[2];
-			// we will need the S & T coors too for hitlocation and hitmaterial stuff
-			TransformedVerts[pos++] = pTexCoords[j].texCoords[0];
-			TransformedVerts[pos] = pTexCoords[j].texCoords[1];
+	numClusters = (surface->numTriangles + G2_CLUSTER_TRIS - 1) / G2_CLUSTER_TRIS;
+	maxClusterVerts = min(numVerts, G2_CLUSTER_TRIS * 3);
+	spheres = (g2BoneSphere_t *)Z_Malloc(numBoneRefs * (numClusters + 1) * sizeof(g2BoneSphere_t), TAG_TEMP_WORKSPACE, qfalse);
+	clusters = (g2TriCluster_t *)Z_Malloc(numClusters * sizeof(g2TriCluster_t), TAG_TEMP_WORKSPACE, qfalse);
+	clusterVerts = (short *)Z_Malloc(numClusters * maxClusterVerts * sizeof(short), TAG_TEMP_WORKSPACE, qfalse);
 
-			v++;// = (mdxmVertex_t *)&v->weights[/*v->numWeights*/surface->maxVertBoneWeights];
-		}
+	// the whole surface
+	for (i = 0; i < numVerts; i++)
+	{
+		list[i] = i;
 	}
-	else
+	numSpheres = 0;
+	for (k = 0; k < numBoneRefs; k++)
 	{
-		int pos = 0;
-	  	for ( j = 0; j < numVerts; j++ ) 
+		if (G2_BuildBoneSphere(verts, list, numVerts, k, &spheres[numSpheres]))
 		{
-			vec3_t			tempVert, tempNormal;
-//			const mdxmWeight_t	*w;
+			numSpheres++;
+		}
+	}
+	sc->numSpheres = numSpheres;
 
-			VectorClear( tempVert );
-			VectorClear( tempNormal );
-//			w = v->weights;
+	// and each run of triangles
+	numClusterVerts = 0;
+	for (i = 0; i < numClusters; i++)
+	{
+		g2TriCluster_t *c = &clusters[i];
 
-			const int iNumWeights = G2_GetVertWeights( v );
+		c->firstTri = i * G2_CLUSTER_TRIS;
+		c->numTris = min(G2_CLUSTER_TRIS, surface->numTriangles - c->firstTri);
+		c->firstVert = numClusterVerts;
+		memset(used, 0, numVerts);
+		for (j = c->firstTri; j < c->firstTri + c->numTris; j++)
+		{
+			for (k = 0; k < 3; k++)
+			{
+				const int index = tris[j].indexes[k];
+				if (!used[index])
+				{
+					used[index] = 1;
+					clusterVerts[numClusterVerts++] = index;
+				}
+			}
+		}
+		c->numVerts = numClusterVerts - c->firstVert;
 
-			float fTotalWeight = 0.0f;
-			for ( k = 0 ; k < iNumWeights ; k++ ) 
+		c->firstSphere = numSpheres;
+		for (k = 0; k < numBoneRefs; k++)
+		{
+			if (G2_BuildBoneSphere(verts, &clusterVerts[c->firstVert], c->numVerts, k, &spheres[numSpheres]))
 			{
-				int		iBoneIndex	= G2_GetVertBoneIndex( v, k );
-				float	fBoneWeight	= G2_GetVertBoneWeight( v, k, fTotalWeight, iNumWeights );
+				numSpheres++;
+			}
+		}
+		c->numSpheres = numSpheres - c->firstSphere;
+	}
+
+	// keep just what we used
+	sc->valid = qtrue;
+	sc->spheres = (g2BoneSphere_t *)Hunk_Alloc(numSpheres * sizeof(g2BoneSphere_t), h_low);
+	memcpy(sc->spheres, spheres, numSpheres * sizeof(g2BoneSphere_t));
+	sc->numClusters = numClusters;
+	sc->clusters = (g2TriCluster_t *)Hunk_Alloc(numClusters * sizeof(g2TriCluster_t), h_low);
+	memcpy(sc->clusters, clusters, numClusters * sizeof(g2TriCluster_t));
+	sc->verts = (short *)Hunk_Alloc(numClusterVerts * sizeof(short), h_low);
+	memcpy(sc->verts, clusterVerts, numClusterVerts * sizeof(short));
+
+	Z_Free(clusterVerts);
+	Z_Free(clusters);
+	Z_Free(spheres);
+}
 
-				const mdxaBone_t &bone=EvalBoneCache(piBoneReferences[iBoneIndex],boneCache);
+// called once an mdxm has loaded, the bounds live on the hunk with the model
+void G2_BuildCollisionVolumes(model_t *mod)
+{
+	g2Collision_t	*col;
+	int				l, i;
 
-				tempVert[0] += fBoneWeight * ( DotProduct( bone.matrix[0], v->vertCoords ) + bone.matrix[0][3] );
-				tempVert[1] += fBoneWeight * ( DotProduct( bone.matrix[1], v->vertCoords ) + bone.matrix[1][3] );
-				tempVert[2] += fBoneWeight * ( DotProduct( bone.matrix[2], v->vertCoords ) + bone.matrix[2][3] );
+	if (mod->g2Collision || !mod->mdxm)
+	{
+		return;
+	}
 
-				tempNormal[0] += fBoneWeight * DotProduct( bone.matrix[0], v->normal );
-				tempNormal[1] += fBoneWeight * DotProduct( bone.matrix[1], v->normal );
-				tempNormal[2] += fBoneWeight * DotProduct( bone.matrix[2], v->normal );
+	col = (g2Collision_t *)Hunk_Alloc(sizeof(g2Collision_t), h_low);
+	col->numSurfaces = mod->mdxm->numSurfaces;
+	col->surfaces = (g2SurfCollision_t *)Hunk_Alloc(mod->mdxm->numLODs * col->numSurfaces * sizeof(g2SurfCollision_t), h_low);
+	for (l = 0; l < mod->mdxm->numLODs; l++)
+	{
+		for (i = 0; i < col->numSurfaces; i++)
+		{
+			G2_BuildSurfaceCollision((mdxmSurface_t *)G2_FindSurface(mod, i, l), &col->surfaces[l * col->numSurfaces + i]);
+		}
+	}
+	mod->g2Collision = col;
+}
+
+// how far the bone can stretch a vector, from the largest row sum of its transpose times itself
+static float G2_BoneStretch(const mdxaBone_t &bone)
+{
+	float	g[3][3];
+	float	sum, best;
+	int		i, j;
+
+	for (i = 0; i < 3; i++)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			g[i][j] = bone.matrix[0][i] * bone.matrix[0][j] + bone.matrix[1][i] * bone.matrix[1][j] + bone.matrix[2][i] * bone.matrix[2][j];
+		}
+	}
+	best = 0;
+	for (i = 0; i < 3; i++)
+	{
+		sum = fabs(g[i][0]) + fabs(g[i][1]) + fabs(g[i][2]);
+		if (sum > best)
+		{
+			best = sum;
+		}
+	}
+	return sqrt(best);
+}
+
+// grow the box to hold where the current pose puts each sphere
+static void G2_AddPosedSpheres(const g2BoneSphere_t *spheres, int numSpheres, const int *piBoneReferences, CBoneCache *boneCache, const vec3_t scale, vec3_t mins, vec3_t maxs)
+{
+	const float	maxScale = max(fabs(scale[0]), max(fabs(scale[1]), fabs(scale[2])));
+	int			i, j;
+
+	for (i = 0; i < numSpheres; i++)
+	{
+		const g2BoneSphere_t *s = &spheres[i];
+		const mdxaBone_t &bone = EvalBoneCache(piBoneReferences[s->boneRef], boneCache);
+		const float r = s->radius * G2_BoneStretch(bone) * maxScale + G2_BOUNDS_EPSILON;
+
+		for (j = 0; j < 3; j++)
+		{
+			const float c = (DotProduct(bone.matrix[j], s->center) + bone.matrix[j][3]) * scale[j];
+			if (c - r < mins[j])
+			{
+				mins[j] = c - r;
+			}
+			if (c + r > maxs[j])
+			{
+				maxs[j] = c + r;
 			}
+		}
+	}
+}
 
-			// copy tranformed verts into temp space
-			TransformedVerts[pos++] = tempVert[0];
-			TransformedVerts[pos++] = tempVert[1];
-			TransformedVerts[pos++] = tempVert[2];
-			// we will need the S & T coors too for hitlocation and hitmaterial stuff
-			TransformedVerts[pos++] = pTexCoords[j].texCoords[0];
-			TransformedVerts[pos++] = pTexCoords[j].texCoords[1];
+// does the segment from start to end touch the box
+static bool G2_SegmentHitsBox(const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs)
+{
+	float	enter = 0.0f, leave = 1.0f;
+	float	t0, t1, d;
+	int		i;
 
-			v++;// = (mdxmVertex_t *)&v->weights[/*v->numWeights*/surface->maxVertBoneWeights];
+	for (i = 0; i < 3; i++)
+	{
+		d = end[i] - start[i];
+		if (d == 0.0f)
+		{
+			if (start[i] < mins[i] || start[i] > maxs[i])
+			{
+				return false;
+			}
+			continue;
+		}
+		t0 = (mins[i] - start[i]) / d;
+		t1 = (maxs[i] - start[i]) / d;
+		if (t0 > t1)
+		{
+			d = t0; t0 = t1; t1 = d;
+		}
+		if (t0 > enter)
+		{
+			enter = t0;
+		}
+		if (t1 < leave)
+		{
+			leave = t1;
+		}
+		if (enter > leave)
+		{
+			return false;
 		}
 	}
+	return true;
 }
 
+// G2_TransformModelDeferred leaves the skinning to the trace, which needs these
+static CMiniHeap	*g2DeferredVertSpace = NULL;
+static vec3_t		g2DeferredScale;
+
 #endif // _XBOX
 
 void G2_TransformSurfaces(int surfaceNum, surfaceInfo_v &rootSList, 
@@ -578,6 +876,11 @@ void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale,
 	}
 
 
+#ifndef _XBOX
+	// everything gets skinned here, nothing is left for the trace
+	g2DeferredVertSpace = NULL;
+#endif
+
 	VectorCopy(scale, correctScale);
 	// check for scales of 0 - that's the default I believe
 	if (!scale[0])
@@ -661,6 +964,68 @@ void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale,
 }
 
 
+#ifndef _XBOX
+// like G2_TransformModel, but skin nothing yet.  G2_TraceSurfaces skins what the ray
+// might touch as it gets there, until G2_EndDeferredTransform
+void G2_TransformModelDeferred(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, CMiniHeap *G2VertSpace)
+{
+	int				i;
+
+	for (i=0; i<ghoul2.size(); i++)
+	{
+		CGhoul2Info &g=ghoul2[i];
+		// don't bother with models that we don't care about.
+		if (!g.mValid)
+		{
+			continue;
+		}
+		assert(g.mBoneCache);
+		// stop us building this model more than once per frame
+		g.mMeshFrameNum = frameNum;
+
+		// give us space for the transformed vertex array to be put in
+		if (!(g.mFlags & GHOUL2_ZONETRANSALLOC))
+		{ //do not stomp if we're using zone space
+			g.mTransformedVertsArray = (int*)G2VertSpace->MiniHeapAlloc(g.currentModel->mdxm->numSurfaces * 4);
+			if (!g.mTransformedVertsArray)
+			{
+				Com_Error(ERR_DROP, "Ran out of transform space for Ghoul2 Models. Adjust MiniHeapSize in SV_SpawnServer.\n");
+			}
+		}
+
+		// a surface with no verts here hasn't been traced yet
+		memset(g.mTransformedVertsArray, 0,(g.currentModel->mdxm->numSurfaces * 4)); 
+	}
+
+	G2_ResumeDeferredTransform(scale, G2VertSpace);
+}
+
+// carry on skinning into what an earlier G2_TransformModelDeferred of the same pose left in
+// G2VertSpace, its verts must still be there
+void G2_ResumeDeferredTransform(vec3_t scale, CMiniHeap *G2VertSpace)
+{
+	int				i;
+
+	// check for scales of 0 - that's the default I believe
+	VectorCopy(scale, g2DeferredScale);
+	for (i = 0; i < 3; i++)
+	{
+		if (!scale[i])
+		{
+			g2DeferredScale[i] = 1.0;
+		}
+	}
+
+	g2DeferredVertSpace = G2VertSpace;
+}
+
+void G2_EndDeferredTransform(void)
+{
+	g2DeferredVertSpace = NULL;
+}
+#endif // _XBOX
+
+
 // work out how much space a triangle takes
 static float	G2_AreaOfTri(const vec3_t A, const vec3_t B, const vec3_t C)
 {
@@ -1088,153 +1453,156 @@ struct SVertexTemp
 static SVertexTemp GoreVerts[MAX_GORE_VERTS];
 #endif
 
-// now we're at poly level, check each model space transformed poly against the model world transfomed ray
-static bool G2_TracePolys(const mdxmSurface_t *surface, const mdxmSurfHierarchy_t *surfInfo, CTraceSurface &TS)
+// test one model space transformed poly against the model world transfomed ray, true if the trace should stop
+static bool G2_TracePoly(const mdxmSurface_t *surface, const mdxmTriangle_t *tris, const float *verts, int j, CTraceSurface &TS)
 {
-	int				j, numTris;
-	
-	// whip through and actually transform each vertex
-	const mdxmTriangle_t *tris = (mdxmTriangle_t *) ((byte *)surface + surface->ofsTriangles);
-	const float *verts = (float *)TS.TransformedVertsArray[surface->thisSurfaceIndex];
-	numTris = surface->numTriangles;
-	for ( j = 0; j < numTris; j++ ) 
-	{
-		float			face;
-		vec3_t	hitPoint, normal;
-		// determine actual coords for this triangle
-		const float *point1 = &verts[(tris[j].indexes[0] * 5)];
-		const float *point2 = &verts[(tris[j].indexes[1] * 5)];
-		const float *point3 = &verts[(tris[j].indexes[2] * 5)];
-		// did we hit it?
-		int i;
-		if (G2_SegmentTriangleTest(TS.rayStart, TS.rayEnd, point1, point2, point3, qtrue, qtrue, hitPoint, normal, &face))
-		{	// find space in the collision records for this record
-			for (i=0; i<MAX_G2_COLLISIONS;i++)
+	float			face;
+	vec3_t	hitPoint, normal;
+	// determine actual coords for this triangle
+	const float *point1 = &verts[(tris[j].indexes[0] * 5)];
+	const float *point2 = &verts[(tris[j].indexes[1] * 5)];
+	const float *point3 = &verts[(tris[j].indexes[2] * 5)];
+	// did we hit it?
+	int i;
+	if (G2_SegmentTriangleTest(TS.rayStart, TS.rayEnd, point1, point2, point3, qtrue, qtrue, hitPoint, normal, &face))
+	{	// find space in the collision records for this record
+		for (i=0; i<MAX_G2_COLLISIONS;i++)
+		{
+			if (TS.collRecMap[i].mEntityNum == -1)
 			{
-				if (TS.collRecMap[i].mEntityNum == -1)
+				CollisionRecord_t  	&newCol = TS.collRecMap[i];
+				vec3_t			  	distVect;
+				float				x_pos = 0, y_pos = 0;
+				
+				newCol.mPolyIndex = j;
+				newCol.mEntityNum = TS.entNum;
+				newCol.mSurfaceIndex = surface->thisSurfaceIndex;
+				newCol.mModelIndex = TS.modelIndex;
+				if (face>0)
 				{
-					CollisionRecord_t  	&newCol = TS.collRecMap[i];
-					vec3_t			  	distVect;
-					float				x_pos = 0, y_pos = 0;
-					
-					newCol.mPolyIndex = j;
-					newCol.mEntityNum = TS.entNum;
-					newCol.mSurfaceIndex = surface->thisSurfaceIndex;
-					newCol.mModelIndex = TS.modelIndex;
-					if (face>0)
-					{
-						newCol.mFlags = G2_FRONTFACE;
-					}
-					else
-					{
-						newCol.mFlags = G2_BACKFACE;
-					}
+					newCol.mFlags = G2_FRONTFACE;
+				}
+				else
+				{
+					newCol.mFlags = G2_BACKFACE;
+				}
 
-					VectorSubtract(hitPoint, TS.rayStart, distVect);
-					newCol.mDistance = VectorLength(distVect);
+				VectorSubtract(hitPoint, TS.rayStart, distVect);
+				newCol.mDistance = VectorLength(distVect);
 
-					// put the hit point back into world space
-					TransformAndTranslatePoint(hitPoint, newCol.mCollisionPosition, &worldMatrix);
+				// put the hit point back into world space
+				TransformAndTranslatePoint(hitPoint, newCol.mCollisionPosition, &worldMatrix);
 
-					// transform normal (but don't translate) into world angles
-					TransformPoint(normal, newCol.mCollisionNormal, &worldMatrix);
-					VectorNormalize(newCol.mCollisionNormal);
+				// transform normal (but don't translate) into world angles
+				TransformPoint(normal, newCol.mCollisionNormal, &worldMatrix);
+				VectorNormalize(newCol.mCollisionNormal);
 
-					newCol.mMaterial = newCol.mLocation = 0;
+				newCol.mMaterial = newCol.mLocation = 0;
 
-					// Determine our location within the texture, and barycentric coordinates
-					G2_BuildHitPointST(point1, point1[3], point1[4],
-									   point2, point2[3], point2[4],
-									   point3, point3[3], point3[4],
-									   hitPoint, &x_pos, &y_pos,newCol.mBarycentricI,newCol.mBarycentricJ); 
-									
+				// Determine our location within the texture, and barycentric coordinates
+				G2_BuildHitPointST(point1, point1[3], point1[4],
+								   point2, point2[3], point2[4],
+								   point3, point3[3], point3[4],
+								   hitPoint, &x_pos, &y_pos,newCol.mBarycentricI,newCol.mBarycentricJ); 
+								
 /*
-					const shader_t		*shader = 0;
-					// now, we know what surface this hit belongs to, we need to go get the shader handle so we can get the correct hit location and hit material info
-					if ( cust_shader ) 
-					{
-						shader = cust_shader;
-					} 
-					else if ( skin ) 
+				const shader_t		*shader = 0;
+				// now, we know what surface this hit belongs to, we need to go get the shader handle so we can get the correct hit location and hit material info
+				if ( cust_shader ) 
+				{
+					shader = cust_shader;
+				} 
+				else if ( skin ) 
+				{
+					int		j;
+						
+					// match the surface name to something in the skin file
+					shader = tr.defaultShader;
+					for ( j = 0 ; j < skin->numSurfaces ; j++ )
 					{
-						int		j;
-							
-						// match the surface name to something in the skin file
-						shader = tr.defaultShader;
-						for ( j = 0 ; j < skin->numSurfaces ; j++ )
+						// the names have both been lowercased
+						if ( !strcmp( skin->surfaces[j]->name, surfInfo->name ) ) 
 						{
-							// the names have both been lowercased
-							if ( !strcmp( skin->surfaces[j]->name, surfInfo->name ) ) 
-							{
-								shader = skin->surfaces[j]->shader;
-								break;
-							}
+							shader = skin->surfaces[j]->shader;
+							break;
 						}
-					} 
-					else 
-					{
-						shader = R_GetShaderByHandle( surfInfo->shaderIndex );
 					}
+				} 
+				else 
+				{
+					shader = R_GetShaderByHandle( surfInfo->shaderIndex );
+				}
 
-					// do we even care to decide what the hit or location area's are? If we don't have them in the shader there is little point
-					if ((shader->hitLocation) || (shader->hitMaterial))
-					{
+				// do we even care to decide what the hit or location area's are? If we don't have them in the shader there is little point
+				if ((shader->hitLocation) || (shader->hitMaterial))
+				{
  						// ok, we have a floating point position. - determine location in data we need to look at
-						if (shader->hitLocation)
-						{
-							newCol.mLocation = *(hitMatReg[shader->hitLocation].loc +
-												((int)(y_pos * hitMatReg[shader->hitLocation].height) * hitMatReg[shader->hitLocation].width) +
-												((int)(x_pos * hitMatReg[shader->hitLocation].width)));
-							Com_Printf("G2_TracePolys hit location: %d\n", newCol.mLocation); 
-						}
-
-						if (shader->hitMaterial)
-						{
-							newCol.mMaterial = *(hitMatReg[shader->hitMaterial].loc +
-												((int)(y_pos * hitMatReg[shader->hitMaterial].height) * hitMatReg[shader->hitMaterial].width) +
-												((int)(x_pos * hitMatReg[shader->hitMaterial].width)));
-						}
-					}
-*/
-					// exit now if we should
-					if (TS.traceFlags == G2_RETURNONHIT)
+					if (shader->hitLocation)
 					{
-						TS.hitOne = true;
-						return true;
+						newCol.mLocation = *(hitMatReg[shader->hitLocation].loc +
+											((int)(y_pos * hitMatReg[shader->hitLocation].height) * hitMatReg[shader->hitLocation].width) +
+											((int)(x_pos * hitMatReg[shader->hitLocation].width)));
+						Com_Printf("G2_TracePolys hit location: %d\n", newCol.mLocation); 
 					}
 
-					break;
+					if (shader->hitMaterial)
+					{
+						newCol.mMaterial = *(hitMatReg[shader->hitMaterial].loc +
+											((int)(y_pos * hitMatReg[shader->hitMaterial].height) * hitMatReg[shader->hitMaterial].width) +
+											((int)(x_pos * hitMatReg[shader->hitMaterial].width)));
+					}
 				}
+*/
+				// exit now if we should
+				if (TS.traceFlags == G2_RETURNONHIT)
+				{
+					TS.hitOne = true;
+					return true;
+				}
+
+				break;
 			}
-			if (i==MAX_G2_COLLISIONS)
-			{
-				//assert(i!=MAX_G2_COLLISIONS);		// run out of collision record space - will probalbly never happen
-				//It happens. And the assert is bugging me.
-				TS.hitOne = true;	//force stop recursion
-				return true;	// return true to avoid wasting further time, but no hit will result without a record
-			}
+		}
+		if (i==MAX_G2_COLLISIONS)
+		{
+			//assert(i!=MAX_G2_COLLISIONS);		// run out of collision record space - will probalbly never happen
+			//It happens. And the assert is bugging me.
+			TS.hitOne = true;	//force stop recursion
+			return true;	// return true to avoid wasting further time, but no hit will result without a record
 		}
 	}
 	return false;
 }
 
 // now we're at poly level, check each model space transformed poly against the model world transfomed ray
-static bool G2_RadiusTracePolys(
-								const mdxmSurface_t *surface, 
-								CTraceSurface &TS
-								)
+static bool G2_TracePolys(const mdxmSurface_t *surface, const mdxmSurfHierarchy_t *surfInfo, CTraceSurface &TS)
+{
+	int				j, numTris;
+	
+	// whip through and actually transform each vertex
+	const mdxmTriangle_t *tris = (mdxmTriangle_t *) ((byte *)surface + surface->ofsTriangles);
+	const float *verts = (float *)TS.TransformedVertsArray[surface->thisSurfaceIndex];
+	numTris = surface->numTriangles;
+	for ( j = 0; j < numTris; j++ ) 
+	{
+		if (G2_TracePoly(surface, tris, verts, j, TS))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// axes across the ray scaled so the radius covers 0..1 of them, and the ray scaled so it covers 0..1 along it
+static void G2_RadiusTraceAxes(const CTraceSurface &TS, vec3_t saxis, vec3_t taxis, vec3_t v3RayDir)
 {
-	int		j;
 	vec3_t basis1;
 	vec3_t basis2;
-	vec3_t taxis;
-	vec3_t saxis;
 
 	basis2[0]=0.0f;
 	basis2[1]=0.0f;
 	basis2[2]=1.0f;
 
-	vec3_t v3RayDir;
 	VectorSubtract(TS.rayEnd, TS.rayStart, v3RayDir);
 
 	CrossProduct(v3RayDir,basis2,basis1);
@@ -1264,15 +1632,30 @@ static bool G2_RadiusTracePolys(
 	VectorScale(basis1,-0.5f * s /TS.m_fRadius,saxis);
 	VectorMA(    saxis, 0.5f * c /TS.m_fRadius,basis2,saxis);
 
-	const float * const verts = (float *)TS.TransformedVertsArray[surface->thisSurfaceIndex];
-	const int numVerts = surface->numVerts;
-	
-	int flags=63;
 	//rayDir/=lengthSquared(raydir);
 	const float f = VectorLengthSquared(v3RayDir); 
 	v3RayDir[0]/=f;
 	v3RayDir[1]/=f;
 	v3RayDir[2]/=f;
+}
+
+// now we're at poly level, check each model space transformed poly against the model world transfomed ray
+static bool G2_RadiusTracePolys(
+								const mdxmSurface_t *surface, 
+								CTraceSurface &TS
+								)
+{
+	int		j;
+	vec3_t taxis;
+	vec3_t saxis;
+	vec3_t v3RayDir;
+
+	G2_RadiusTraceAxes(TS, saxis, taxis, v3RayDir);
+
+	const float * const verts = (float *)TS.TransformedVertsArray[surface->thisSurfaceIndex];
+	const int numVerts = surface->numVerts;
+	
+	int flags=63;
 
 	for ( j = 0; j < numVerts; j++ ) 
 	{
@@ -1424,6 +1807,171 @@ static bool G2_RadiusTracePolys(
 }
 
 
+#ifndef _XBOX
+// could anything in the box be inside the radius trace's volume
+static bool G2_RadiusTraceHitsBox(const CTraceSurface &TS, const vec3_t mins, const vec3_t maxs)
+{
+	vec3_t	taxis, saxis, v3RayDir;
+	vec3_t	center, extents, delta;
+	float	d, e;
+	int		i;
+
+	G2_RadiusTraceAxes(TS, saxis, taxis, v3RayDir);
+
+	VectorAdd(mins, maxs, center);
+	VectorScale(center, 0.5f, center);
+	VectorSubtract(maxs, center, extents);
+	VectorSubtract(center, TS.rayStart, delta);
+
+	// the same s, t and u G2_RadiusTracePolys finds for each vertex, over the whole box
+	const float *axes[3] = { saxis, taxis, v3RayDir };
+	const float offsets[3] = { 0.5f, 0.5f, 0.0f };
+	for (i = 0; i < 3; i++)
+	{
+		d = DotProduct(delta, axes[i]) + offsets[i];
+		e = extents[0] * fabs(axes[i][0]) + extents[1] * fabs(axes[i][1]) + extents[2] * fabs(axes[i][2]);
+		if (d + e < 0.0f || d - e > 1.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// the verts of a surface traced since G2_TransformModelDeferred, followed by a byte per run
+// of triangles that's set once its verts are skinned, and one more once every vert is
+static float *G2_DeferredSurfaceVerts(const mdxmSurface_t *surface, int numClusters, CTraceSurface &TS)
+{
+	float	*TransformedVerts = (float *)TS.TransformedVertsArray[surface->thisSurfaceIndex];
+
+	if (!TransformedVerts)
+	{
+		const int flagSize = (numClusters + 1 + 3) & ~3;
+
+		TransformedVerts = (float *)g2DeferredVertSpace->MiniHeapAlloc(surface->numVerts * 5 * 4 + flagSize);
+		TS.TransformedVertsArray[surface->thisSurfaceIndex] = (int)TransformedVerts;
+		if (!TransformedVerts)
+		{
+			Com_Error(ERR_DROP, "Ran out of transform space for Ghoul2 Models. Adjust MiniHeapSize in SV_SpawnServer.\n");
+		}
+		memset(&TransformedVerts[surface->numVerts * 5], 0, flagSize);
+	}
+	return TransformedVerts;
+}
+
+static void G2_SkinDeferredSurface(const mdxmSurface_t *surface, float *TransformedVerts, int numClusters, CTraceSurface &TS)
+{
+	byte	*skinned = (byte *)&TransformedVerts[surface->numVerts * 5];
+	int		j;
+
+	if (skinned[numClusters])
+	{
+		return;
+	}
+	if (G2_SkinCollisionSurface(surface, TS.boneCache, g2DeferredScale, TransformedVerts))
+	{
+		memset(skinned, 1, numClusters + 1);
+		return;
+	}
+
+	const int *piBoneReferences = (int *) ((byte *)surface + surface->ofsBoneReferences);
+	const mdxmVertex_t *v = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
+	const mdxmVertexTexCoord_t *pTexCoords = (mdxmVertexTexCoord_t *) &v[surface->numVerts];
+
+	for ( j = 0; j < surface->numVerts; j++ ) 
+	{
+		G2_SkinTraceVert(&v[j], &pTexCoords[j], piBoneReferences, TS.boneCache, g2DeferredScale, &TransformedVerts[j * 5]);
+	}
+	memset(skinned, 1, numClusters + 1);
+}
+
+// trace a surface G2_TransformModelDeferred didn't skin, skinning only what the ray might touch
+static bool G2_TraceDeferredSurface(const mdxmSurface_t *surface, const mdxmSurfHierarchy_t *surfInfo, CTraceSurface &TS)
+{
+	const g2Collision_t		*col = TS.currentModel->g2Collision;
+	const g2SurfCollision_t	*sc = NULL;
+	const int				*piBoneReferences = (int *) ((byte *)surface + surface->ofsBoneReferences);
+	vec3_t					mins, maxs;
+	float					*TransformedVerts;
+	byte					*skinned;
+	int						i, j;
+
+	if (col)
+	{
+		sc = &col->surfaces[TS.lod * col->numSurfaces + TS.surfaceNum];
+	}
+	if (!sc || !sc->valid)
+	{
+		// nothing to bound it with, do it the old way
+		TransformedVerts = G2_DeferredSurfaceVerts(surface, 0, TS);
+		G2_SkinDeferredSurface(surface, TransformedVerts, 0, TS);
+		if (!(fabs(TS.m_fRadius) < 0.1))
+		{
+			return G2_RadiusTracePolys(surface, TS);
+		}
+		return G2_TracePolys(surface, surfInfo, TS);
+	}
+
+	ClearBounds(mins, maxs);
+	G2_AddPosedSpheres(sc->spheres, sc->numSpheres, piBoneReferences, TS.boneCache, g2DeferredScale, mins, maxs);
+
+	if (!(fabs(TS.m_fRadius) < 0.1))	// if not a point-trace
+	{
+		// the radius test needs every vertex, so all we can skip is the whole surface
+		if (!G2_RadiusTraceHitsBox(TS, mins, maxs))
+		{
+			return false;
+		}
+		TransformedVerts = G2_DeferredSurfaceVerts(surface, sc->numClusters, TS);
+		G2_SkinDeferredSurface(surface, TransformedVerts, sc->numClusters, TS);
+		return G2_RadiusTracePolys(surface, TS);
+	}
+
+	if (!G2_SegmentHitsBox(TS.rayStart, TS.rayEnd, mins, maxs))
+	{
+		return false;
+	}
+
+	TransformedVerts = G2_DeferredSurfaceVerts(surface, sc->numClusters, TS);
+	skinned = (byte *)&TransformedVerts[surface->numVerts * 5];
+
+	const mdxmVertex_t *v = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
+	const mdxmVertexTexCoord_t *pTexCoords = (mdxmVertexTexCoord_t *) &v[surface->numVerts];
+	const mdxmTriangle_t *tris = (mdxmTriangle_t *) ((byte *)surface + surface->ofsTriangles);
+
+	// runs are in triangle order, so hits are recorded in the same order G2_TracePolys would
+	for (i = 0; i < sc->numClusters; i++)
+	{
+		const g2TriCluster_t *c = &sc->clusters[i];
+
+		ClearBounds(mins, maxs);
+		G2_AddPosedSpheres(&sc->spheres[c->firstSphere], c->numSpheres, piBoneReferences, TS.boneCache, g2DeferredScale, mins, maxs);
+		if (!G2_SegmentHitsBox(TS.rayStart, TS.rayEnd, mins, maxs))
+		{
+			continue;
+		}
+
+		if (!skinned[i])
+		{
+			for (j = 0; j < c->numVerts; j++)
+			{
+				const int index = sc->verts[c->firstVert + j];
+				G2_SkinTraceVert(&v[index], &pTexCoords[index], piBoneReferences, TS.boneCache, g2DeferredScale, &TransformedVerts[index * 5]);
+			}
+			skinned[i] = 1;
+		}
+		for (j = c->firstTri; j < c->firstTri + c->numTris; j++)
+		{
+			if (G2_TracePoly(surface, tris, TransformedVerts, j, TS))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+#endif // _XBOX
+
 // look at a surface and then do the trace on each poly
 static void G2_TraceSurfaces(CTraceSurface &TS)
 {
@@ -1459,6 +2007,19 @@ static void G2_TraceSurfaces(CTraceSurface &TS)
 #ifdef _G2_GORE
 		if (TS.collRecMap)
 		{
+#endif
+#ifndef _XBOX
+			if (g2DeferredVertSpace && TS.collRecMap)
+			{
+				if (G2_TraceDeferredSurface(surface, surfInfo, TS)
+					&& (TS.traceFlags == G2_RETURNONHIT)
+					)
+				{
+					TS.hitOne = true;
+					return;
+				}
+			}
+			else
 #endif
 			if (!(fabs(TS.m_fRadius) < 0.1))	// if not a point-trace
 			{
@@ -1592,6 +2153,8 @@ void G2_TraceModels(CGhoul2Info_v &ghoul2, vec3_t rayStart, vec3_t rayEnd, Colli
 #else
 		CTraceSurface TS(ghoul2[i].mSurfaceRoot, ghoul2[i].mSlist,  (model_t *)ghoul2[i].currentModel, lod, rayStart, rayEnd, collRecMap, entNum, i, skin, cust_shader, ghoul2[i].mTransformedVertsArray, eG2TraceType, fRadius);
 #endif
+		TS.boneCache = ghoul2[i].mBoneCache;
+
 		// start the surface recursion loop
 		G2_TraceSurfaces(TS);
 
@@ -8,12 +8,30 @@ private:
 	char	*mHeap;
 	char	*mCurrentHeap;
 	int		mSize;
+	int		mResetCount;
 public:
 
 // reset the heap back to the start
 void ResetHeap()
 {
 	mCurrentHeap = mHeap;
+	mResetCount++;
+}
+
+// lets anything holding on to allocations tell whether they're still there
+int ResetCount() const
+{
+	return mResetCount;
+}
+
+int Size() const
+{
+	return mSize;
+}
+
+int FreeSpace() const
+{
+	return mSize - (mCurrentHeap - mHeap);
 }
 
 // initialise the heap
@@ -21,6 +39,7 @@ CMiniHeap(int size)
 {
 	mHeap = (char *)malloc(size);
 	mSize = size;
+	mResetCount = 0;
 	if (mHeap)
 	{
 		ResetHeap();
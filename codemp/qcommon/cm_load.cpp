@@ -666,6 +666,7 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 	//	then discard it after that...
 	//
 	buf = NULL;	
+#ifdef _XBOX
 	fileHandle_t h;	
 	const int iBSPLen = FS_FOpenFileRead( name, &h, qfalse );
 	if (h)
@@ -673,6 +674,13 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 		newBuff = Z_Malloc( iBSPLen, TAG_BSP_DISKIMAGE );
 		FS_Read( newBuff, iBSPLen, h);
 		FS_FCloseFile( h );
+#else
+	// FS_ReadFile rather than FS_Read so a prefetched or mapped copy is used
+	const int iBSPLen = FS_ReadFile( name, &newBuff );
+	if (newBuff)
+	{			
+		Z_MorphMallocTag( newBuff, TAG_BSP_DISKIMAGE );
+#endif
 
 		buf = (int*) newBuff;	// so the rest of the code works as normal
 		if (&cm == &cmg)
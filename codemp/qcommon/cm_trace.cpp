@@ -1583,6 +1583,8 @@ void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 	cmodel_t	*cmod;
 	clipMap_t	*local = 0;
 
+	PROFILE_ZONE( "CM_Trace" );
+
 	cmod = CM_ClipHandleToModel( model, &local );
 
 	local->checkcount++;		// for multi-check avoidance
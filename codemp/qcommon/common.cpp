@@ -51,6 +51,7 @@ cvar_t	*com_logfile;		// 1 = buffer log, 2 = flush after each print
 cvar_t	*com_showtrace;
 
 cvar_t	*com_optvehtrace;
+cvar_t	*com_g2CollisionCache;
 
 #ifdef G2_PERFORMANCE_ANALYSIS
 cvar_t	*com_G2Report;
@@ -238,6 +239,17 @@ void QDECL Com_OPrintf( const char *fmt, ...)
 #endif
 }
 
+static THREADLOCAL errorTrap_t	*com_errorTrap;
+
+/*
+=============
+Com_SetErrorTrap
+=============
+*/
+void Com_SetErrorTrap( errorTrap_t *trap ) {
+	com_errorTrap = trap;
+}
+
 /*
 =============
 Com_Error
@@ -255,6 +267,18 @@ void QDECL Com_Error( int code, const char *fmt, ... ) {
 	int			wasRunningServer = com_sv_running->integer;
 #endif
 
+	if ( com_errorTrap ) {
+		char	msg[MAXPRINTMSG];
+
+		va_start (argptr,fmt);
+		vsprintf (msg,fmt,argptr);
+		va_end (argptr);
+
+		com_errorTrap->code = code;
+		Q_strncpyz( com_errorTrap->message, msg, sizeof( com_errorTrap->message ) );
+		throw ("TRAPPED\n");
+	}
+
 #if defined(_WIN32) && defined(_DEBUG)
 	if ( code != ERR_DISCONNECT && code != ERR_NEED_CD ) {
 		if (com_noErrorInterrupt && !com_noErrorInterrupt->integer) {
@@ -290,6 +314,10 @@ void QDECL Com_Error( int code, const char *fmt, ... ) {
 	}
 	com_errorEntered = qtrue;
 
+	// an error in the middle of SV_Frame skips its flush, don't leave
+	// every later datagram held in the batch
+	NET_FlushPacketBatch();
+
 	va_start (argptr,fmt);
 	vsprintf (com_errorMessage,fmt,argptr);
 	va_end (argptr);
@@ -1321,6 +1349,7 @@ void Com_Init( char *commandLine ) {
 		com_cameraMode = Cvar_Get ("com_cameraMode", "0", CVAR_CHEAT);
 
 		com_optvehtrace = Cvar_Get("com_optvehtrace", "0", 0);
+		com_g2CollisionCache = Cvar_Get("com_g2CollisionCache", "1", 0);
 
 		cl_paused = Cvar_Get ("cl_paused", "0", CVAR_ROM);
 		sv_paused = Cvar_Get ("sv_paused", "0", CVAR_ROM);
@@ -1372,6 +1401,7 @@ void Com_Init( char *commandLine ) {
 		}
 		Cmd_AddCommand ("quit", Com_Quit_f);
 		Cmd_AddCommand ("changeVectors", MSG_ReportChangeVectors_f );
+		Cmd_AddCommand ("huffbench", MSG_HuffBench_f );
 		Cmd_AddCommand ("writeconfig", Com_WriteConfig_f );
 
 		s = va("%s %s %s", Q3_VERSION, CPUSTRING, __DATE__ );
@@ -1380,6 +1410,8 @@ void Com_Init( char *commandLine ) {
 		SE_Init();
 
 		Sys_Init();
+		Prof_Init();
+		Job_Init();
 		Netchan_Init( Com_Milliseconds() & 0xffff );	// pick a port value that should be nice and random
 		VM_Init();
 		SV_Init();
@@ -1620,6 +1652,9 @@ try
 	// old net chan encryption key
 	key = 0x87243987;
 
+	// pick up com_profileZones changes once per frame
+	Prof_Frame();
+
 	// write config file if anything changed
 	Com_WriteConfiguration(); 
 
@@ -1748,6 +1783,8 @@ try
 		c_pointcontents = 0;
 	}
 
+	VM_ProfileFrame();
+
 	// old net chan encryption key
 	key = lastTime * 0x87243987;
 
@@ -1784,6 +1821,9 @@ Com_Shutdown
 void MSG_shutdownHuffman();
 void Com_Shutdown (void) 
 {
+	Job_Shutdown();
+	Prof_Shutdown();
+
 	CM_ClearMap();
 
 	if (logfile) {
@@ -53,6 +53,9 @@ typedef struct {
 	int				hashSize;					// hash table size (power of 2)
 	fileInPack_t*	*hashTable;					// hash table
 	fileInPack_t*	buildBuffer;				// buffer with the filenames etc.
+	byte			*mapBase;					// read-only view of the whole pk3, NULL until first FS_ReadFile
+	int				mapSize;
+	qboolean		mapFailed;					// don't keep retrying
 } pack_t;
 
 typedef struct {
@@ -89,6 +92,7 @@ typedef struct {
 	int			zipFilePos;
 	qboolean	zipFile;
 	qboolean	streamed;
+	pack_t		*pak;					// pack the zip file came from
 	char		name[MAX_ZPATH];
 
 #ifdef _XBOX
@@ -154,5 +158,10 @@ void			FS_Shutdown( void );
 void			FS_SetRestrictions(void);
 void			FS_CheckInit(void);
 void			FS_ReplaceSeparators( char *path );
+#ifndef _XBOX
+void			FS_FreePathIndex( void );
+void			FS_ShutdownPrefetch( void );
+void			FS_UnmapPak( pack_t *pak );
+#endif
 
 #endif
@@ -437,12 +437,18 @@ void FS_Shutdown( qboolean closemfp ) {
 		}
 	}
 
+#ifndef _XBOX
+	// the prefetch threads read straight out of the pack views
+	FS_ShutdownPrefetch();
+#endif
+
 	// free everything
 	for ( p = fs_searchpaths ; p ; p = next ) {
 		next = p->next;
 
 		if ( p->pack ) {
 #ifndef _XBOX
+			FS_UnmapPak( p->pack );
 			unzClose(p->pack->handle);
 #endif
 			Z_Free( p->pack->buildBuffer );
@@ -456,6 +462,9 @@ void FS_Shutdown( qboolean closemfp ) {
 
 	// any FS_ calls will now be an error until reinitialized
 	fs_searchpaths = NULL;
+#ifndef _XBOX
+	FS_FreePathIndex();
+#endif
 
 	Cmd_RemoveCommand( "path" );
 	Cmd_RemoveCommand( "dir" );
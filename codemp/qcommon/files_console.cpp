@@ -1029,3 +1029,19 @@ const char *FS_LoadedPakChecksums(void)
 {
 	return "";
 }
+
+void FS_PrefetchFile(const char *qpath)
+{
+	return;
+}
+
+void FS_PrefetchFlush(void)
+{
+	return;
+}
+
+int FS_PeekPrefetched(const char *qpath, const void **buffer)
+{
+	*buffer = NULL;
+	return -1;
+}
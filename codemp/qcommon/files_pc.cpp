@@ -20,6 +20,22 @@
 // wether we did a reorder on the current search path when joining the server
 static qboolean fs_reordered;
 
+// every pk3 entry across all search paths, each chain in search path priority order
+typedef struct pathIndex_s {
+	fileInPack_t		*pakFile;
+	searchpath_t		*search;
+	struct pathIndex_s	*next;
+} pathIndex_t;
+
+#define	MAX_MAPPED_PAK_BYTES	(1024*1024*1024)	// leave address space for everything else
+
+static	cvar_t		*fs_mmap;
+
+static	pathIndex_t	**fs_pathIndex;			// NULL when it needs (re)building
+static	pathIndex_t	*fs_pathIndexEntries;
+static	int			fs_pathIndexSize;		// hash table size (power of 2)
+static	int			fs_mappedBytes;			// total size of the pk3 views
+
 // productId: This file is copyright 2003 Raven Software, and may not be duplicated except during a licensed installation of the full commercial version of Star Wars: Jedi Academy
 static const byte fs_scrambledProductId[] = {
 42, 143, 149, 190,  10, 197, 225, 133, 243,  63, 189, 182, 226,  56, 143,  17, 215,  37, 197, 218,  50, 103,  24, 235, 246, 191, 183, 149, 160, 170,
@@ -81,6 +97,107 @@ static long FS_HashFileName( const char *fname, int hashSize ) {
 	return hash;
 }
 
+/*
+================
+FS_FreePathIndex
+================
+*/
+void FS_FreePathIndex( void ) {
+	if ( fs_pathIndex ) {
+		Z_Free( fs_pathIndex );
+		Z_Free( fs_pathIndexEntries );
+	}
+	fs_pathIndex = NULL;
+	fs_pathIndexEntries = NULL;
+	fs_pathIndexSize = 0;
+}
+
+/*
+================
+FS_BuildPathIndex
+
+Hashes every pk3 entry once so a lookup doesn't have to probe
+each pack in turn.  Chains are kept in search path order, so
+the first pure entry that matches is the one the search path
+walk would have found.
+================
+*/
+static void FS_BuildPathIndex( void ) {
+	searchpath_t	*search;
+	searchpath_t	**order;
+	pathIndex_t		*entry;
+	pack_t			*pak;
+	int				numSearch, numEntries;
+	int				i, j;
+	long			hash;
+
+	FS_FreePathIndex();
+
+	numSearch = numEntries = 0;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		numSearch++;
+		if ( search->pack ) {
+			numEntries += search->pack->numfiles;
+		}
+	}
+
+	for ( fs_pathIndexSize = MAX_FILEHASH_SIZE ; fs_pathIndexSize < numEntries ; fs_pathIndexSize <<= 1 ) {
+	}
+	fs_pathIndex = (pathIndex_t **)Z_Malloc( fs_pathIndexSize * sizeof( *fs_pathIndex ), TAG_FILESYS, qtrue );
+	fs_pathIndexEntries = (pathIndex_t *)Z_Malloc( numEntries * sizeof( *fs_pathIndexEntries ), TAG_FILESYS, qfalse );
+
+	order = (searchpath_t **)Z_Malloc( numSearch * sizeof( *order ), TAG_TEMP_WORKSPACE, qfalse );
+	for ( i = 0, search = fs_searchpaths ; search ; search = search->next ) {
+		order[i++] = search;
+	}
+
+	// insert at the head of the chains from the lowest priority pak
+	// up, and in pack order within a pak so duplicate names in one
+	// pk3 resolve the same way its own hash table does
+	entry = fs_pathIndexEntries;
+	for ( i = numSearch - 1 ; i >= 0 ; i-- ) {
+		pak = order[i]->pack;
+		if ( !pak ) {
+			continue;
+		}
+		for ( j = 0 ; j < pak->numfiles ; j++, entry++ ) {
+			hash = FS_HashFileName( pak->buildBuffer[j].name, fs_pathIndexSize );
+			entry->pakFile = &pak->buildBuffer[j];
+			entry->search = order[i];
+			entry->next = fs_pathIndex[hash];
+			fs_pathIndex[hash] = entry;
+		}
+	}
+
+	Z_Free( order );
+}
+
+/*
+================
+FS_PathIndexLookup
+
+Returns the highest priority pure pak entry for the file, or NULL
+================
+*/
+static pathIndex_t *FS_PathIndexLookup( const char *filename ) {
+	pathIndex_t	*entry;
+
+	if ( !fs_pathIndex ) {
+		FS_BuildPathIndex();
+	}
+
+	for ( entry = fs_pathIndex[FS_HashFileName( filename, fs_pathIndexSize )] ; entry ; entry = entry->next ) {
+		// case and separator insensitive comparisons
+		if ( !FS_FilenameCompare( entry->pakFile->name, filename ) ) {
+			// disregard if it doesn't match one of the allowed pure pak files
+			if ( FS_PakIsPure( entry->search->pack ) ) {
+				return entry;
+			}
+		}
+	}
+	return NULL;
+}
+
 
 static FILE	*FS_FileForHandle( fileHandle_t f ) {
 	if ( f < 0 || f > MAX_FILE_HANDLES ) {
@@ -674,15 +791,13 @@ int FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean uniqueF
 	char			*netpath;
 	pack_t			*pak;
 	fileInPack_t	*pakFile;
+	pathIndex_t		*indexed;
 	directory_t		*dir;
-	long			hash;
 	unz_s			*zfi;
 	ZIP_FILE		*temp;
 	int				l;
 	char demoExt[16];
 
-	hash = 0;
-
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
 	}
@@ -730,131 +845,122 @@ int FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean uniqueF
 	//
 	qboolean bFasterToReOpenUsingNewLocalFile = qfalse;
 
+	indexed = FS_PathIndexLookup( filename );
+
 	do
 	{
 		bFasterToReOpenUsingNewLocalFile = qfalse;
 
 		for ( search = fs_searchpaths ; search ; search = search->next ) {
-			//
-			if ( search->pack ) {
-				hash = FS_HashFileName(filename, search->pack->hashSize);
-			}
 			// is the element a pak file?
-			if ( search->pack && search->pack->hashTable[hash] ) {
-				// disregard if it doesn't match one of the allowed pure pak files
-				if ( !FS_PakIsPure(search->pack) ) {
+			if ( search->pack ) {
+				// the path index has already picked the highest
+				// priority pure pak holding this file
+				if ( !indexed || indexed->search != search ) {
 					continue;
 				}
-
-				// look through all the pak file elements
 				pak = search->pack;
-				pakFile = pak->hashTable[hash];
-				do {
-					// case and separator insensitive comparisons
-					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-						// found it!
-
-						// mark the pak as having been referenced and mark specifics on cgame and ui
-						// shaders, txt, arena files  by themselves do not count as a reference as 
-						// these are loaded from all pk3s 
-						// from every pk3 file.. 
-						l = strlen( filename );
-						if ( !(pak->referenced & FS_GENERAL_REF)) {
-							if ( Q_stricmp(filename + l - 7, ".shader") != 0 &&
-								Q_stricmp(filename + l - 4, ".txt") != 0 &&
-								Q_stricmp(filename + l - 4, ".str") != 0 &&
-								Q_stricmp(filename + l - 4, ".cfg") != 0 &&
-								Q_stricmp(filename + l - 4, ".fcf") != 0 &&
-								Q_stricmp(filename + l - 7, ".config") != 0 &&
-								strstr(filename, "levelshots") == NULL &&
-								Q_stricmp(filename + l - 4, ".bot") != 0 &&
-								Q_stricmp(filename + l - 6, ".arena") != 0 &&
-								Q_stricmp(filename + l - 5, ".menu") != 0) {
-								pak->referenced |= FS_GENERAL_REF;
-							}
-						}
+				pakFile = indexed->pakFile;
 
-						/*
-						FS_ShiftedStrStr(filename, "jampgamex86.dll", -13);
-												  //]^&`cZT`Xk+)!W__
-						FS_ShiftedStrStr(filename, "cgamex86.dll", -7);
-												  //\`Zf^q1/']ee
-						FS_ShiftedStrStr(filename, "uix86.dll", -5);
-												  //pds31)_gg
-						*/
-
-						// jampgame.qvm	- 13
-						// ]^&`cZT`X!di`
-						if (!(pak->referenced & FS_QAGAME_REF))
-						{
-							if (FS_ShiftedStrStr(filename, "]T`cZT`X!di`", 13) ||
-								FS_ShiftedStrStr(filename, "]T`cZT`Xk+)!W__", 13))
-							{
-								pak->referenced |= FS_QAGAME_REF;
-							}
-						}
-						// cgame.qvm	- 7
-						// \`Zf^'jof
-						if (!(pak->referenced & FS_CGAME_REF))
-						{
-							if (FS_ShiftedStrStr(filename , "\\`Zf^'jof", 7) ||
-								FS_ShiftedStrStr(filename , "\\`Zf^q1/']ee", 7))
-							{
-								pak->referenced |= FS_CGAME_REF;
-							}
-						}
-						// ui.qvm		- 5
-						// pd)lqh
-						if (!(pak->referenced & FS_UI_REF))
-						{
-							if (FS_ShiftedStrStr(filename , "pd)lqh", 5) ||
-								FS_ShiftedStrStr(filename , "pds31)_gg", 5))
-							{
-								pak->referenced |= FS_UI_REF;
-							}
-						}
+				// mark the pak as having been referenced and mark specifics on cgame and ui
+				// shaders, txt, arena files  by themselves do not count as a reference as 
+				// these are loaded from all pk3s 
+				// from every pk3 file.. 
+				l = strlen( filename );
+				if ( !(pak->referenced & FS_GENERAL_REF)) {
+					if ( Q_stricmp(filename + l - 7, ".shader") != 0 &&
+						Q_stricmp(filename + l - 4, ".txt") != 0 &&
+						Q_stricmp(filename + l - 4, ".str") != 0 &&
+						Q_stricmp(filename + l - 4, ".cfg") != 0 &&
+						Q_stricmp(filename + l - 4, ".fcf") != 0 &&
+						Q_stricmp(filename + l - 7, ".config") != 0 &&
+						strstr(filename, "levelshots") == NULL &&
+						Q_stricmp(filename + l - 4, ".bot") != 0 &&
+						Q_stricmp(filename + l - 6, ".arena") != 0 &&
+						Q_stricmp(filename + l - 5, ".menu") != 0) {
+						pak->referenced |= FS_GENERAL_REF;
+					}
+				}
 
-						if ( uniqueFILE ) {
-							// open a new file on the pakfile
-							fsh[*file].handleFiles.file.z = unzReOpen (pak->pakFilename, pak->handle);
-							if (fsh[*file].handleFiles.file.z == NULL) {
-								Com_Error (ERR_FATAL, "Couldn't reopen %s", pak->pakFilename);
-							}
-						} else {
-							fsh[*file].handleFiles.file.z = pak->handle;
-						}
-						Q_strncpyz( fsh[*file].name, filename, sizeof( fsh[*file].name ) );
-						fsh[*file].zipFile = qtrue;
-						zfi = (unz_s *)fsh[*file].handleFiles.file.z;
-						// in case the file was new
-						temp = zfi->file;
-						// set the file position in the zip file (also sets the current file info)
-						unzSetCurrentFileInfoPosition(pak->handle, pakFile->pos);
-						// copy the file info into the unzip structure
-						Com_Memcpy( zfi, pak->handle, sizeof(unz_s) );
-						// we copy this back into the structure
-						zfi->file = temp;
-						// open the file in the zip
-						unzOpenCurrentFile( fsh[*file].handleFiles.file.z );
-						fsh[*file].zipFilePos = pakFile->pos;
-
-						if ( fs_debug->integer ) {
-							Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n", 
-								filename, pak->pakFilename );
-						}
+				/*
+				FS_ShiftedStrStr(filename, "jampgamex86.dll", -13);
+										  //]^&`cZT`Xk+)!W__
+				FS_ShiftedStrStr(filename, "cgamex86.dll", -7);
+										  //\`Zf^q1/']ee
+				FS_ShiftedStrStr(filename, "uix86.dll", -5);
+										  //pds31)_gg
+				*/
+
+				// jampgame.qvm	- 13
+				// ]^&`cZT`X!di`
+				if (!(pak->referenced & FS_QAGAME_REF))
+				{
+					if (FS_ShiftedStrStr(filename, "]T`cZT`X!di`", 13) ||
+						FS_ShiftedStrStr(filename, "]T`cZT`Xk+)!W__", 13))
+					{
+						pak->referenced |= FS_QAGAME_REF;
+					}
+				}
+				// cgame.qvm	- 7
+				// \`Zf^'jof
+				if (!(pak->referenced & FS_CGAME_REF))
+				{
+					if (FS_ShiftedStrStr(filename , "\\`Zf^'jof", 7) ||
+						FS_ShiftedStrStr(filename , "\\`Zf^q1/']ee", 7))
+					{
+						pak->referenced |= FS_CGAME_REF;
+					}
+				}
+				// ui.qvm		- 5
+				// pd)lqh
+				if (!(pak->referenced & FS_UI_REF))
+				{
+					if (FS_ShiftedStrStr(filename , "pd)lqh", 5) ||
+						FS_ShiftedStrStr(filename , "pds31)_gg", 5))
+					{
+						pak->referenced |= FS_UI_REF;
+					}
+				}
+
+				if ( uniqueFILE ) {
+					// open a new file on the pakfile
+					fsh[*file].handleFiles.file.z = unzReOpen (pak->pakFilename, pak->handle);
+					if (fsh[*file].handleFiles.file.z == NULL) {
+						Com_Error (ERR_FATAL, "Couldn't reopen %s", pak->pakFilename);
+					}
+				} else {
+					fsh[*file].handleFiles.file.z = pak->handle;
+				}
+				Q_strncpyz( fsh[*file].name, filename, sizeof( fsh[*file].name ) );
+				fsh[*file].zipFile = qtrue;
+				fsh[*file].pak = pak;
+				zfi = (unz_s *)fsh[*file].handleFiles.file.z;
+				// in case the file was new
+				temp = zfi->file;
+				// set the file position in the zip file (also sets the current file info)
+				unzSetCurrentFileInfoPosition(pak->handle, pakFile->pos);
+				// copy the file info into the unzip structure
+				Com_Memcpy( zfi, pak->handle, sizeof(unz_s) );
+				// we copy this back into the structure
+				zfi->file = temp;
+				// open the file in the zip
+				unzOpenCurrentFile( fsh[*file].handleFiles.file.z );
+				fsh[*file].zipFilePos = pakFile->pos;
+
+				if ( fs_debug->integer ) {
+					Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n", 
+						filename, pak->pakFilename );
+				}
 	#ifndef DEDICATED
 	#ifndef FINAL_BUILD
-						// Check for unprecached files when in game but not in the menus
-						if((cls.state == CA_ACTIVE) && !(cls.keyCatchers & KEYCATCH_UI))
-						{
-							Com_Printf(S_COLOR_YELLOW "WARNING: File %s not precached\n", filename);
-						}
+				// Check for unprecached files when in game but not in the menus
+				if((cls.state == CA_ACTIVE) && !(cls.keyCatchers & KEYCATCH_UI))
+				{
+					Com_Printf(S_COLOR_YELLOW "WARNING: File %s not precached\n", filename);
+				}
 	#endif
 	#endif // DEDICATED
-						return zfi->cur_file_info.uncompressed_size;
-					}
-					pakFile = pakFile->next;
-				} while(pakFile != NULL);
+				return zfi->cur_file_info.uncompressed_size;
 			} else if ( search->dir ) {
 				// check a file in the directory tree
 
@@ -1189,10 +1295,7 @@ CONVENIENCE FUNCTIONS FOR ENTIRE FILES
 */
 
 int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
-	searchpath_t	*search;
-	pack_t			*pak;
-	fileInPack_t	*pakFile;
-	long			hash = 0;
+	pathIndex_t		*indexed;
 
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
@@ -1214,38 +1317,589 @@ int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
 		return -1;
 	}
 
-	//
-	// search through the path, one element at a time
-	//
+	indexed = FS_PathIndexLookup( filename );
+	if ( !indexed ) {
+		return -1;
+	}
 
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-		//
-		if (search->pack) {
-			hash = FS_HashFileName(filename, search->pack->hashSize);
+	if (pChecksum) {
+		*pChecksum = indexed->search->pack->pure_checksum;
+	}
+	return 1;
+}
+
+/*
+======================================================================================
+
+MAPPED PK3 ACCESS
+
+Whole-file reads of pk3 entries go straight to a read-only view of the
+archive rather than through unzip's FILE* reads.  The central directory
+entry is parsed out of the view as well, so none of this touches the
+pack's shared unzFile and it's safe to use from the prefetch threads.
+
+======================================================================================
+*/
+
+typedef struct {
+	byte		*data;				// start of the entry's data in the view
+	int			compressedSize;
+	int			size;
+	qboolean	deflated;
+} mappedEntry_t;
+
+static int FS_ViewShort( const byte *p ) {
+	return p[0] | ( p[1] << 8 );
+}
+
+static int FS_ViewLong( const byte *p ) {
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( p[3] << 24 );
+}
+
+/*
+============
+FS_MapPak
+
+Maps the pk3 the first time one of its entries is read
+============
+*/
+static qboolean FS_MapPak( pack_t *pak ) {
+	if ( pak->mapBase ) {
+		return qtrue;
+	}
+	if ( pak->mapFailed || !fs_mmap->integer ) {
+		return qfalse;
+	}
+
+	pak->mapBase = (byte *)Sys_MapFile( pak->pakFilename, &pak->mapSize );
+	if ( pak->mapBase && fs_mappedBytes + pak->mapSize > MAX_MAPPED_PAK_BYTES ) {
+		Sys_UnmapFile( pak->mapBase, pak->mapSize );
+		pak->mapBase = NULL;
+	}
+	if ( !pak->mapBase ) {
+		pak->mapFailed = qtrue;
+		return qfalse;
+	}
+	fs_mappedBytes += pak->mapSize;
+	return qtrue;
+}
+
+/*
+============
+FS_UnmapPak
+============
+*/
+void FS_UnmapPak( pack_t *pak ) {
+	if ( pak->mapBase ) {
+		Sys_UnmapFile( pak->mapBase, pak->mapSize );
+		fs_mappedBytes -= pak->mapSize;
+		pak->mapBase = NULL;
+	}
+}
+
+/*
+============
+FS_GetMappedEntry
+
+Locates the data for the entry whose central directory record is at
+pos, the same position the pack's hash table stores
+============
+*/
+static qboolean FS_GetMappedEntry( pack_t *pak, unsigned long pos, mappedEntry_t *entry ) {
+	const byte		*p;
+	unsigned long	base, ofs;
+	int				method;
+
+	base = ((unz_s *)pak->handle)->byte_before_the_zipfile;
+
+	// central directory record
+	ofs = base + pos;
+	if ( ofs + 46 > (unsigned long)pak->mapSize ) {
+		return qfalse;
+	}
+	p = pak->mapBase + ofs;
+	if ( FS_ViewLong( p ) != 0x02014b50 ) {
+		return qfalse;
+	}
+	method = FS_ViewShort( p + 10 );
+	entry->compressedSize = FS_ViewLong( p + 20 );
+	entry->size = FS_ViewLong( p + 24 );
+	ofs = base + (unsigned long)FS_ViewLong( p + 42 );
+
+	if ( ( method != 0 && method != ZF_DEFLATED ) || entry->compressedSize < 0 || entry->size < 0 ) {
+		return qfalse;
+	}
+	if ( method == 0 && entry->compressedSize != entry->size ) {
+		return qfalse;
+	}
+	entry->deflated = (qboolean)( method != 0 );
+
+	// local header, whose name and extra field lengths can differ from the central record
+	if ( ofs + 30 > (unsigned long)pak->mapSize ) {
+		return qfalse;
+	}
+	p = pak->mapBase + ofs;
+	if ( FS_ViewLong( p ) != 0x04034b50 ) {
+		return qfalse;
+	}
+	ofs += 30 + FS_ViewShort( p + 26 ) + FS_ViewShort( p + 28 );
+	if ( ofs > (unsigned long)pak->mapSize || (unsigned long)entry->compressedSize > pak->mapSize - ofs ) {
+		return qfalse;
+	}
+
+	entry->data = pak->mapBase + ofs;
+	return qtrue;
+}
+
+/*
+============
+FS_DecodeMappedEntry
+
+Stored entries are a single copy, deflated ones are inflated in
+one go into the destination.  sysAlloc keeps the inflate workspace
+out of the zone for callers off the main thread.
+============
+*/
+static qboolean FS_DecodeMappedEntry( const mappedEntry_t *entry, byte *buf, qboolean sysAlloc ) {
+	if ( !entry->deflated ) {
+		Com_Memcpy( buf, entry->data, entry->size );
+		return qtrue;
+	}
+	return (qboolean)InflateFile( entry->data, entry->compressedSize, buf, entry->size, 1, sysAlloc );
+}
+
+/*
+======================================================================================
+
+ASSET PREFETCH
+
+During a level load the list of assets the level is going to need is
+known well before they're asked for (configstrings on the client, the
+entity lump on the server), so FS_PrefetchFile queues up their pk3
+entries and a few threads read and inflate them out of the mapped
+archives while the main thread gets on with the BSP.  Each job's buffer
+is allocated from the zone when it's queued, and FS_ReadFile takes the
+buffer over instead of going to the archive; anything not taken by the
+time FS_PrefetchFlush is called at the end of the load is thrown away.
+Only pk3 entries are prefetched, loose files are read as normal.
+
+The main thread owns the job list and does all the zone work; the only
+state shared with the threads is each job's claimed/state pair and the
+job counters, all updated with Sys_AtomicAdd.  Whoever claims a job
+first does it, so the main thread never waits on a job no thread has
+started.
+
+======================================================================================
+*/
+
+#define	MAX_PREFETCH_JOBS		4096
+#define	MAX_PREFETCH_THREADS	8
+#define	PREFETCH_HASH_SIZE		1024
+
+enum {
+	PREFETCH_PENDING,
+	PREFETCH_READY,
+	PREFETCH_FAILED
+};
+
+typedef struct {
+	pack_t			*pak;
+	unsigned long	pos;			// central directory position, matches fileHandleData_t zipFilePos
+	mappedEntry_t	entry;
+	byte			*data;			// zone buffer, allocated by the main thread when queued
+	volatile int	claimed;		// first to bump this to 1 does the job
+	volatile int	state;
+	qboolean		taken;			// main thread only
+	int				hashNext;
+} prefetchJob_t;
+
+static	cvar_t			*fs_prefetch;			// number of prefetch threads, 0 disables
+static	cvar_t			*fs_prefetchCache;		// MB of prefetched data allowed in flight
+
+static	prefetchJob_t	fs_prefetchJobs[MAX_PREFETCH_JOBS];
+static	int				fs_prefetchHash[PREFETCH_HASH_SIZE];
+static	int				fs_numPrefetchJobs;
+static	volatile int	fs_prefetchClaimCursor;	// next job index for the threads
+static	volatile int	fs_prefetchRetired;		// jobs the threads have finished with, done or skipped
+static	int				fs_prefetchBytes;		// size of the queued jobs' data
+static	int				fs_prefetchHits;
+
+static	void			*fs_prefetchThreads[MAX_PREFETCH_THREADS];
+static	int				fs_numPrefetchThreads;
+static	void			*fs_prefetchWork;		// posted once per queued job
+static	void			*fs_prefetchDone;		// posted once per retired job
+static	volatile int	fs_prefetchQuit;
+
+/*
+============
+FS_RunPrefetchJob
+============
+*/
+static void FS_RunPrefetchJob( prefetchJob_t *job ) {
+	if ( FS_DecodeMappedEntry( &job->entry, job->data, qtrue ) ) {
+		Sys_AtomicAdd( &job->state, PREFETCH_READY - PREFETCH_PENDING );
+	} else {
+		Sys_AtomicAdd( &job->state, PREFETCH_FAILED - PREFETCH_PENDING );
+	}
+}
+
+/*
+============
+FS_PrefetchThread
+============
+*/
+static void FS_PrefetchThread( void *data ) {
+	prefetchJob_t	*job;
+
+	while ( 1 ) {
+		Sys_SemaphoreWait( fs_prefetchWork );
+		if ( fs_prefetchQuit ) {
+			break;
 		}
-		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[hash] ) {
-			// disregard if it doesn't match one of the allowed pure pak files
-			if ( !FS_PakIsPure(search->pack) ) {
-				continue;
-			}
 
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					if (pChecksum) {
-						*pChecksum = pak->pure_checksum;
-					}
-					return 1;
-				}
-				pakFile = pakFile->next;
-			} while(pakFile != NULL);
+		job = &fs_prefetchJobs[Sys_AtomicAdd( &fs_prefetchClaimCursor, 1 ) - 1];
+		if ( Sys_AtomicAdd( &job->claimed, 1 ) == 1 ) {
+			FS_RunPrefetchJob( job );
 		}
+
+		Sys_AtomicAdd( &fs_prefetchRetired, 1 );
+		Sys_SemaphorePost( fs_prefetchDone );
 	}
-	return -1;
+}
+
+/*
+============
+FS_StartPrefetchThreads
+============
+*/
+static qboolean FS_StartPrefetchThreads( void ) {
+	int		count;
+
+	count = fs_prefetch->integer;
+	if ( count > MAX_PREFETCH_THREADS ) {
+		count = MAX_PREFETCH_THREADS;
+	}
+	if ( fs_numPrefetchThreads ) {
+		return qtrue;
+	}
+	if ( count <= 0 ) {
+		return qfalse;
+	}
+
+	fs_prefetchWork = Sys_CreateSemaphore( 0 );
+	fs_prefetchDone = Sys_CreateSemaphore( 0 );
+	if ( !fs_prefetchWork || !fs_prefetchDone ) {
+		if ( fs_prefetchWork ) {
+			Sys_DestroySemaphore( fs_prefetchWork );
+		}
+		if ( fs_prefetchDone ) {
+			Sys_DestroySemaphore( fs_prefetchDone );
+		}
+		fs_prefetchWork = fs_prefetchDone = NULL;
+		return qfalse;
+	}
+
+	fs_prefetchQuit = 0;
+	while ( fs_numPrefetchThreads < count ) {
+		fs_prefetchThreads[fs_numPrefetchThreads] = Sys_CreateThread( FS_PrefetchThread, NULL );
+		if ( !fs_prefetchThreads[fs_numPrefetchThreads] ) {
+			break;
+		}
+		fs_numPrefetchThreads++;
+	}
+	if ( !fs_numPrefetchThreads ) {
+		Sys_DestroySemaphore( fs_prefetchWork );
+		Sys_DestroySemaphore( fs_prefetchDone );
+		fs_prefetchWork = fs_prefetchDone = NULL;
+		return qfalse;
+	}
+	return qtrue;
+}
+
+/*
+============
+FS_ShutdownPrefetch
+============
+*/
+void FS_ShutdownPrefetch( void ) {
+	int		i;
+
+	FS_PrefetchFlush();
+
+	if ( !fs_numPrefetchThreads ) {
+		return;
+	}
+
+	fs_prefetchQuit = 1;
+	for ( i = 0 ; i < fs_numPrefetchThreads ; i++ ) {
+		Sys_SemaphorePost( fs_prefetchWork );
+	}
+	for ( i = 0 ; i < fs_numPrefetchThreads ; i++ ) {
+		Sys_JoinThread( fs_prefetchThreads[i] );
+	}
+	fs_numPrefetchThreads = 0;
+
+	Sys_DestroySemaphore( fs_prefetchWork );
+	Sys_DestroySemaphore( fs_prefetchDone );
+	fs_prefetchWork = fs_prefetchDone = NULL;
+}
+
+/*
+============
+FS_FindPrefetchJob
+============
+*/
+static prefetchJob_t *FS_FindPrefetchJob( pack_t *pak, unsigned long pos ) {
+	int		i;
+
+	if ( !fs_numPrefetchJobs ) {
+		return NULL;
+	}
+	for ( i = fs_prefetchHash[pos & ( PREFETCH_HASH_SIZE - 1 )] ; i >= 0 ; i = fs_prefetchJobs[i].hashNext ) {
+		if ( fs_prefetchJobs[i].pos == pos && fs_prefetchJobs[i].pak == pak ) {
+			return &fs_prefetchJobs[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+============
+FS_FinishPrefetchJob
+
+Makes sure nobody is still working on the job: if no thread has
+claimed it yet it's done here, or dropped if run is qfalse, otherwise
+waits for the thread to be done with it.  Returns qfalse if the job
+didn't produce any data.
+============
+*/
+static qboolean FS_FinishPrefetchJob( prefetchJob_t *job, qboolean run ) {
+	if ( Sys_AtomicAdd( &job->claimed, 1 ) == 1 ) {
+		// we got there first
+		if ( run ) {
+			FS_RunPrefetchJob( job );
+		} else {
+			Sys_AtomicAdd( &job->state, PREFETCH_FAILED - PREFETCH_PENDING );
+		}
+	}
+	while ( job->state == PREFETCH_PENDING ) {
+		Sys_SemaphoreWait( fs_prefetchDone );
+	}
+	return (qboolean)( job->state == PREFETCH_READY );
+}
+
+/*
+============
+FS_PrefetchFile
+
+Queues up a pk3 entry to be read ahead of FS_ReadFile asking for it.
+Silently ignores anything that isn't in a pk3 or won't fit in the cache.
+============
+*/
+void FS_PrefetchFile( const char *qpath ) {
+	pathIndex_t		*indexed;
+	prefetchJob_t	*job;
+	pack_t			*pak;
+	int				hash;
+
+	if ( !fs_searchpaths || !fs_prefetch || !qpath || !qpath[0] ) {
+		return;
+	}
+	if ( fs_numPrefetchJobs == MAX_PREFETCH_JOBS ) {
+		return;
+	}
+
+	// same rules as FS_FOpenFileRead
+	if ( qpath[0] == '/' || qpath[0] == '\\' ) {
+		qpath++;
+	}
+	if ( strstr( qpath, ".." ) || strstr( qpath, "::" ) ) {
+		return;
+	}
+
+	indexed = FS_PathIndexLookup( qpath );
+	if ( !indexed ) {
+		return;
+	}
+
+	// a loose file earlier in the search path would win, don't bother
+	// with directories since FS_ReadFile will just miss the cache
+	pak = indexed->search->pack;
+	if ( FS_FindPrefetchJob( pak, indexed->pakFile->pos ) ) {
+		return;
+	}
+	if ( !FS_StartPrefetchThreads() || !FS_MapPak( pak ) ) {
+		return;
+	}
+
+	job = &fs_prefetchJobs[fs_numPrefetchJobs];
+	if ( !FS_GetMappedEntry( pak, indexed->pakFile->pos, &job->entry ) ) {
+		return;
+	}
+	if ( fs_prefetchBytes + job->entry.size > fs_prefetchCache->integer * 1024 * 1024 ) {
+		return;
+	}
+
+	job->pak = pak;
+	job->pos = indexed->pakFile->pos;
+	job->data = (byte *)Z_Malloc( job->entry.size + 1, TAG_FILESYS, qfalse );
+	job->claimed = 0;
+	job->state = PREFETCH_PENDING;
+	job->taken = qfalse;
+
+	hash = job->pos & ( PREFETCH_HASH_SIZE - 1 );
+	job->hashNext = fs_prefetchHash[hash];
+	fs_prefetchHash[hash] = fs_numPrefetchJobs;
+
+	fs_numPrefetchJobs++;
+	fs_prefetchBytes += job->entry.size;
+
+	Sys_SemaphorePost( fs_prefetchWork );
+}
+
+/*
+============
+FS_TakePrefetched
+
+Hands over the buffer of a prefetched entry for this handle, or NULL if
+there isn't one.  *filled is qfalse if the read failed, the caller then
+reads into the buffer as normal.
+============
+*/
+static byte *FS_TakePrefetched( fileHandle_t f, int len, qboolean *filled ) {
+	prefetchJob_t	*job;
+	byte			*data;
+
+	if ( !fsh[f].zipFile || !fsh[f].pak ) {
+		return NULL;
+	}
+	job = FS_FindPrefetchJob( fsh[f].pak, fsh[f].zipFilePos );
+	if ( !job || job->taken || job->entry.size != len ) {
+		return NULL;
+	}
+
+	job->taken = qtrue;
+	fs_prefetchBytes -= job->entry.size;
+	*filled = FS_FinishPrefetchJob( job, qtrue );
+
+	data = job->data;
+	job->data = NULL;
+
+	if ( *filled ) {
+		fs_readCount += len;
+		fs_prefetchHits++;
+	}
+	return data;
+}
+
+/*
+============
+FS_PeekPrefetched
+
+Waits for a queued pk3 entry and returns its data without taking it,
+so a loader can look inside a file before reading it for real.  A loose
+copy earlier in the search path isn't considered, so only use this for
+hints.  Returns the length, or -1 if the file isn't queued or couldn't
+be read.
+============
+*/
+int FS_PeekPrefetched( const char *qpath, const void **buffer ) {
+	pathIndex_t		*indexed;
+	prefetchJob_t	*job;
+
+	*buffer = NULL;
+	if ( !fs_searchpaths || !fs_numPrefetchJobs || !qpath || !qpath[0] ) {
+		return -1;
+	}
+	if ( qpath[0] == '/' || qpath[0] == '\\' ) {
+		qpath++;
+	}
+
+	indexed = FS_PathIndexLookup( qpath );
+	if ( !indexed ) {
+		return -1;
+	}
+	job = FS_FindPrefetchJob( indexed->search->pack, indexed->pakFile->pos );
+	if ( !job || job->taken || !FS_FinishPrefetchJob( job, qtrue ) ) {
+		return -1;
+	}
+
+	*buffer = job->data;
+	return job->entry.size;
+}
+
+/*
+============
+FS_PrefetchFlush
+
+Drops everything that was prefetched and not used, called once a
+level load is over
+============
+*/
+void FS_PrefetchFlush( void ) {
+	prefetchJob_t	*job;
+	int				i, unused;
+
+	if ( !fs_numPrefetchJobs ) {
+		return;
+	}
+
+	unused = 0;
+	for ( i = 0, job = fs_prefetchJobs ; i < fs_numPrefetchJobs ; i++, job++ ) {
+		if ( !job->taken ) {
+			FS_FinishPrefetchJob( job, qfalse );
+			unused++;
+		}
+		if ( job->data ) {
+			Z_Free( job->data );
+			job->data = NULL;
+		}
+	}
+
+	// the threads still have to step their cursor past any job we claimed
+	// before the list can be reused
+	while ( fs_prefetchRetired < fs_numPrefetchJobs ) {
+		Sys_SemaphoreWait( fs_prefetchDone );
+	}
+
+	if ( fs_debug && fs_debug->integer ) {
+		Com_Printf( "FS_PrefetchFlush: %d of %d prefetched files used\n", fs_prefetchHits, fs_numPrefetchJobs );
+	}
+
+	fs_numPrefetchJobs = 0;
+	fs_prefetchClaimCursor = 0;
+	fs_prefetchRetired = 0;
+	fs_prefetchBytes = 0;
+	fs_prefetchHits = 0;
+	memset( fs_prefetchHash, -1, sizeof( fs_prefetchHash ) );
+}
+
+/*
+============
+FS_ReadMappedFile
+
+Whole-file read of a pk3 entry opened by FS_FOpenFileRead straight
+from the mapped archive.  Returns qfalse if the caller should go
+through unzip instead.
+============
+*/
+static qboolean FS_ReadMappedFile( fileHandle_t f, byte *buf, int len ) {
+	mappedEntry_t	entry;
+	pack_t			*pak;
+
+	pak = fsh[f].pak;
+	if ( !fsh[f].zipFile || !pak || !FS_MapPak( pak ) ) {
+		return qfalse;
+	}
+	if ( !FS_GetMappedEntry( pak, fsh[f].zipFilePos, &entry ) || entry.size != len ) {
+		return qfalse;
+	}
+	if ( !FS_DecodeMappedEntry( &entry, buf, qfalse ) ) {
+		return qfalse;
+	}
+
+	fs_readCount += len;
+	return qtrue;
 }
 
 /*
@@ -1260,6 +1914,7 @@ int FS_ReadFile( const char *qpath, void **buffer ) {
 	fileHandle_t	h;
 	byte*			buf;
 	qboolean		isConfig;
+	qboolean		filled;
 	int				len;
 
 	if ( !fs_searchpaths ) {
@@ -1349,13 +2004,20 @@ int FS_ReadFile( const char *qpath, void **buffer ) {
 	buf = (unsigned char *)Hunk_AllocateTempMemory(len+1);
 	*buffer = buf;*/
 
-	buf = (byte*)Z_Malloc( len+1, TAG_FILESYS, qfalse);
+	// a prefetched entry comes with its buffer
+	buf = FS_TakePrefetched( h, len, &filled );
+	if ( !buf ) {
+		buf = (byte*)Z_Malloc( len+1, TAG_FILESYS, qfalse);
+		filled = qfalse;
+	}
 	buf[len]='\0';	// because we're not calling Z_Malloc with optional trailing 'bZeroIt' bool
 	*buffer = buf;	
 
 //	Z_Label(buf, qpath);
 
-	FS_Read (buf, len, h);
+	if ( !filled && !FS_ReadMappedFile( h, buf, len ) ) {
+		FS_Read (buf, len, h);
+	}
 
 	// guarantee that it will have a trailing 0 for string operations
 	buf[len] = 0;
@@ -2230,6 +2892,9 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	
 	Q_strncpyz( fs_gamedir, dir, sizeof( fs_gamedir ) );
 
+	// the search order is changing, lookups will rebuild the index
+	FS_FreePathIndex();
+
 	//
 	// add the directory to the search path
 	//
@@ -2502,6 +3167,10 @@ void FS_Startup( const char *gameName ) {
 	fs_restrict = Cvar_Get ("fs_restrict", "", CVAR_INIT );
 
 	fs_dirbeforepak = Cvar_Get("fs_dirbeforepak", "0", CVAR_INIT);
+	fs_mmap = Cvar_Get( "fs_mmap", "1", 0 );
+	fs_prefetch = Cvar_Get( "fs_prefetch", "2", CVAR_ARCHIVE );
+	fs_prefetchCache = Cvar_Get( "fs_prefetchCache", "64", CVAR_ARCHIVE );
+	memset( fs_prefetchHash, -1, sizeof( fs_prefetchHash ) );
 
 	// add search path elements in reverse priority order
 	if (fs_cdpath->string[0]) {
@@ -2572,6 +3241,8 @@ void FS_Startup( const char *gameName ) {
 		missingFiles = fopen( "\\missing.txt", "ab" );
 	}
 #endif
+	FS_BuildPathIndex();
+
 	Com_Printf( "%d files in pk3 files\n", fs_packFiles );
 }
 
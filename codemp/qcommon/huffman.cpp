@@ -9,22 +9,22 @@
 
 static int			bloc = 0;
 
+// the offset versions keep all of their state in *offset, so they can be
+// used to encode and decode separate messages on several threads at once
 void	Huff_putBit( int bit, byte *fout, int *offset) {
-	bloc = *offset;
-	if ((bloc&7) == 0) {
-		fout[(bloc>>3)] = 0;
+	int b = *offset;
+	if ((b&7) == 0) {
+		fout[(b>>3)] = 0;
 	}
-	fout[(bloc>>3)] |= bit << (bloc&7);
-	bloc++;
-	*offset = bloc;
+	fout[(b>>3)] |= bit << (b&7);
+	*offset = b + 1;
 }
 
 int		Huff_getBit( byte *fin, int *offset) {
 	int t;
-	bloc = *offset;
-	t = (fin[(bloc>>3)] >> (bloc&7)) & 0x1;
-	bloc++;
-	*offset = bloc;
+	int b = *offset;
+	t = (fin[(b>>3)] >> (b&7)) & 0x1;
+	*offset = b + 1;
 	return t;
 }
 
@@ -250,13 +250,14 @@ int Huff_Receive (node_t *node, int *ch, byte *fin) {
 
 /* Get a symbol */
 void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset) {
-	bloc = *offset;
+	int b = *offset;
 	while (node && node->symbol == INTERNAL_NODE) {
-		if (get_bit(fin)) {
+		if ((fin[(b>>3)] >> (b&7)) & 0x1) {
 			node = node->right;
 		} else {
 			node = node->left;
 		}
+		b++;
 	}
 	if (!node) {
 		*ch = 0;
@@ -264,7 +265,7 @@ void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset) {
 //		Com_Error(ERR_DROP, "Illegal tree!\n");
 	}
 	*ch = node->symbol;
-	*offset = bloc;
+	*offset = b;
 }
 
 /* Send the prefix code for this node */
@@ -295,10 +296,119 @@ void Huff_transmit (huff_t *huff, int ch, byte *fout) {
 	}
 }
 
+/* Send the prefix code for this node at *offset */
+static void offsetSend(node_t *node, node_t *child, byte *fout, int *offset) {
+	if (node->parent) {
+		offsetSend(node->parent, node, fout, offset);
+	}
+	if (child) {
+		if (node->right == child) {
+			Huff_putBit(1, fout, offset);
+		} else {
+			Huff_putBit(0, fout, offset);
+		}
+	}
+}
+
 void Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset) {
-	bloc = *offset;
-	send(huff->loc[ch], NULL, fout);
-	*offset = bloc;
+	offsetSend(huff->loc[ch], NULL, fout, offset);
+}
+
+/*
+==================
+Huff_BuildTable
+
+Precomputes the codes of a tree that won't change any more, so
+symbols can be sent and received without walking the tree bit by bit
+==================
+*/
+void Huff_BuildTable( huffTable_t *table, const huff_t *huff ) {
+	const node_t	*node;
+	unsigned int	code;
+	int				ch, length, i, bit;
+
+	Com_Memset( table, 0, sizeof( *table ) );
+
+	for ( ch = 0 ; ch < HMAX ; ch++ ) {
+		node = huff->loc[ch];
+		if ( !node ) {
+			continue;	// never seen, can't be sent
+		}
+
+		// walk up to the root, the last bit found is the first one sent
+		code = 0;
+		length = 0;
+		for ( ; node->parent ; node = node->parent ) {
+			if ( length == HUFF_TABLE_MAXCODE ) {
+				return;
+			}
+			code = ( code << 1 ) | ( node->parent->right == node ? 1 : 0 );
+			length++;
+		}
+		table->encodeBits[ch] = code;
+		table->encodeLength[ch] = length;
+	}
+
+	for ( i = 0 ; i < HUFF_TABLE_PEEKSIZE ; i++ ) {
+		node = huff->tree;
+		for ( bit = 0 ; bit < HUFF_TABLE_PEEKBITS && node && node->symbol == INTERNAL_NODE ; bit++ ) {
+			node = ( i >> bit ) & 1 ? node->right : node->left;
+		}
+		if ( node && node->symbol != INTERNAL_NODE ) {
+			table->decodeSymbol[i] = node->symbol;
+			table->decodeLength[i] = bit;
+		} else {
+			table->decodeSymbol[i] = -1;
+			table->decodeLength[i] = HUFF_TABLE_PEEKBITS;
+		}
+		table->decodeNode[i] = (node_t *)node;
+	}
+
+	table->valid = qtrue;
+}
+
+/*
+==================
+Huff_tableReceive
+
+Same as Huff_offsetReceive, but looks up HUFF_TABLE_PEEKBITS at once.
+May read up to three bytes past *offset.
+==================
+*/
+void Huff_tableReceive( const huffTable_t *table, int *ch, const byte *fin, int *offset ) {
+	const byte		*p;
+	unsigned int	peek;
+	int				b;
+	node_t			*node;
+
+	b = *offset;
+	p = fin + ( b >> 3 );
+	peek = ( p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) ) >> ( b & 7 );
+	peek &= HUFF_TABLE_PEEKSIZE - 1;
+
+	b += table->decodeLength[peek];
+	if ( table->decodeSymbol[peek] >= 0 ) {
+		*ch = table->decodeSymbol[peek];
+		*offset = b;
+		return;
+	}
+
+	// finish off long codes on the tree
+	node = table->decodeNode[peek];
+	while (node && node->symbol == INTERNAL_NODE) {
+		if ((fin[(b>>3)] >> (b&7)) & 0x1) {
+			node = node->right;
+		} else {
+			node = node->left;
+		}
+		b++;
+	}
+	if (!node) {
+		*ch = 0;
+		return;
+	}
+	*ch = node->symbol;
+	*offset = b;
 }
 
 void Huff_Decompress(msg_t *mbuf, int offset) {
@@ -353,7 +463,7 @@ void Huff_Decompress(msg_t *mbuf, int offset) {
 	Com_Memcpy(mbuf->data + offset, seq, cch);
 }
 
-extern 	int oldsize;
+extern 	THREADLOCAL int oldsize;
 
 void Huff_Compress(msg_t *mbuf, int offset) {
 	int			i, ch, size;
@@ -0,0 +1,538 @@
+// jobs.cpp -- work stealing job scheduler
+
+//Anything above this #include will be ignored by the compiler
+#include "../qcommon/exe_headers.h"
+
+/*
+=============================================================================
+
+JOB SYSTEM
+
+The main thread and every job thread own a fixed size deque of jobs.  The
+owner pushes and pops at the bottom, threads that run out of work steal
+from the top of the others (Chase-Lev), so the only contended operation is
+the compare and swap on a deque's top.  A job that doesn't fit its deque is
+run right away by the thread adding it.
+
+Each job can name a counter that is raised when the job is added and
+lowered when it has run.  Job_Wait runs jobs until the counter reaches
+zero, so a job may wait on jobs it added itself without tying up a thread.
+
+Jobs follow the Sys_CreateThread rules: no Com_Error, Com_Printf or
+Z_Malloc.  Only the main thread and jobs may add jobs.
+
+=============================================================================
+*/
+
+#define MAX_JOB_THREADS		15			// not counting the main thread
+#define JOB_DEQUE_SIZE		256			// must be a power of two
+#define JOB_DEQUE_MASK		( JOB_DEQUE_SIZE - 1 )
+
+typedef struct {
+	jobFunc_t		function;
+	jobRangeFunc_t	rangeFunction;
+	void			*data;
+	int				first, last;
+	jobCounter_t	*counter;
+} job_t;
+
+typedef struct {
+	volatile int	top;				// next job to be stolen
+	volatile int	bottom;				// next free slot
+	job_t			jobs[JOB_DEQUE_SIZE];
+} jobDeque_t;
+
+typedef struct {
+	int				numThreads;			// not counting the main thread
+	void			*threads[MAX_JOB_THREADS];
+	jobDeque_t		deques[MAX_JOB_THREADS+1];	// the main thread owns deques[0]
+	void			*wakeSemaphore;
+	volatile int	sleeping;			// threads that will wait on wakeSemaphore
+	volatile int	shutdown;
+} jobPool_t;
+
+static jobPool_t	jobPool;
+
+// index of the deque the running thread owns
+static THREADLOCAL int	jobThreadNum;
+
+cvar_t	*com_jobThreads;
+
+/*
+=======================
+Job_Push
+
+Only called by the owner of the deque
+=======================
+*/
+static qboolean Job_Push( jobDeque_t *deque, const job_t *job ) {
+	int		b;
+
+	b = deque->bottom;
+	if ( b - deque->top >= JOB_DEQUE_SIZE ) {
+		return qfalse;
+	}
+	deque->jobs[b & JOB_DEQUE_MASK] = *job;
+	// publishes the job to the stealers
+	Sys_AtomicAdd( &deque->bottom, 1 );
+	return qtrue;
+}
+
+/*
+=======================
+Job_Pop
+
+Only called by the owner of the deque
+=======================
+*/
+static qboolean Job_Pop( jobDeque_t *deque, job_t *job ) {
+	int			b, t;
+	qboolean	taken;
+
+	b = Sys_AtomicAdd( &deque->bottom, -1 );
+	t = deque->top;
+	if ( t > b ) {
+		// empty
+		deque->bottom = b + 1;
+		return qfalse;
+	}
+
+	*job = deque->jobs[b & JOB_DEQUE_MASK];
+	if ( t < b ) {
+		return qtrue;
+	}
+
+	// the last job, a stealer may be taking it as well
+	taken = (qboolean)( Sys_AtomicCompareExchange( &deque->top, t + 1, t ) == t );
+	deque->bottom = t + 1;
+	return taken;
+}
+
+/*
+=======================
+Job_Steal
+=======================
+*/
+static qboolean Job_Steal( jobDeque_t *deque, job_t *job ) {
+	int		b, t;
+
+	t = Sys_AtomicAdd( &deque->top, 0 );
+	b = deque->bottom;
+	if ( t >= b ) {
+		return qfalse;
+	}
+
+	*job = deque->jobs[t & JOB_DEQUE_MASK];
+	// another thread got it first
+	return (qboolean)( Sys_AtomicCompareExchange( &deque->top, t + 1, t ) == t );
+}
+
+/*
+=======================
+Job_Find
+
+Takes a job from the thread's own deque, or steals one
+=======================
+*/
+static qboolean Job_Find( job_t *job ) {
+	int		i, numDeques;
+
+	if ( Job_Pop( &jobPool.deques[jobThreadNum], job ) ) {
+		return qtrue;
+	}
+
+	numDeques = jobPool.numThreads + 1;
+	for ( i = 1 ; i < numDeques ; i++ ) {
+		if ( Job_Steal( &jobPool.deques[( jobThreadNum + i ) % numDeques], job ) ) {
+			return qtrue;
+		}
+	}
+	return qfalse;
+}
+
+/*
+=======================
+Job_Run
+=======================
+*/
+static void Job_Run( const job_t *job ) {
+	if ( job->rangeFunction ) {
+		job->rangeFunction( job->data, job->first, job->last );
+	} else {
+		job->function( job->data );
+	}
+	if ( job->counter ) {
+		Sys_AtomicAdd( &job->counter->pending, -1 );
+	}
+}
+
+/*
+=======================
+Job_Wake
+
+Wakes up to count sleeping threads
+=======================
+*/
+static void Job_Wake( int count ) {
+	int		sleeping;
+
+	while ( count > 0 ) {
+		sleeping = Sys_AtomicAdd( &jobPool.sleeping, 0 );
+		if ( sleeping <= 0 ) {
+			return;
+		}
+		if ( Sys_AtomicCompareExchange( &jobPool.sleeping, sleeping - 1, sleeping ) == sleeping ) {
+			Sys_SemaphorePost( jobPool.wakeSemaphore );
+			count--;
+		}
+	}
+}
+
+/*
+=======================
+Job_Thread
+=======================
+*/
+static void Job_Thread( void *data ) {
+	job_t	job;
+
+	jobThreadNum = (jobDeque_t *)data - jobPool.deques;
+
+	while ( !jobPool.shutdown ) {
+		if ( Job_Find( &job ) ) {
+			Job_Run( &job );
+			continue;
+		}
+
+		// once counted as sleeping, every job added posts the semaphore,
+		// so the wait below can't miss a job added after this last look
+		Sys_AtomicAdd( &jobPool.sleeping, 1 );
+		while ( Job_Find( &job ) ) {
+			Job_Run( &job );
+		}
+		Sys_SemaphoreWait( jobPool.wakeSemaphore );
+	}
+}
+
+/*
+=======================
+Job_Queue
+=======================
+*/
+static void Job_Queue( const job_t *job ) {
+	if ( job->counter ) {
+		Sys_AtomicAdd( &job->counter->pending, 1 );
+	}
+	if ( !Job_Push( &jobPool.deques[jobThreadNum], job ) ) {
+		Job_Run( job );
+		return;
+	}
+	Job_Wake( 1 );
+}
+
+/*
+=======================
+Job_Add
+
+Queues function( data ), raising counter until it has run
+=======================
+*/
+void Job_Add( jobFunc_t function, void *data, jobCounter_t *counter ) {
+	job_t	job;
+
+	job.function = function;
+	job.rangeFunction = NULL;
+	job.data = data;
+	job.first = job.last = 0;
+	job.counter = counter;
+	Job_Queue( &job );
+}
+
+/*
+=======================
+Job_AddRange
+
+Queues function( data, first, last ) for [first, last)
+=======================
+*/
+void Job_AddRange( jobRangeFunc_t function, void *data, int first, int last, jobCounter_t *counter ) {
+	job_t	job;
+
+	job.function = NULL;
+	job.rangeFunction = function;
+	job.data = data;
+	job.first = first;
+	job.last = last;
+	job.counter = counter;
+	Job_Queue( &job );
+}
+
+/*
+=======================
+Job_Wait
+
+Runs jobs until everything counted by counter has run
+=======================
+*/
+void Job_Wait( jobCounter_t *counter ) {
+	job_t	job;
+
+	while ( Sys_AtomicAdd( &counter->pending, 0 ) > 0 ) {
+		if ( Job_Find( &job ) ) {
+			Job_Run( &job );
+		}
+	}
+}
+
+/*
+=======================
+Job_ParallelFor
+
+Splits [0, count) into ranges of at most batch items, runs them on the job
+threads and the calling thread, and returns when they are all done
+=======================
+*/
+void Job_ParallelFor( jobRangeFunc_t function, void *data, int count, int batch ) {
+	jobCounter_t	counter;
+	int				first;
+
+	if ( count <= 0 ) {
+		return;
+	}
+	if ( batch < 1 ) {
+		// a few ranges per thread so the stealing can even out the load
+		batch = count / ( ( jobPool.numThreads + 1 ) * 4 );
+		if ( batch < 1 ) {
+			batch = 1;
+		}
+	}
+	if ( !jobPool.numThreads || count <= batch ) {
+		function( data, 0, count );
+		return;
+	}
+
+	counter.pending = 0;
+	for ( first = 0 ; first < count ; first += batch ) {
+		Job_AddRange( function, data, first, first + batch < count ? first + batch : count, &counter );
+	}
+	Job_Wait( &counter );
+}
+
+/*
+=======================
+Job_NumThreads
+
+Threads that run jobs, counting the main thread
+=======================
+*/
+int Job_NumThreads( void ) {
+	return jobPool.numThreads + 1;
+}
+
+/*
+=============================================================================
+
+BENCHMARK
+
+=============================================================================
+*/
+
+typedef struct {
+	volatile int	*runs;				// [numItems] times each item has run
+	int				numItems;
+	int				work;				// iterations of busy work per item
+	volatile int	checksum;
+	jobCounter_t	*counter;			// for jobs added by jobs
+} jobBench_t;
+
+static int Job_BenchWork( int item, int work ) {
+	unsigned int	h;
+	int				i;
+
+	h = item;
+	for ( i = 0 ; i < work ; i++ ) {
+		h = h * 1664525 + 1013904223;
+	}
+	return h >> 16;
+}
+
+static void Job_BenchRange( void *data, int first, int last ) {
+	jobBench_t	*bench = (jobBench_t *)data;
+	int			i, sum;
+
+	sum = 0;
+	for ( i = first ; i < last ; i++ ) {
+		Sys_AtomicAdd( &bench->runs[i], 1 );
+		sum += Job_BenchWork( i, bench->work );
+	}
+	Sys_AtomicAdd( &bench->checksum, sum );
+}
+
+// splits its range in two until it's small, each half as a new job
+static void Job_BenchSplit( void *data, int first, int last ) {
+	jobBench_t	*bench = (jobBench_t *)data;
+	int			mid;
+
+	if ( last - first <= 16 ) {
+		Job_BenchRange( data, first, last );
+		return;
+	}
+	mid = ( first + last ) / 2;
+	Job_AddRange( Job_BenchSplit, data, first, mid, bench->counter );
+	Job_AddRange( Job_BenchSplit, data, mid, last, bench->counter );
+}
+
+static qboolean Job_BenchCheck( jobBench_t *bench, int expectedSum, const char *test ) {
+	int		i;
+
+	for ( i = 0 ; i < bench->numItems ; i++ ) {
+		if ( bench->runs[i] != 1 ) {
+			Com_Printf( S_COLOR_RED "%s: item %i ran %i times\n", test, i, bench->runs[i] );
+			return qfalse;
+		}
+	}
+	if ( bench->checksum != expectedSum ) {
+		Com_Printf( S_COLOR_RED "%s: checksum %i, should be %i\n", test, bench->checksum, expectedSum );
+		return qfalse;
+	}
+	return qtrue;
+}
+
+/*
+=======================
+Job_Bench_f
+
+jobbench [items] [work] [passes]
+
+Times the same work run on the main thread, with Job_ParallelFor, and as
+a tree of jobs adding jobs, and checks every item ran exactly once
+=======================
+*/
+static void Job_Bench_f( void ) {
+	jobBench_t		bench;
+	jobCounter_t	counter;
+	int				passes, pass, i, expectedSum, start;
+	int				serialTime, parallelTime, splitTime;
+	qboolean		ok;
+
+	bench.numItems = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 65536;
+	bench.work = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 200;
+	passes = Cmd_Argc() > 3 ? atoi( Cmd_Argv( 3 ) ) : 10;
+	if ( bench.numItems < 1 || bench.work < 0 || passes < 1 ) {
+		Com_Printf( "usage: jobbench [items] [work] [passes]\n" );
+		return;
+	}
+	bench.runs = (volatile int *)Z_Malloc( bench.numItems * sizeof( int ), TAG_TEMP_WORKSPACE, qtrue );
+	bench.counter = &counter;
+
+	expectedSum = 0;
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		expectedSum = 0;
+		for ( i = 0 ; i < bench.numItems ; i++ ) {
+			expectedSum += Job_BenchWork( i, bench.work );
+		}
+	}
+	serialTime = Sys_Milliseconds() - start;
+
+	ok = qtrue;
+	parallelTime = 0;
+	splitTime = 0;
+	for ( pass = 0 ; pass < passes && ok ; pass++ ) {
+		Com_Memset( (void *)bench.runs, 0, bench.numItems * sizeof( int ) );
+		bench.checksum = 0;
+		start = Sys_Milliseconds();
+		Job_ParallelFor( Job_BenchRange, &bench, bench.numItems, 0 );
+		parallelTime += Sys_Milliseconds() - start;
+		ok = Job_BenchCheck( &bench, expectedSum, "parallel for" );
+		if ( !ok ) {
+			break;
+		}
+
+		Com_Memset( (void *)bench.runs, 0, bench.numItems * sizeof( int ) );
+		bench.checksum = 0;
+		counter.pending = 0;
+		start = Sys_Milliseconds();
+		Job_AddRange( Job_BenchSplit, &bench, 0, bench.numItems, &counter );
+		Job_Wait( &counter );
+		splitTime += Sys_Milliseconds() - start;
+		ok = Job_BenchCheck( &bench, expectedSum, "nested jobs" );
+	}
+
+	Z_Free( (void *)bench.runs );
+
+	if ( !ok ) {
+		Com_Printf( S_COLOR_RED "jobbench failed\n" );
+		return;
+	}
+	Com_Printf( "%i items, %i work, %i passes, %i threads\n", bench.numItems, bench.work, passes, Job_NumThreads() );
+	Com_Printf( "main thread  : %5i msec\n", serialTime );
+	Com_Printf( "parallel for : %5i msec\n", parallelTime );
+	Com_Printf( "nested jobs  : %5i msec\n", splitTime );
+}
+
+/*
+=======================
+Job_Init
+=======================
+*/
+void Job_Init( void ) {
+	int		i, numThreads;
+
+	com_jobThreads = Cvar_Get( "com_jobThreads", "0", CVAR_ARCHIVE | CVAR_LATCH );
+	Cmd_AddCommand( "jobbench", Job_Bench_f );
+
+	Com_Memset( &jobPool, 0, sizeof( jobPool ) );
+	jobThreadNum = 0;
+
+	numThreads = com_jobThreads->integer;
+	if ( numThreads < 0 ) {
+		numThreads = Sys_ProcessorCount() - 1;
+	}
+	if ( numThreads > MAX_JOB_THREADS ) {
+		numThreads = MAX_JOB_THREADS;
+	}
+	if ( numThreads <= 0 ) {
+		return;
+	}
+
+	jobPool.wakeSemaphore = Sys_CreateSemaphore( 0 );
+	if ( !jobPool.wakeSemaphore ) {
+		Com_Printf( "WARNING: couldn't create job thread semaphore\n" );
+		return;
+	}
+
+	for ( i = 0 ; i < numThreads ; i++ ) {
+		// numThreads is only raised once the thread exists, so nothing
+		// steals from a deque nobody owns
+		jobPool.threads[i] = Sys_CreateThread( Job_Thread, &jobPool.deques[i+1] );
+		if ( !jobPool.threads[i] ) {
+			Com_Printf( "WARNING: only started %i of %i job threads\n", i, numThreads );
+			break;
+		}
+		jobPool.numThreads++;
+	}
+	Com_Printf( "%i job threads\n", jobPool.numThreads );
+}
+
+/*
+=======================
+Job_Shutdown
+=======================
+*/
+void Job_Shutdown( void ) {
+	int		i;
+
+	jobPool.shutdown = qtrue;
+	for ( i = 0 ; i < jobPool.numThreads ; i++ ) {
+		Sys_SemaphorePost( jobPool.wakeSemaphore );
+	}
+	for ( i = 0 ; i < jobPool.numThreads ; i++ ) {
+		Sys_JoinThread( jobPool.threads[i] );
+	}
+	if ( jobPool.wakeSemaphore ) {
+		Sys_DestroySemaphore( jobPool.wakeSemaphore );
+	}
+	Com_Memset( &jobPool, 0, sizeof( jobPool ) );
+	Cmd_RemoveCommand( "jobbench" );
+}
@@ -17,6 +17,7 @@ extern	cvar_t	*cl_shownet;
 //#define _USINGNEWHUFFTABLE_		// Build a new frequency table to cut and paste.
 
 static huffman_t		msgHuff;
+static huffTable_t		msgHuffTable;		// msgHuff never changes after MSG_initHuffman
 
 static qboolean			msgInit = qfalse;
 static FILE				*fp=0;
@@ -30,11 +31,12 @@ Handles byte ordering and avoids alignment errors
 ==============================================================================
 */
 
+// per thread, snapshots can be encoded on several threads at once
 #ifndef FINAL_BUILD
-	int gLastBitIndex = 0;
+	THREADLOCAL int gLastBitIndex = 0;
 #endif
 
-int oldsize = 0;
+THREADLOCAL int oldsize = 0;
 
 #ifndef _XBOX	// No mods on Xbox
 bool g_nOverrideChecked = false;
@@ -123,7 +125,79 @@ bit functions
 =============================================================================
 */
 
-int	overflows;
+THREADLOCAL int	overflows;
+
+/*
+=================
+MSG_FlushHuffBits
+
+Stores up to 64 accumulated bits at the message's bit position,
+leaving the buffer exactly as Huff_putBit would have
+=================
+*/
+static void MSG_FlushHuffBits( msg_t *msg, huffBits_t acc, int accBits ) {
+	byte	*p;
+	int		shift;
+
+	if ( !accBits ) {
+		return;
+	}
+
+	p = msg->data + ( msg->bit >> 3 );
+	shift = msg->bit & 7;
+	msg->bit += accBits;
+
+	if ( shift ) {
+		// the bits above shift are still clear
+		*p++ |= (byte)( acc << shift );
+		if ( accBits <= 8 - shift ) {
+			return;
+		}
+		acc >>= 8 - shift;
+		accBits -= 8 - shift;
+	}
+
+	while ( accBits > 0 ) {
+		*p++ = (byte)acc;
+		acc >>= 8;
+		accBits -= 8;
+	}
+}
+
+/*
+=================
+MSG_WriteHuffBits
+
+The table driven version of the huffman part of MSG_WriteBits
+=================
+*/
+static void MSG_WriteHuffBits( msg_t *msg, unsigned int value, int bits ) {
+	huffBits_t	acc;
+	int			accBits;
+	int			nbits, i, ch, length;
+
+	// the bits that don't make up a whole byte are sent raw
+	nbits = bits & 7;
+	acc = value & ( ( 1 << nbits ) - 1 );
+	accBits = nbits;
+	value >>= nbits;
+	bits -= nbits;
+
+	for ( i = 0 ; i < bits ; i += 8 ) {
+		ch = value & 0xff;
+		value >>= 8;
+		length = msgHuffTable.encodeLength[ch];
+		if ( accBits + length > 64 ) {
+			MSG_FlushHuffBits( msg, acc, accBits );
+			acc = 0;
+			accBits = 0;
+		}
+		acc |= (huffBits_t)msgHuffTable.encodeBits[ch] << accBits;
+		accBits += length;
+	}
+
+	MSG_FlushHuffBits( msg, acc, accBits );
+}
 
 // negative bit values include signs
 void MSG_WriteBits( msg_t *msg, int value, int bits ) {
@@ -184,6 +258,10 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 		} else {
 			Com_Error(ERR_DROP, "can't read %d bits\n", bits);
 		}
+	} else if ( msgHuffTable.valid ) {
+		value &= (0xffffffff>>(32-bits));
+		MSG_WriteHuffBits( msg, value, bits );
+		msg->cursize = (msg->bit>>3)+1;
 	} else {
 		value &= (0xffffffff>>(32-bits));
 		if (bits&7) {
@@ -251,7 +329,12 @@ int MSG_ReadBits( msg_t *msg, int bits ) {
 		}
 		if (bits) {
 			for(i=0;i<bits;i+=8) {
-				Huff_offsetReceive (msgHuff.decompressor.tree, &get, msg->data, &msg->bit);
+				// the lookup reads a few bytes ahead of the bit position
+				if ( msgHuffTable.valid && ( msg->bit >> 3 ) + 3 <= msg->maxsize ) {
+					Huff_tableReceive (&msgHuffTable, &get, msg->data, &msg->bit);
+				} else {
+					Huff_offsetReceive (msgHuff.decompressor.tree, &get, msg->data, &msg->bit);
+				}
 #ifdef _NEWHUFFTABLE_
 				fwrite(&get, 1, 1, fp);
 #endif // _NEWHUFFTABLE_
@@ -838,7 +921,7 @@ typedef struct {
 #endif
 	int		bits;		// 0 = float
 #ifndef FINAL_BUILD
-	unsigned	mCount;
+	volatile int	mCount;		// Sys_AtomicAdd, snapshots can be encoded on several threads
 #endif
 
 } netField_t;
@@ -1117,7 +1200,7 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 		if ( *fromF != *toF ) {
 			lc = i+1;
 #ifndef FINAL_BUILD
-			field->mCount++;
+			Sys_AtomicAdd( &field->mCount, 1 );
 #endif
 		}
 #endif
@@ -1212,6 +1295,232 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 	}
 }
 
+/*
+=============================================================================
+
+Entity delta cache
+
+When many clients ack the same frames, the server keeps writing the same
+entity deltas over and over.  The encoded bits of a delta don't depend on
+where in the message they start, so they are kept for the rest of the
+server frame and copied into any other message that needs the same delta.
+
+A cache must only be used by one thread at a time.
+
+=============================================================================
+*/
+
+#define	DELTACACHE_SLOTS		1024			// must be a power of two
+#define	DELTACACHE_PROBES		8
+#define	DELTACACHE_ARENA_SIZE	(256*1024)
+#define	DELTACACHE_MAX_BYTES	2048			// largest delta that will be cached
+
+typedef struct {
+	int				frame;				// valid if == cache->frame
+	unsigned int	hash;
+	qboolean		force;
+	entityState_t	from;
+	entityState_t	to;
+	int				offset;				// into arena
+	int				numBits;
+} deltaCacheSlot_t;
+
+struct entityDeltaCache_s {
+	int					frame;
+	deltaCacheSlot_t	slots[DELTACACHE_SLOTS];
+	byte				arena[DELTACACHE_ARENA_SIZE];
+	int					arenaUsed;
+
+	int					lookups;		// for changeVectors
+	int					hits;
+
+	entityDeltaCache_t	*next;
+};
+
+static entityDeltaCache_t	*msgDeltaCaches;		// every allocated cache, for reporting
+
+/*
+==================
+MSG_AllocEntityDeltaCache
+==================
+*/
+entityDeltaCache_t *MSG_AllocEntityDeltaCache( void ) {
+	entityDeltaCache_t	*cache;
+
+	cache = (entityDeltaCache_t *)Z_Malloc( sizeof( *cache ), TAG_GENERAL, qtrue );
+	cache->frame = 1;
+	cache->next = msgDeltaCaches;
+	msgDeltaCaches = cache;
+	return cache;
+}
+
+/*
+==================
+MSG_FreeEntityDeltaCache
+==================
+*/
+void MSG_FreeEntityDeltaCache( entityDeltaCache_t *cache ) {
+	entityDeltaCache_t	**prev;
+
+	for ( prev = &msgDeltaCaches ; *prev ; prev = &(*prev)->next ) {
+		if ( *prev == cache ) {
+			*prev = cache->next;
+			break;
+		}
+	}
+	Z_Free( cache );
+}
+
+/*
+==================
+MSG_ClearEntityDeltaCache
+
+Forgets every delta, must be called whenever the entity states
+that were delta'd could have changed
+==================
+*/
+void MSG_ClearEntityDeltaCache( entityDeltaCache_t *cache ) {
+	cache->frame++;
+	cache->arenaUsed = 0;
+}
+
+/*
+==================
+MSG_HashEntityState
+==================
+*/
+static unsigned int MSG_HashEntityState( const entityState_t *state, unsigned int hash ) {
+	const int	*p;
+	int			i;
+
+	p = (const int *)state;
+	for ( i = 0 ; i < (int)( sizeof( *state ) / 4 ) ; i++ ) {
+		hash = ( hash ^ (unsigned int)p[i] ) * 16777619;
+	}
+	return hash;
+}
+
+/*
+==================
+MSG_AppendBits
+
+Copies bits written by MSG_WriteBits into another message at any bit position
+==================
+*/
+static void MSG_AppendBits( msg_t *msg, const byte *bits, int numBits ) {
+	byte	*out;
+	int		numBytes, shift;
+	int		i;
+
+	if ( !numBits ) {
+		return;
+	}
+
+	numBytes = ( numBits + 7 ) >> 3;
+
+	// this isn't an exact overflow check, but close enough
+	if ( msg->maxsize - ( ( msg->bit >> 3 ) + numBytes ) < 4 ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	out = msg->data + ( msg->bit >> 3 );
+	shift = msg->bit & 7;
+
+	if ( !shift ) {
+		Com_Memcpy( out, bits, numBytes );
+	} else {
+		// the unused high bits of the current byte are always clear
+		for ( i = 0 ; i < numBytes ; i++ ) {
+			out[i] |= bits[i] << shift;
+			out[i+1] = bits[i] >> ( 8 - shift );
+		}
+	}
+
+	msg->bit += numBits;
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
+/*
+==================
+MSG_WriteDeltaEntityCached
+
+Same as MSG_WriteDeltaEntity, but reuses the encoded delta if the
+same from -> to delta has already been written since the cache was
+last cleared.  A NULL cache writes the delta normally.
+==================
+*/
+void MSG_WriteDeltaEntityCached( msg_t *msg, struct entityState_s *from, struct entityState_s *to, 
+						   qboolean force, entityDeltaCache_t *cache ) {
+	deltaCacheSlot_t	*slot, *freeSlot;
+	unsigned int		hash;
+	int					i;
+	msg_t				encoded;
+	byte				encodedBuf[DELTACACHE_MAX_BYTES + 8];
+
+	// removes are only a few bits
+	if ( !cache || !from || !to || msg->oob ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	// most entities don't change between frames, and an unchanged
+	// entity is written as nothing or two bits without hashing
+	if ( !memcmp( from, to, sizeof( *to ) ) ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	cache->lookups++;
+
+	hash = MSG_HashEntityState( from, 2166136261u );
+	hash = MSG_HashEntityState( to, hash );
+	if ( force ) {
+		hash = ~hash;
+	}
+
+	freeSlot = NULL;
+	for ( i = 0 ; i < DELTACACHE_PROBES ; i++ ) {
+		slot = &cache->slots[( hash + i ) & ( DELTACACHE_SLOTS - 1 )];
+		if ( slot->frame != cache->frame ) {
+			if ( !freeSlot ) {
+				freeSlot = slot;
+			}
+			continue;
+		}
+		if ( slot->hash == hash && slot->force == force 
+			&& !memcmp( &slot->to, to, sizeof( *to ) ) && !memcmp( &slot->from, from, sizeof( *from ) ) ) {
+			cache->hits++;
+			MSG_AppendBits( msg, cache->arena + slot->offset, slot->numBits );
+			return;
+		}
+	}
+
+	if ( !freeSlot || cache->arenaUsed + DELTACACHE_MAX_BYTES > DELTACACHE_ARENA_SIZE ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	// encode on its own so the bits can be kept
+	MSG_Init( &encoded, encodedBuf, sizeof( encodedBuf ) );
+	MSG_WriteDeltaEntity( &encoded, from, to, force );
+	if ( encoded.overflowed ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+	MSG_AppendBits( msg, encoded.data, encoded.bit );
+
+	freeSlot->frame = cache->frame;
+	freeSlot->hash = hash;
+	freeSlot->force = force;
+	freeSlot->from = *from;
+	freeSlot->to = *to;
+	freeSlot->offset = cache->arenaUsed;
+	freeSlot->numBits = encoded.bit;
+	Com_Memcpy( cache->arena + cache->arenaUsed, encoded.data, ( encoded.bit + 7 ) >> 3 );
+	cache->arenaUsed += ( encoded.bit + 7 ) >> 3;
+}
+
 /*
 ==================
 MSG_ReadDeltaEntity
@@ -2271,7 +2580,7 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 		if ( *fromF != *toF ) {
 			lc = i+1;
 #ifndef FINAL_BUILD
-			field->mCount++;
+			Sys_AtomicAdd( &field->mCount, 1 );
 #endif
 		}
 	}
@@ -3231,6 +3540,10 @@ void MSG_initHuffman() {
 			Huff_addRef(&msgHuff.decompressor,	(byte)i);			// Do update
 		}
 	}
+
+#ifndef _NEWHUFFTABLE_	// every byte has to go through MSG_WriteBits' fwrite
+	Huff_BuildTable( &msgHuffTable, &msgHuff.compressor );
+#endif
 }
 
 #else
@@ -3289,6 +3602,19 @@ Prints out a table from the current statistics for copying to code
 =================
 */
 void MSG_ReportChangeVectors_f( void ) {
+	entityDeltaCache_t	*cache;
+	int					lookups, hits;
+
+	lookups = hits = 0;
+	for ( cache = msgDeltaCaches ; cache ; cache = cache->next ) {
+		lookups += cache->lookups;
+		hits += cache->hits;
+		cache->lookups = cache->hits = 0;
+	}
+	if ( lookups ) {
+		Com_Printf("Entity delta cache: %d hits / %d lookups (%.1f%%)\n\n", hits, lookups, 100.0f * hits / lookups);
+	}
+
 #ifndef _XBOX
 #ifndef FINAL_BUILD
 	int			numFields, i;
@@ -3315,4 +3641,136 @@ void MSG_ReportChangeVectors_f( void ) {
 #endif
 }
 
+/*
+=================
+MSG_HuffBench_f
+
+huffbench <demo> [passes]
+
+Decodes the huffman symbols of every message recorded in a demo, then
+times encoding and decoding them with the lookup tables and with the
+tree, and checks that both produce the same bits
+=================
+*/
+void MSG_HuffBench_f( void ) {
+	byte		*demo, *symbols, *treeBuf, *tableBuf;
+	int			demoSize, numSymbols, encodedSize;
+	int			pos, len, passes, pass, i, start, ch;
+	int			treeEncode, tableEncode, treeDecode, tableDecode;
+	msg_t		msg;
+	qboolean	saveValid;
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "usage: huffbench <demo> [passes]\n" );
+		return;
+	}
+	if ( !msgInit ) {
+		MSG_initHuffman();
+	}
+	if ( !msgHuffTable.valid ) {
+		Com_Printf( "huffman lookup tables are not in use\n" );
+		return;
+	}
+
+	demoSize = FS_ReadFile( Cmd_Argv( 1 ), (void **)&demo );
+	if ( demoSize <= 0 ) {
+		Com_Printf( "couldn't load %s\n", Cmd_Argv( 1 ) );
+		return;
+	}
+	passes = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 20;
+	if ( passes < 1 ) {
+		passes = 1;
+	}
+
+	// pull the symbols out of each recorded message: sequence, length, data
+	symbols = (byte *)Z_Malloc( demoSize * 4, TAG_TEMP_WORKSPACE, qfalse );
+	numSymbols = 0;
+	for ( pos = 0 ; pos + 8 <= demoSize ; pos += 8 + len ) {
+		len = LittleLong( *(int *)( demo + pos + 4 ) );
+		if ( len <= 0 || pos + 8 + len > demoSize ) {
+			break;
+		}
+		i = 0;
+		while ( ( i >> 3 ) + 4 < len ) {
+			Huff_offsetReceive( msgHuff.decompressor.tree, &ch, demo + pos + 8, &i );
+			symbols[numSymbols++] = ch;
+		}
+	}
+	FS_FreeFile( demo );
+
+	if ( !numSymbols ) {
+		Com_Printf( "no messages found\n" );
+		Z_Free( symbols );
+		return;
+	}
+
+	treeBuf = (byte *)Z_Malloc( numSymbols * 4 + 16, TAG_TEMP_WORKSPACE, qtrue );
+	tableBuf = (byte *)Z_Malloc( numSymbols * 4 + 16, TAG_TEMP_WORKSPACE, qtrue );
+	saveValid = msgHuffTable.valid;
+
+	// encode
+	msgHuffTable.valid = qfalse;
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		MSG_Init( &msg, treeBuf, numSymbols * 4 + 16 );
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			MSG_WriteBits( &msg, symbols[i], 8 );
+		}
+	}
+	treeEncode = Sys_Milliseconds() - start;
+	encodedSize = msg.cursize;
+
+	msgHuffTable.valid = saveValid;
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		MSG_Init( &msg, tableBuf, numSymbols * 4 + 16 );
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			MSG_WriteBits( &msg, symbols[i], 8 );
+		}
+	}
+	tableEncode = Sys_Milliseconds() - start;
+
+	if ( msg.cursize != encodedSize || memcmp( treeBuf, tableBuf, encodedSize ) ) {
+		Com_Printf( "^1table encoding doesn't match the tree!\n" );
+	}
+
+	// decode
+	msgHuffTable.valid = qfalse;
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		MSG_Init( &msg, treeBuf, numSymbols * 4 + 16 );
+		msg.cursize = encodedSize;
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			MSG_ReadBits( &msg, 8 );
+		}
+	}
+	treeDecode = Sys_Milliseconds() - start;
+
+	msgHuffTable.valid = saveValid;
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		MSG_Init( &msg, tableBuf, numSymbols * 4 + 16 );
+		msg.cursize = encodedSize;
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			if ( MSG_ReadBits( &msg, 8 ) != symbols[i] ) {
+				Com_Printf( "^1table decoding doesn't match symbol %i!\n", i );
+				break;
+			}
+		}
+	}
+	tableDecode = Sys_Milliseconds() - start;
+
+#define	HUFFBENCH_MBS(msec)	( (float)numSymbols * passes / ( 1024.0f * 1024.0f ) / ( ( (msec) ? (msec) : 1 ) / 1000.0f ) )
+	Com_Printf( "%i symbols, %i bytes encoded, %i passes\n", numSymbols, encodedSize, passes );
+	Com_Printf( "encode: tree %5i msec %7.2f MB/s, table %5i msec %7.2f MB/s\n",
+		treeEncode, HUFFBENCH_MBS(treeEncode), tableEncode, HUFFBENCH_MBS(tableEncode) );
+	Com_Printf( "decode: tree %5i msec %7.2f MB/s, table %5i msec %7.2f MB/s\n",
+		treeDecode, HUFFBENCH_MBS(treeDecode), tableDecode, HUFFBENCH_MBS(tableDecode) );
+#undef HUFFBENCH_MBS
+
+	Z_Free( tableBuf );
+	Z_Free( treeBuf );
+	Z_Free( symbols );
+}
+
 //===========================================================================
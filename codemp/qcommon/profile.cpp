@@ -0,0 +1,281 @@
+// profile.cpp -- named timing zones dumped as chrome trace events
+
+//Anything above this #include will be ignored by the compiler
+#include "../qcommon/exe_headers.h"
+
+/*
+=============================================================================
+
+PROFILE ZONES
+
+PROFILE_ZONE( "name" ) times the rest of its scope.  While com_profileZones
+is 0 a zone costs a test of com_profileZonesActive; while it is set every
+zone is written to a ring of events owned by the thread that ran it, so
+recording never locks.  A ring is allocated the first time its thread
+records a zone, with malloc since job and snapshot threads can't use the
+zone allocator, and kept until shutdown.
+
+profiledump reads the rings from the main thread while the other threads
+keep writing, and drops whatever they overwrote during the copy.
+
+Zone names must be string literals, the events only keep the pointer.
+
+=============================================================================
+*/
+
+#define MAX_PROFILE_RINGS		32
+#define PROFILE_RING_SIZE		65536	// events per thread, must be a power of two
+#define PROFILE_RING_MASK		( PROFILE_RING_SIZE - 1 )
+
+typedef struct {
+	const char		*name;
+	sysTicks_t		start;
+	unsigned int	duration;			// in ticks
+} profileEvent_t;
+
+typedef struct {
+	volatile int	head;				// events ever written, only the owner writes
+	qboolean		mainThread;
+	profileEvent_t	events[PROFILE_RING_SIZE];
+} profileRing_t;
+
+typedef struct {
+	profileRing_t * volatile	rings[MAX_PROFILE_RINGS];
+	volatile int	numRings;
+} profile_t;
+
+static profile_t	profile;
+
+static THREADLOCAL profileRing_t	*profThreadRing;
+static THREADLOCAL qboolean			profNoRing;
+static THREADLOCAL qboolean			profMainThread;
+
+cvar_t	*com_profileZones;
+int		com_profileZonesActive;
+
+/*
+=======================
+Prof_NewRing
+=======================
+*/
+static profileRing_t *Prof_NewRing( void ) {
+	profileRing_t	*ring;
+	int				slot;
+
+	slot = Sys_AtomicAdd( &profile.numRings, 1 ) - 1;
+	if ( slot >= MAX_PROFILE_RINGS ) {
+		profNoRing = qtrue;
+		return NULL;
+	}
+
+	ring = (profileRing_t *)malloc( sizeof( *ring ) );
+	if ( !ring ) {
+		profNoRing = qtrue;
+		return NULL;
+	}
+	ring->head = 0;
+	ring->mainThread = profMainThread;
+
+	profile.rings[slot] = ring;
+	profThreadRing = ring;
+	return ring;
+}
+
+/*
+=======================
+Prof_Record
+
+Called by profileZone_c when a zone is left
+=======================
+*/
+void Prof_Record( const char *name, sysTicks_t start ) {
+	profileRing_t	*ring;
+	profileEvent_t	*event;
+	sysTicks_t		end;
+
+	end = Sys_Ticks();
+
+	ring = profThreadRing;
+	if ( !ring ) {
+		if ( profNoRing ) {
+			return;
+		}
+		ring = Prof_NewRing();
+		if ( !ring ) {
+			return;
+		}
+	}
+
+	event = &ring->events[ring->head & PROFILE_RING_MASK];
+	event->name = name;
+	event->start = start;
+	event->duration = (unsigned int)( end - start );
+	// publishes the event to profiledump
+	Sys_AtomicAdd( &ring->head, 1 );
+}
+
+/*
+=======================
+Prof_CopyRing
+
+Copies the events of a ring that are still intact after the copy,
+returns how many there are
+=======================
+*/
+static int Prof_CopyRing( profileRing_t *ring, profileEvent_t *out ) {
+	unsigned int	head, newHead, first, count, i;
+
+	head = (unsigned int)Sys_AtomicAdd( &ring->head, 0 );
+	count = head < PROFILE_RING_SIZE ? head : PROFILE_RING_SIZE;
+	first = head - count;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		out[i] = ring->events[( first + i ) & PROFILE_RING_MASK];
+	}
+
+	// anything the owner wrapped around to during the copy is torn, and
+	// so is the slot at newHead, which it may be writing but hasn't published
+	newHead = (unsigned int)Sys_AtomicAdd( &ring->head, 0 );
+	if ( newHead - first >= PROFILE_RING_SIZE ) {
+		i = newHead - first - PROFILE_RING_SIZE + 1;
+		if ( i >= count ) {
+			return 0;
+		}
+		memmove( out, out + i, ( count - i ) * sizeof( *out ) );
+		count -= i;
+	}
+	return count;
+}
+
+/*
+=======================
+Prof_Dump_f
+
+profiledump [seconds] [file]
+
+Writes the zones that ended in the last seconds as chrome trace event
+JSON, for chrome://tracing or any viewer of that format
+=======================
+*/
+static void Prof_Dump_f( void ) {
+	profileEvent_t	*events;
+	profileRing_t	*ring;
+	fileHandle_t	f;
+	const char		*filename;
+	sysTicks_t		now, cutoff, ticksPerSecond;
+	double			usec;
+	float			seconds;
+	int				numRings, slot, count, i, written;
+	qboolean		first;
+
+	seconds = Cmd_Argc() > 1 ? atof( Cmd_Argv( 1 ) ) : 5;
+	filename = Cmd_Argc() > 2 ? Cmd_Argv( 2 ) : "profile.json";
+	if ( seconds <= 0 ) {
+		Com_Printf( "usage: profiledump [seconds] [file]\n" );
+		return;
+	}
+
+	numRings = profile.numRings;
+	if ( numRings > MAX_PROFILE_RINGS ) {
+		numRings = MAX_PROFILE_RINGS;
+	}
+	if ( !numRings ) {
+		Com_Printf( "no zones recorded, set com_profileZones 1\n" );
+		return;
+	}
+
+	f = FS_FOpenFileWrite( filename );
+	if ( !f ) {
+		Com_Printf( "couldn't open %s\n", filename );
+		return;
+	}
+
+	ticksPerSecond = Sys_TicksPerSecond();
+	usec = 1000000.0 / (double)ticksPerSecond;
+	now = Sys_Ticks();
+	// the monotonic clocks can start near zero at boot
+	if ( seconds * (double)ticksPerSecond >= (double)now ) {
+		cutoff = 0;
+	} else {
+		cutoff = now - (sysTicks_t)( seconds * (double)ticksPerSecond );
+	}
+
+	events = (profileEvent_t *)Z_Malloc( PROFILE_RING_SIZE * sizeof( *events ), TAG_TEMP_WORKSPACE, qfalse );
+
+	FS_Printf( f, "{\"traceEvents\":[\n" );
+	first = qtrue;
+	written = 0;
+	for ( slot = 0 ; slot < numRings ; slot++ ) {
+		ring = profile.rings[slot];
+		if ( !ring ) {
+			continue;
+		}
+
+		FS_Printf( f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+			first ? "" : ",\n", slot, ring->mainThread ? "main" : va( "thread %i", slot ) );
+		first = qfalse;
+
+		count = Prof_CopyRing( ring, events );
+		for ( i = 0 ; i < count ; i++ ) {
+			if ( events[i].start + events[i].duration < cutoff ) {
+				continue;
+			}
+			FS_Printf( f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+				events[i].name, slot,
+				( (double)events[i].start - (double)cutoff ) * usec,
+				(double)events[i].duration * usec );
+			written++;
+		}
+	}
+	FS_Printf( f, "\n]}\n" );
+	FS_FCloseFile( f );
+
+	Z_Free( events );
+
+	Com_Printf( "wrote %i zones from %i threads to %s\n", written, numRings, filename );
+}
+
+/*
+=======================
+Prof_Frame
+
+Called at the start of every frame
+=======================
+*/
+void Prof_Frame( void ) {
+	com_profileZonesActive = com_profileZones->integer;
+}
+
+/*
+=======================
+Prof_Init
+=======================
+*/
+void Prof_Init( void ) {
+	com_profileZones = Cvar_Get( "com_profileZones", "0", 0 );
+	com_profileZonesActive = com_profileZones->integer;
+	profMainThread = qtrue;
+	Cmd_AddCommand( "profiledump", Prof_Dump_f );
+}
+
+/*
+=======================
+Prof_Shutdown
+
+Call once no other thread can record zones
+=======================
+*/
+void Prof_Shutdown( void ) {
+	int		i;
+
+	com_profileZonesActive = 0;
+	for ( i = 0 ; i < MAX_PROFILE_RINGS ; i++ ) {
+		if ( profile.rings[i] ) {
+			free( profile.rings[i] );
+		}
+	}
+	Com_Memset( &profile, 0, sizeof( profile ) );
+	profThreadRing = NULL;
+	profNoRing = qfalse;
+	Cmd_RemoveCommand( "profiledump" );
+}
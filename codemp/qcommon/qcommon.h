@@ -75,6 +75,13 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 void MSG_ReadDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, 
 						 int number );
 
+typedef struct entityDeltaCache_s entityDeltaCache_t;
+entityDeltaCache_t *MSG_AllocEntityDeltaCache( void );
+void MSG_FreeEntityDeltaCache( entityDeltaCache_t *cache );
+void MSG_ClearEntityDeltaCache( entityDeltaCache_t *cache );
+void MSG_WriteDeltaEntityCached( msg_t *msg, struct entityState_s *from, struct entityState_s *to, 
+						   qboolean force, entityDeltaCache_t *cache );
+
 #ifdef _ONEBIT_COMBO
 void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct playerState_s *to, int *bitComboDelta, int *bitNumDelta, qboolean isVehiclePS = qfalse );
 #else
@@ -84,6 +91,7 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct pl
 
 
 void MSG_ReportChangeVectors_f( void );
+void MSG_HuffBench_f( void );
 
 //============================================================================
 
@@ -145,6 +153,8 @@ const char	*NET_AdrToString (netadr_t a);
 qboolean	NET_StringToAdr ( const char *s, netadr_t *a);
 qboolean	NET_GetLoopPacket (netsrc_t sock, netadr_t *net_from, msg_t *net_message);
 void		NET_Sleep(int msec);
+void		NET_BeginPacketBatch( void );
+void		NET_FlushPacketBatch( void );
 
 
 #define	MAX_MSGLEN				49152		// max length of a message, which may
@@ -318,6 +328,8 @@ void	VM_Shifted_Free(void **ptr);
 void	*VM_ArgPtr( int intValue );
 void	*VM_ExplicitArgPtr( vm_t *vm, int intValue );
 
+void	VM_ProfileFrame( void );
+
 /*
 ==============================================================
 
@@ -574,9 +586,22 @@ void	FS_ForceFlush( fileHandle_t f );
 void	FS_FreeFile( void *buffer );
 // frees the memory returned by FS_ReadFile
 
+void	FS_PrefetchFile( const char *qpath );
+// queues a pk3 entry to be read and inflated in the background so a
+// later FS_ReadFile of it doesn't block on the archive
+
+void	FS_PrefetchFlush( void );
+// drops anything prefetched that wasn't read, call at the end of a level load
+
+int		FS_PeekPrefetched( const char *qpath, const void **buffer );
+// waits for a queued file and returns its data without taking it, or -1
+
 void	FS_WriteFile( const char *qpath, const void *buffer, int size );
 // writes a complete file, creating any subdirectories needed
 
+char	*FS_BuildOSPath( const char *base, const char *game, const char *qpath );
+// where a qpath under base lives on disk, an empty game means the current one
+
 int		FS_filelength( fileHandle_t f );
 // doesn't work for files that are opened from a pack file
 
@@ -668,6 +693,16 @@ void 		QDECL Com_Printf( const char *fmt, ... );
 void 		QDECL Com_DPrintf( const char *fmt, ... );
 void		QDECL Com_OPrintf( const char *fmt, ...); // Outputs to the VC / Windows Debug window (only in debug compile)
 void 		QDECL Com_Error( int code, const char *fmt, ... );
+
+// Com_Error can't shut anything down from a worker thread, so a worker
+// sets a trap first: the error is recorded in it and thrown back to the
+// worker's own catch, for the thread that started the work to raise again
+typedef struct {
+	int			code;		// 0 if nothing went wrong
+	char		message[MAX_STRING_CHARS];
+} errorTrap_t;
+
+void		Com_SetErrorTrap( errorTrap_t *trap );	// for the calling thread only, NULL to clear
 void 		Com_Quit_f( void );
 int			Com_EventLoop( void );
 int			Com_Milliseconds( void );	// will be journaled properly
@@ -700,6 +735,7 @@ extern	cvar_t	*com_journal;
 extern	cvar_t	*com_cameraMode;
 
 extern	cvar_t	*com_optvehtrace;
+extern	cvar_t	*com_g2CollisionCache;
 
 #ifdef G2_PERFORMANCE_ANALYSIS
 extern	cvar_t	*com_G2Report;
@@ -824,6 +860,37 @@ CGenericParser2 *Com_ParseTextFile(const char *file, bool cleanFirst, bool write
 void Com_ParseTextFileDestroy(class CGenericParser2 &parser);
 
 
+/*
+==============================================================
+
+JOBS
+
+==============================================================
+*/
+
+// a counter is raised by every job added with it and lowered when the
+// job has run, Job_Wait runs jobs until it is back to zero
+typedef struct {
+	volatile int	pending;
+} jobCounter_t;
+
+typedef void (*jobFunc_t)( void *data );
+typedef void (*jobRangeFunc_t)( void *data, int first, int last );
+
+extern	cvar_t	*com_jobThreads;
+
+void	Job_Init( void );
+void	Job_Shutdown( void );
+// jobs must not call Com_Error, Com_Printf or Z_Malloc, counter may be NULL
+void	Job_Add( jobFunc_t function, void *data, jobCounter_t *counter );
+void	Job_AddRange( jobRangeFunc_t function, void *data, int first, int last, jobCounter_t *counter );
+void	Job_Wait( jobCounter_t *counter );
+// runs function over [0, count) split into batches, batch 0 picks a size
+void	Job_ParallelFor( jobRangeFunc_t function, void *data, int count, int batch );
+int		Job_NumThreads( void );
+
+
+
 /*
 ==============================================================
 
@@ -977,6 +1044,15 @@ void	Sys_Log( const char *file, const void *buffer, int size, bool flush );
 // any game related timing information should come from event timestamps
 int		Sys_Milliseconds (bool baseTime = false);
 
+// a fine grained counter for profilers, only differences are meaningful
+#ifdef _MSC_VER
+typedef unsigned __int64	sysTicks_t;
+#else
+typedef unsigned long long	sysTicks_t;
+#endif
+sysTicks_t	Sys_Ticks( void );
+sysTicks_t	Sys_TicksPerSecond( void );
+
 #if __linux__
 extern "C" void	Sys_SnapVector( float *v );
 
@@ -1035,6 +1111,70 @@ int Sys_FunctionCheckSum(void *f1);
 qboolean Sys_LowPhysicalMemory();
 unsigned int Sys_ProcessorCount();
 
+// threads for spreading independent work across processors,
+// handles are opaque and returned as NULL on failure
+typedef void (*threadFunc_t)( void *data );
+void	*Sys_CreateThread( threadFunc_t function, void *data );
+void	Sys_JoinThread( void *thread );
+void	*Sys_CreateSemaphore( int initialCount );
+void	Sys_DestroySemaphore( void *semaphore );
+void	Sys_SemaphoreWait( void *semaphore );
+void	Sys_SemaphorePost( void *semaphore );
+int		Sys_AtomicAdd( volatile int *value, int add );	// returns the new value
+int		Sys_AtomicCompareExchange( volatile int *value, int exchange, int comparand );	// returns the old value
+
+// a separate copy of the variable for every thread
+#ifdef _MSC_VER
+#define THREADLOCAL		__declspec( thread )
+#else
+#define THREADLOCAL		__thread
+#endif
+
+// read-only view of a whole file, NULL if it can't be mapped
+void	*Sys_MapFile( const char *osPath, int *length );
+void	Sys_UnmapFile( void *base, int length );
+
+/*
+==============================================================
+
+PROFILE ZONES
+
+==============================================================
+*/
+
+extern	cvar_t	*com_profileZones;
+extern	int		com_profileZonesActive;
+
+void	Prof_Init( void );
+void	Prof_Shutdown( void );
+void	Prof_Frame( void );
+void	Prof_Record( const char *name, sysTicks_t start );
+
+// times the rest of the scope it's declared in, name must be a literal
+class profileZone_c
+{
+private:
+	const char	*name;
+	sysTicks_t	start;
+public:
+	profileZone_c( const char *zoneName )
+	{
+		name = NULL;
+		if ( com_profileZonesActive ) {
+			name = zoneName;
+			start = Sys_Ticks();
+		}
+	}
+	~profileZone_c()
+	{
+		if ( name ) {
+			Prof_Record( name, start );
+		}
+	}
+};
+
+#define PROFILE_ZONE( name )	profileZone_c profileZone( name )
+
 int Sys_MonkeyShouldBeSpanked( void );
 
 /* This is based on the Adaptive Huffman algorithm described in Sayood's Data
@@ -1073,6 +1213,29 @@ typedef struct {
 	huff_t		decompressor;
 } huffman_t;
 
+#ifdef _MSC_VER
+typedef unsigned __int64	huffBits_t;
+#else
+typedef unsigned long long	huffBits_t;
+#endif
+
+#define	HUFF_TABLE_MAXCODE		32			// longer codes make the whole table invalid
+#define	HUFF_TABLE_PEEKBITS		11			// bits decoded with one lookup
+#define	HUFF_TABLE_PEEKSIZE		(1<<HUFF_TABLE_PEEKBITS)
+
+// lookup tables for a tree that will never be updated again, codes
+// are stored with the first transmitted bit in the lowest bit
+typedef struct {
+	qboolean		valid;
+
+	unsigned int	encodeBits[HMAX];
+	byte			encodeLength[HMAX];
+
+	short			decodeSymbol[HUFF_TABLE_PEEKSIZE];	// -1 if the code is longer than the peek
+	byte			decodeLength[HUFF_TABLE_PEEKSIZE];
+	node_t			*decodeNode[HUFF_TABLE_PEEKSIZE];	// where the tree walk continues for long codes
+} huffTable_t;
+
 void	Huff_Compress(msg_t *buf, int offset);
 void	Huff_Decompress(msg_t *buf, int offset);
 void	Huff_Init(huffman_t *huff);
@@ -1083,6 +1246,8 @@ void	Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset);
 void	Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset);
 void	Huff_putBit( int bit, byte *fout, int *offset);
 int		Huff_getBit( byte *fout, int *offset);
+void	Huff_BuildTable( huffTable_t *table, const huff_t *huff );
+void	Huff_tableReceive( const huffTable_t *table, int *ch, const byte *fin, int *offset );
 
 extern huffman_t clientHuffTables;
 
@@ -30,6 +30,42 @@ vm_t	vmTable[MAX_VM];
 
 void VM_VmInfo_f( void );
 void VM_VmProfile_f( void );
+void VM_CallProfile_f( void );
+void VM_Compare_f( void );
+
+/*
+VM_Call and system call timing, for dlls as well as qvms.  Entry points
+also track how much of their time was spent back in the engine, which
+gives the module's own share of it.
+*/
+#define	VM_PROFILE_SYSCALLS	1024		// higher numbers share the last counter
+#define	VM_PROFILE_CALLS	64
+
+typedef struct {
+	int			count;
+	sysTicks_t	ticks;
+	sysTicks_t	syscallTicks;		// entry points only
+	// totals at the last csv row
+	int			dumpedCount;
+	sysTicks_t	dumpedTicks;
+	sysTicks_t	dumpedSyscallTicks;
+} vmProfileCounter_t;
+
+typedef struct {
+	char				name[MAX_QPATH];
+	int					syscallDepth;	// a system call can VM_Call back in
+	sysTicks_t			syscallTicks;	// outermost system calls only
+	vmProfileCounter_t	syscalls[VM_PROFILE_SYSCALLS];
+	vmProfileCounter_t	calls[VM_PROFILE_CALLS];
+} vmProfile_t;
+
+// kept apart from vmTable so the totals survive map changes
+static vmProfile_t	vmProfiles[MAX_VM];
+
+cvar_t	*vm_profile;
+cvar_t	*vm_profileDump;
+
+static int VM_ProfileSystemCall( int *args );
 
 
 // converts a VM pointer to a C pointer and
@@ -54,8 +90,13 @@ void VM_Init( void ) {
 	//client wants to know if the server is using vm's for certain modules,
 	//so if pure we can force the same method (be it vm or dll) -rww
 
+	vm_profile = Cvar_Get( "vm_profile", "1", 0 );
+	vm_profileDump = Cvar_Get( "vm_profileDump", "0", 0 );	// seconds between vmprofile.csv rows
+
 	Cmd_AddCommand ("vmprofile", VM_VmProfile_f );
+	Cmd_AddCommand ("vmcallprofile", VM_CallProfile_f );
 	Cmd_AddCommand ("vminfo", VM_VmInfo_f );
+	Cmd_AddCommand ("vm_compare", VM_Compare_f );
 
 	Com_Memset( vmTable, 0, sizeof( vmTable ) );
 }
@@ -400,7 +441,7 @@ vm_t *VM_Restart( vm_t *vm ) {
 		char	name[MAX_QPATH];
 	    int			(*systemCall)( int *parms );
 		
-		systemCall = vm->systemCall;	
+		systemCall = vm->moduleSystemCall;	
 		Q_strncpyz( name, vm->name, sizeof( name ) );
 
 		VM_Free( vm );
@@ -466,8 +507,6 @@ it will attempt to load as a system dll
 ================
 */
 
-#define	STACK_SIZE	0x20000
-
 vm_t *VM_Create( const char *module, int (*systemCalls)(int *), 
 				vmInterpret_t interpret ) {
 	vm_t		*vm;
@@ -503,7 +542,15 @@ vm_t *VM_Create( const char *module, int (*systemCalls)(int *),
 	vm = &vmTable[i];
 
 	Q_strncpyz( vm->name, module, sizeof( vm->name ) );
-	vm->systemCall = systemCalls;
+	vm->systemCall = VM_ProfileSystemCall;
+	vm->moduleSystemCall = systemCalls;
+
+	if ( Q_stricmp( vmProfiles[i].name, module ) ) {
+		Com_Memset( &vmProfiles[i], 0, sizeof( vmProfiles[i] ) );
+		Q_strncpyz( vmProfiles[i].name, module, sizeof( vmProfiles[i].name ) );
+	}
+	// an error out of a system call never came back down
+	vmProfiles[i].syscallDepth = 0;
 
 	// never allow dll loading with a demo
 	if ( interpret == VMI_NATIVE ) {
@@ -608,6 +655,9 @@ void VM_Free( vm_t *vm ) {
 		Sys_UnloadDll( vm->dllHandle );
 		Com_Memset( vm, 0, sizeof( *vm ) );
 	}
+	if ( vm->compiled ) {
+		VM_FreeCompiled( vm );
+	}
 #if 0	// now automatically freed by hunk
 	if ( vm->codeBase ) {
 		Z_Free( vm->codeBase );
@@ -631,6 +681,9 @@ void VM_Clear(void) {
 		if ( vmTable[i].dllHandle ) {
 			Sys_UnloadDll( vmTable[i].dllHandle );
 		}
+		if ( vmTable[i].compiled ) {
+			VM_FreeCompiled( &vmTable[i] );
+		}
 		Com_Memset( &vmTable[i], 0, sizeof( vm_t ) );
 	}
 	currentVM = NULL;
@@ -713,7 +766,7 @@ void VM_Shifted_Alloc(void **ptr, int size)
 
 	//Alright, subtract the database from the memory pointer to get a memory address relative to the VM.
 	//When the VM modifies it it should be modifying the same chunk of memory we have allocated in the engine.
-	*ptr = (void *)((int)mem - (int)currentVM->dataBase);
+	*ptr = (void *)((byte *)mem - currentVM->dataBase);
 }
 
 void VM_Shifted_Free(void **ptr)
@@ -727,7 +780,7 @@ void VM_Shifted_Free(void **ptr)
 	}
 
 	//Shift the VM memory pointer back to get the same pointer we initially allocated in real memory space.
-	mem = (void *)((int)currentVM->dataBase + (int)*ptr);
+	mem = (void *)(currentVM->dataBase + ((byte *)*ptr - (byte *)0));
 
 	if (!mem)
 	{
@@ -788,9 +841,12 @@ int	QDECL VM_Call( vm_t *vm, int callnum, ... ) {
 	vm_t	*oldVM;
 	int		r;
 	int i;
-	int args[16];
+	int args[17];
 	va_list ap;
+	vmProfile_t	*profile;
+	sysTicks_t	start, syscallStart;
 
+	PROFILE_ZONE( "VM_Call" );
 
 	if ( !vm ) {
 		Com_Error( ERR_FATAL, "VM_Call with NULL vm" );
@@ -804,23 +860,42 @@ int	QDECL VM_Call( vm_t *vm, int callnum, ... ) {
 	  Com_Printf( "VM_Call( %i )\n", callnum );
 	}
 
+	//rcg010207 -  see dissertation at top of VM_DllSyscall() in this file.
+	// the qvm paths want callnum and the args as one array too, which
+	// &callnum only happens to be on 32 bit x86
+	args[0] = callnum;
+	va_start(ap, callnum);
+	for (i = 1; i < sizeof (args) / sizeof (args[i]); i++) {
+		args[i] = va_arg(ap, int);
+	}
+	va_end(ap);
+
+	profile = NULL;
+	start = syscallStart = 0;
+	if ( vm_profile->integer && (unsigned)callnum < VM_PROFILE_CALLS && vm >= vmTable && vm < vmTable + MAX_VM ) {
+		profile = &vmProfiles[ vm - vmTable ];
+		syscallStart = profile->syscallTicks;
+		start = Sys_Ticks();
+	}
+
 	// if we have a dll loaded, call it directly
 	if ( vm->entryPoint ) {
-		//rcg010207 -  see dissertation at top of VM_DllSyscall() in this file.
-		va_start(ap, callnum);
-		for (i = 0; i < sizeof (args) / sizeof (args[i]); i++) {
-			args[i] = va_arg(ap, int);
-		}
-		va_end(ap);
-
-		r = vm->entryPoint( callnum,  args[0],  args[1],  args[2], args[3],
-                            args[4],  args[5],  args[6], args[7],
-                            args[8],  args[9], args[10], args[11],
-                            args[12], args[13], args[14], args[15]);
+		r = vm->entryPoint( args[0],  args[1],  args[2],  args[3], args[4],
+                            args[5],  args[6],  args[7], args[8],
+                            args[9],  args[10], args[11], args[12],
+                            args[13], args[14], args[15], args[16]);
 	} else if ( vm->compiled ) {
-		r = VM_CallCompiled( vm, &callnum );
+		r = VM_CallCompiled( vm, args );
 	} else {
-		r = VM_CallInterpreted( vm, &callnum );
+		r = VM_CallInterpreted( vm, args );
+	}
+
+	if ( profile ) {
+		vmProfileCounter_t	*counter = &profile->calls[callnum];
+
+		counter->count++;
+		counter->ticks += Sys_Ticks() - start;
+		counter->syscallTicks += profile->syscallTicks - syscallStart;
 	}
 
 	if ( oldVM != NULL ) // bk001220 - assert(currentVM!=NULL) for oldVM==NULL
@@ -924,6 +999,234 @@ void VM_VmInfo_f( void ) {
 	}
 }
 
+/*
+==============================================================================
+
+CALL PROFILING
+
+==============================================================================
+*/
+
+/*
+============
+VM_ProfileSystemCall
+
+Every module's systemCall, times the real one
+============
+*/
+static int VM_ProfileSystemCall( int *args ) {
+	vm_t				*vm;
+	vmProfile_t			*profile;
+	vmProfileCounter_t	*counter;
+	sysTicks_t			ticks;
+	int					r;
+
+	vm = currentVM;
+	if ( !vm_profile->integer ) {
+		return vm->moduleSystemCall( args );
+	}
+
+	profile = &vmProfiles[ vm - vmTable ];
+	if ( (unsigned)args[0] < VM_PROFILE_SYSCALLS ) {
+		counter = &profile->syscalls[ args[0] ];
+	} else {
+		counter = &profile->syscalls[ VM_PROFILE_SYSCALLS - 1 ];
+	}
+
+	profile->syscallDepth++;
+	ticks = Sys_Ticks();
+	r = vm->moduleSystemCall( args );
+	ticks = Sys_Ticks() - ticks;
+	profile->syscallDepth--;
+
+	if ( !profile->syscallDepth ) {
+		profile->syscallTicks += ticks;
+	}
+	counter->count++;
+	counter->ticks += ticks;
+
+	return r;
+}
+
+static double VM_TicksToMsec( sysTicks_t ticks ) {
+	return (double)ticks * 1000.0 / (double)Sys_TicksPerSecond();
+}
+
+static const vmProfileCounter_t	*vmProfileSortTable;
+
+static int QDECL VM_CallProfileSort( const void *a, const void *b ) {
+	sysTicks_t	ta, tb;
+
+	ta = vmProfileSortTable[ *(const int *)a ].ticks;
+	tb = vmProfileSortTable[ *(const int *)b ].ticks;
+	if ( ta > tb ) {
+		return -1;
+	}
+	if ( ta < tb ) {
+		return 1;
+	}
+	return 0;
+}
+
+// indexes of the used counters, most time first
+static int VM_SortCounters( const vmProfileCounter_t *counters, int numCounters, int *sorted ) {
+	int		i, count;
+
+	count = 0;
+	for ( i = 0 ; i < numCounters ; i++ ) {
+		if ( counters[i].count ) {
+			sorted[count++] = i;
+		}
+	}
+	vmProfileSortTable = counters;
+	qsort( sorted, count, sizeof( *sorted ), VM_CallProfileSort );
+	return count;
+}
+
+/*
+==============
+VM_CallProfile_f
+
+vmcallprofile [all|reset]
+Entry point and system call numbers are the module's *_public.h enums
+==============
+*/
+void VM_CallProfile_f( void ) {
+	vmProfile_t			*profile;
+	vmProfileCounter_t	*c;
+	int					sorted[VM_PROFILE_SYSCALLS];
+	int					i, j, count, max;
+	double				msec, self, total;
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		for ( i = 0 ; i < MAX_VM ; i++ ) {
+			Com_Memset( vmProfiles[i].syscalls, 0, sizeof( vmProfiles[i].syscalls ) );
+			Com_Memset( vmProfiles[i].calls, 0, sizeof( vmProfiles[i].calls ) );
+			vmProfiles[i].syscallTicks = 0;
+		}
+		return;
+	}
+	max = Q_stricmp( Cmd_Argv( 1 ), "all" ) ? 20 : VM_PROFILE_SYSCALLS;
+
+	if ( !vm_profile->integer ) {
+		Com_Printf( "vm_profile is off\n" );
+	}
+
+	for ( i = 0 ; i < MAX_VM ; i++ ) {
+		profile = &vmProfiles[i];
+		if ( !profile->name[0] ) {
+			continue;
+		}
+		Com_Printf( "%s:\n", profile->name );
+
+		count = VM_SortCounters( profile->calls, VM_PROFILE_CALLS, sorted );
+		for ( j = 0 ; j < count ; j++ ) {
+			c = &profile->calls[ sorted[j] ];
+			msec = VM_TicksToMsec( c->ticks );
+			self = msec - VM_TicksToMsec( c->syscallTicks );
+			Com_Printf( "  call    %4i %9i %10.2fms %10.2fms self %8.2fus each\n",
+				sorted[j], c->count, msec, self, msec * 1000.0 / c->count );
+		}
+
+		total = VM_TicksToMsec( profile->syscallTicks );
+		count = VM_SortCounters( profile->syscalls, VM_PROFILE_SYSCALLS, sorted );
+		for ( j = 0 ; j < count && j < max ; j++ ) {
+			c = &profile->syscalls[ sorted[j] ];
+			msec = VM_TicksToMsec( c->ticks );
+			Com_Printf( "  syscall %4i %9i %10.2fms %3i%% %8.2fus each\n",
+				sorted[j], c->count, msec, total > 0 ? (int)( 100 * msec / total ) : 0, msec * 1000.0 / c->count );
+		}
+		if ( count > max ) {
+			Com_Printf( "  %i more system calls\n", count - max );
+		}
+		Com_Printf( "  %.2fms in system calls\n", total );
+	}
+}
+
+static void VM_MarkCounters( vmProfileCounter_t *counters, int numCounters ) {
+	int		i;
+
+	for ( i = 0 ; i < numCounters ; i++ ) {
+		counters[i].dumpedCount = counters[i].count;
+		counters[i].dumpedTicks = counters[i].ticks;
+		counters[i].dumpedSyscallTicks = counters[i].syscallTicks;
+	}
+}
+
+static void VM_DumpCounters( fileHandle_t f, int time, const char *name, const char *kind, vmProfileCounter_t *counters, int numCounters ) {
+	vmProfileCounter_t	*c;
+	int					i;
+
+	for ( i = 0 ; i < numCounters ; i++ ) {
+		c = &counters[i];
+		if ( c->count == c->dumpedCount ) {
+			continue;
+		}
+		FS_Printf( f, "%i,%s,%s,%i,%i,%.3f,%.3f\n", time, name, kind, i, c->count - c->dumpedCount,
+			VM_TicksToMsec( c->ticks - c->dumpedTicks ), VM_TicksToMsec( c->syscallTicks - c->dumpedSyscallTicks ) );
+		c->dumpedCount = c->count;
+		c->dumpedTicks = c->ticks;
+		c->dumpedSyscallTicks = c->syscallTicks;
+	}
+}
+
+/*
+==============
+VM_ProfileFrame
+
+Appends a row per counter that moved to vmprofile.csv every
+vm_profileDump seconds
+==============
+*/
+void VM_ProfileFrame( void ) {
+	static fileHandle_t	f;
+	static int			lastDump;
+	int					time, i;
+
+	if ( vm_profileDump->integer <= 0 || !vm_profile->integer ) {
+		if ( f ) {
+			FS_FCloseFile( f );
+			f = 0;
+		}
+		return;
+	}
+
+	time = Sys_Milliseconds();
+	if ( f && time - lastDump < vm_profileDump->integer * 1000 ) {
+		return;
+	}
+
+	if ( !f ) {
+		if ( !FS_Initialized() ) {
+			return;
+		}
+		f = FS_FOpenFileWrite( "vmprofile.csv" );
+		if ( !f ) {
+			Com_Printf( "Couldn't open vmprofile.csv\n" );
+			Cvar_Set( "vm_profileDump", "0" );
+			return;
+		}
+		FS_Printf( f, "time,vm,kind,num,count,msec,syscallmsec\n" );
+		// rows are per interval, start the first one now
+		for ( i = 0 ; i < MAX_VM ; i++ ) {
+			VM_MarkCounters( vmProfiles[i].calls, VM_PROFILE_CALLS );
+			VM_MarkCounters( vmProfiles[i].syscalls, VM_PROFILE_SYSCALLS );
+		}
+		lastDump = time;
+		return;
+	}
+	lastDump = time;
+
+	for ( i = 0 ; i < MAX_VM ; i++ ) {
+		if ( !vmProfiles[i].name[0] ) {
+			continue;
+		}
+		VM_DumpCounters( f, time, vmProfiles[i].name, "call", vmProfiles[i].calls, VM_PROFILE_CALLS );
+		VM_DumpCounters( f, time, vmProfiles[i].name, "syscall", vmProfiles[i].syscalls, VM_PROFILE_SYSCALLS );
+	}
+	FS_Flush( f );
+}
+
 /*
 ===============
 VM_LogSyscalls
@@ -951,4 +1254,6 @@ int	VM_CallCompiled( vm_t *vm, int *args ) {
 }
 
 void VM_Compile( vm_t *vm, vmHeader_t *header ) {}
+
+void VM_FreeCompiled( vm_t *vm ) {}
 #endif // DLL_ONLY
@@ -0,0 +1,730 @@
+// vm_compare.c -- differential check of the vm compiler against the interpreter
+//Anything above this #include will be ignored by the compiler
+#include "../qcommon/exe_headers.h"
+
+#include "vm_local.h"
+
+/*
+
+vm_compare [programs] [seed]
+
+Generates random bytecode programs that use every opcode, loads each
+one twice, interpreted and through VM_Compile, calls both with the same
+arguments and compares the return values, the data segments, the system
+calls made and the break counts.  A mismatch prints the seed of the
+program, so "vm_compare 1 <seed>" reproduces it.
+
+A program is vmMain followed by one helper function.  Both use a
+VMC_FRAME byte frame: outgoing call args at +8, locals at +VMC_LOCALS,
+and their own args above the frame.
+
+*/
+
+#define	VMC_MAX_CODE		0x20000
+#define	VMC_SLOTS			64						// ints of initialised data
+#define	VMC_SCRATCH			( VMC_SLOTS * 4 )		// first bss int
+#define	VMC_IMAGE_SIZE		( STACK_SIZE * 2 )		// power of two, stack on top
+#define	VMC_FRAME			64
+#define	VMC_LOCALS			32						// 8 locals, the last two are loop counters
+#define	VMC_MAX_PATCHES		1024
+#define	VMC_MAX_SYSCALLS	256
+#define	VMC_CALLS			8						// calls per program
+#define	VMC_MAX_REPORTS		8
+
+typedef struct {
+	int		num;
+	int		args[3];
+	int		programStack;
+} vmcSyscall_t;
+
+static struct {
+	unsigned int	seed;
+
+	byte		code[VMC_MAX_CODE];
+	int			codeLength;
+	int			instructionCount;
+
+	qboolean	inHelper;
+	int			loopDepth;
+	int			helperPatches[VMC_MAX_PATCHES];
+	int			numHelperPatches;
+
+	// the system calls each side made
+	vmcSyscall_t	log[2][VMC_MAX_SYSCALLS];
+	int				logCount[2];
+	int				side;
+} vmc;
+
+// static so that whatever a Com_Error out of the middle of a run
+// leaves allocated is freed by the next vm_compare
+static vm_t		vmcVM[2];
+
+static const unsigned int vmcFloats[] = {
+	0x00000000,	// 0
+	0x80000000,	// -0
+	0x3f800000,	// 1
+	0xbfc00000,	// -1.5
+	0x3e800000,	// 0.25
+	0x4f32d05e,	// 3e9
+	0xcf32d05e,	// -3e9
+	0x1e3ce508,	// 1e-20
+	0x7149f2ca,	// 1e30
+	0x00000001,	// denormal
+	0x7f800000,	// inf
+	0xff800000,	// -inf
+	0x7fc00000	// nan
+};
+
+static unsigned int VMC_Rand( void ) {
+	vmc.seed = vmc.seed * 1103515245 + 12345;
+	return ( vmc.seed >> 8 ) & 0xffffff;
+}
+
+static int VMC_RandomInt( void ) {
+	switch ( VMC_Rand() & 7 ) {
+	case 0:
+		return 0;
+	case 1:
+		return 1;
+	case 2:
+		return -1;
+	case 3:
+		return 0x7fffffff;
+	case 4:
+		return (int)0x80000000;
+	case 5:
+		return (int)( VMC_Rand() & 255 ) - 128;
+	default:
+		return (int)( ( VMC_Rand() << 8 ) ^ VMC_Rand() );
+	}
+}
+
+static int VMC_RandomFloat( void ) {
+	union {
+		float	f;
+		int		i;
+	} v;
+
+	if ( VMC_Rand() & 1 ) {
+		return (int)vmcFloats[ VMC_Rand() % ( sizeof( vmcFloats ) / sizeof( vmcFloats[0] ) ) ];
+	}
+	v.f = ( (int)( VMC_Rand() % 2001 ) - 1000 ) / 8.0f;
+	return v.i;
+}
+
+/*
+==============================================================================
+
+PROGRAM GENERATION
+
+==============================================================================
+*/
+
+static void VMC_Put4( int ofs, int v ) {
+	vmc.code[ofs] = v & 255;
+	vmc.code[ofs+1] = ( v >> 8 ) & 255;
+	vmc.code[ofs+2] = ( v >> 16 ) & 255;
+	vmc.code[ofs+3] = ( v >> 24 ) & 255;
+}
+
+static void VMC_Emit( int op ) {
+	if ( vmc.codeLength + 5 > VMC_MAX_CODE ) {
+		Com_Error( ERR_DROP, "vm_compare: program too large" );
+	}
+	vmc.code[ vmc.codeLength++ ] = op;
+	vmc.instructionCount++;
+}
+
+static void VMC_Emit1( int op, int v ) {
+	VMC_Emit( op );
+	vmc.code[ vmc.codeLength++ ] = v;
+}
+
+static void VMC_Emit4( int op, int v ) {
+	VMC_Emit( op );
+	VMC_Put4( vmc.codeLength, v );
+	vmc.codeLength += 4;
+}
+
+// emits an op whose operand is an instruction number that isn't known yet
+static int VMC_EmitForward( int op ) {
+	VMC_Emit4( op, 0 );
+	return vmc.codeLength - 4;
+}
+
+// points a forward operand at the next instruction
+static void VMC_Label( int patch ) {
+	VMC_Put4( patch, vmc.instructionCount );
+}
+
+static void VMC_IntExpr( int depth, qboolean allowCalls );
+static void VMC_FloatExpr( int depth, qboolean allowCalls );
+static void VMC_Statement( int depth );
+
+static int VMC_Compare( int depth, qboolean allowCalls ) {
+	if ( VMC_Rand() & 1 ) {
+		VMC_IntExpr( depth, allowCalls );
+		VMC_IntExpr( depth, allowCalls );
+		return VMC_EmitForward( OP_EQ + VMC_Rand() % ( OP_GEU - OP_EQ + 1 ) );
+	}
+	VMC_FloatExpr( depth, allowCalls );
+	VMC_FloatExpr( depth, allowCalls );
+	return VMC_EmitForward( OP_EQF + VMC_Rand() % ( OP_GEF - OP_EQF + 1 ) );
+}
+
+static void VMC_IntLeaf( void ) {
+	switch ( VMC_Rand() % 5 ) {
+	case 0:
+		VMC_Emit4( OP_CONST, VMC_RandomInt() );
+		break;
+	case 1:		// one of our args
+		if ( vmc.inHelper ) {
+			VMC_Emit4( OP_LOCAL, VMC_FRAME + 8 + ( VMC_Rand() % 2 ) * 4 );
+		} else {
+			VMC_Emit4( OP_LOCAL, VMC_FRAME + 8 + ( VMC_Rand() % 10 ) * 4 );
+		}
+		VMC_Emit( OP_LOAD4 );
+		break;
+	case 2:
+		VMC_Emit4( OP_LOCAL, VMC_LOCALS + ( VMC_Rand() % 8 ) * 4 );
+		VMC_Emit( OP_LOAD4 );
+		break;
+	case 3:
+		VMC_Emit4( OP_CONST, ( VMC_Rand() % VMC_SLOTS ) * 4 );
+		VMC_Emit( OP_LOAD4 );
+		break;
+	default:
+		if ( VMC_Rand() & 1 ) {
+			VMC_Emit4( OP_CONST, ( VMC_Rand() % VMC_SLOTS ) * 4 + ( VMC_Rand() & 2 ) );
+			VMC_Emit( OP_LOAD2 );
+			if ( VMC_Rand() & 1 ) {
+				VMC_Emit( OP_SEX16 );
+			}
+		} else {
+			VMC_Emit4( OP_CONST, ( VMC_Rand() % VMC_SLOTS ) * 4 + ( VMC_Rand() & 3 ) );
+			VMC_Emit( OP_LOAD1 );
+			if ( VMC_Rand() & 1 ) {
+				VMC_Emit( OP_SEX8 );
+			}
+		}
+		break;
+	}
+}
+
+static void VMC_IntExpr( int depth, qboolean allowCalls ) {
+	static const int unary[] = { OP_NEGI, OP_BCOM, OP_SEX8, OP_SEX16 };
+	static const int binary[] = { OP_ADD, OP_SUB, OP_MULI, OP_MULU, OP_BAND, OP_BOR, OP_BXOR };
+	static const int shift[] = { OP_LSH, OP_RSHI, OP_RSHU };
+	static const int divide[] = { OP_DIVI, OP_DIVU, OP_MODI, OP_MODU };
+	int		patch, patch2;
+
+	if ( depth <= 0 ) {
+		VMC_IntLeaf();
+		return;
+	}
+
+	switch ( VMC_Rand() % 12 ) {
+	case 0:
+	case 1:
+		VMC_IntLeaf();
+		break;
+	case 2:
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_Emit( unary[ VMC_Rand() % 4 ] );
+		break;
+	case 3:
+	case 4:
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_Emit( binary[ VMC_Rand() % 7 ] );
+		break;
+	case 5:		// keep the count in range, x86 and C disagree past 31
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_Emit4( OP_CONST, 31 );
+		VMC_Emit( OP_BAND );
+		VMC_Emit( shift[ VMC_Rand() % 3 ] );
+		break;
+	case 6:		// a small positive divisor, no faults
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_Emit4( OP_CONST, 255 );
+		VMC_Emit( OP_BAND );
+		VMC_Emit4( OP_CONST, 1 );
+		VMC_Emit( OP_BOR );
+		VMC_Emit( divide[ VMC_Rand() % 4 ] );
+		break;
+	case 7:
+		VMC_FloatExpr( depth - 1, allowCalls );
+		VMC_Emit( OP_CVFI );
+		break;
+	case 8:		// a comparison as a value
+		patch = VMC_Compare( depth - 1, allowCalls );
+		VMC_Emit4( OP_CONST, 0 );
+		patch2 = VMC_EmitForward( OP_CONST );
+		if ( VMC_Rand() & 1 ) {
+			// not a constant jump any more
+			VMC_Emit4( OP_CONST, 0 );
+			VMC_Emit( OP_ADD );
+		}
+		VMC_Emit( OP_JUMP );
+		VMC_Label( patch );
+		VMC_Emit4( OP_CONST, 1 );
+		VMC_Label( patch2 );
+		break;
+	case 9:
+	case 10:
+		if ( !allowCalls || vmc.inHelper || vmc.numHelperPatches == VMC_MAX_PATCHES ) {
+			VMC_IntLeaf();
+			break;
+		}
+		// args can't make calls of their own, they'd stomp the arg area
+		VMC_IntExpr( depth - 1, qfalse );
+		VMC_Emit1( OP_ARG, 8 );
+		VMC_IntExpr( depth - 1, qfalse );
+		VMC_Emit1( OP_ARG, 12 );
+		vmc.helperPatches[ vmc.numHelperPatches++ ] = VMC_EmitForward( OP_CONST );
+		VMC_Emit( OP_CALL );
+		break;
+	default:
+		if ( !allowCalls ) {
+			VMC_IntLeaf();
+			break;
+		}
+		VMC_IntExpr( depth - 1, qfalse );
+		VMC_Emit1( OP_ARG, 8 );
+		VMC_IntExpr( depth - 1, qfalse );
+		VMC_Emit1( OP_ARG, 12 );
+		VMC_IntExpr( depth - 1, qfalse );
+		VMC_Emit1( OP_ARG, 16 );
+		if ( VMC_Rand() & 1 ) {
+			VMC_Emit4( OP_CONST, -1 - (int)( VMC_Rand() % 4 ) );
+		} else {
+			// not a constant call any more
+			VMC_Emit4( OP_CONST, -(int)( VMC_Rand() % 4 ) );
+			VMC_Emit4( OP_CONST, -1 );
+			VMC_Emit( OP_ADD );
+		}
+		VMC_Emit( OP_CALL );
+		break;
+	}
+}
+
+static void VMC_FloatExpr( int depth, qboolean allowCalls ) {
+	int		patch, patch2;
+
+	switch ( VMC_Rand() % ( depth > 0 ? 6 : 2 ) ) {
+	case 0:
+		VMC_Emit4( OP_CONST, VMC_RandomFloat() );
+		break;
+	case 1:
+		VMC_Emit4( OP_CONST, ( VMC_Rand() % VMC_SLOTS ) * 4 );
+		VMC_Emit( OP_LOAD4 );
+		break;
+	case 2:
+		VMC_IntExpr( depth - 1, allowCalls );
+		VMC_Emit( OP_CVIF );
+		break;
+	case 3:
+		VMC_FloatExpr( depth - 1, allowCalls );
+		VMC_Emit( OP_NEGF );
+		break;
+	default:
+		// which NaN comes out of two NaN operands depends on how the
+		// interpreter was compiled, so turn a NaN result into zero
+		VMC_Emit4( OP_CONST, VMC_SCRATCH );
+		VMC_FloatExpr( depth - 1, allowCalls );
+		VMC_FloatExpr( depth - 1, allowCalls );
+		VMC_Emit( OP_ADDF + VMC_Rand() % ( OP_MULF - OP_ADDF + 1 ) );
+		VMC_Emit( OP_STORE4 );
+		VMC_Emit4( OP_CONST, VMC_SCRATCH );
+		VMC_Emit( OP_LOAD4 );
+		VMC_Emit4( OP_CONST, VMC_SCRATCH );
+		VMC_Emit( OP_LOAD4 );
+		patch = VMC_EmitForward( OP_EQF );
+		VMC_Emit4( OP_CONST, 0 );
+		patch2 = VMC_EmitForward( OP_CONST );
+		VMC_Emit( OP_JUMP );
+		VMC_Label( patch );
+		VMC_Emit4( OP_CONST, VMC_SCRATCH );
+		VMC_Emit( OP_LOAD4 );
+		VMC_Label( patch2 );
+		break;
+	}
+}
+
+static void VMC_Statement( int depth ) {
+	int		patch, patch2;
+	int		count;
+	int		local;
+	int		top;
+
+	switch ( VMC_Rand() % ( depth > 0 ? 10 : 6 ) ) {
+	case 0:
+		VMC_Emit4( OP_CONST, ( VMC_Rand() % VMC_SLOTS ) * 4 );
+		if ( VMC_Rand() & 1 ) {
+			VMC_IntExpr( 3, qtrue );
+		} else {
+			VMC_FloatExpr( 3, qtrue );
+		}
+		VMC_Emit( OP_STORE4 );
+		break;
+	case 1:
+		if ( VMC_Rand() & 1 ) {
+			VMC_Emit4( OP_CONST, ( VMC_Rand() % VMC_SLOTS ) * 4 + ( VMC_Rand() & 2 ) );
+			VMC_IntExpr( 2, qtrue );
+			VMC_Emit( OP_STORE2 );
+		} else {
+			VMC_Emit4( OP_CONST, ( VMC_Rand() % VMC_SLOTS ) * 4 + ( VMC_Rand() & 3 ) );
+			VMC_IntExpr( 2, qtrue );
+			VMC_Emit( OP_STORE1 );
+		}
+		break;
+	case 2:
+		VMC_Emit4( OP_LOCAL, VMC_LOCALS + ( VMC_Rand() % 6 ) * 4 );
+		VMC_IntExpr( 3, qtrue );
+		VMC_Emit( OP_STORE4 );
+		break;
+	case 3:
+		count = 1 + VMC_Rand() % 8;
+		VMC_Emit4( OP_CONST, ( VMC_Rand() % ( VMC_SLOTS - count ) ) * 4 );
+		VMC_Emit4( OP_CONST, ( VMC_Rand() % ( VMC_SLOTS - count ) ) * 4 );
+		VMC_Emit4( OP_BLOCK_COPY, count * 4 );
+		break;
+	case 4:
+		VMC_IntExpr( 3, qtrue );
+		VMC_Emit( OP_POP );
+		VMC_Emit( OP_PUSH );
+		VMC_Emit( OP_POP );
+		VMC_Emit( OP_BREAK );
+		break;
+	case 5:		// jump over dead code
+		patch = VMC_EmitForward( OP_CONST );
+		if ( VMC_Rand() & 1 ) {
+			VMC_Emit4( OP_CONST, 0 );
+			VMC_Emit( OP_ADD );
+		}
+		VMC_Emit( OP_JUMP );
+		VMC_Emit4( OP_CONST, 0 );
+		VMC_Emit( OP_POP );
+		VMC_Label( patch );
+		break;
+	case 6:
+		patch = VMC_Compare( 2, qtrue );
+		VMC_Statement( depth - 1 );
+		VMC_Label( patch );
+		break;
+	case 7:
+		patch = VMC_Compare( 2, qtrue );
+		VMC_Statement( depth - 1 );
+		patch2 = VMC_EmitForward( OP_CONST );
+		VMC_Emit( OP_JUMP );
+		VMC_Label( patch );
+		VMC_Statement( depth - 1 );
+		VMC_Label( patch2 );
+		break;
+	default:	// counted loop
+		if ( vmc.loopDepth >= 2 ) {
+			VMC_Statement( 0 );
+			break;
+		}
+		local = VMC_LOCALS + ( 6 + vmc.loopDepth ) * 4;
+		VMC_Emit4( OP_LOCAL, local );
+		VMC_Emit4( OP_CONST, 0 );
+		VMC_Emit( OP_STORE4 );
+		top = vmc.instructionCount;
+		vmc.loopDepth++;
+		VMC_Statement( depth - 1 );
+		vmc.loopDepth--;
+		VMC_Emit4( OP_LOCAL, local );
+		VMC_Emit4( OP_LOCAL, local );
+		VMC_Emit( OP_LOAD4 );
+		VMC_Emit4( OP_CONST, 1 );
+		VMC_Emit( OP_ADD );
+		VMC_Emit( OP_STORE4 );
+		VMC_Emit4( OP_LOCAL, local );
+		VMC_Emit( OP_LOAD4 );
+		VMC_Emit4( OP_CONST, 1 + VMC_Rand() % 4 );
+		VMC_Emit4( OP_LTI, top );
+		break;
+	}
+}
+
+static void VMC_Function( int statements ) {
+	int		i;
+
+	VMC_Emit4( OP_ENTER, VMC_FRAME );
+	for ( i = 0 ; i < statements ; i++ ) {
+		VMC_Statement( 2 );
+	}
+	VMC_IntExpr( 3, qtrue );
+	VMC_Emit4( OP_LEAVE, VMC_FRAME );
+}
+
+/*
+=================
+VMC_BuildProgram
+
+Returns a Z_Malloc'd image laid out like a .qvm file
+=================
+*/
+static vmHeader_t *VMC_BuildProgram( void ) {
+	vmHeader_t	*header;
+	int			helper;
+	int			i;
+
+	vmc.codeLength = 0;
+	vmc.instructionCount = 0;
+	vmc.numHelperPatches = 0;
+	vmc.loopDepth = 0;
+
+	vmc.inHelper = qfalse;
+	VMC_Function( 4 + VMC_Rand() % 12 );
+
+	helper = vmc.instructionCount;
+	vmc.inHelper = qtrue;
+	VMC_Function( 1 + VMC_Rand() % 4 );
+
+	for ( i = 0 ; i < vmc.numHelperPatches ; i++ ) {
+		VMC_Put4( vmc.helperPatches[i], helper );
+	}
+
+	header = (vmHeader_t *)Z_Malloc( sizeof( *header ) + vmc.codeLength + VMC_SLOTS * 4, TAG_VM, qtrue );
+	header->vmMagic = VM_MAGIC;
+	header->instructionCount = vmc.instructionCount;
+	header->codeOffset = sizeof( *header );
+	header->codeLength = vmc.codeLength;
+	header->dataOffset = sizeof( *header ) + vmc.codeLength;
+	header->dataLength = VMC_SLOTS * 4;
+	header->litLength = 0;
+	header->bssLength = VMC_IMAGE_SIZE - VMC_SLOTS * 4;
+
+	Com_Memcpy( (byte *)header + header->codeOffset, vmc.code, vmc.codeLength );
+	for ( i = 0 ; i < VMC_SLOTS ; i++ ) {
+		((int *)( (byte *)header + header->dataOffset ))[i] = ( i & 1 ) ? VMC_RandomInt() : VMC_RandomFloat();
+	}
+
+	return header;
+}
+
+/*
+==============================================================================
+
+EXECUTION
+
+==============================================================================
+*/
+
+static int VMC_SystemCalls( int *args ) {
+	vmcSyscall_t	*call;
+	int				side;
+
+	side = vmc.side;
+	if ( vmc.logCount[side] < VMC_MAX_SYSCALLS ) {
+		call = &vmc.log[side][ vmc.logCount[side] ];
+		call->num = args[0];
+		call->args[0] = args[1];
+		call->args[1] = args[2];
+		call->args[2] = args[3];
+		call->programStack = currentVM->programStack;
+	}
+	vmc.logCount[side]++;
+
+	switch ( args[0] ) {
+	case 0:
+		return args[1] + args[2] + args[3];
+	case 1:
+		return args[1] ^ (int)( (unsigned)args[2] << 3 ) ^ args[3];
+	case 2:		// write into the vm like the real ones do
+		*(int *)( currentVM->dataBase + ( ( args[1] & ( VMC_SLOTS - 1 ) ) << 2 ) ) = args[2];
+		return 7;
+	default:
+		return currentVM->programStack;
+	}
+}
+
+static void VMC_Load( vm_t *vm, const char *name, vmHeader_t *header, qboolean compile ) {
+	Com_Memset( vm, 0, sizeof( *vm ) );
+	Q_strncpyz( vm->name, name, sizeof( vm->name ) );
+	vm->systemCall = VMC_SystemCalls;
+	vm->codeInZone = qtrue;		// the hunk can't give it back
+
+	vm->dataBase = (byte *)Z_Malloc( VMC_IMAGE_SIZE, TAG_VM, qtrue );
+	vm->dataMask = VMC_IMAGE_SIZE - 1;
+	Com_Memcpy( vm->dataBase, (byte *)header + header->dataOffset, header->dataLength );
+
+	vm->instructionPointersLength = header->instructionCount * 4;
+	vm->instructionPointers = (int *)Z_Malloc( vm->instructionPointersLength, TAG_VM, qtrue );
+	vm->codeLength = header->codeLength;
+
+	vm->compiled = compile;
+	if ( compile ) {
+		VM_Compile( vm, header );
+	} else {
+		VM_PrepareInterpreter( vm, header );
+	}
+
+	vm->programStack = vm->dataMask + 1;
+	vm->stackBottom = vm->programStack - STACK_SIZE;
+}
+
+static void VMC_Free( vm_t *vm ) {
+	if ( vm->compiled ) {
+		VM_FreeCompiled( vm );
+	} else if ( vm->codeBase ) {
+		Z_Free( vm->codeBase );
+	}
+	if ( vm->dataBase ) {
+		Z_Free( vm->dataBase );
+	}
+	if ( vm->instructionPointers ) {
+		Z_Free( vm->instructionPointers );
+	}
+	Com_Memset( vm, 0, sizeof( *vm ) );
+}
+
+static int VMC_Run( int side, int *args ) {
+	vm_t	*oldVM;
+	int		r;
+
+	oldVM = currentVM;
+	currentVM = &vmcVM[side];
+	vmc.side = side;
+	vmc.logCount[side] = 0;
+
+	if ( vmcVM[side].compiled ) {
+		r = VM_CallCompiled( &vmcVM[side], args );
+	} else {
+		r = VM_CallInterpreted( &vmcVM[side], args );
+	}
+
+	currentVM = oldVM;
+	return r;
+}
+
+// returns qtrue if both sides agree, printing what differs otherwise
+static qboolean VMC_Check( unsigned int seed, int call, int interpreted, int compiled, qboolean report ) {
+	int			i, count;
+	qboolean	ok;
+
+	ok = qtrue;
+	if ( interpreted != compiled ) {
+		if ( report ) {
+			Com_Printf( "seed %u call %i: returned %i interpreted, %i compiled\n", seed, call, interpreted, compiled );
+		}
+		ok = qfalse;
+	}
+
+	for ( i = 0 ; i < VMC_IMAGE_SIZE ; i += 4 ) {
+		if ( i == VMC_SCRATCH ) {
+			continue;	// may hold either side's NaN
+		}
+		if ( *(int *)( vmcVM[0].dataBase + i ) != *(int *)( vmcVM[1].dataBase + i ) ) {
+			if ( report ) {
+				Com_Printf( "seed %u call %i: data differs at 0x%x, 0x%08x interpreted, 0x%08x compiled\n", seed, call, i,
+					*(int *)( vmcVM[0].dataBase + i ), *(int *)( vmcVM[1].dataBase + i ) );
+			}
+			ok = qfalse;
+			break;
+		}
+	}
+
+	if ( vmc.logCount[0] != vmc.logCount[1] ) {
+		if ( report ) {
+			Com_Printf( "seed %u call %i: %i system calls interpreted, %i compiled\n", seed, call, vmc.logCount[0], vmc.logCount[1] );
+		}
+		ok = qfalse;
+	} else {
+		count = vmc.logCount[0] < VMC_MAX_SYSCALLS ? vmc.logCount[0] : VMC_MAX_SYSCALLS;
+		for ( i = 0 ; i < count ; i++ ) {
+			if ( memcmp( &vmc.log[0][i], &vmc.log[1][i], sizeof( vmc.log[0][i] ) ) ) {
+				if ( report ) {
+					Com_Printf( "seed %u call %i: system call %i differs\n", seed, call, i );
+				}
+				ok = qfalse;
+				break;
+			}
+		}
+	}
+
+	if ( vmcVM[0].breakCount != vmcVM[1].breakCount ) {
+		if ( report ) {
+			Com_Printf( "seed %u call %i: break count %i interpreted, %i compiled\n", seed, call, vmcVM[0].breakCount, vmcVM[1].breakCount );
+		}
+		ok = qfalse;
+	}
+
+	if ( vmcVM[0].programStack != vmcVM[1].programStack ) {
+		if ( report ) {
+			Com_Printf( "seed %u call %i: program stack left at %i interpreted, %i compiled\n", seed, call, vmcVM[0].programStack, vmcVM[1].programStack );
+		}
+		ok = qfalse;
+	}
+
+	return ok;
+}
+
+/*
+=================
+VM_Compare_f
+=================
+*/
+void VM_Compare_f( void ) {
+	vmHeader_t		*header;
+	unsigned int	seed, programSeed;
+	int				programs;
+	int				args[10];
+	int				interpreted, compiled;
+	int				mismatches, calls;
+	int				i, j, k;
+
+	if ( com_vmdebug->integer > 1 ) {
+		// the interpreter's checks leave stack frame info in the data segment
+		Com_Printf( "vm_compare: needs vmdebug below 2\n" );
+		return;
+	}
+
+	VMC_Free( &vmcVM[0] );
+	VMC_Free( &vmcVM[1] );
+
+	programs = 32;
+	seed = Com_Milliseconds();
+	if ( Cmd_Argc() > 1 ) {
+		programs = atoi( Cmd_Argv( 1 ) );
+	}
+	if ( Cmd_Argc() > 2 ) {
+		seed = strtoul( Cmd_Argv( 2 ), NULL, 10 );
+	}
+
+	mismatches = 0;
+	calls = 0;
+	for ( i = 0 ; i < programs ; i++ ) {
+		programSeed = seed + i;
+		vmc.seed = programSeed;
+
+		header = VMC_BuildProgram();
+		VMC_Load( &vmcVM[0], "compare_interpreted", header, qfalse );
+		VMC_Load( &vmcVM[1], "compare_compiled", header, qtrue );
+		Z_Free( header );
+
+		for ( j = 0 ; j < VMC_CALLS ; j++ ) {
+			for ( k = 0 ; k < 10 ; k++ ) {
+				args[k] = VMC_RandomInt();
+			}
+
+			interpreted = VMC_Run( 0, args );
+			compiled = VMC_Run( 1, args );
+			calls++;
+
+			if ( !VMC_Check( programSeed, j, interpreted, compiled, (qboolean)( mismatches < VMC_MAX_REPORTS ) ) ) {
+				mismatches++;
+				break;
+			}
+		}
+
+		VMC_Free( &vmcVM[0] );
+		VMC_Free( &vmcVM[1] );
+	}
+
+	Com_Printf( "vm_compare: %i programs, %i calls, %i mismatches (seed %u)\n", programs, calls, mismatches, seed );
+}
@@ -227,3 +227,5 @@ void VM_Init(void) {}
 void *VM_ExplicitArgPtr(vm_t *, int) { return NULL; }
 
 vm_t *VM_Restart(vm_t *vm) { return vm; }
+
+void VM_ProfileFrame(void) {}
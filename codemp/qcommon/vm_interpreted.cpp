@@ -143,7 +143,11 @@ void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header ) {
 	int		instruction;
 	int		*codeBase;
 
-	vm->codeBase = (unsigned char *)Hunk_Alloc( vm->codeLength*4, h_high );			// we're now int aligned
+	if ( vm->codeInZone ) {
+		vm->codeBase = (unsigned char *)Z_Malloc( vm->codeLength*4, TAG_VM, qtrue );
+	} else {
+		vm->codeBase = (unsigned char *)Hunk_Alloc( vm->codeLength*4, h_high );			// we're now int aligned
+	}
 //	memcpy( vm->codeBase, (byte *)header + header->codeOffset, vm->codeLength );
 
 	// we don't need to translate the instructions, but we still need
@@ -474,7 +478,7 @@ nextInstruction2:
 
 				src = (int *)&image[ r0&dataMask ];
 				dest = (int *)&image[ r1&dataMask ];
-				if ( ( (int)src | (int)dest | count ) & 3 ) {
+				if ( ( srci | desti | count ) & 3 ) {
 					Com_Error( ERR_DROP, "OP_BLOCK_COPY not dword aligned" );
 				}
 				count >>= 2;
@@ -840,7 +844,7 @@ nextInstruction2:
 			opStack--;
 			goto nextInstruction;
 		case OP_BCOM:
-			opStack[-1] = ~ ((unsigned)r0);
+			*opStack = ~ ((unsigned)r0);
 			goto nextInstruction;
 
 		case OP_LSH:
@@ -105,6 +105,9 @@ typedef struct vmSymbol_s {
 	char	symName[1];		// variable sized
 } vmSymbol_t;
 
+// the program stack sits at the top of the data segment
+#define	STACK_SIZE	0x20000
+
 #define	VM_OFFSET_PROGRAM_STACK		0
 #define	VM_OFFSET_SYSTEM_CALL		4
 
@@ -128,6 +131,7 @@ struct vm_s {
 	qboolean	compiled;
 	byte		*codeBase;
 	int			codeLength;
+	qboolean	codeInZone;			// codeBase is Z_Malloc'd instead of on the hunk, for vms freed on their own
 
 	int			*instructionPointers;
 	int			instructionPointersLength;
@@ -143,6 +147,8 @@ struct vm_s {
 	int			callLevel;			// for debug indenting
 	int			breakFunction;		// increment breakCount on function entry to this
 	int			breakCount;
+
+	int			(*moduleSystemCall)( int *parms );	// systemCall goes through the profiler to this
 };
 
 #ifdef CRAZY_SYMBOL_MAP
@@ -171,6 +177,7 @@ extern	int		vm_debugLevel;
 
 void VM_Compile( vm_t *vm, vmHeader_t *header );
 int	VM_CallCompiled( vm_t *vm, int *args );
+void VM_FreeCompiled( vm_t *vm );
 
 void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header );
 int	VM_CallInterpreted( vm_t *vm, int *args );
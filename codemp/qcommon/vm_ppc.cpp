@@ -1112,6 +1112,16 @@ void VM_Compile( vm_t *vm, vmHeader_t *header ) {
     Z_Free( jused );
 }
 
+/*
+=================
+VM_FreeCompiled
+
+The code lives on the hunk and goes with it
+=================
+*/
+void VM_FreeCompiled( vm_t *vm ) {
+}
+
 /*
 ==============
 VM_CallCompiled
@@ -4,6 +4,8 @@
 
 #include "vm_local.h"
 
+#if !defined( __x86_64__ ) && !defined( _M_X64 )	// vm_x86_64.cpp
+
 #ifdef __FreeBSD__ // rb0101023
 #include <sys/types.h>
 #endif
@@ -1025,7 +1027,11 @@ void VM_Compile( vm_t *vm, vmHeader_t *header ) {
 
 	// copy to an exact size buffer on the hunk
 	vm->codeLength = compiledOfs;
-	vm->codeBase = (unsigned char *)Hunk_Alloc( compiledOfs, h_low );
+	if ( vm->codeInZone ) {
+		vm->codeBase = (unsigned char *)Z_Malloc( compiledOfs, TAG_VM, qfalse );
+	} else {
+		vm->codeBase = (unsigned char *)Hunk_Alloc( compiledOfs, h_low );
+	}
 	Com_Memcpy( vm->codeBase, buf, compiledOfs );
 	Z_Free( buf );
 	Z_Free( jused );
@@ -1055,6 +1061,20 @@ void VM_Compile( vm_t *vm, vmHeader_t *header ) {
 
 }
 
+/*
+=================
+VM_FreeCompiled
+
+The code normally lives on the hunk and goes with it
+=================
+*/
+void VM_FreeCompiled( vm_t *vm ) {
+	if ( vm->codeInZone && vm->codeBase ) {
+		Z_Free( vm->codeBase );
+		vm->codeBase = NULL;
+	}
+}
+
 /*
 ==============
 VM_CallCompiled
@@ -1164,3 +1184,4 @@ int	VM_CallCompiled( vm_t *vm, int *args ) {
 }
 #endif // !DLL_ONLY
 
+#endif // !__x86_64__ && !_M_X64
@@ -0,0 +1,925 @@
+// vm_x86_64.c -- load time compiler and execution environment for x86-64
+//Anything above this #include will be ignored by the compiler
+#include "../qcommon/exe_headers.h"
+
+#include "vm_local.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+
+#ifndef _WIN32
+#include <sys/mman.h> // for PROT_ stuff
+#endif
+
+/*
+
+  rax	scratch
+  rcx	scratch (required for shifts)
+  rdx	scratch (required for divisions)
+  rbx	program stack
+  rbp	opstack base, for the range checks
+  r12	data base
+  r13	opstack
+  r14	instruction pointer table
+  r15	code base
+
+  Everything but the scratch registers is callee saved under both the
+  SysV and Win64 conventions, so system calls and recursive VM entries
+  leave the VM state alone.
+
+  instructionPointers holds offsets from codeBase rather than absolute
+  addresses, since those no longer fit in an int.
+
+  All data segment accesses are masked with dataMask, call and jump
+  targets are range checked against the instruction count, and the
+  opstack is range checked on function entry and return, at every branch,
+  after every call and at least every OPSTACK_CHECK_INTERVAL instructions
+  in between.  The checks at calls and returns keep the unchecked drift
+  from piling up across a chain of returns, so it is never more than one
+  interval's worth and OPSTACK_GUARD always covers it.
+
+*/
+
+#define	OPSTACK_SIZE			1024
+#define	OPSTACK_CHECK_INTERVAL	64
+#define	OPSTACK_GUARD			( OPSTACK_CHECK_INTERVAL * 2 + 8 )	// slack for the unchecked stretches
+
+typedef enum {
+	VMERR_BAD_CALL,
+	VMERR_BAD_JUMP,
+	VMERR_OPSTACK,
+	VMERR_PROGRAM_STACK,
+	VMERR_DIVIDE,
+
+	VMERR_COUNT
+} vmCompiledError_t;
+
+static const char *vmCompiledErrors[VMERR_COUNT] = {
+	"call to a bad instruction",
+	"jump to a bad instruction",
+	"opStack overflow",
+	"program stack overflow",
+	"integer divide by zero"
+};
+
+// handed to the entry stub, which loads the registers from it and
+// writes back the final opstack and program stack
+typedef struct {
+	byte	*dataBase;				// 0
+	int		*opStack;				// 8
+	int		*instructionPointers;	// 16
+	byte	*codeBase;				// 24
+	int		*opStackBase;			// 32
+	int		programStack;			// 40
+} vmCallFrame_t;
+
+typedef void (*vmEntryStub_t)( vmCallFrame_t *frame );
+
+static	byte	*buf = NULL;
+static	int		compiledOfs = 0;
+static	byte	*code = NULL;
+static	int		codeLength = 0;
+static	int		pc = 0;
+
+static	int		*instructionPointers = NULL;
+static	int		instruction, instructionCount, pass;
+
+static	int		sinceCheck;			// instructions emitted since the last opstack check
+static	int		fusedCallSkip;		// jmp rel8 over the OP_CALL following a fused OP_CONST
+
+static	int		callStubOfs;
+static	int		syscallStubOfs;
+static	int		errorStubOfs[VMERR_COUNT];
+
+/*
+=================
+VM_CompiledError
+
+Reached from the generated code, never returns
+=================
+*/
+static void VM_CompiledError( int error ) {
+	Com_Error( ERR_DROP, "%s: %s", currentVM ? currentVM->name : "VM", vmCompiledErrors[error] );
+}
+
+/*
+=================
+VM_CompiledSystemCall
+=================
+*/
+static int VM_CompiledSystemCall( int programStack, int syscallNum ) {
+	vm_t	*savedVM;
+	int		*args;
+	int		r;
+
+	savedVM = currentVM;
+
+	if ( (unsigned)programStack > (unsigned)( currentVM->dataMask - 4 ) ) {
+		Com_Error( ERR_DROP, "%s: system call with a bad program stack", currentVM->name );
+	}
+
+	// store the syscall number right before the first arg
+	args = (int *)( currentVM->dataBase + programStack + 4 );
+	args[0] = syscallNum;
+
+	// save the stack to allow recursive VM entry
+	currentVM->programStack = programStack - 4;
+//VM_LogSyscalls( args );
+	r = currentVM->systemCall( args );
+
+	currentVM = savedVM;
+	return r;
+}
+
+/*
+=================
+VM_CompiledBlockCopy
+
+Same clamping as the interpreter's OP_BLOCK_COPY
+=================
+*/
+static void VM_CompiledBlockCopy( int dest, int src, int count ) {
+	int		*s, *d;
+	int		i, srci, desti;
+	int		dataMask;
+
+	dataMask = currentVM->dataMask;
+
+	srci = src & dataMask;
+	desti = dest & dataMask;
+	count = ((srci + count) & dataMask) - srci;
+	count = ((desti + count) & dataMask) - desti;
+
+	if ( ( srci | desti | count ) & 3 ) {
+		Com_Error( ERR_DROP, "OP_BLOCK_COPY not dword aligned" );
+	}
+
+	s = (int *)&currentVM->dataBase[ srci ];
+	d = (int *)&currentVM->dataBase[ desti ];
+	count >>= 2;
+	for ( i = count-1 ; i >= 0 ; i-- ) {
+		d[i] = s[i];
+	}
+}
+
+static int	Constant4( void ) {
+	int		v;
+
+	if ( pc + 4 > codeLength ) {
+		Com_Error( ERR_DROP, "VM_CompileX64: truncated instruction at offset %i", pc );
+	}
+	v = code[pc] | (code[pc+1]<<8) | (code[pc+2]<<16) | (code[pc+3]<<24);
+	pc += 4;
+	return v;
+}
+
+static int	Constant1( void ) {
+	int		v;
+
+	if ( pc + 1 > codeLength ) {
+		Com_Error( ERR_DROP, "VM_CompileX64: truncated instruction at offset %i", pc );
+	}
+	v = code[pc];
+	pc += 1;
+	return v;
+}
+
+static void Emit1( int v ) {
+	buf[ compiledOfs ] = v;
+	compiledOfs++;
+}
+
+static void Emit4( int v ) {
+	Emit1( v & 255 );
+	Emit1( ( v >> 8 ) & 255 );
+	Emit1( ( v >> 16 ) & 255 );
+	Emit1( ( v >> 24 ) & 255 );
+}
+
+static void EmitPtr( const void *p ) {
+	size_t	v;
+	int		i;
+
+	v = (size_t)p;
+	for ( i = 0 ; i < 8 ; i++ ) {
+		Emit1( ( v >> ( i * 8 ) ) & 255 );
+	}
+}
+
+static int Hex( int c ) {
+	if ( c >= 'a' && c <= 'f' ) {
+		return 10 + c - 'a';
+	}
+	if ( c >= 'A' && c <= 'F' ) {
+		return 10 + c - 'A';
+	}
+	if ( c >= '0' && c <= '9' ) {
+		return c - '0';
+	}
+
+	Com_Error( ERR_DROP, "Hex: bad char '%c'", c );
+
+	return 0;
+}
+
+static void EmitString( const char *string ) {
+	int		c1, c2;
+	int		v;
+
+	while ( 1 ) {
+		c1 = string[0];
+		c2 = string[1];
+
+		v = ( Hex( c1 ) << 4 ) | Hex( c2 );
+		Emit1( v );
+
+		if ( !string[2] ) {
+			break;
+		}
+		string += 3;
+	}
+}
+
+// opcode followed by a rel32 to a code offset
+static void EmitJump( const char *opcode, int target ) {
+	EmitString( opcode );
+	Emit4( target - ( compiledOfs + 4 ) );
+}
+
+// branch targets are instruction numbers
+static int BranchTarget( void ) {
+	int		v;
+
+	v = Constant4();
+	if ( v < 0 || v >= instructionCount ) {
+		Com_Error( ERR_DROP, "VM_CompileX64: branch to bad instruction %i at offset %i", v, pc );
+	}
+	return instructionPointers[ v ];
+}
+
+/*
+=================
+EmitCallC
+
+Calls a C function with the stack realigned, the arguments
+must already be in the registers
+=================
+*/
+static void EmitCallC( const void *func ) {
+	EmitString( "48 89 E0" );		// mov rax, rsp
+	EmitString( "48 83 E4 F0" );	// and rsp, -16
+	EmitString( "50 50" );			// push rax, push rax
+#ifdef _WIN32
+	EmitString( "48 83 EC 20" );	// sub rsp, 32 (shadow space)
+#endif
+	EmitString( "48 B8" );			// mov rax, func
+	EmitPtr( func );
+	EmitString( "FF D0" );			// call rax
+#ifdef _WIN32
+	EmitString( "48 83 C4 20" );	// add rsp, 32
+#endif
+	EmitString( "48 8B 24 24" );	// mov rsp, [rsp]
+}
+
+static void EmitCheckOpStack( void ) {
+	EmitString( "4C 89 E8" );		// mov rax, r13
+	EmitString( "48 29 E8" );		// sub rax, rbp
+	EmitString( "48 3D" );			// cmp rax, OPSTACK_SIZE * 4
+	Emit4( OPSTACK_SIZE * 4 );
+	EmitJump( "0F 87", errorStubOfs[VMERR_OPSTACK] );	// ja error
+	sinceCheck = 0;
+}
+
+// save the return pc where the interpreter keeps it, so the
+// data segment looks the same whichever way the vm is run
+static void EmitStoreReturnPC( vm_t *vm, int returnPC ) {
+	EmitString( "89 D8" );			// mov eax, ebx
+	EmitString( "25" );				// and eax, dataMask
+	Emit4( vm->dataMask );
+	EmitString( "41 C7 04 04" );	// mov dword ptr [r12+rax], returnPC
+	Emit4( returnPC );
+}
+
+// pop an instruction number off the opstack and jump to it
+static void EmitIndirectJump( int error ) {
+	EmitString( "41 8B 45 00" );	// mov eax, [r13]
+	EmitString( "49 83 ED 04" );	// sub r13, 4
+	EmitString( "3D" );				// cmp eax, instructionCount
+	Emit4( instructionCount );
+	EmitJump( "0F 83", errorStubOfs[error] );	// jae error
+	EmitString( "41 8B 04 86" );	// mov eax, [r14+rax*4]
+	EmitString( "4C 01 F8" );		// add rax, r15
+	EmitString( "FF E0" );			// jmp rax
+}
+
+/*
+=================
+EmitStubs
+
+Shared code at the start of the block, the same size on both passes
+=================
+*/
+static void EmitStubs( void ) {
+	int		i;
+	int		sysPatch;
+
+	// entry from VM_CallCompiled, the frame comes in the first arg register
+	EmitString( "53 55" );				// push rbx, push rbp
+	EmitString( "41 54 41 55" );		// push r12, push r13
+	EmitString( "41 56 41 57" );		// push r14, push r15
+	EmitString( "56 57" );				// push rsi, push rdi
+#ifdef _WIN32
+	EmitString( "48 89 CF" );			// mov rdi, rcx
+#endif
+	EmitString( "57" );					// push rdi
+	EmitString( "4C 8B 27" );			// mov r12, [rdi]
+	EmitString( "4C 8B 6F 08" );		// mov r13, [rdi+8]
+	EmitString( "4C 8B 77 10" );		// mov r14, [rdi+16]
+	EmitString( "4C 8B 7F 18" );		// mov r15, [rdi+24]
+	EmitString( "48 8B 6F 20" );		// mov rbp, [rdi+32]
+	EmitString( "8B 5F 28" );			// mov ebx, [rdi+40]
+	EmitString( "41 8B 06" );			// mov eax, [r14]
+	EmitString( "4C 01 F8" );			// add rax, r15
+	EmitString( "FF D0" );				// call rax
+	EmitString( "5F" );					// pop rdi
+	EmitString( "4C 89 6F 08" );		// mov [rdi+8], r13
+	EmitString( "89 5F 28" );			// mov [rdi+40], ebx
+	EmitString( "5F 5E" );				// pop rdi, pop rsi
+	EmitString( "41 5F 41 5E" );		// pop r15, pop r14
+	EmitString( "41 5D 41 5C" );		// pop r13, pop r12
+	EmitString( "5D 5B" );				// pop rbp, pop rbx
+	EmitString( "C3" );					// ret
+
+	// errors, the jumps into these come later so they need to be known first
+	for ( i = 0 ; i < VMERR_COUNT ; i++ ) {
+		errorStubOfs[i] = compiledOfs;
+#ifdef _WIN32
+		EmitString( "B9" );				// mov ecx, i
+#else
+		EmitString( "BF" );				// mov edi, i
+#endif
+		Emit4( i );
+		EmitCallC( (void *)VM_CompiledError );
+	}
+
+	// OP_CALL with the target on the opstack
+	callStubOfs = compiledOfs;
+	EmitString( "41 8B 45 00" );		// mov eax, [r13]
+	EmitString( "85 C0" );				// test eax, eax
+	EmitString( "7C" );					// jl syscall
+	sysPatch = compiledOfs;
+	Emit1( 0 );
+	EmitIndirectJump( VMERR_BAD_CALL );
+	buf[sysPatch] = compiledOfs - ( sysPatch + 1 );
+	EmitString( "49 83 ED 04" );		// sub r13, 4
+	EmitString( "F7 D0" );				// not eax
+
+	// system call with the number in eax, the return value gets pushed
+	syscallStubOfs = compiledOfs;
+#ifdef _WIN32
+	EmitString( "89 D9" );				// mov ecx, ebx
+	EmitString( "89 C2" );				// mov edx, eax
+#else
+	EmitString( "89 DF" );				// mov edi, ebx
+	EmitString( "89 C6" );				// mov esi, eax
+#endif
+	EmitCallC( (void *)VM_CompiledSystemCall );
+	EmitString( "49 83 C5 04" );		// add r13, 4
+	EmitString( "41 89 45 00" );		// mov [r13], eax
+	EmitString( "C3" );					// ret
+}
+
+static void EmitBranch( const char *loadFirst, const char *jcc ) {
+	int		target;
+
+	target = BranchTarget();
+	EmitCheckOpStack();
+	EmitString( "49 83 ED 08" );		// sub r13, 8
+	EmitString( loadFirst );
+	EmitJump( jcc, target );
+}
+
+static void EmitFloatBranch( qboolean swap, const char *jcc ) {
+	int		target;
+
+	target = BranchTarget();
+	EmitCheckOpStack();
+	EmitString( "49 83 ED 08" );		// sub r13, 8
+	// ucomiss flags unordered compares as below-or-equal, so
+	// less-than tests are done as swapped greater-than ones
+	if ( swap ) {
+		EmitString( "F3 41 0F 10 45 08" );	// movss xmm0, [r13+8]
+		EmitString( "41 0F 2E 45 04" );		// ucomiss xmm0, [r13+4]
+	} else {
+		EmitString( "F3 41 0F 10 45 04" );	// movss xmm0, [r13+4]
+		EmitString( "41 0F 2E 45 08" );		// ucomiss xmm0, [r13+8]
+	}
+	EmitJump( jcc, target );
+}
+
+static void EmitBinaryOp( const char *op ) {
+	EmitString( "41 8B 45 00" );		// mov eax, [r13]
+	EmitString( "49 83 ED 04" );		// sub r13, 4
+	EmitString( op );					// op [r13], eax
+}
+
+static void EmitFloatOp( const char *op ) {
+	EmitString( "49 83 ED 04" );		// sub r13, 4
+	EmitString( "F3 41 0F 10 45 00" );	// movss xmm0, [r13]
+	EmitString( op );					// op xmm0, [r13+4]
+	EmitString( "F3 41 0F 11 45 00" );	// movss [r13], xmm0
+}
+
+static void EmitDivide( qboolean isSigned, qboolean remainder ) {
+	EmitString( "49 83 ED 04" );		// sub r13, 4
+	EmitString( "41 8B 4D 04" );		// mov ecx, [r13+4]
+	EmitString( "85 C9" );				// test ecx, ecx
+	EmitJump( "0F 84", errorStubOfs[VMERR_DIVIDE] );	// je error
+	EmitString( "41 8B 45 00" );		// mov eax, [r13]
+	if ( isSigned ) {
+		EmitString( "99" );				// cdq
+		EmitString( "F7 F9" );			// idiv ecx
+	} else {
+		EmitString( "31 D2" );			// xor edx, edx
+		EmitString( "F7 F1" );			// div ecx
+	}
+	if ( remainder ) {
+		EmitString( "41 89 55 00" );	// mov [r13], edx
+	} else {
+		EmitString( "41 89 45 00" );	// mov [r13], eax
+	}
+}
+
+static void EmitLoad( vm_t *vm, const char *load ) {
+	EmitString( "41 8B 45 00" );		// mov eax, [r13]
+	EmitString( "25" );					// and eax, dataMask
+	Emit4( vm->dataMask );
+	EmitString( load );					// load eax, [r12+rax]
+	EmitString( "41 89 45 00" );		// mov [r13], eax
+}
+
+static void EmitStore( int mask, const char *store ) {
+	EmitString( "41 8B 45 FC" );		// mov eax, [r13-4]
+	EmitString( "25" );					// and eax, mask
+	Emit4( mask );
+	EmitString( "41 8B 4D 00" );		// mov ecx, [r13]
+	EmitString( store );				// store [r12+rax], ecx
+	EmitString( "49 83 ED 08" );		// sub r13, 8
+}
+
+/*
+=================
+VM_Compile
+=================
+*/
+void VM_Compile( vm_t *vm, vmHeader_t *header ) {
+	int		op;
+	int		maxLength;
+	int		v;
+	int		stackBottom;
+	byte	*exec;
+
+	instructionPointers = vm->instructionPointers;
+	instructionCount = header->instructionCount;
+	codeLength = header->codeLength;
+
+	// VM_Create sets the stack up at the end of the data segment
+	stackBottom = vm->dataMask + 1 - STACK_SIZE;
+
+	// allocate a very large temp buffer, we will copy it out when done
+	maxLength = header->instructionCount * 96 + 1024;
+	buf = (unsigned char *)Z_Malloc( maxLength, TAG_VM, qfalse );
+
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		pc = 0;
+		instruction = 0;
+		code = (byte *)header + header->codeOffset;
+		compiledOfs = 0;
+		sinceCheck = 0;
+		fusedCallSkip = -1;
+
+		EmitStubs();
+
+		while ( instruction < header->instructionCount ) {
+			if ( compiledOfs > maxLength - 128 ) {
+				Com_Error( ERR_FATAL, "VM_CompileX64: maxLength exceeded" );
+			}
+
+			instructionPointers[ instruction ] = compiledOfs;
+			instruction++;
+
+			if ( pc >= header->codeLength ) {
+				Com_Error( ERR_DROP, "VM_CompileX64: pc > header->codeLength" );
+			}
+
+			if ( ++sinceCheck >= OPSTACK_CHECK_INTERVAL ) {
+				EmitCheckOpStack();
+			}
+
+			op = code[ pc ];
+			pc++;
+			switch ( op ) {
+			case OP_UNDEF:
+			case OP_IGNORE:
+				break;
+			case OP_BREAK:
+				EmitString( "48 B8" );			// mov rax, &vm->breakCount
+				EmitPtr( &vm->breakCount );
+				EmitString( "FF 00" );			// inc dword ptr [rax]
+				break;
+			case OP_ENTER:
+				v = Constant4();
+				EmitString( "81 EB" );			// sub ebx, v
+				Emit4( v );
+				EmitString( "81 FB" );			// cmp ebx, stackBottom
+				Emit4( stackBottom );
+				EmitJump( "0F 8E", errorStubOfs[VMERR_PROGRAM_STACK] );	// jle error
+				EmitCheckOpStack();
+				break;
+			case OP_LEAVE:
+				v = Constant4();
+				EmitString( "81 C3" );			// add ebx, v
+				Emit4( v );
+				EmitCheckOpStack();
+				EmitString( "C3" );				// ret
+				break;
+			case OP_CONST:
+				v = Constant4();
+				if ( instruction < instructionCount && pc < codeLength && code[pc] == OP_CALL ) {
+					if ( v < 0 ) {
+						// direct system call
+						EmitCheckOpStack();
+						EmitStoreReturnPC( vm, pc + 1 );
+						EmitString( "B8" );		// mov eax, syscall number
+						Emit4( -1 - v );
+						EmitJump( "E8", syscallStubOfs );
+					} else if ( v < instructionCount ) {
+						EmitCheckOpStack();
+						EmitStoreReturnPC( vm, pc + 1 );
+						EmitJump( "E8", instructionPointers[v] );
+					} else {
+						goto pushConst;
+					}
+					// the OP_CALL itself is only reached by jumps now
+					EmitString( "EB" );			// jmp over it
+					fusedCallSkip = compiledOfs;
+					Emit1( 0 );
+					break;
+				}
+				if ( instruction < instructionCount && pc < codeLength && code[pc] == OP_JUMP
+					&& v >= 0 && v < instructionCount ) {
+					EmitCheckOpStack();
+					EmitJump( "E9", instructionPointers[v] );
+					break;
+				}
+pushConst:
+				EmitString( "49 83 C5 04" );	// add r13, 4
+				EmitString( "41 C7 45 00" );	// mov dword ptr [r13], v
+				Emit4( v );
+				break;
+			case OP_LOCAL:
+				EmitString( "49 83 C5 04" );	// add r13, 4
+				EmitString( "8D 83" );			// lea eax, [rbx+v]
+				Emit4( Constant4() );
+				EmitString( "41 89 45 00" );	// mov [r13], eax
+				break;
+			case OP_ARG:
+				EmitString( "41 8B 45 00" );	// mov eax, [r13]
+				EmitString( "49 83 ED 04" );	// sub r13, 4
+				EmitString( "8D 8B" );			// lea ecx, [rbx+v]
+				Emit4( Constant1() );
+				EmitString( "81 E1" );			// and ecx, dataMask
+				Emit4( vm->dataMask );
+				EmitString( "41 89 04 0C" );	// mov [r12+rcx], eax
+				break;
+			case OP_CALL:
+				EmitCheckOpStack();
+				EmitStoreReturnPC( vm, pc );
+				EmitJump( "E8", callStubOfs );	// call callStub
+				if ( fusedCallSkip >= 0 ) {
+					buf[fusedCallSkip] = compiledOfs - ( fusedCallSkip + 1 );
+					fusedCallSkip = -1;
+				}
+				// both kinds of call come back here
+				EmitCheckOpStack();
+				break;
+			case OP_PUSH:
+				EmitString( "49 83 C5 04" );	// add r13, 4
+				break;
+			case OP_POP:
+				EmitString( "49 83 ED 04" );	// sub r13, 4
+				break;
+			case OP_JUMP:
+				EmitCheckOpStack();
+				EmitIndirectJump( VMERR_BAD_JUMP );
+				break;
+
+			case OP_EQ:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 84" );	// cmp [r13+4], [r13+8]; je
+				break;
+			case OP_NE:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 85" );	// jne
+				break;
+			case OP_LTI:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 8C" );	// jl
+				break;
+			case OP_LEI:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 8E" );	// jle
+				break;
+			case OP_GTI:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 8F" );	// jg
+				break;
+			case OP_GEI:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 8D" );	// jge
+				break;
+			case OP_LTU:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 82" );	// jb
+				break;
+			case OP_LEU:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 86" );	// jbe
+				break;
+			case OP_GTU:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 87" );	// ja
+				break;
+			case OP_GEU:
+				EmitBranch( "41 8B 45 04 41 3B 45 08", "0F 83" );	// jae
+				break;
+
+			case OP_EQF:
+				v = BranchTarget();
+				EmitCheckOpStack();
+				EmitString( "49 83 ED 08" );		// sub r13, 8
+				EmitString( "F3 41 0F 10 45 04" );	// movss xmm0, [r13+4]
+				EmitString( "41 0F 2E 45 08" );		// ucomiss xmm0, [r13+8]
+				EmitString( "7A 06" );				// jp over the je
+				EmitJump( "0F 84", v );				// je
+				break;
+			case OP_NEF:
+				v = BranchTarget();
+				EmitCheckOpStack();
+				EmitString( "49 83 ED 08" );		// sub r13, 8
+				EmitString( "F3 41 0F 10 45 04" );	// movss xmm0, [r13+4]
+				EmitString( "41 0F 2E 45 08" );		// ucomiss xmm0, [r13+8]
+				EmitJump( "0F 8A", v );				// jp
+				EmitJump( "0F 85", v );				// jne
+				break;
+			case OP_LTF:
+				EmitFloatBranch( qtrue, "0F 87" );	// ja
+				break;
+			case OP_LEF:
+				EmitFloatBranch( qtrue, "0F 83" );	// jae
+				break;
+			case OP_GTF:
+				EmitFloatBranch( qfalse, "0F 87" );	// ja
+				break;
+			case OP_GEF:
+				EmitFloatBranch( qfalse, "0F 83" );	// jae
+				break;
+
+			case OP_LOAD4:
+				EmitLoad( vm, "41 8B 04 04" );		// mov eax, [r12+rax]
+				break;
+			case OP_LOAD2:
+				EmitLoad( vm, "41 0F B7 04 04" );	// movzx eax, word ptr [r12+rax]
+				break;
+			case OP_LOAD1:
+				EmitLoad( vm, "41 0F B6 04 04" );	// movzx eax, byte ptr [r12+rax]
+				break;
+			case OP_STORE4:
+				EmitStore( vm->dataMask & ~3, "41 89 0C 04" );		// mov [r12+rax], ecx
+				break;
+			case OP_STORE2:
+				EmitStore( vm->dataMask & ~1, "66 41 89 0C 04" );	// mov [r12+rax], cx
+				break;
+			case OP_STORE1:
+				EmitStore( vm->dataMask, "41 88 0C 04" );			// mov [r12+rax], cl
+				break;
+
+			case OP_BLOCK_COPY:
+				v = Constant4();
+#ifdef _WIN32
+				EmitString( "41 8B 4D FC" );	// mov ecx, [r13-4]
+				EmitString( "41 8B 55 00" );	// mov edx, [r13]
+				EmitString( "41 B8" );			// mov r8d, count
+#else
+				EmitString( "41 8B 7D FC" );	// mov edi, [r13-4]
+				EmitString( "41 8B 75 00" );	// mov esi, [r13]
+				EmitString( "BA" );				// mov edx, count
+#endif
+				Emit4( v );
+				EmitCallC( (void *)VM_CompiledBlockCopy );
+				EmitString( "49 83 ED 08" );	// sub r13, 8
+				break;
+
+			case OP_SEX8:
+				EmitString( "41 0F BE 45 00" );	// movsx eax, byte ptr [r13]
+				EmitString( "41 89 45 00" );	// mov [r13], eax
+				break;
+			case OP_SEX16:
+				EmitString( "41 0F BF 45 00" );	// movsx eax, word ptr [r13]
+				EmitString( "41 89 45 00" );	// mov [r13], eax
+				break;
+
+			case OP_NEGI:
+				EmitString( "41 F7 5D 00" );	// neg dword ptr [r13]
+				break;
+			case OP_ADD:
+				EmitBinaryOp( "41 01 45 00" );	// add [r13], eax
+				break;
+			case OP_SUB:
+				EmitBinaryOp( "41 29 45 00" );	// sub [r13], eax
+				break;
+			case OP_DIVI:
+				EmitDivide( qtrue, qfalse );
+				break;
+			case OP_DIVU:
+				EmitDivide( qfalse, qfalse );
+				break;
+			case OP_MODI:
+				EmitDivide( qtrue, qtrue );
+				break;
+			case OP_MODU:
+				EmitDivide( qfalse, qtrue );
+				break;
+			case OP_MULI:
+			case OP_MULU:
+				EmitString( "41 8B 45 00" );	// mov eax, [r13]
+				EmitString( "49 83 ED 04" );	// sub r13, 4
+				EmitString( "41 0F AF 45 00" );	// imul eax, [r13]
+				EmitString( "41 89 45 00" );	// mov [r13], eax
+				break;
+
+			case OP_BAND:
+				EmitBinaryOp( "41 21 45 00" );	// and [r13], eax
+				break;
+			case OP_BOR:
+				EmitBinaryOp( "41 09 45 00" );	// or [r13], eax
+				break;
+			case OP_BXOR:
+				EmitBinaryOp( "41 31 45 00" );	// xor [r13], eax
+				break;
+			case OP_BCOM:
+				EmitString( "41 F7 55 00" );	// not dword ptr [r13]
+				break;
+
+			case OP_LSH:
+				EmitString( "41 8B 4D 00" );	// mov ecx, [r13]
+				EmitString( "49 83 ED 04" );	// sub r13, 4
+				EmitString( "41 D3 65 00" );	// shl dword ptr [r13], cl
+				break;
+			case OP_RSHI:
+				EmitString( "41 8B 4D 00" );	// mov ecx, [r13]
+				EmitString( "49 83 ED 04" );	// sub r13, 4
+				EmitString( "41 D3 7D 00" );	// sar dword ptr [r13], cl
+				break;
+			case OP_RSHU:
+				EmitString( "41 8B 4D 00" );	// mov ecx, [r13]
+				EmitString( "49 83 ED 04" );	// sub r13, 4
+				EmitString( "41 D3 6D 00" );	// shr dword ptr [r13], cl
+				break;
+
+			case OP_NEGF:
+				EmitString( "41 81 75 00" );	// xor dword ptr [r13], 0x80000000
+				Emit4( 0x80000000 );
+				break;
+			case OP_ADDF:
+				EmitFloatOp( "F3 41 0F 58 45 04" );	// addss xmm0, [r13+4]
+				break;
+			case OP_SUBF:
+				EmitFloatOp( "F3 41 0F 5C 45 04" );	// subss xmm0, [r13+4]
+				break;
+			case OP_DIVF:
+				EmitFloatOp( "F3 41 0F 5E 45 04" );	// divss xmm0, [r13+4]
+				break;
+			case OP_MULF:
+				EmitFloatOp( "F3 41 0F 59 45 04" );	// mulss xmm0, [r13+4]
+				break;
+
+			case OP_CVIF:
+				EmitString( "F3 41 0F 2A 45 00" );	// cvtsi2ss xmm0, dword ptr [r13]
+				EmitString( "F3 41 0F 11 45 00" );	// movss [r13], xmm0
+				break;
+			case OP_CVFI:
+				EmitString( "F3 41 0F 2C 45 00" );	// cvttss2si eax, dword ptr [r13]
+				EmitString( "41 89 45 00" );		// mov [r13], eax
+				break;
+
+			default:
+				Com_Error( ERR_DROP, "VM_CompileX64: bad opcode %i at offset %i", op, pc );
+			}
+		}
+	}
+
+	// copy to an exact size block that can be made executable
+#ifdef _WIN32
+	exec = (byte *)VirtualAlloc( NULL, compiledOfs, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+	if ( !exec ) {
+		Com_Error( ERR_FATAL, "VM_CompileX64: VirtualAlloc failed" );
+	}
+#else
+	exec = (byte *)mmap( NULL, compiledOfs, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( exec == (byte *)MAP_FAILED ) {
+		Com_Error( ERR_FATAL, "VM_CompileX64: mmap failed" );
+	}
+#endif
+	Com_Memcpy( exec, buf, compiledOfs );
+	Z_Free( buf );
+	buf = NULL;
+
+#ifdef _WIN32
+	{
+		DWORD	oldProtect;
+
+		if ( !VirtualProtect( exec, compiledOfs, PAGE_EXECUTE_READ, &oldProtect ) ) {
+			Com_Error( ERR_FATAL, "VM_CompileX64: VirtualProtect failed" );
+		}
+	}
+#else
+	if ( mprotect( exec, compiledOfs, PROT_READ | PROT_EXEC ) < 0 ) {
+		Com_Error( ERR_FATAL, "VM_CompileX64: mprotect failed to change PROT_EXEC" );
+	}
+#endif
+
+	vm->codeBase = exec;
+	vm->codeLength = compiledOfs;
+	Com_Printf( "VM file %s compiled to %i bytes of code\n", vm->name, compiledOfs );
+}
+
+/*
+=================
+VM_FreeCompiled
+=================
+*/
+void VM_FreeCompiled( vm_t *vm ) {
+	if ( !vm->codeBase ) {
+		return;
+	}
+#ifdef _WIN32
+	VirtualFree( vm->codeBase, 0, MEM_RELEASE );
+#else
+	munmap( vm->codeBase, vm->codeLength );
+#endif
+	vm->codeBase = NULL;
+}
+
+/*
+==============
+VM_CallCompiled
+==============
+*/
+int	VM_CallCompiled( vm_t *vm, int *args ) {
+	int				stack[ OPSTACK_GUARD + OPSTACK_SIZE + 1 + OPSTACK_GUARD ];
+	vmCallFrame_t	frame;
+	int				programStack;
+	int				stackOnEntry;
+	byte			*image;
+
+	currentVM = vm;
+
+	vm->currentlyInterpreting = qtrue;
+
+	// we might be called recursively, so this might not be the very top
+	programStack = vm->programStack;
+	stackOnEntry = programStack;
+
+	// set up the stack frame
+	image = vm->dataBase;
+
+	programStack -= 48;
+
+	*(int *)&image[ programStack + 44] = args[9];
+	*(int *)&image[ programStack + 40] = args[8];
+	*(int *)&image[ programStack + 36] = args[7];
+	*(int *)&image[ programStack + 32] = args[6];
+	*(int *)&image[ programStack + 28] = args[5];
+	*(int *)&image[ programStack + 24] = args[4];
+	*(int *)&image[ programStack + 20] = args[3];
+	*(int *)&image[ programStack + 16] = args[2];
+	*(int *)&image[ programStack + 12] = args[1];
+	*(int *)&image[ programStack + 8 ] = args[0];
+	*(int *)&image[ programStack + 4 ] = 0;	// return stack
+	*(int *)&image[ programStack ] = -1;	// will terminate the loop on return
+
+	frame.dataBase = image;
+	frame.opStack = &stack[ OPSTACK_GUARD ];
+	frame.instructionPointers = vm->instructionPointers;
+	frame.codeBase = vm->codeBase;
+	frame.opStackBase = &stack[ OPSTACK_GUARD ];
+	frame.programStack = programStack;
+
+	// off we go into generated code...
+	((vmEntryStub_t)vm->codeBase)( &frame );
+
+	if ( frame.opStack != &stack[ OPSTACK_GUARD + 1 ] ) {
+		Com_Error( ERR_DROP, "opStack corrupted in compiled code" );
+	}
+	if ( frame.programStack != stackOnEntry - 48 ) {
+		Com_Error( ERR_DROP, "programStack corrupted in compiled code" );
+	}
+
+	vm->programStack = stackOnEntry;
+	vm->currentlyInterpreting = qfalse;
+
+	return stack[ OPSTACK_GUARD + 1 ];
+}
+
+#endif // __x86_64__ || _M_X64
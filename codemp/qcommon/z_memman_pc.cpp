@@ -24,8 +24,19 @@ void CIN_CloseAllVideos();
 
 // This handles zone memory allocation.
 // It is a wrapper around malloc with a tag id and a magic number at the start
+//
+// Blocks are kept on one list per tag, so freeing a tag only visits that tag's blocks.
+//	Bulk tags that are normally thrown away wholesale (hunk, bsp) are bump-allocated
+//	out of per-tag arenas instead, and Z_TagFree just hands the arenas back to the system.
+//	Models stay on malloc, the model cache keeps some of them across levels and a single
+//	survivor would pin its whole arena.
 
 #define ZONE_MAGIC			0x21436587
+#define ZONE_FREE_MAGIC		0x78563412	// arena block that's been Z_Free'd, space comes back with the arena
+
+#define ZONE_ARENA_SIZE		(1024*1024)
+#define ZONE_ARENA_MAXBLOCK	(ZONE_ARENA_SIZE/4)	// anything bigger gets a malloc of its own
+#define ZONE_ARENA_ALIGN	16
 
 typedef struct zoneHeader_s
 {
@@ -34,8 +45,20 @@ typedef struct zoneHeader_s
 		int					iSize;
 struct	zoneHeader_s		*pNext;
 struct	zoneHeader_s		*pPrev;
+struct	zoneArena_s			*pArena;	// NULL if this block was malloc'd on its own
 } zoneHeader_t;
 
+typedef struct zoneArena_s
+{
+struct	zoneArena_s			*pNext;
+		memtag_t			eTag;
+		int					iUsed;		// bump offset into the block space
+		int					iLive;		// blocks not yet Z_Free'd
+//		byte				blocks[ZONE_ARENA_SIZE];	// starts ZONE_ARENA_HEADERSIZE in
+} zoneArena_t;
+
+#define ZONE_ARENA_HEADERSIZE	((sizeof(zoneArena_t) + (ZONE_ARENA_ALIGN-1)) & ~(ZONE_ARENA_ALIGN-1))
+
 typedef struct 
 {
 	int iMagic;
@@ -58,6 +81,9 @@ typedef struct zoneStats_s
 	int		iCurrent;
 	int		iPeak;
 
+	int		iArenaCount;
+	int		iArenaPeak;
+
 	// I'm keeping these updated on the fly, since it's quicker for cache-pool
 	//	purposes rather than recalculating each time...
 	//
@@ -69,15 +95,70 @@ typedef struct zoneStats_s
 typedef struct zone_s
 {
 	zoneStats_t				Stats;
-	zoneHeader_t			Header;
+	zoneHeader_t			Headers[TAG_COUNT];	// list heads for the individually malloc'd blocks
+	zoneArena_t				*pArenas[TAG_COUNT];	// newest (ie the one being bumped) first
 } zone_t;
 
 cvar_t	*com_validateZone;
+cvar_t	*com_zoneArenas;
 
 zone_t	TheZone = {0};
 
+static qboolean gbZoneArenas = qfalse;
+
+
+static inline byte *ZoneArenaBlocks(zoneArena_t *pArena)
+{
+	return (byte*) pArena + ZONE_ARENA_HEADERSIZE;
+}
+
+// total footprint of an arena block, header and tail included
+//
+static inline int ZoneArenaStride(int iSize)
+{
+	return (sizeof(zoneHeader_t) + iSize + sizeof(zoneTail_t) + (ZONE_ARENA_ALIGN-1)) & ~(ZONE_ARENA_ALIGN-1);
+}
+
+static inline qboolean Zone_TagUsesArena(memtag_t eTag)
+{
+	switch (eTag)
+	{
+	case TAG_HUNK_MARK1:
+	case TAG_HUNK_MARK2:
+	case TAG_BSP:
+	case TAG_GRIDMESH:
+		return gbZoneArenas;
+	default:
+		return qfalse;
+	}
+}
+
+static void Zone_ValidateBlock(zoneHeader_t *pMemory)
+{
+	#ifdef DETAILED_ZONE_DEBUG_CODE
+	// this won't happen here, but wtf?
+	int& iAllocCount = mapAllocatedZones[pMemory];
+	if (iAllocCount <= 0)
+	{
+		Com_Error(ERR_FATAL, "Z_Validate(): Bad block allocation count!");
+		return;
+	}		   
+	#endif
+
+	if(pMemory->iMagic != ZONE_MAGIC)
+	{
+		Com_Error(ERR_FATAL, "Z_Validate(): Corrupt zone header!");
+		return;
+	}
 
-// Scans through the linked list of mallocs and makes sure no data has been overwritten
+	if (ZoneTailFromHeader(pMemory)->iMagic != ZONE_MAGIC)
+	{
+		Com_Error(ERR_FATAL, "Z_Validate(): Corrupt zone tail!");
+		return;
+	}
+}
+
+// Scans through the linked lists of mallocs and the arenas and makes sure no data has been overwritten
 
 void Z_Validate(void)
 {	
@@ -86,32 +167,33 @@ void Z_Validate(void)
 		return;
 	}
 
-	zoneHeader_t *pMemory = TheZone.Header.pNext;
-	while (pMemory)
+	for (int i=0; i<TAG_COUNT; i++)
 	{
-		#ifdef DETAILED_ZONE_DEBUG_CODE
-		// this won't happen here, but wtf?
-		int& iAllocCount = mapAllocatedZones[pMemory];
-		if (iAllocCount <= 0)
-		{
-			Com_Error(ERR_FATAL, "Z_Validate(): Bad block allocation count!");
-			return;
-		}		   
-		#endif
-
-		if(pMemory->iMagic != ZONE_MAGIC)
+		zoneHeader_t *pMemory = TheZone.Headers[i].pNext;
+		while (pMemory)
 		{
-			Com_Error(ERR_FATAL, "Z_Validate(): Corrupt zone header!");
-			return;
+			Zone_ValidateBlock(pMemory);
+			pMemory = pMemory->pNext;
 		}
 
-		if (ZoneTailFromHeader(pMemory)->iMagic != ZONE_MAGIC)
+		for (zoneArena_t *pArena = TheZone.pArenas[i]; pArena; pArena = pArena->pNext)
 		{
-			Com_Error(ERR_FATAL, "Z_Validate(): Corrupt zone tail!");
-			return;
+			int iOffset = 0;
+			while (iOffset < pArena->iUsed)
+			{
+				pMemory = (zoneHeader_t *) (ZoneArenaBlocks(pArena) + iOffset);
+				if (pMemory->iMagic != ZONE_FREE_MAGIC)
+				{
+					Zone_ValidateBlock(pMemory);
+				}
+				if (pMemory->pArena != pArena)
+				{
+					Com_Error(ERR_FATAL, "Z_Validate(): Corrupt zone arena!");
+					return;
+				}
+				iOffset += ZoneArenaStride(pMemory->iSize);
+			}
 		}
-		
-		pMemory = pMemory->pNext;
 	}
 }
 				
@@ -137,40 +219,29 @@ typedef struct
 #pragma pack(pop)
 
 StaticZeroMem_t gZeroMalloc  =
-	{ {ZONE_MAGIC, TAG_STATIC,0,NULL,NULL},{ZONE_MAGIC}};
+	{ {ZONE_MAGIC, TAG_STATIC,0,NULL,NULL,NULL},{ZONE_MAGIC}};
 StaticMem_t gEmptyString =
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'\0','\0',{ZONE_MAGIC}};
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'\0','\0',{ZONE_MAGIC}};
 StaticMem_t gNumberString[] = {
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'0','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'1','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'2','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'3','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'4','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'5','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'6','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'7','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'8','\0',{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},'9','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'0','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'1','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'2','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'3','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'4','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'5','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'6','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'7','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'8','\0',{ZONE_MAGIC}},
+	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL,NULL},'9','\0',{ZONE_MAGIC}},
 };
 
 qboolean gbMemFreeupOccured = qfalse;
-void *Z_Malloc(int iSize, memtag_t eTag, qboolean bZeroit /* = qfalse */, int iUnusedAlign /* = 4 */)
-{	
-	gbMemFreeupOccured = qfalse;
 
-	if (iSize == 0)
-	{
-		zoneHeader_t *pMemory = (zoneHeader_t *) &gZeroMalloc;
-		return &pMemory[1];
-	}
-
-	// Add in tracking info
-	//
-	int iRealSize = (iSize + sizeof(zoneHeader_t) + sizeof(zoneTail_t));
-
-	// Allocate a chunk...
-	//
-	zoneHeader_t *pMemory = NULL;
+// Gets memory from the system, dumping caches to make room if it has to...
+//
+static void *Zone_SysAlloc(int iRealSize, qboolean bZeroit, int iSize, memtag_t eTag)
+{
+	void *pMemory = NULL;
 	while (pMemory == NULL)
 	{
 		#ifdef _WIN32
@@ -181,9 +252,9 @@ void *Z_Malloc(int iSize, memtag_t eTag, qboolean bZeroit /* = qfalse */, int iU
 		#endif
 
 		if (bZeroit) {
-			pMemory = (zoneHeader_t *) calloc ( iRealSize, 1 );
+			pMemory = calloc ( iRealSize, 1 );
 		} else {
-			pMemory = (zoneHeader_t *) malloc ( iRealSize );
+			pMemory = malloc ( iRealSize );
 		}
 		if (!pMemory)
 		{
@@ -269,17 +340,87 @@ void *Z_Malloc(int iSize, memtag_t eTag, qboolean bZeroit /* = qfalse */, int iU
 		}
 	}
 
-	// Link in
+	return pMemory;
+}
+
+// Bumps a block out of the tag's current arena, starting a new arena if there's no room...
+//
+static zoneHeader_t *Zone_ArenaAlloc(int iSize, memtag_t eTag)
+{
+	int iStride = ZoneArenaStride(iSize);
+
+	zoneArena_t *pArena = TheZone.pArenas[eTag];
+	if (!pArena || pArena->iUsed + iStride > ZONE_ARENA_SIZE)
+	{
+		pArena = (zoneArena_t *) Zone_SysAlloc(ZONE_ARENA_HEADERSIZE + ZONE_ARENA_SIZE, qfalse, iSize, eTag);
+
+		// (re-read the list head, the freeup code in Zone_SysAlloc may have dumped this tag)
+		pArena->pNext	= TheZone.pArenas[eTag];
+		pArena->eTag	= eTag;
+		pArena->iUsed	= 0;
+		pArena->iLive	= 0;
+		TheZone.pArenas[eTag] = pArena;
+
+		TheZone.Stats.iArenaCount++;
+		if (TheZone.Stats.iArenaCount > TheZone.Stats.iArenaPeak)
+		{
+			TheZone.Stats.iArenaPeak = TheZone.Stats.iArenaCount;
+		}
+	}
+
+	zoneHeader_t *pMemory = (zoneHeader_t *) (ZoneArenaBlocks(pArena) + pArena->iUsed);
+	pArena->iUsed += iStride;
+	pArena->iLive++;
+
+	pMemory->pNext	= NULL;
+	pMemory->pPrev	= NULL;
+	pMemory->pArena = pArena;
+	return pMemory;
+}
+
+void *Z_Malloc(int iSize, memtag_t eTag, qboolean bZeroit /* = qfalse */, int iUnusedAlign /* = 4 */)
+{	
+	gbMemFreeupOccured = qfalse;
+
+	if (iSize == 0)
+	{
+		zoneHeader_t *pMemory = (zoneHeader_t *) &gZeroMalloc;
+		return &pMemory[1];
+	}
+
+	zoneHeader_t *pMemory;
+	if (Zone_TagUsesArena(eTag) && ZoneArenaStride(iSize) <= ZONE_ARENA_MAXBLOCK)
+	{
+		pMemory = Zone_ArenaAlloc(iSize, eTag);
+		if (bZeroit)
+		{
+			memset(&pMemory[1], 0, iSize);	// arena space gets reused after frees, so can't rely on it being clean
+		}
+	}
+	else
+	{
+		// Add in tracking info
+		//
+		int iRealSize = (iSize + sizeof(zoneHeader_t) + sizeof(zoneTail_t));
+
+		// Allocate a chunk...
+		//
+		pMemory = (zoneHeader_t *) Zone_SysAlloc(iRealSize, bZeroit, iSize, eTag);
+
+		// Link in
+		pMemory->pArena = NULL;
+		pMemory->pNext  = TheZone.Headers[eTag].pNext;
+		TheZone.Headers[eTag].pNext = pMemory;
+		if (pMemory->pNext)
+		{
+			pMemory->pNext->pPrev = pMemory;
+		}
+		pMemory->pPrev = &TheZone.Headers[eTag];
+	}
+
 	pMemory->iMagic	= ZONE_MAGIC;
 	pMemory->eTag	= eTag;
 	pMemory->iSize	= iSize;	
-	pMemory->pNext  = TheZone.Header.pNext;
-	TheZone.Header.pNext = pMemory;
-	if (pMemory->pNext)
-	{
-		pMemory->pNext->pPrev = pMemory;
-	}
-	pMemory->pPrev = &TheZone.Header;
 	//
 	// add tail...
 	//
@@ -320,6 +461,18 @@ void Z_MorphMallocTag( void *pvAddress, memtag_t eDesiredTag )
 		return;	// won't get here
 	}
 
+	if (pMemory->eTag == eDesiredTag)
+	{
+		return;
+	}
+
+	if (pMemory->pArena)
+	{
+		// the arena belongs to the old tag and would get freed out from under it
+		Com_Error(ERR_FATAL, "Z_MorphMallocTag(): Can't morph an arena block (TAG_%s)!", psTagStrings[pMemory->eTag]);
+		return;	// won't get here
+	}
+
 	// DEC existing tag stats...
 	//
 //	TheZone.Stats.iCurrent	- unchanged
@@ -327,9 +480,21 @@ void Z_MorphMallocTag( void *pvAddress, memtag_t eDesiredTag )
 	TheZone.Stats.iSizesPerTag	[pMemory->eTag] -= pMemory->iSize;
 	TheZone.Stats.iCountsPerTag	[pMemory->eTag]--;
 
-	// morph...
+	// morph, and move over to the new tag's list...
 	//
+	pMemory->pPrev->pNext = pMemory->pNext;
+	if (pMemory->pNext)
+	{
+		pMemory->pNext->pPrev = pMemory->pPrev;
+	}
 	pMemory->eTag = eDesiredTag;
+	pMemory->pNext = TheZone.Headers[eDesiredTag].pNext;
+	TheZone.Headers[eDesiredTag].pNext = pMemory;
+	if (pMemory->pNext)
+	{
+		pMemory->pNext->pPrev = pMemory;
+	}
+	pMemory->pPrev = &TheZone.Headers[eDesiredTag];
 
 	// INC new tag stats...
 	//
@@ -339,6 +504,46 @@ void Z_MorphMallocTag( void *pvAddress, memtag_t eDesiredTag )
 	TheZone.Stats.iCountsPerTag	[pMemory->eTag]++;
 }
 
+static void Zone_FreeArena(zoneArena_t *pArena)
+{
+	free (pArena);
+	TheZone.Stats.iArenaCount--;
+}
+
+// Arena blocks just get marked as free. Their space comes back if they were the last block bumped,
+//	and the whole arena goes once every block in it has been freed...
+//
+static void Zone_FreeArenaBlock(zoneHeader_t *pMemory)
+{
+	zoneArena_t *pArena = pMemory->pArena;
+	int iOffset = (byte*)pMemory - ZoneArenaBlocks(pArena);
+
+	pMemory->iMagic = ZONE_FREE_MAGIC;
+
+	if (iOffset + ZoneArenaStride(pMemory->iSize) == pArena->iUsed)
+	{
+		pArena->iUsed = iOffset;
+	}
+
+	if (--pArena->iLive == 0)
+	{
+		zoneArena_t **ppArena = &TheZone.pArenas[pArena->eTag];
+		if (*ppArena == pArena)
+		{
+			pArena->iUsed = 0;	// still the one being bumped, so keep it
+		}
+		else
+		{
+			while (*ppArena != pArena)
+			{
+				ppArena = &(*ppArena)->pNext;
+			}
+			*ppArena = pArena->pNext;
+			Zone_FreeArena(pArena);
+		}
+	}
+}
+
 static void Zone_FreeBlock(zoneHeader_t *pMemory)
 {
 	if (pMemory->eTag != TAG_STATIC)	// belt and braces, should never hit this though
@@ -350,19 +555,26 @@ static void Zone_FreeBlock(zoneHeader_t *pMemory)
 		TheZone.Stats.iSizesPerTag	[pMemory->eTag] -= pMemory->iSize;
 		TheZone.Stats.iCountsPerTag	[pMemory->eTag]--;
 
-		// Sanity checks...
-		//
-		assert(pMemory->pPrev->pNext == pMemory);
-		assert(!pMemory->pNext || (pMemory->pNext->pPrev == pMemory));
-
-		// Unlink and free...
-		//
-		pMemory->pPrev->pNext = pMemory->pNext;
-		if(pMemory->pNext)
+		if (pMemory->pArena)
 		{
-			pMemory->pNext->pPrev = pMemory->pPrev;
+			Zone_FreeArenaBlock(pMemory);
+		}
+		else
+		{
+			// Sanity checks...
+			//
+			assert(pMemory->pPrev->pNext == pMemory);
+			assert(!pMemory->pNext || (pMemory->pNext->pPrev == pMemory));
+
+			// Unlink and free...
+			//
+			pMemory->pPrev->pNext = pMemory->pNext;
+			if(pMemory->pNext)
+			{
+				pMemory->pNext->pPrev = pMemory->pPrev;
+			}
+			free (pMemory);
 		}
-		free (pMemory);
 
 		
 		#ifdef DETAILED_ZONE_DEBUG_CODE
@@ -448,6 +660,49 @@ int Z_MemSize(memtag_t eTag)
 	return TheZone.Stats.iSizesPerTag[eTag];
 }
 
+static void Zone_FreeTag(memtag_t eTag)
+{
+	zoneHeader_t *pMemory = TheZone.Headers[eTag].pNext;
+	while (pMemory)
+	{
+		zoneHeader_t *pNext = pMemory->pNext;
+		Zone_FreeBlock(pMemory);
+		pMemory = pNext;
+	}
+
+	zoneArena_t *pArena = TheZone.pArenas[eTag];
+	if (pArena)
+	{
+		// everything the tag has left lives in its arenas, so the stats can go in one hit...
+		//
+		TheZone.Stats.iCount	-= TheZone.Stats.iCountsPerTag[eTag];
+		TheZone.Stats.iCurrent	-= TheZone.Stats.iSizesPerTag [eTag];
+		TheZone.Stats.iCountsPerTag[eTag] = 0;
+		TheZone.Stats.iSizesPerTag [eTag] = 0;
+
+		while (pArena)
+		{
+			zoneArena_t *pNext = pArena->pNext;
+
+			#ifdef DETAILED_ZONE_DEBUG_CODE
+			for (int iOffset = 0; iOffset < pArena->iUsed; )
+			{
+				pMemory = (zoneHeader_t *) (ZoneArenaBlocks(pArena) + iOffset);
+				if (pMemory->iMagic == ZONE_MAGIC)
+				{
+					mapAllocatedZones[pMemory]--;
+				}
+				iOffset += ZoneArenaStride(pMemory->iSize);
+			}
+			#endif
+
+			Zone_FreeArena(pArena);
+			pArena = pNext;
+		}
+		TheZone.pArenas[eTag] = NULL;
+	}
+}
+
 // Frees all blocks with the specified tag...
 //
 void Z_TagFree(memtag_t eTag)
@@ -456,15 +711,16 @@ void Z_TagFree(memtag_t eTag)
 //	int iZoneBlocks = TheZone.Stats.iCount;
 //#endif
 
-	zoneHeader_t *pMemory = TheZone.Header.pNext;
-	while (pMemory)
+	if (eTag == TAG_ALL)
 	{
-		zoneHeader_t *pNext = pMemory->pNext;
-		if ( (eTag == TAG_ALL) || (pMemory->eTag == eTag))
+		for (int i=0; i<TAG_COUNT; i++)
 		{
-			Zone_FreeBlock(pMemory);
+			Zone_FreeTag((memtag_t)i);
 		}
-		pMemory = pNext;
+	}
+	else
+	{
+		Zone_FreeTag(eTag);
 	}
 
 // these stupid pragmas don't work here???!?!?!
@@ -519,6 +775,11 @@ static void Z_Stats_f(void)
 									TheZone.Stats.iPeak, 
 									         (float)TheZone.Stats.iPeak / 1024.0f / 1024.0f
 				);
+
+	if (gbZoneArenas)
+	{
+		Com_Printf("%d arenas of %dKB in use, peaked at %d\n", TheZone.Stats.iArenaCount, ZONE_ARENA_SIZE / 1024, TheZone.Stats.iArenaPeak);
+	}
 }
 
 // Gives a detailed breakdown of the memory blocks in the zone
@@ -577,7 +838,10 @@ void Com_ShutdownZoneMemory(void)
 void Com_InitZoneMemory( void ) 
 {
 	memset(&TheZone, 0, sizeof(TheZone)); 
-	TheZone.Header.iMagic = ZONE_MAGIC;
+	for (int i=0; i<TAG_COUNT; i++)
+	{
+		TheZone.Headers[i].iMagic = ZONE_MAGIC;
+	}
 
 //#ifdef _DEBUG
 //	com_validateZone = Cvar_Get("com_validateZone", "1", 0);
@@ -585,6 +849,11 @@ void Com_InitZoneMemory( void )
 	com_validateZone = Cvar_Get("com_validateZone", "0", 0);
 //#endif
 
+	// this has to be known before the first alloc, so pick it up off the command line now
+	Com_StartupVariable("com_zoneArenas");
+	com_zoneArenas = Cvar_Get("com_zoneArenas", "1", CVAR_INIT);
+	gbZoneArenas = (qboolean)!!com_zoneArenas->integer;
+
 	Cmd_AddCommand("zone_stats", Z_Stats_f);
 	Cmd_AddCommand("zone_details", Z_Details_f);
 
@@ -643,16 +912,27 @@ void Com_TouchMemory( void ) {
 
 	sum = 0;
 
-	zoneHeader_t *pMemory = TheZone.Header.pNext;
-	while (pMemory)
+	for (int iTag=0; iTag<TAG_COUNT; iTag++)
 	{
-		byte *pMem = (byte *) &pMemory[1];
-		j = pMemory->iSize >> 2;
-		for (i=0; i<j; i+=64){
-			sum += ((int*)pMem)[i];
+		zoneHeader_t *pMemory = TheZone.Headers[iTag].pNext;
+		while (pMemory)
+		{
+			byte *pMem = (byte *) &pMemory[1];
+			j = pMemory->iSize >> 2;
+			for (i=0; i<j; i+=64){
+				sum += ((int*)pMem)[i];
+			}
+			
+			pMemory = pMemory->pNext;
+		}
+
+		for (zoneArena_t *pArena = TheZone.pArenas[iTag]; pArena; pArena = pArena->pNext)
+		{
+			j = pArena->iUsed >> 2;
+			for (i=0; i<j; i+=64){
+				sum += ((int*)ZoneArenaBlocks(pArena))[i];
+			}
 		}
-		
-		pMemory = pMemory->pNext;
 	}
 
 //	end = Sys_Milliseconds();
@@ -108,6 +108,8 @@ qboolean G2_SetupModelPointers(CGhoul2Info_v &ghoul2);
 
 extern cvar_t	*r_Ghoul2AnimSmooth;
 extern cvar_t	*r_Ghoul2UnSqashAfterSmooth;
+extern cvar_t	*r_ghoul2BatchSkin;
+extern cvar_t	*r_ghoul2SkinCheck;
 
 static inline int G2_Find_Bone_ByNum(const model_t *mod, boneInfo_v &blist, const int boneNum)
 {
@@ -1161,6 +1163,110 @@ static int G2_GetBonePoolIndex(	const mdxaHeader_t *pMDXAHeader, int iFrame, int
 	MC_UnCompressQuat(mat, pCompBonePool[ G2_GetBonePoolIndex( pMDXAHeader, iFrame, iBoneIndex ) ].Comp);
 }
 
+/*
+==============================================================================
+
+Decompressed pose cache
+
+Every entity playing the same animation decompresses the same bones of the
+same frames, and the server's players and NPCs nearly all share _humanoid.
+Decompressed matrices are kept here keyed by (mdxa, frame, bone), in sets of
+G2_POSE_WAYS with the least recently used entry in a set the one replaced.
+Loading an mdxa bumps the generation, which forgets everything, so a new
+animation file landing where a freed one was can't be mistaken for it.
+
+==============================================================================
+*/
+
+#define G2_POSE_SETS	2048	// power of two
+#define G2_POSE_WAYS	4
+
+typedef struct {
+	const mdxaHeader_t	*header;
+	int					frame;
+	int					bone;
+	int					generation;
+	unsigned			lastUsed;
+	mdxaBone_t			matrix;
+} g2PoseEntry_t;
+
+static g2PoseEntry_t	g2PoseCache[G2_POSE_SETS][G2_POSE_WAYS];
+static int				g2PoseGeneration = 1;
+static unsigned			g2PoseClock;
+static int				g2PoseHits, g2PoseMisses;
+
+extern cvar_t	*r_ghoul2PoseCache;
+
+// called whenever an mdxa is loaded or freed
+void G2_ForgetPoseCache(void)
+{
+	g2PoseGeneration++;
+}
+
+static void G2_CachedUnCompressBone(float mat[3][4], int iBoneIndex, const mdxaHeader_t *pMDXAHeader, int iFrame)
+{
+	g2PoseEntry_t	*set, *oldest, *stale;
+	unsigned		hash;
+	int				i;
+
+	if (r_ghoul2PoseCache && !r_ghoul2PoseCache->integer)
+	{
+		UnCompressBone(mat, iBoneIndex, pMDXAHeader, iFrame);
+		return;
+	}
+
+	hash = (unsigned)((size_t)pMDXAHeader >> 4) * 2654435761u;
+	hash ^= (unsigned)iFrame * 40503u + (unsigned)iBoneIndex * 97u;
+	set = g2PoseCache[(hash ^ (hash >> 16)) & (G2_POSE_SETS - 1)];
+	g2PoseClock++;
+
+	oldest = set;
+	stale = NULL;
+	for (i = 0; i < G2_POSE_WAYS; i++)
+	{
+		g2PoseEntry_t *e = &set[i];
+
+		if (e->generation == g2PoseGeneration && e->header == pMDXAHeader && e->frame == iFrame && e->bone == iBoneIndex)
+		{
+			e->lastUsed = g2PoseClock;
+			memcpy(mat, e->matrix.matrix, sizeof(e->matrix.matrix));
+			g2PoseHits++;
+			return;
+		}
+		if (e->generation != g2PoseGeneration)
+		{
+			stale = e;
+		}
+		else if (oldest->lastUsed > e->lastUsed)
+		{
+			oldest = e;
+		}
+	}
+
+	UnCompressBone(mat, iBoneIndex, pMDXAHeader, iFrame);
+	g2PoseMisses++;
+
+	if (stale)
+	{
+		oldest = stale;
+	}
+
+	oldest->header = pMDXAHeader;
+	oldest->frame = iFrame;
+	oldest->bone = iBoneIndex;
+	oldest->generation = g2PoseGeneration;
+	oldest->lastUsed = g2PoseClock;
+	memcpy(oldest->matrix.matrix, mat, sizeof(oldest->matrix.matrix));
+}
+
+void G2_PoseCacheInfo(void)
+{
+	const int total = g2PoseHits + g2PoseMisses;
+
+	Com_Printf("Ghoul2 pose cache: %i lookups, %i hits (%i%%), %i entries\n",
+		total, g2PoseHits, total ? (int)(100.0f * g2PoseHits / total) : 0, G2_POSE_SETS * G2_POSE_WAYS);
+}
+
 #define DEBUG_G2_TIMING (0)
 #define DEBUG_G2_TIMING_RENDER_ONLY (1)
 
@@ -1461,7 +1567,7 @@ void G2_RagGetAnimMatrix(CGhoul2Info &ghoul2, const int boneNum, mdxaBone_t &mat
 	}
 
 	//get the base matrix for the specified frame
-	UnCompressBone(animMatrix.matrix, boneNum, ghoul2.mBoneCache->header, frame);
+	G2_CachedUnCompressBone(animMatrix.matrix, boneNum, ghoul2.mBoneCache->header, frame);
 
 	parent = skel->parent;
 	if (boneNum > 0 && parent > -1)
@@ -1704,8 +1810,8 @@ void G2_TransformBone (int child,CBoneCache &BC)
 		
 // 		MC_UnCompress(tbone[3].matrix,compBonePointer[bFrame->boneIndexes[child]].Comp);
 // 		MC_UnCompress(tbone[4].matrix,compBonePointer[boldFrame->boneIndexes[child]].Comp);
-		UnCompressBone(tbone[3].matrix, child, BC.header, TB.blendFrame);
-		UnCompressBone(tbone[4].matrix, child, BC.header, TB.blendOldFrame);
+		G2_CachedUnCompressBone(tbone[3].matrix, child, BC.header, TB.blendFrame);
+		G2_CachedUnCompressBone(tbone[4].matrix, child, BC.header, TB.blendOldFrame);
 
 		for ( j = 0 ; j < 12 ; j++ ) 
 		{
@@ -1720,7 +1826,7 @@ void G2_TransformBone (int child,CBoneCache &BC)
   	if (!TB.backlerp)
   	{
 // 		MC_UnCompress(tbone[2].matrix,compBonePointer[aoldFrame->boneIndexes[child]].Comp);
-		UnCompressBone(tbone[2].matrix, child, BC.header, TB.currentFrame);
+		G2_CachedUnCompressBone(tbone[2].matrix, child, BC.header, TB.currentFrame);
 
 		// blend in the other frame if we need to
 		if (TB.blendMode)
@@ -1744,8 +1850,8 @@ void G2_TransformBone (int child,CBoneCache &BC)
 		float frontlerp = 1.0 - TB.backlerp;
 // 		MC_UnCompress(tbone[0].matrix,compBonePointer[aFrame->boneIndexes[child]].Comp);
 //		MC_UnCompress(tbone[1].matrix,compBonePointer[aoldFrame->boneIndexes[child]].Comp);
-		UnCompressBone(tbone[0].matrix, child, BC.header, TB.newFrame);
-		UnCompressBone(tbone[1].matrix, child, BC.header, TB.currentFrame);		
+		G2_CachedUnCompressBone(tbone[0].matrix, child, BC.header, TB.newFrame);
+		G2_CachedUnCompressBone(tbone[1].matrix, child, BC.header, TB.currentFrame);		
 
 		for ( j = 0 ; j < 12 ; j++ ) 
 		{
@@ -3623,6 +3729,419 @@ void G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool ch
 #endif
 }	
 
+#ifndef _XBOX
+/*
+==============================================================================
+
+Batched skinning
+
+RB_SurfaceGhoul and the collision code skin a vertex at a time, branching on
+how many weights it has and fetching its bones again for every weight.  When
+an mdxm loads, each surface's verts are also repacked as separate arrays per
+component, grouped by weight count, and padded to fours.  G2_SkinBatch then
+runs every group with no per-vertex branches, four verts at a time with SSE
+where the compiler has it.  The operations are done in the same order as the
+per-vertex loops, which stay as the reference.  r_ghoul2BatchSkin 0 goes
+back to those loops, and r_ghoul2SkinCheck renders with them while comparing
+the batched result.
+
+==============================================================================
+*/
+
+#if !defined(_XBOX) && (defined(_M_IX86) || defined(_M_X64) || defined(__SSE__))
+#define G2_SSE_SKIN
+#include <xmmintrin.h>
+#endif
+
+#define G2_SKIN_LANES	4
+
+typedef struct g2SkinSurface_s {
+	int			bucketEnd[iMAX_G2_BONEWEIGHTS_PER_VERT];	// verts with b+1 weights end here, each a multiple of G2_SKIN_LANES
+	short		*index;										// which of the surface's verts, NULL if it isn't batched
+	float		*pos[3];
+	float		*normal[3];
+	float		*weight[iMAX_G2_BONEWEIGHTS_PER_VERT];		// the last one is what the others leave, as G2_GetVertBoneWeight has it
+	byte		*bone[iMAX_G2_BONEWEIGHTS_PER_VERT];		// into the surface's bone references
+} g2SkinSurface_t;
+
+#ifdef G2_SSE_SKIN
+typedef __m128 g2Lanes_t;
+#define G2L_Load(p)			_mm_load_ps(p)
+#define G2L_Set(a,b,c,d)	_mm_setr_ps(a,b,c,d)
+#define G2L_Splat(a)		_mm_set1_ps(a)
+#define G2L_Add(a,b)		_mm_add_ps(a,b)
+#define G2L_Sub(a,b)		_mm_sub_ps(a,b)
+#define G2L_Mul(a,b)		_mm_mul_ps(a,b)
+#define G2L_Store(p,a)		_mm_storeu_ps(p,a)
+#else
+typedef struct { float v[G2_SKIN_LANES]; } g2Lanes_t;
+
+static inline g2Lanes_t G2L_Load(const float *p) { g2Lanes_t r; r.v[0]=p[0]; r.v[1]=p[1]; r.v[2]=p[2]; r.v[3]=p[3]; return r; }
+static inline g2Lanes_t G2L_Set(float a, float b, float c, float d) { g2Lanes_t r; r.v[0]=a; r.v[1]=b; r.v[2]=c; r.v[3]=d; return r; }
+static inline g2Lanes_t G2L_Splat(float a) { return G2L_Set(a, a, a, a); }
+static inline g2Lanes_t G2L_Add(g2Lanes_t a, g2Lanes_t b) { g2Lanes_t r; r.v[0]=a.v[0]+b.v[0]; r.v[1]=a.v[1]+b.v[1]; r.v[2]=a.v[2]+b.v[2]; r.v[3]=a.v[3]+b.v[3]; return r; }
+static inline g2Lanes_t G2L_Sub(g2Lanes_t a, g2Lanes_t b) { g2Lanes_t r; r.v[0]=a.v[0]-b.v[0]; r.v[1]=a.v[1]-b.v[1]; r.v[2]=a.v[2]-b.v[2]; r.v[3]=a.v[3]-b.v[3]; return r; }
+static inline g2Lanes_t G2L_Mul(g2Lanes_t a, g2Lanes_t b) { g2Lanes_t r; r.v[0]=a.v[0]*b.v[0]; r.v[1]=a.v[1]*b.v[1]; r.v[2]=a.v[2]*b.v[2]; r.v[3]=a.v[3]*b.v[3]; return r; }
+static inline void G2L_Store(float *p, g2Lanes_t a) { p[0]=a.v[0]; p[1]=a.v[1]; p[2]=a.v[2]; p[3]=a.v[3]; }
+#endif
+
+static void G2_FillSkinLane(g2SkinSurface_t *ss, int lane, const mdxmVertex_t *v, int index)
+{
+	const int	iNumWeights = G2_GetVertWeights( v );
+	float		fTotalWeight = 0.0f;
+	int			k;
+
+	ss->index[lane] = index;
+	for (k = 0; k < 3; k++)
+	{
+		ss->pos[k][lane] = v->vertCoords[k];
+		ss->normal[k][lane] = v->normal[k];
+	}
+	for (k = 0; k < iNumWeights; k++)
+	{
+		ss->bone[k][lane] = G2_GetVertBoneIndex( v, k );
+		ss->weight[k][lane] = G2_GetVertBoneWeight( v, k, fTotalWeight, iNumWeights );
+	}
+}
+
+static void G2_BuildSkinSurface(const mdxmSurface_t *surface, g2SkinSurface_t *ss)
+{
+	const mdxmVertex_t	*v = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
+	int					count[iMAX_G2_BONEWEIGHTS_PER_VERT];
+	int					i, k, b, total, lane, last;
+	byte				*mem;
+
+	memset(ss, 0, sizeof(*ss));
+	if (surface->numVerts <= 0 || surface->numBoneReferences > iMAX_G2_BONEREFS_PER_SURFACE)
+	{
+		return;
+	}
+
+	memset(count, 0, sizeof(count));
+	for (i = 0; i < surface->numVerts; i++)
+	{
+		const int iNumWeights = G2_GetVertWeights( &v[i] );
+
+		if (iNumWeights < 1 || iNumWeights > iMAX_G2_BONEWEIGHTS_PER_VERT)
+		{
+			return;
+		}
+		for (k = 0; k < iNumWeights; k++)
+		{
+			if (G2_GetVertBoneIndex( &v[i], k ) >= surface->numBoneReferences)
+			{
+				return;
+			}
+		}
+		count[iNumWeights - 1]++;
+	}
+
+	total = 0;
+	for (b = 0; b < iMAX_G2_BONEWEIGHTS_PER_VERT; b++)
+	{
+		total += (count[b] + G2_SKIN_LANES - 1) & ~(G2_SKIN_LANES - 1);
+		ss->bucketEnd[b] = total;
+	}
+
+	// every float array is a multiple of four long, so aligning the first aligns them all
+	mem = (byte *)Hunk_Alloc(total * (10 * sizeof(float) + iMAX_G2_BONEWEIGHTS_PER_VERT + sizeof(short)) + 15, h_low);
+	mem = (byte *)(((size_t)mem + 15) & ~(size_t)15);
+	for (k = 0; k < 3; k++)
+	{
+		ss->pos[k] = (float *)mem;
+		mem += total * sizeof(float);
+		ss->normal[k] = (float *)mem;
+		mem += total * sizeof(float);
+	}
+	for (k = 0; k < iMAX_G2_BONEWEIGHTS_PER_VERT; k++)
+	{
+		ss->weight[k] = (float *)mem;
+		mem += total * sizeof(float);
+	}
+	for (k = 0; k < iMAX_G2_BONEWEIGHTS_PER_VERT; k++)
+	{
+		ss->bone[k] = mem;
+		mem += total;
+	}
+	ss->index = (short *)mem;
+
+	lane = 0;
+	for (b = 0; b < iMAX_G2_BONEWEIGHTS_PER_VERT; b++)
+	{
+		last = -1;
+		for (i = 0; i < surface->numVerts; i++)
+		{
+			if (G2_GetVertWeights( &v[i] ) == b + 1)
+			{
+				G2_FillSkinLane(ss, lane++, &v[i], i);
+				last = i;
+			}
+		}
+		// pad with copies of the last one, it just gets written twice
+		while (lane < ss->bucketEnd[b])
+		{
+			G2_FillSkinLane(ss, lane++, &v[last], last);
+		}
+	}
+}
+
+// called once an mdxm has loaded, the batches live on the hunk with the model
+void G2_BuildSkinBatches(model_t *mod)
+{
+	g2SkinSurface_t	*surfaces;
+	int				l, i;
+
+	if (mod->g2Skin || !mod->mdxm)
+	{
+		return;
+	}
+
+	surfaces = (g2SkinSurface_t *)Hunk_Alloc(mod->mdxm->numLODs * mod->mdxm->numSurfaces * sizeof(g2SkinSurface_t), h_low);
+	for (l = 0; l < mod->mdxm->numLODs; l++)
+	{
+		for (i = 0; i < mod->mdxm->numSurfaces; i++)
+		{
+			G2_BuildSkinSurface((mdxmSurface_t *)G2_FindSurface(mod, i, l), &surfaces[l * mod->mdxm->numSurfaces + i]);
+		}
+	}
+	mod->g2Skin = surfaces;
+}
+
+// the surface only knows its index, the lod comes from where it sits in the file
+static const g2SkinSurface_t *G2_FindSkinSurface(const model_t *mod, const mdxmSurface_t *surface)
+{
+	const byte	*current;
+	int			l;
+
+	if (!mod || !mod->g2Skin)
+	{
+		return NULL;
+	}
+
+	current = (byte *)mod->mdxm + mod->mdxm->ofsLODs;
+	for (l = 0; l < mod->mdxm->numLODs; l++)
+	{
+		const mdxmLOD_t *lodData = (mdxmLOD_t *)current;
+
+		if ((byte *)surface < current + lodData->ofsEnd)
+		{
+			const g2SkinSurface_t *ss = &mod->g2Skin[l * mod->mdxm->numSurfaces + surface->thisSurfaceIndex];
+			return ss->index ? ss : NULL;
+		}
+		current += lodData->ofsEnd;
+	}
+	return NULL;
+}
+
+// DotProduct(bone.matrix[r], v) + bone.matrix[r][3], added up in the same order, for four verts
+static inline g2Lanes_t G2_SkinRow(const mdxaBone_t * const *b, int r, g2Lanes_t x, g2Lanes_t y, g2Lanes_t z)
+{
+	const g2Lanes_t m0 = G2L_Set(b[0]->matrix[r][0], b[1]->matrix[r][0], b[2]->matrix[r][0], b[3]->matrix[r][0]);
+	const g2Lanes_t m1 = G2L_Set(b[0]->matrix[r][1], b[1]->matrix[r][1], b[2]->matrix[r][1], b[3]->matrix[r][1]);
+	const g2Lanes_t m2 = G2L_Set(b[0]->matrix[r][2], b[1]->matrix[r][2], b[2]->matrix[r][2], b[3]->matrix[r][2]);
+	const g2Lanes_t m3 = G2L_Set(b[0]->matrix[r][3], b[1]->matrix[r][3], b[2]->matrix[r][3], b[3]->matrix[r][3]);
+
+	return G2L_Add(G2L_Add(G2L_Add(G2L_Mul(m0, x), G2L_Mul(m1, y)), G2L_Mul(m2, z)), m3);
+}
+
+static inline g2Lanes_t G2_RotateRow(const mdxaBone_t * const *b, int r, g2Lanes_t x, g2Lanes_t y, g2Lanes_t z)
+{
+	const g2Lanes_t m0 = G2L_Set(b[0]->matrix[r][0], b[1]->matrix[r][0], b[2]->matrix[r][0], b[3]->matrix[r][0]);
+	const g2Lanes_t m1 = G2L_Set(b[0]->matrix[r][1], b[1]->matrix[r][1], b[2]->matrix[r][1], b[3]->matrix[r][1]);
+	const g2Lanes_t m2 = G2L_Set(b[0]->matrix[r][2], b[1]->matrix[r][2], b[2]->matrix[r][2], b[3]->matrix[r][2]);
+
+	return G2L_Add(G2L_Add(G2L_Mul(m0, x), G2L_Mul(m1, y)), G2L_Mul(m2, z));
+}
+
+// skin every vertex of the surface.  bones are its bone references already evaluated.  render
+// follows RB_SurfaceGhoul, which lerps two weight verts and wants normals; otherwise it follows
+// the collision code, which sums every weight and scales the result
+static void G2_SkinBatch(const g2SkinSurface_t *ss, const mdxaBone_t * const *bones, bool render, const float *scale, float *xyz, int xyzStride, float *normals, int normalStride)
+{
+	const mdxaBone_t	*b[G2_SKIN_LANES];
+	g2Lanes_t			out[3], t[3], t2[3];
+	float				lanes[3][G2_SKIN_LANES];
+	int					bucket, first, i, k, l, c;
+
+	first = 0;
+	for (bucket = 0; bucket < iMAX_G2_BONEWEIGHTS_PER_VERT; bucket++)
+	{
+		const int numWeights = bucket + 1;
+
+		for (i = first; i < ss->bucketEnd[bucket]; i += G2_SKIN_LANES)
+		{
+			const g2Lanes_t x = G2L_Load(&ss->pos[0][i]);
+			const g2Lanes_t y = G2L_Load(&ss->pos[1][i]);
+			const g2Lanes_t z = G2L_Load(&ss->pos[2][i]);
+
+			for (l = 0; l < G2_SKIN_LANES; l++)
+			{
+				b[l] = bones[ss->bone[0][i + l]];
+			}
+			for (c = 0; c < 3; c++)
+			{
+				t[c] = G2_SkinRow(b, c, x, y, z);
+			}
+
+			if (render && normals)
+			{
+				const g2Lanes_t nx = G2L_Load(&ss->normal[0][i]);
+				const g2Lanes_t ny = G2L_Load(&ss->normal[1][i]);
+				const g2Lanes_t nz = G2L_Load(&ss->normal[2][i]);
+
+				for (c = 0; c < 3; c++)
+				{
+					G2L_Store(lanes[c], G2_RotateRow(b, c, nx, ny, nz));
+				}
+				for (l = 0; l < G2_SKIN_LANES; l++)
+				{
+					float *n = &normals[ss->index[i + l] * normalStride];
+					n[0] = lanes[0][l];
+					n[1] = lanes[1][l];
+					n[2] = lanes[2][l];
+				}
+			}
+
+			if (render && numWeights == 1)
+			{
+				out[0] = t[0];
+				out[1] = t[1];
+				out[2] = t[2];
+			}
+			else if (render && numWeights == 2)
+			{
+				const g2Lanes_t w = G2L_Load(&ss->weight[0][i]);
+
+				for (l = 0; l < G2_SKIN_LANES; l++)
+				{
+					b[l] = bones[ss->bone[1][i + l]];
+				}
+				for (c = 0; c < 3; c++)
+				{
+					t2[c] = G2_SkinRow(b, c, x, y, z);
+					out[c] = G2L_Add(G2L_Mul(w, G2L_Sub(t[c], t2[c])), t2[c]);
+				}
+			}
+			else
+			{
+				g2Lanes_t w = G2L_Load(&ss->weight[0][i]);
+
+				for (c = 0; c < 3; c++)
+				{
+					out[c] = G2L_Mul(w, t[c]);
+				}
+				for (k = 1; k < numWeights; k++)
+				{
+					w = G2L_Load(&ss->weight[k][i]);
+					for (l = 0; l < G2_SKIN_LANES; l++)
+					{
+						b[l] = bones[ss->bone[k][i + l]];
+					}
+					for (c = 0; c < 3; c++)
+					{
+						out[c] = G2L_Add(out[c], G2L_Mul(w, G2_SkinRow(b, c, x, y, z)));
+					}
+				}
+			}
+
+			for (c = 0; c < 3; c++)
+			{
+				if (scale)
+				{
+					out[c] = G2L_Mul(out[c], G2L_Splat(scale[c]));
+				}
+				G2L_Store(lanes[c], out[c]);
+			}
+			for (l = 0; l < G2_SKIN_LANES; l++)
+			{
+				float *p = &xyz[ss->index[i + l] * xyzStride];
+				p[0] = lanes[0][l];
+				p[1] = lanes[1][l];
+				p[2] = lanes[2][l];
+			}
+		}
+		first = ss->bucketEnd[bucket];
+	}
+}
+
+// skin a whole surface for collision into the five floats per vertex the trace code wants,
+// false if it has no batches and the caller has to do it a vertex at a time
+qboolean G2_SkinCollisionSurface(const mdxmSurface_t *surface, CBoneCache *boneCache, const vec3_t scale, float *out)
+{
+	const mdxaBone_t	*bones[iMAX_G2_BONEREFS_PER_SURFACE];
+	const g2SkinSurface_t *ss;
+	int					j;
+
+	if (r_ghoul2BatchSkin && !r_ghoul2BatchSkin->integer)
+	{
+		return qfalse;
+	}
+	ss = G2_FindSkinSurface(boneCache->mod, surface);
+	if (!ss)
+	{
+		return qfalse;
+	}
+
+	const int *piBoneReferences = (int*) ((byte*)surface + surface->ofsBoneReferences);
+	for (j = 0; j < surface->numBoneReferences; j++)
+	{
+		bones[j] = &EvalBoneCache(piBoneReferences[j], boneCache);
+	}
+
+	G2_SkinBatch(ss, bones, false, scale, out, 5, NULL, 0);
+
+	const mdxmVertex_t *v = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
+	const mdxmVertexTexCoord_t *pTexCoords = (mdxmVertexTexCoord_t *) &v[surface->numVerts];
+	for (j = 0; j < surface->numVerts; j++)
+	{
+		out[j * 5 + 3] = pTexCoords[j].texCoords[0];
+		out[j * 5 + 4] = pTexCoords[j].texCoords[1];
+	}
+	return qtrue;
+}
+
+#ifndef DEDICATED
+static float	g2SkinCheckXyz[SHADER_MAX_VERTEXES][4];
+static float	g2SkinCheckNormal[SHADER_MAX_VERTEXES][4];
+
+// r_ghoul2SkinCheck, the per-vertex loop has just filled tess, see how far the batches are off
+static void G2_CheckSkinBatch(const mdxmSurface_t *surface, int firstVertex)
+{
+	float	worst = 0.0f;
+	int		worstVert = -1;
+	int		j, c;
+
+	for (j = 0; j < surface->numVerts; j++)
+	{
+		for (c = 0; c < 3; c++)
+		{
+			const float dXyz = fabs(g2SkinCheckXyz[j][c] - tess.xyz[firstVertex + j][c]);
+			const float dNormal = fabs(g2SkinCheckNormal[j][c] - tess.normal[firstVertex + j][c]);
+
+			if (dXyz > worst || dNormal > worst)
+			{
+				worst = dXyz > dNormal ? dXyz : dNormal;
+				worstVert = j;
+			}
+		}
+	}
+	if (worst > 0.01f)
+	{
+		Com_Printf("G2_CheckSkinBatch: surface %i vert %i off by %f\n", surface->thisSurfaceIndex, worstVert, worst);
+	}
+}
+#endif // !DEDICATED
+
+#else
+
+// TransformRenderSurface and TransformCollideSurface have their own vertex format to deal with
+void G2_BuildSkinBatches(model_t *mod)
+{
+	mod->g2Skin = NULL;
+}
+
+#endif // _XBOX
+
 #ifndef DEDICATED
 
 static inline float G2_GetVertBoneWeightNotSlow( const mdxmVertex_t *pVert, const int iWeightNum)
@@ -4256,6 +4775,39 @@ void RB_SurfaceGhoul( CRenderableSurface *surf )
 	v = (mdxmVertex_t *) ((byte *)surface + surface->ofsVerts);
 	pTexCoords = (mdxmVertexTexCoord_t *) &v[numVerts];
 
+	const g2SkinSurface_t *skinBatch = NULL;
+	bool batched = false;
+
+	if (!r_ghoul2BatchSkin || r_ghoul2BatchSkin->integer)
+	{
+		skinBatch = G2_FindSkinSurface(bones->mod, surface);
+	}
+	if (skinBatch)
+	{
+		const mdxaBone_t *boneMats[iMAX_G2_BONEREFS_PER_SURFACE];
+
+		for (j = 0; j < surface->numBoneReferences; j++)
+		{
+			boneMats[j] = &bones->EvalRender(piBoneReferences[j]);
+		}
+		if (r_ghoul2SkinCheck && r_ghoul2SkinCheck->integer)
+		{
+			G2_SkinBatch(skinBatch, boneMats, true, NULL, g2SkinCheckXyz[0], 4, g2SkinCheckNormal[0], 4);
+		}
+		else
+		{
+			G2_SkinBatch(skinBatch, boneMats, true, NULL, tess.xyz[baseVertex], 4, tess.normal[baseVertex], 4);
+			for (j = 0; j < numVerts; j++)
+			{
+				tess.texCoords[baseVertex + j][0][0] = pTexCoords[j].texCoords[0];
+				tess.texCoords[baseVertex + j][0][1] = pTexCoords[j].texCoords[1];
+			}
+			batched = true;
+		}
+	}
+
+	if (!batched)
+	{
 //	if (r_ghoul2fastnormals&&r_ghoul2fastnormals->integer==0)
 #if 0
 	if (0)
@@ -4380,6 +4932,11 @@ void RB_SurfaceGhoul( CRenderableSurface *surf )
 #if 0
 	}
 #endif
+		if (skinBatch)
+		{
+			G2_CheckSkinBatch(surface, tess.numVertexes);
+		}
+	}
 #endif // _XBOX
 
 #ifdef _G2_GORE
@@ -5453,6 +6010,9 @@ qboolean R_LoadMDXA( model_t *mod, void *buffer, const char *mod_name, qboolean
 		return qfalse;
 	}
 
+	// this one may sit where a freed one used to
+	G2_ForgetPoseCache();
+
 	if (bAlreadyFound)
 	{
 		return qtrue;	// All done, stop here, do not LittleLong() etc. Do not pass go...
@@ -195,6 +195,9 @@ cvar_t	*r_noPrecacheGLA;
 cvar_t	*r_noServerGhoul2;
 cvar_t	*r_Ghoul2AnimSmooth=0;
 cvar_t	*r_Ghoul2UnSqashAfterSmooth=0;
+cvar_t	*r_ghoul2BatchSkin=0;
+cvar_t	*r_ghoul2SkinCheck=0;
+cvar_t	*r_ghoul2PoseCache=0;
 //cvar_t	*r_Ghoul2UnSqash;
 //cvar_t	*r_Ghoul2TimeBase=0; from single player
 //cvar_t	*r_Ghoul2NoLerp;
@@ -1160,6 +1163,9 @@ Ghoul2 Insert Start
 
 	r_Ghoul2AnimSmooth = Cvar_Get( "r_ghoul2animsmooth", "0.3", 0 );
 	r_Ghoul2UnSqashAfterSmooth = Cvar_Get( "r_ghoul2unsqashaftersmooth", "1", 0 );
+	r_ghoul2BatchSkin = Cvar_Get( "r_ghoul2BatchSkin", "1", 0 );
+	r_ghoul2SkinCheck = Cvar_Get( "r_ghoul2SkinCheck", "0", CVAR_CHEAT );
+	r_ghoul2PoseCache = Cvar_Get( "r_ghoul2PoseCache", "1", 0 );
 
 	broadsword = Cvar_Get( "broadsword", "0", 0);
 	broadsword_kickbones = Cvar_Get( "broadsword_kickbones", "1", 0);
@@ -1201,6 +1207,7 @@ extern qboolean Sys_LowPhysicalMemory();
 	Cmd_AddCommand( "modelist", R_ModeList_f );
 #endif
 	Cmd_AddCommand( "modelcacheinfo", RE_RegisterModels_Info_f);
+	Cmd_AddCommand( "g2posecacheinfo", G2_PoseCacheInfo);
 
 }
 
@@ -1346,6 +1353,7 @@ void RE_Shutdown( qboolean destroyWindow ) {
 	Cmd_RemoveCommand ("modellist");
 	Cmd_RemoveCommand ("modelist");
 	Cmd_RemoveCommand ("modelcacheinfo");
+	Cmd_RemoveCommand ("g2posecacheinfo");
 #ifndef DEDICATED
 
 #ifndef _XBOX	// GLOWXXX
@@ -1127,6 +1127,8 @@ Ghoul2 Insert Start
 */
 	mdxmHeader_t *mdxm;				// only if type == MOD_GL2M which is a GHOUL II Mesh file NOT a GHOUL II animation file
 	mdxaHeader_t *mdxa;				// only if type == MOD_GL2A which is a GHOUL II Animation file
+	struct g2Collision_s *g2Collision;	// bone space bounds for tracing an mdxm, see G2_BuildCollisionVolumes
+	struct g2SkinSurface_s *g2Skin;		// mdxm verts repacked for G2_SkinBatch, see G2_BuildSkinBatches
 /*
 Ghoul2 Insert End
 */
@@ -2307,6 +2309,12 @@ void		Create_Matrix(const float *angle, mdxaBone_t *matrix);
 void		Multiply_3x4Matrix(mdxaBone_t *out, mdxaBone_t *in2, mdxaBone_t *in);
 extern qboolean R_LoadMDXM (model_t *mod, void *buffer, const char *name, qboolean &bAlreadyCached );
 extern qboolean R_LoadMDXA (model_t *mod, void *buffer, const char *name, qboolean &bAlreadyCached );
+// G2_misc.cpp
+void		G2_BuildCollisionVolumes(model_t *mod);
+// tr_ghoul2.cpp
+void		G2_BuildSkinBatches(model_t *mod);
+void		G2_ForgetPoseCache(void);
+void		G2_PoseCacheInfo(void);
 bool LoadTGAPalletteImage ( const char *name, byte **pic, int *width, int *height);
 void		RE_InsertModelIntoHash(const char *name, model_t *mod);
 /*
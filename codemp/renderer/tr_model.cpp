@@ -384,6 +384,7 @@ qboolean RE_RegisterModels_LevelLoadEnd(qboolean bDeleteEverythingNotUsedThisLev
 					Z_Free(CachedModel.pModelDiskImage);	
 					//CachedModel.pModelDiskImage = NULL;	// REM for reference, erase() call below negates the need for it.
 					bAtLeastoneModelFreed = qtrue;
+					G2_ForgetPoseCache();	// the pose cache is keyed on the mdxa's address
 				}
 #ifndef __linux__
 				itModel = CachedModels->erase(itModel);
@@ -444,6 +445,7 @@ static void RE_RegisterModels_DumpNonPure(void)
 				if (CachedModel.pModelDiskImage) {
 					Z_Free(CachedModel.pModelDiskImage);	
 					//CachedModel.pModelDiskImage = NULL;	// REM for reference, erase() call below negates the need for it.
+					G2_ForgetPoseCache();
 				}
 #ifndef __linux__
 				itModel = CachedModels->erase(itModel);
@@ -506,12 +508,14 @@ static void RE_RegisterModels_DeleteAll(void)
 
 		if (CachedModel.pModelDiskImage) {
 			Z_Free(CachedModel.pModelDiskImage);					
+			G2_ForgetPoseCache();
 		}
 
 		itModel = CachedModels->erase(itModel);			
 	}
 #else
 	CachedModels->erase(CachedModels->begin(),CachedModels->end());
+	G2_ForgetPoseCache();
 #endif
 }
 
@@ -743,6 +747,9 @@ qboolean ServerLoadMDXA( model_t *mod, void *buffer, const char *mod_name, qbool
 		return qfalse;
 	}
 
+	// this one may sit where a freed one used to
+	G2_ForgetPoseCache();
+
 	if (bAlreadyFound)
 	{
 		return qtrue;	// All done, stop here, do not LittleLong() etc. Do not pass go...
@@ -1105,6 +1112,11 @@ Ghoul2 Insert End
 				break;
 			case MDXM_IDENT:
 				loaded = ServerLoadMDXM( mod, buf, filename, bAlreadyCached );
+				if (loaded)
+				{
+					G2_BuildCollisionVolumes(mod);
+					G2_BuildSkinBatches(mod);
+				}
 				break;
 			default:
 				goto fail;
@@ -1327,6 +1339,11 @@ Ghoul2 Insert End
 		
 			case MDXM_IDENT:
 				loaded = R_LoadMDXM( mod, buf, filename, bAlreadyCached );
+				if (loaded)
+				{
+					G2_BuildCollisionVolumes(mod);
+					G2_BuildSkinBatches(mod);
+				}
 				break;
 
 			case MD3_IDENT:
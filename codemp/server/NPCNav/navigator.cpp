@@ -105,15 +105,11 @@ CNode::CNode( void )
 {
 	m_numEdges		= 0;
 	m_radius		= 0;
-	m_ranks			= NULL;
 }
 
 CNode::~CNode( void )
 {
 	m_edges.clear();
-
-	if ( m_ranks )
-		delete [] m_ranks;
 }
 
 /*
@@ -205,19 +201,6 @@ int CNode::GetEdgeNumToNode( int ID )
 	return -1;
 }
 
-/*
--------------------------
-AddRank
--------------------------
-*/
-
-void CNode::AddRank( int ID, int rank )
-{
-	assert( m_ranks );
-
-	m_ranks[ ID ] = rank;
-}
-
 /*
 -------------------------
 Draw
@@ -342,47 +325,13 @@ void CNode::SetEdgeFlags( int edgeNum, int newFlags )
 	}
 
 }
-/*
--------------------------
-InitRanks
--------------------------
-*/
-
-void CNode::InitRanks( int size )
-{
-	//Clear it if it's already allocated
-	if ( m_ranks != NULL )
-	{
-		delete [] m_ranks;
-		m_ranks = NULL;
-	}
-
-	m_ranks = new int[size];
-
-	memset( m_ranks, -1, sizeof(int)*size );
-}
-
-/*
--------------------------
-GetRank
--------------------------
-*/
-
-int CNode::GetRank( int ID )
-{
-	assert( m_ranks );
-
-	return m_ranks[ ID ];
-}
-
-
 /*
 -------------------------
 Save
 -------------------------
 */
 
-int	CNode::Save( int numNodes, fileHandle_t file )
+int	CNode::Save( fileHandle_t file )
 {
 	//Write out the header
 	unsigned long header = NODE_HEADER_ID;
@@ -406,14 +355,6 @@ int	CNode::Save( int numNodes, fileHandle_t file )
 		FS_Write( &(*ei), sizeof( edge_t ), file );
 	}
 
-	//Write out the node ranks
-	FS_Write( &numNodes, sizeof( numNodes ), file );
-
-	for ( i = 0; i < numNodes; i++ )
-	{
-		FS_Write( &m_ranks[i], sizeof( int ), file );
-	}
-
 	return true;
 }
 
@@ -423,7 +364,7 @@ Load
 -------------------------
 */
 
-int CNode::Load( int numNodes, fileHandle_t file )
+int CNode::Load( fileHandle_t file )
 {
 	unsigned long header;
 	FS_Read( &header, sizeof(header), file );
@@ -453,19 +394,6 @@ int CNode::Load( int numNodes, fileHandle_t file )
 		STL_INSERT( m_edges, edge );
 	}
 
-	//Read the node ranks
-	int	numRanks;
-
-	FS_Read( &numRanks, sizeof( numRanks ), file );
-
-	//Allocate the memory
-	InitRanks( numRanks );
-
-	for ( i = 0; i < numRanks; i++ )
-	{
-		FS_Read( &m_ranks[i], sizeof( int ), file );
-	}
-
 	return true;
 }
 
@@ -477,6 +405,12 @@ CNavigator
 
 CNavigator::CNavigator( void )
 {
+	m_ranks			= NULL;
+	m_numRanked		= 0;
+	m_ranksMap		= NULL;
+	m_ranksMapLength = 0;
+	m_gridNodes		= 0;
+
 	if (!d_altRoutes || !d_patched)
 	{
 		NAV_CvarInit();
@@ -591,6 +525,204 @@ void CNavigator::Free( void )
 
 	m_nodes.clear();
 	m_edgeLookupMap.clear();
+
+	m_gridHead.clear();
+	m_gridNext.clear();
+	m_gridNodes = 0;
+
+	FreeRanks();
+}
+
+/*
+-------------------------
+FreeRanks
+-------------------------
+*/
+
+void CNavigator::FreeRanks( void )
+{
+	if ( m_ranksMap )
+	{
+		Sys_UnmapFile( m_ranksMap, m_ranksMapLength );
+	}
+	else if ( m_ranks )
+	{
+		delete [] m_ranks;
+	}
+
+	m_ranks			= NULL;
+	m_numRanked		= 0;
+	m_ranksMap		= NULL;
+	m_ranksMapLength = 0;
+}
+
+/*
+-------------------------
+AllocRanks
+-------------------------
+*/
+
+void CNavigator::AllocRanks( void )
+{
+	int	numNodes = m_nodes.size();
+
+	FreeRanks();
+
+	//ranks are stored in shorts, and a table that size wouldn't fit in memory anyway
+	if ( numNodes >= NAV_RANK_NONE )
+	{
+		Com_Error( ERR_DROP, "Too many navigation nodes (%i, max %i)\n", numNodes, NAV_RANK_NONE - 1 );
+	}
+
+	m_ranks = new navRank_t[ numNodes * numNodes ];
+	m_numRanked = numNodes;
+
+	memset( m_ranks, 0xFF, sizeof( navRank_t ) * numNodes * numNodes );
+}
+
+/*
+-------------------------
+MakeRanksWritable
+
+A mapped table is read only, copy it before recalculating any of it
+-------------------------
+*/
+
+void CNavigator::MakeRanksWritable( void )
+{
+	if ( !m_ranksMap )
+		return;
+
+	int			 numRanked = m_numRanked;
+	navRank_t	*ranks = new navRank_t[ numRanked * numRanked ];
+
+	memcpy( ranks, m_ranks, sizeof( navRank_t ) * numRanked * numRanked );
+
+	FreeRanks();
+
+	m_ranks		= ranks;
+	m_numRanked	= numRanked;
+}
+
+/*
+-------------------------
+GetRank
+-------------------------
+*/
+
+int CNavigator::GetRank( int endID, int ID ) const
+{
+	if ( m_ranks == NULL || endID >= m_numRanked || ID >= m_numRanked )
+		return NODE_NONE;
+
+	navRank_t	rank = m_ranks[ endID * m_numRanked + ID ];
+
+	return ( rank == NAV_RANK_NONE ) ? NODE_NONE : rank;
+}
+
+/*
+-------------------------
+LoadRanks
+
+The route table goes in its own file beside the .nav so a server can map
+it instead of reading it or working it out again
+-------------------------
+*/
+
+bool CNavigator::LoadRanks( const char *filename, int checksum )
+{
+	const char	*qpath = va( "maps/%s.nvr", filename );
+	int			numNodes = m_nodes.size();
+	int			headerSize = 3 * sizeof( int );
+	int			tableSize = numNodes * numNodes * sizeof( navRank_t );
+	int			*header;
+	int			length;
+
+	FreeRanks();
+
+	if ( numNodes >= NAV_RANK_NONE )
+		return false;
+
+	//try to map it where Save puts it, otherwise read it from wherever the filesystem finds it
+	m_ranksMap = Sys_MapFile( FS_BuildOSPath( Cvar_VariableString( "fs_homepath" ), "", qpath ), &length );
+	if ( m_ranksMap )
+	{
+		m_ranksMapLength = length;
+		header = (int *)m_ranksMap;
+	}
+	else
+	{
+		void	*buffer;
+
+		length = FS_ReadFile( qpath, &buffer );
+		if ( length < 0 )
+			return false;
+
+		if ( length != headerSize + tableSize )
+		{
+			FS_FreeFile( buffer );
+			return false;
+		}
+
+		m_ranks = new navRank_t[ numNodes * numNodes ];
+		m_numRanked = numNodes;
+		memcpy( m_ranks, (byte *)buffer + headerSize, tableSize );
+
+		header = (int *)buffer;
+		bool valid = ( header[0] == ROUTE_HEADER_ID && header[1] == checksum && header[2] == numNodes );
+		FS_FreeFile( buffer );
+
+		if ( !valid )
+		{
+			FreeRanks();
+			return false;
+		}
+		return true;
+	}
+
+	if ( length != headerSize + tableSize || header[0] != ROUTE_HEADER_ID || header[1] != checksum || header[2] != numNodes )
+	{
+		FreeRanks();
+		return false;
+	}
+
+	m_ranks = (navRank_t *)( (byte *)m_ranksMap + headerSize );
+	m_numRanked = numNodes;
+
+	return true;
+}
+
+/*
+-------------------------
+SaveRanks
+-------------------------
+*/
+
+bool CNavigator::SaveRanks( const char *filename, int checksum )
+{
+	fileHandle_t	file;
+
+	if ( m_ranks == NULL || m_numRanked != m_nodes.size() )
+		return false;
+
+	//a mapped copy of this same file can't be written over
+	MakeRanksWritable();
+
+	FS_FOpenFileByMode( va( "maps/%s.nvr", filename ), &file, FS_WRITE );
+
+	if ( file == NULL )
+		return false;
+
+	int	id = ROUTE_HEADER_ID;
+
+	FS_Write( &id, sizeof( id ), file );
+	FS_Write( &checksum, sizeof( checksum ), file );
+	FS_Write( &m_numRanked, sizeof( m_numRanked ), file );
+	FS_Write( m_ranks, sizeof( navRank_t ) * m_numRanked * m_numRanked, file );
+
+	FS_FCloseFile( file );
+
+	return true;
 }
 
 /*
@@ -634,8 +766,9 @@ bool CNavigator::Load( const char *filename, int checksum )
 	{
 		CNode	*node = CNode::Create();
 
-		if ( node->Load( numNodes, file ) == false )
+		if ( node->Load( file ) == false )
 		{
+			delete node;
 			FS_FCloseFile( file );
 			return false;
 		}
@@ -653,6 +786,13 @@ bool CNavigator::Load( const char *filename, int checksum )
 
 	FS_FCloseFile( file );
 
+	//No routes means working everything out again
+	if ( LoadRanks( filename, checksum ) == false )
+	{
+		Free();
+		return false;
+	}
+
 	return true;
 }
 
@@ -690,7 +830,7 @@ bool CNavigator::Save( const char *filename, int checksum )
 
 	STL_ITERATE( ni, m_nodes )
 	{
-		(*ni)->Save( numNodes, file );
+		(*ni)->Save( file );
 	}
 
 	//write out failed edges
@@ -698,7 +838,7 @@ bool CNavigator::Save( const char *filename, int checksum )
 
 	FS_FCloseFile( file );
 
-	return true;
+	return SaveRanks( filename, checksum );
 }
 
 /*
@@ -807,24 +947,34 @@ void CNavigator::AddNodeEdges( CNode *node, int addDist, edge_l	&edgeList, bool
 
 /*
 -------------------------
-CalculatePath
+RankPaths
+
+Flood out from node, ranking every node by the order it's reached.  Runs on
+the path threads, so it only reads the graph and writes node's own row, and
+pathList and checked come in already big enough to never allocate.
 -------------------------
 */
 
-void CNavigator::CalculatePath( CNode *node )
+class CEdgeCostGreater
 {
-	int	curRank = 0;
+public:
+	bool operator()( const CEdge &first, const CEdge &second ) const {
+		return( first.m_cost > second.m_cost );
+	}
+};
 
-	CPriorityQueue	*pathList = new CPriorityQueue();
-	BYTE			*checked;
+void CNavigator::RankPaths( CNode *node, vector< CEdge > &pathList, BYTE *checked )
+{
+	navRank_t	*ranks = &m_ranks[ node->GetID() * m_numRanked ];
+	int			curRank = 0;
 
 	//Init the completion table
-	checked = new BYTE[ m_nodes.size() ];
 	memset( checked, 0, m_nodes.size() );
+	pathList.clear();
 
 	//Mark this node as checked
 	checked[ node->GetID() ] = true;
-	node->AddRank( node->GetID(), curRank++ );
+	ranks[ node->GetID() ] = curRank++;
 
 	//Add all initial nodes
 	int i;
@@ -835,22 +985,21 @@ void CNavigator::CalculatePath( CNode *node )
 
 		checked[ nextNode->GetID() ] = true;
 
-		pathList->Push( new CEdge( nextNode->GetID(), nextNode->GetID(), node->GetEdgeCost(i) ) );
+		pathList.push_back( CEdge( nextNode->GetID(), nextNode->GetID(), node->GetEdgeCost(i) ) );
+		std::push_heap( pathList.begin(), pathList.end(), CEdgeCostGreater() );
 	}
 
-	float				minDist;
-	CEdge				*test;	
-
 	//Now flood fill all the others
-	while ( !pathList->Empty() )
+	while ( !pathList.empty() )
 	{
-		minDist = Q3_INFINITE;			
-		test	 = pathList->Pop();
+		std::pop_heap( pathList.begin(), pathList.end(), CEdgeCostGreater() );
+		CEdge	test = pathList.back();
+		pathList.pop_back();
 		
-		CNode	*testNode = m_nodes[ (*test).m_first ];
+		CNode	*testNode = m_nodes[ test.m_first ];
 		assert( testNode );
 
-		node->AddRank( testNode->GetID(), curRank++ );
+		ranks[ testNode->GetID() ] = curRank++;
 
 		//Add in all the new edges
 		for ( i = 0; i < testNode->GetNumEdges(); i++ )
@@ -861,21 +1010,72 @@ void CNavigator::CalculatePath( CNode *node )
 			if ( checked[ addNode->GetID() ] )
 				continue;
 
-			int	newDist = (*test).m_cost + testNode->GetEdgeCost(i);
-			pathList->Push( new CEdge( addNode->GetID(), (*test).m_second, newDist ) );
+			int	newDist = test.m_cost + testNode->GetEdgeCost(i);
+			pathList.push_back( CEdge( addNode->GetID(), test.m_second, newDist ) );
+			std::push_heap( pathList.begin(), pathList.end(), CEdgeCostGreater() );
 
 			checked[ addNode->GetID() ] = true;
 		}
-		delete test;
-
 	}
 
 	node->RemoveFlag( NF_RECALC );
+}
+
+/*
+-------------------------
+CalculatePath
+-------------------------
+*/
+
+void CNavigator::CalculatePath( CNode *node )
+{
+	if ( m_ranks == NULL || m_numRanked != m_nodes.size() )
+	{
+		CalculatePaths( qtrue );
+		return;
+	}
+
+	MakeRanksWritable();
+
+	vector< CEdge >	pathList;
+	BYTE			*checked = new BYTE[ m_nodes.size() ];
+
+	pathList.reserve( m_nodes.size() );
+
+	RankPaths( node, pathList, checked );
 
-	delete pathList;
 	delete [] checked;
 }
 
+/*
+-------------------------
+CalculatePathsThread
+-------------------------
+*/
+
+#define	MAX_PATH_THREADS	8
+
+typedef struct pathWorker_s
+{
+	CNavigator		*navigator;
+	volatile int	*nextNode;
+	vector< CEdge >	pathList;
+	BYTE			*checked;
+} pathWorker_t;
+
+void CNavigator::CalculatePathsThread( void *data )
+{
+	pathWorker_t	*worker = (pathWorker_t *) data;
+	CNavigator		*nav = worker->navigator;
+	int				numNodes = nav->m_nodes.size();
+	int				nodeID;
+
+	while ( ( nodeID = Sys_AtomicAdd( worker->nextNode, 1 ) - 1 ) < numNodes )
+	{
+		nav->RankPaths( nav->m_nodes[ nodeID ], worker->pathList, worker->checked );
+	}
+}
+
 /*
 -------------------------
 CalculatePaths
@@ -887,16 +1087,52 @@ void CNavigator::CalculatePaths( qboolean recalc )
 #else
 #endif	
 
+	//Allocate the needed memory
+	AllocRanks();
+
+	//Every node's search is independent, so split them across the processors
+	int				numNodes = m_nodes.size();
+	int				numThreads = 0;
+	void			*threads[MAX_PATH_THREADS];
+	pathWorker_t	workers[MAX_PATH_THREADS+1];
+	volatile int	nextNode = 0;
+
+	if ( numNodes >= 64 )
+	{
+		numThreads = Sys_ProcessorCount() - 1;
+
+		if ( numThreads > MAX_PATH_THREADS )
+			numThreads = MAX_PATH_THREADS;
+	}
+
 	int i;
-	for ( i = 0; i < m_nodes.size(); i++ )
+	for ( i = 0; i <= numThreads; i++ )
+	{
+		//all the memory comes from here, the workers can't allocate
+		workers[i].navigator = this;
+		workers[i].nextNode = &nextNode;
+		workers[i].pathList.reserve( numNodes );
+		workers[i].checked = new BYTE[ numNodes ];
+	}
+
+	int	numStarted = 0;
+	for ( i = 0; i < numThreads; i++ )
+	{
+		threads[numStarted] = Sys_CreateThread( CalculatePathsThread, &workers[i+1] );
+		if ( threads[numStarted] )
+			numStarted++;
+	}
+
+	CalculatePathsThread( &workers[0] );
+
+	for ( i = 0; i < numStarted; i++ )
 	{
-		//Allocate the needed memory
-		m_nodes[i]->InitRanks( m_nodes.size() );
+		Sys_JoinThread( threads[i] );
 	}
 
-	for ( i = 0; i < m_nodes.size(); i++ )
+	for ( i = 0; i <= numThreads; i++ )
 	{
-		CalculatePath( m_nodes[i] );
+		delete [] workers[i].checked;
 	}
 		
 	if(!recalc)	//Mike says doesn't need to happen on recalc
@@ -1246,75 +1482,145 @@ CollectNearestNodes
 #define NODE_COLLECT_RADIUS	512		//Default radius to search for nodes in
 #define NODE_COLLECT_RADIUS_SQR		( NODE_COLLECT_RADIUS * NODE_COLLECT_RADIUS )
 
+/*
+-------------------------
+BuildNodeGrid
+
+Nodes hashed into columns of NODE_GRID_SIZE on x and y, so only the nodes
+near a point need looking at.  Built the first time it's needed after the
+nodes change.
+-------------------------
+*/
+
+#define	NODE_GRID_SIZE		256
+#define	NODE_GRID_HASH		1024	//power of two
+
+static inline int NAV_GridCell( float coord )
+{
+	return (int) floor( coord / NODE_GRID_SIZE );
+}
+
+static inline int NAV_GridHash( int x, int y )
+{
+	return ( ( x * 73856093 ) ^ ( y * 19349663 ) ) & ( NODE_GRID_HASH - 1 );
+}
+
+void CNavigator::BuildNodeGrid( void )
+{
+	vec3_t	position;
+	int		numNodes = m_nodes.size();
+
+	m_gridHead.assign( NODE_GRID_HASH, NODE_NONE );
+	m_gridNext.assign( numNodes, NODE_NONE );
+
+	for ( int i = 0; i < numNodes; i++ )
+	{
+		m_nodes[i]->GetPosition( position );
+
+		int	hash = NAV_GridHash( NAV_GridCell( position[0] ), NAV_GridCell( position[1] ) );
+
+		m_gridNext[i] = m_gridHead[hash];
+		m_gridHead[hash] = i;
+	}
+
+	m_gridNodes = numNodes;
+}
+
+/*
+-------------------------
+CollectNearestNodes
+-------------------------
+*/
+
+bool CNavigator::NodeDistanceLess( const nodeList_t &first, const nodeList_t &second )
+{
+	if ( first.distance != second.distance )
+		return( first.distance < second.distance );
+
+	return( first.nodeID < second.nodeID );
+}
+
 int CNavigator::CollectNearestNodes( vec3_t origin, int radius, int maxCollect, nodeChain_l &nodeChain )
 {
-	node_v::iterator	ni;
-	float				dist;
-	vec3_t				position;
-	int					collected = 0;
-	bool				added = false;
+	vector< nodeList_t >	candidates;
+	int						buckets[NODE_GRID_HASH];
+	bool					bucketSeen[NODE_GRID_HASH];
+	int						numBuckets = 0;
+	float					dist;
+	vec3_t					position;
+	int						x, y, i;
 
-	//Get a distance rating for each node in the system
-	STL_ITERATE( ni, m_nodes )
+	if ( m_gridNodes != m_nodes.size() || m_gridHead.empty() )
 	{
-		//If we've got our quota, then stop looking
-		//Get the distance to the node
-		(*ni)->GetPosition( position );
-		dist = DistanceSquared( position, origin );
+		BuildNodeGrid();
+	}
 
-		//Must be within our radius range
-		if ( dist > (float) ( radius * radius ) )
-			continue;
-		
-		nodeList_t				nChain;
-		nodeChain_l::iterator	nci;
+	int	minX = NAV_GridCell( origin[0] - radius );
+	int	maxX = NAV_GridCell( origin[0] + radius );
+	int	minY = NAV_GridCell( origin[1] - radius );
+	int	maxY = NAV_GridCell( origin[1] + radius );
 
-		//Always add the first node
-		if ( nodeChain.size() == 0 )
+	if ( (double) ( maxX - minX + 1 ) * (double) ( maxY - minY + 1 ) >= NODE_GRID_HASH )
+	{
+		//Touches at least as many cells as there are buckets, just take them all
+		for ( i = 0; i < NODE_GRID_HASH; i++ )
 		{
-			nChain.nodeID = (*ni)->GetID();
-			nChain.distance = dist;
-
-			nodeChain.insert( nodeChain.begin(), nChain );
-			continue;
+			buckets[i] = i;
 		}
+		numBuckets = NODE_GRID_HASH;
+	}
+	else
+	{
+		//Every cell the radius touches, each hash bucket only once
+		memset( bucketSeen, 0, sizeof( bucketSeen ) );
 
-		added = false;
-
-		//Compare it to what we already have
-		STL_ITERATE( nci, nodeChain )
+		for ( x = minX; x <= maxX; x++ )
 		{
-			//If we're less, than this entry, then insert before it
-			if ( dist < (*nci).distance )
+			for ( y = minY; y <= maxY; y++ )
 			{
-				nChain.nodeID = (*ni)->GetID();
-				nChain.distance = dist;
+				int	hash = NAV_GridHash( x, y );
 
-				nodeChain.insert( nci, nChain );
-				collected = nodeChain.size();
-				added = true;
-				
-				//If we've hit our collection limit, throw off the oldest one
-				if ( nodeChain.size() > maxCollect )
+				if ( !bucketSeen[hash] )
 				{
-					nodeChain.pop_back();
+					bucketSeen[hash] = true;
+					buckets[numBuckets++] = hash;
 				}
-
-				break;
 			}
 		}
+	}
 
-		//Otherwise, always pad out the collection if possible so we don't miss anything
-		if ( ( added == false ) && ( nodeChain.size() < maxCollect ) )
+	for ( i = 0; i < numBuckets; i++ )
+	{
+		for ( int nodeID = m_gridHead[ buckets[i] ]; nodeID != NODE_NONE; nodeID = m_gridNext[ nodeID ] )
 		{
-			nChain.nodeID = (*ni)->GetID();
+			//Get the distance to the node
+			m_nodes[ nodeID ]->GetPosition( position );
+			dist = DistanceSquared( position, origin );
+
+			//Must be within our radius range
+			if ( dist > (float) ( radius * radius ) )
+				continue;
+
+			nodeList_t	nChain;
+
+			nChain.nodeID = nodeID;
 			nChain.distance = dist;
 
-			nodeChain.insert( nodeChain.end(), nChain );
+			STL_INSERT( candidates, nChain );
 		}
 	}
 
-	return collected;
+	//Nearest first, the same order scanning the nodes in ID order and inserting ahead of anything further gave
+	std::sort( candidates.begin(), candidates.end(), NodeDistanceLess );
+
+	if ( candidates.size() > maxCollect )
+	{
+		candidates.resize( maxCollect );
+	}
+
+	nodeChain.insert( nodeChain.end(), candidates.begin(), candidates.end() );
+
+	return nodeChain.size();
 }
 
 int CNavigator::GetBestPathBetweenEnts( sharedEntity_t *ent, sharedEntity_t *goal, int flags )
@@ -2004,7 +2310,7 @@ void CNavigator::AddFailedEdge( int entID, int startID, int endID )
 					continue;
 				}
 
-				if ( nextID == endID || end->GetRank( nextID ) >= 0 )
+				if ( nextID == endID || GetRank( endID, nextID ) >= 0 )
 				{//neighbor of or route to end
 					//There's an alternate route, so don't check this one for 10 seconds
 					failedEdges[j].checkTime = svs.time + CHECK_FAILED_EDGE_INTITIAL;
@@ -2223,7 +2529,7 @@ qboolean CNavigator::RouteBlocked( int startID, int testEdgeID, int endID, int r
 			}
 
 			//Still going...
-			testRank = end->GetRank( edgeID );
+			testRank = GetRank( endID, edgeID );
 
 			if ( testRank < 0 )
 			{//No route this way
@@ -2400,7 +2706,7 @@ int CNavigator::GetBestNode( int startID, int endID, int rejectID )
 		{
 			if ( start->GetEdge(i) == rejectID )
 			{
-				rejectRank = end->GetRank( start->GetEdge(i) );
+				rejectRank = GetRank( endID, start->GetEdge(i) );
 				break;
 			}
 		}
@@ -2414,7 +2720,7 @@ int CNavigator::GetBestNode( int startID, int endID, int rejectID )
 		if ( edgeID == endID )
 			return edgeID;
 
-		testRank = end->GetRank( edgeID );
+		testRank = GetRank( endID, edgeID );
 
 		//Found one
 		if ( testRank <= rejectRank )
@@ -2520,7 +2826,7 @@ bool CNavigator::Connected( int startID, int endID )
 		if ( edgeID == endID )
 			return true;
 
-		if ( ( end->GetRank( edgeID ) ) != NODE_NONE )
+		if ( ( GetRank( endID, edgeID ) ) != NODE_NONE )
 			return true;
 	}
 
@@ -2580,7 +2886,7 @@ unsigned int CNavigator::GetPathCost( int startID, int endID )
 				return pathCost + moveNode->GetEdgeCost( i );
 			}	
 
-			testRank = endNode->GetRank( edgeID );
+			testRank = GetRank( endID, edgeID );
 
 			//No possible connection
 			if ( testRank == NODE_NONE )
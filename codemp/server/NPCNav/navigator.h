@@ -18,8 +18,13 @@
 
 //Miscellaneous defines
 #define	NODE_NONE		-1
-#define	NAV_HEADER_ID	'JNV5'
+#define	NAV_HEADER_ID	'JNV6'
 #define	NODE_HEADER_ID	'NODE'
+#define	ROUTE_HEADER_ID	'JNVR'
+
+//Route ranks, one row of numNodes per destination node
+typedef unsigned short	navRank_t;
+#define	NAV_RANK_NONE	0xFFFF
 
 #pragma warning( disable : 4786) 
 
@@ -87,7 +92,6 @@ public:
 	static CNode *Create( void );
 
 	void AddEdge( int ID, int cost, int flags = EFLAG_NONE );
-	void AddRank( int ID, int rank );
 
 	void Draw( qboolean radius );
 
@@ -102,15 +106,12 @@ public:
 	void SetEdgeFlags( int edgeNum, int newFlags );
 	int	GetRadius( void )				const	{	return m_radius;	}
 
-	void InitRanks( int size );
-	int GetRank( int ID );
-
 	int	GetFlags( void )				const	{	return m_flags;	}
 	void AddFlag( int newFlag )			{	m_flags |= newFlag;	}
 	void RemoveFlag( int oldFlag )		{	m_flags &= ~oldFlag; }
 
-	int	Save( int numNodes, fileHandle_t file );
-	int Load( int numNodes, fileHandle_t file );
+	int	Save( fileHandle_t file );
+	int Load( fileHandle_t file );
 
 protected:
 
@@ -121,7 +122,6 @@ protected:
 	
 	edge_v	m_edges;
 
-	int		*m_ranks;
 	int		m_numEdges;
 };
 
@@ -220,9 +220,12 @@ protected:
 	int		TestNodePath( sharedEntity_t *ent, int okToHitEntNum, vec3_t position, qboolean includeEnts );
 	int		TestNodeLOS( sharedEntity_t *ent, vec3_t position );
 	int		TestBestFirst( sharedEntity_t *ent, int lastID, int flags );
+
+	void	BuildNodeGrid( void );
 	
 #if __NEWCOLLECT
 	int		CollectNearestNodes( vec3_t origin, int radius, int maxCollect, nodeChain_l &nodeChain );
+	static bool NodeDistanceLess( const nodeList_t &first, const nodeList_t &second );
 #else
 	int		CollectNearestNodes( vec3_t origin, int radius, int maxCollect, int *nodeChain );
 #endif	//__NEWCOLLECT
@@ -232,12 +235,21 @@ protected:
 	float	GetFloat( fileHandle_t file );
 	long	GetLong( fileHandle_t file );
 
+	int		GetRank( int endID, int ID )	const;
+	void	AllocRanks( void );
+	void	FreeRanks( void );
+	void	MakeRanksWritable( void );
+	bool	LoadRanks( const char *filename, int checksum );
+	bool	SaveRanks( const char *filename, int checksum );
+	static void CalculatePathsThread( void *data );
+
 	//void	ConnectNodes( void );
 	void	SetEdgeCost( int ID1, int ID2, int cost );
 	int		GetEdgeCost( CNode *first, CNode *second );
 	void	AddNodeEdges( CNode *node, int addDist, edge_l &edgeList, bool *checkedNodes );
 
 	void	CalculatePath( CNode *node );
+	void	RankPaths( CNode *node, vector< CEdge > &pathList, BYTE *checked );
 
 	//rww - made failedEdges private as it doesn't seem to need to be public.
 	//And I'd rather shoot myself than have to devise a way of setting/accessing this
@@ -246,6 +258,15 @@ protected:
 
 	node_v			m_nodes;
 	EdgeMultimap	m_edgeLookupMap;
+
+	navRank_t		*m_ranks;			//m_ranks[ endID * m_numRanked + ID ], order ID is reached searching out from endID
+	int				m_numRanked;
+	void			*m_ranksMap;		//m_ranks points into this when it was mapped straight from the .nvr
+	int				m_ranksMapLength;
+
+	vector< int >	m_gridHead;			//first node in each hashed grid cell, NODE_NONE if there aren't any
+	vector< int >	m_gridNext;			//next node hashed to the same cell
+	int				m_gridNodes;		//how many nodes the grid was built from
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -34,13 +34,11 @@ typedef struct svEntity_s {
 	short			clusternums[MAX_ENT_CLUSTERS];
 	short			lastCluster;		// if all the clusters don't fit in clusternums
 	short			areanum, areanum2;
-	char			snapshotCounter;	// used to prevent double adding from portal views
 #else
 	int			numClusters;		// if -1, use headnode instead
 	int			clusternums[MAX_ENT_CLUSTERS];
 	int			lastCluster;		// if all the clusters don't fit in clusternums
 	int			areanum, areanum2;
-	int			snapshotCounter;	// used to prevent double adding from portal views
 #endif
 } svEntity_t;
 
@@ -56,11 +54,6 @@ typedef struct {
 	int				serverId;			// changes each server start
 	int				restartedServerId;	// serverId before a map_restart
 	int				checksumFeed;		//
-#ifdef _XBOX
-	char			snapshotCounter;	// incremented for each snapshot built
-#else
-	int				snapshotCounter;	// incremented for each snapshot built
-#endif
 	int				timeResidual;		// <= 1000 / sv_frame->value
 	int				nextFrameTime;		// when time > nextFrameTime, process world
 	struct cmodel_s	*models[MAX_MODELS];
@@ -85,6 +78,9 @@ typedef struct {
 	char			*mLocalSubBSPEntityParsePoint;
 
 	char			*mSharedMemory;
+
+	int				snapshotsBuilt;				// for snapshotinfo
+	int				snapshotEntitiesVisited;	// entities looked at while building them
 } server_t;
 
 
@@ -260,6 +256,9 @@ extern	cvar_t	*sv_gametype;
 extern	cvar_t	*sv_pure;
 extern	cvar_t	*sv_floodProtect;
 extern	cvar_t	*sv_needpass;
+extern	cvar_t	*sv_snapshotIndex;
+extern	cvar_t	*sv_snapshotThreads;
+extern	cvar_t	*sv_deltaCache;
 #ifdef USE_CD_KEY
 extern	cvar_t	*sv_allowAnonymous;
 #endif
@@ -341,6 +340,8 @@ void SV_WriteFrameToClient (client_t *client, msg_t *msg);
 void SV_SendMessageToClient( msg_t *msg, client_t *client );
 void SV_SendClientMessages( void );
 void SV_SendClientSnapshot( client_t *client );
+void SV_FreeSnapshotIndex( void );
+void SV_ShutdownSnapshotThreads( void );
 
 //
 // sv_game.c
@@ -584,9 +584,17 @@ SV_BotFrame
 ==================
 */
 void SV_BotFrame( int time ) {
+	static cvar_t *bot_saveroutingcache;
+
 	if (!bot_enable) return;
 	//NOTE: maybe the game is already shutdown
 	if (!gvm) return;
+	//pass a route cache write request on to the botlib, it's handled in the next AAS frame
+	if (!bot_saveroutingcache) bot_saveroutingcache = Cvar_Get("bot_saveroutingcache", "0", 0);
+	if (bot_saveroutingcache->integer && botlib_export) {
+		botlib_export->BotLibVarSet("saveroutingcache", bot_saveroutingcache->string);
+		Cvar_Set("bot_saveroutingcache", "0");
+	}
 	VM_Call( gvm, BOTAI_START_FRAME, time );
 }
 
@@ -643,7 +651,7 @@ void SV_BotInitCvars(void) {
 	Cvar_Get("bot_forcereachability", "0", 0);			//force reachability calculations
 	Cvar_Get("bot_forcewrite", "0", 0);					//force writing aas file
 	Cvar_Get("bot_aasoptimize", "0", 0);				//no aas file optimisation
-	Cvar_Get("bot_saveroutingcache", "0", 0);			//save routing cache
+	Cvar_Get("bot_saveroutingcache", "0", 0);			//save routing cache, 2 = create complete routing cache first
 	Cvar_Get("bot_thinktime", "100", CVAR_CHEAT);		//msec the bots thinks
 	Cvar_Get("bot_reloadcharacters", "0", 0);			//reload the bot characters each time
 	Cvar_Get("bot_testichat", "0", 0);					//test ichats
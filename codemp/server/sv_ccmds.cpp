@@ -2,6 +2,7 @@
 #include "../qcommon/exe_headers.h"
 
 #include "server.h"
+#include "../ghoul2/G2_local.h"
 #include "../qcommon/stringed_ingame.h"
 
 /*
@@ -939,6 +940,46 @@ static void SV_DumpUser_f( void ) {
 }
 
 
+/*
+===========
+SV_SnapshotInfo_f
+
+Reports how many entities snapshot building had to look at
+===========
+*/
+static void SV_SnapshotInfo_f( void ) {
+	// make sure server is running
+	if ( !com_sv_running->integer ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	Com_Printf( "sv_snapshotIndex: %i\n", sv_snapshotIndex->integer );
+	Com_Printf( "%i snapshots built, %i entities visited", sv.snapshotsBuilt, sv.snapshotEntitiesVisited );
+	if ( sv.snapshotsBuilt ) {
+		Com_Printf( " (%.1f per snapshot, %i entities in level)", (float)sv.snapshotEntitiesVisited / sv.snapshotsBuilt, sv.num_entities );
+	}
+	Com_Printf( "\n" );
+
+	if ( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		sv.snapshotsBuilt = 0;
+		sv.snapshotEntitiesVisited = 0;
+	}
+}
+
+
+/*
+===========
+SV_G2CollisionInfo_f
+
+Reports how often ghoul2 traces reused a model skinned earlier in the frame
+===========
+*/
+static void SV_G2CollisionInfo_f( void ) {
+	G2API_CollisionCacheInfo( (qboolean)( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) );
+}
+
+
 /*
 =================
 SV_KillServer
@@ -977,6 +1018,8 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f);
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f);
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+	Cmd_AddCommand ("snapshotinfo", SV_SnapshotInfo_f);
+	Cmd_AddCommand ("g2collisioninfo", SV_G2CollisionInfo_f);
 	Cmd_AddCommand ("map", SV_Map_f);
 #ifndef PRE_RELEASE_DEMO
 	Cmd_AddCommand ("devmap", SV_Map_f);
@@ -432,6 +432,86 @@ void SV_SendMapChange(void)
 
 void R_SVModelInit();
 
+/*
+================
+SV_PrefetchEntityModels
+
+Queue the ghoul2 models named by the map's entity lump
+================
+*/
+static void SV_PrefetchEntityModels( const char *entities ) {
+	const char	*data;
+	char		*token;
+	const char	*ext;
+	char		key[MAX_TOKEN_CHARS];
+
+	data = entities;
+	while ( data ) {
+		token = COM_Parse( &data );
+		if ( !token[0] ) {
+			break;
+		}
+		if ( token[0] == '{' || token[0] == '}' ) {
+			continue;
+		}
+		Q_strncpyz( key, token, sizeof( key ) );
+		token = COM_Parse( &data );
+		if ( !token[0] ) {
+			break;
+		}
+		if ( Q_stricmp( key, "model" ) && Q_stricmp( key, "model2" ) ) {
+			continue;
+		}
+		ext = strrchr( token, '.' );
+		if ( token[0] == '*' || !ext || Q_stricmp( ext, ".glm" ) ) {
+			continue;
+		}
+		FS_PrefetchFile( token );
+	}
+}
+
+/*
+================
+SV_PrefetchLevelAssets
+
+Queue the BSP, and the models its entity lump names, so the model
+reads overlap with CM_LoadMap parsing the BSP and with game
+initialization.  The entity lump is read out of the prefetched BSP,
+which CM_LoadMap then takes over.  Returns qfalse if the BSP couldn't
+be prefetched, the models have to wait for CM_EntityString then.
+================
+*/
+static qboolean SV_PrefetchLevelAssets( const char *bspName ) {
+	const void		*data;
+	const dheader_t	*header;
+	char			*entities;
+	int				len, ofs, size;
+
+	FS_PrefetchFile( bspName );
+	len = FS_PeekPrefetched( bspName, &data );
+	if ( len < (int)sizeof( dheader_t ) ) {
+		return qfalse;
+	}
+
+	header = (const dheader_t *)data;
+	if ( LittleLong( header->version ) != BSP_VERSION ) {
+		return qfalse;
+	}
+	ofs = LittleLong( header->lumps[LUMP_ENTITIES].fileofs );
+	size = LittleLong( header->lumps[LUMP_ENTITIES].filelen );
+	if ( ofs < 0 || size <= 0 || ofs > len || size > len - ofs ) {
+		return qfalse;
+	}
+
+	entities = (char *)Z_Malloc( size + 1, TAG_TEMP_WORKSPACE, qfalse );
+	Com_Memcpy( entities, (const byte *)data + ofs, size );
+	entities[size] = 0;
+	SV_PrefetchEntityModels( entities );
+	Z_Free( entities );
+
+	return qtrue;
+}
+
 
 #ifdef _XBOX
 //To avoid fragmentation, we want everything free by this point.
@@ -473,6 +553,7 @@ void SV_SpawnServer( char *server, qboolean killBots, ForceReload_e eForceReload
 	int			i;
 	int			checksum;
 	qboolean	isBot;
+	qboolean	prefetched;
 	char		systemInfo[16384];
 	const char	*p;
 
@@ -626,6 +707,9 @@ Ghoul2 Insert End
 	sv.checksumFeed = ( ((int) rand() << 16) ^ rand() ) ^ Com_Milliseconds();
 	FS_Restart( sv.checksumFeed );
 
+	// start reading the level's models while the BSP is parsed
+	prefetched = SV_PrefetchLevelAssets( va("maps/%s.bsp", server) );
+
 #ifdef _XBOX
 	CL_StartHunkUsers();
 	CM_LoadMap( va("maps/%s.bsp", server), qfalse, &checksum );
@@ -638,6 +722,10 @@ Ghoul2 Insert End
 	CM_LoadMap( va("maps/%s.bsp", server), qfalse, &checksum );
 #endif
 
+	if ( !prefetched ) {
+		SV_PrefetchEntityModels( CM_EntityString() );
+	}
+
 	SV_SendMapChange();
 
 	// set serverinfo visible name
@@ -677,6 +765,9 @@ Ghoul2 Insert End
 	G2API_SetTime(svs.time,0);
 	//rww - RAGDOLL_END
 
+	// anything the game didn't ask for is dropped
+	FS_PrefetchFlush();
+
 	// create a baseline for more efficient communications
 	SV_CreateBaseline ();
 
@@ -868,6 +959,9 @@ void SV_Init (void) {
 	sv_padPackets = Cvar_Get ("sv_padPackets", "0", 0);
 	sv_killserver = Cvar_Get ("sv_killserver", "0", 0);
 	sv_mapChecksum = Cvar_Get ("sv_mapChecksum", "", CVAR_ROM);
+	sv_snapshotIndex = Cvar_Get ("sv_snapshotIndex", "1", 0);
+	sv_snapshotThreads = Cvar_Get ("sv_snapshotThreads", "0", 0);
+	sv_deltaCache = Cvar_Get ("sv_deltaCache", "1", 0);
 
 //	sv_debugserver = Cvar_Get ("sv_debugserver", "0", 0);
 
@@ -935,6 +1029,9 @@ void SV_Shutdown( char *finalmsg )
 
 //	Com_Printf( "----- Server Shutdown -----\n" );
 
+	// send anything a frame left batched before the final message
+	NET_FlushPacketBatch();
+
 	if ( svs.clients && !com_errorEntered ) {
 		SV_FinalMessage( finalmsg );
 	}
@@ -953,6 +1050,8 @@ Ghoul2 Insert Start
 		delete[] svs.snapshotEntities;
 		svs.snapshotEntities = NULL;
 	}
+	SV_FreeSnapshotIndex();
+	SV_ShutdownSnapshotThreads();
 
 	// free current level
 	SV_ClearServer();
@@ -38,6 +38,9 @@ cvar_t	*sv_gametype;
 cvar_t	*sv_pure;
 cvar_t	*sv_floodProtect;
 cvar_t	*sv_needpass;
+cvar_t	*sv_snapshotIndex;		// use the per-frame cluster index to build snapshots
+cvar_t	*sv_snapshotThreads;	// extra threads building and encoding snapshots
+cvar_t	*sv_deltaCache;			// reuse encoded entity deltas across clients
 #ifdef USE_CD_KEY
 cvar_t	*sv_allowAnonymous;
 #endif
@@ -827,6 +830,8 @@ void SV_Frame( int msec ) {
 	int		frameMsec;
 	int		startTime;
 
+	PROFILE_ZONE( "SV_Frame" );
+
 	// the menu kills the server with this cvar
 	if ( sv_killserver->integer ) {
 		SV_Shutdown ("Server was killed.\n");
@@ -925,7 +930,9 @@ void SV_Frame( int msec ) {
 	// check timeouts
 	SV_CheckTimeouts();
 
-	// send messages back to the clients
+	// send messages back to the clients, flushing all of the
+	// frame's datagrams together at the end
+	NET_BeginPacketBatch();
 	SV_SendClientMessages();
 
 	SV_CheckCvars();
@@ -934,6 +941,7 @@ void SV_Frame( int msec ) {
 #ifndef _XBOX	// No master on Xbox
 	SV_MasterHeartbeat();
 #endif
+	NET_FlushPacketBatch();
 }
 
 //============================================================================
@@ -33,7 +33,7 @@ SV_EmitPacketEntities
 Writes a delta update of an entityState_t list to the message.
 =============
 */
-static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg ) {
+static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg, entityDeltaCache_t *deltaCache ) {
 	entityState_t	*oldent, *newent;
 	int		oldindex, newindex;
 	int		oldnum, newnum;
@@ -69,7 +69,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emited if the entity has not changed at all
-			MSG_WriteDeltaEntity (msg, oldent, newent, qfalse );
+			MSG_WriteDeltaEntityCached (msg, oldent, newent, qfalse, deltaCache );
 			oldindex++;
 			newindex++;
 			continue;
@@ -77,7 +77,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 		if ( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			MSG_WriteDeltaEntityCached (msg, &sv.svEntities[newnum].baseline, newent, qtrue, deltaCache );
 			newindex++;
 			continue;
 		}
@@ -97,42 +97,58 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 /*
 ==================
-SV_WriteSnapshotToClient
+SV_ChooseDeltaFrame
+
+Picks the previous frame to delta compress the snapshot from, and returns
+how many frames back it is.  Must be called after the snapshot entities
+of every client being sent this frame have been copied off.
 ==================
 */
-static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
-	clientSnapshot_t	*frame, *oldframe;
-	int					lastframe;
-	int					i;
-	int					snapFlags;
-
-	// this is the snapshot we are creating
-	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+static int SV_ChooseDeltaFrame( client_t *client, clientSnapshot_t **oldframe ) {
+	int		lastframe;
 
 	// try to use a previous frame as the source for delta compressing the snapshot
 	if ( client->deltaMessage <= 0 || client->state != CS_ACTIVE ) {
 		// client is asking for a retransmit
-		oldframe = NULL;
+		*oldframe = NULL;
 		lastframe = 0;
 	} else if ( client->netchan.outgoingSequence - client->deltaMessage 
 		>= (PACKET_BACKUP - 3) ) {
 		// client hasn't gotten a good message through in a long time
 		Com_DPrintf ("%s: Delta request from out of date packet.\n", client->name);
-		oldframe = NULL;
+		*oldframe = NULL;
 		lastframe = 0;
 	} else {
 		// we have a valid snapshot to delta from
-		oldframe = &client->frames[ client->deltaMessage & PACKET_MASK ];
+		*oldframe = &client->frames[ client->deltaMessage & PACKET_MASK ];
 		lastframe = client->netchan.outgoingSequence - client->deltaMessage;
 
 		// the snapshot's entities may still have rolled off the buffer, though
-		if ( oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
+		if ( (*oldframe)->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
 			Com_DPrintf ("%s: Delta request from out of date entities.\n", client->name);
-			oldframe = NULL;
+			*oldframe = NULL;
 			lastframe = 0;
 		}
 	}
 
+	return lastframe;
+}
+
+/*
+==================
+SV_WriteSnapshotToClient
+
+Safe to call from a send thread, as long as each thread has its own deltaCache
+==================
+*/
+static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg, clientSnapshot_t *oldframe, int lastframe, entityDeltaCache_t *deltaCache ) {
+	clientSnapshot_t	*frame;
+	int					i;
+	int					snapFlags;
+
+	// this is the snapshot we are creating
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	MSG_WriteByte (msg, svc_snapshot);
 
 	// NOTE, MRE: now sent at the start of every message from server to client
@@ -204,7 +220,7 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	}
 
 	// delta encode the entities
-	SV_EmitPacketEntities (oldframe, frame, msg);
+	SV_EmitPacketEntities (oldframe, frame, msg, deltaCache);
 
 	// padding for rate debugging
 	if ( sv_padPackets->integer ) {
@@ -243,11 +259,27 @@ Build a client snapshot structure
 */
 
 #define	MAX_SNAPSHOT_ENTITIES	1024
+#define	MAX_SNAPSHOT_THREADS	16
 typedef struct {
 	int		numSnapshotEntities;
 	int		snapshotEntities[MAX_SNAPSHOT_ENTITIES];	
 } snapshotEntityNumbers_t;
 
+// everything a thread needs to build snapshots, so that
+// several clients' snapshots can be built at the same time
+typedef struct {
+	int		entityMarks[MAX_GENTITIES];		// prevents double adding from portal views
+	int		entityMarkCount;				// incremented for each snapshot built
+	int		gatherMarks[MAX_GENTITIES];		// prevents gathering an entity twice
+	int		gatherMarkCount;				// incremented for each viewpoint
+	int		entitiesVisited;				// added to sv.snapshotEntitiesVisited
+	entityDeltaCache_t	*deltaCache;		// NULL outside of SV_SendClientMessages
+	entityDeltaCache_t	*deltaCacheAlloc;
+	errorTrap_t			error;				// raised on the main thread once the jobs are done
+} snapshotBuilder_t;
+
+static snapshotBuilder_t	svSnapshotBuilders[1 + MAX_SNAPSHOT_THREADS];	// [0] is the main thread
+
 /*
 =======================
 SV_QsortEntityNumbers
@@ -276,12 +308,12 @@ static int QDECL SV_QsortEntityNumbers( const void *a, const void *b ) {
 SV_AddEntToSnapshot
 ===============
 */
-static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+static void SV_AddEntToSnapshot( snapshotBuilder_t *builder, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+	if ( builder->entityMarks[gEnt->s.number] == builder->entityMarkCount ) {
 		return;
 	}
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	builder->entityMarks[gEnt->s.number] = builder->entityMarkCount;
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES ) {
@@ -292,15 +324,211 @@ static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapsh
 	eNums->numSnapshotEntities++;
 }
 
+/*
+=============================================================================
+
+Per-frame cluster -> entity index
+
+Built once per server frame in SV_SendClientMessages so that each client
+snapshot only has to look at the entities linked into clusters its PVS can
+see, instead of walking every entity on the server.
+
+=============================================================================
+*/
+
+#define	MAX_SNAPSHOT_INDEX_LINKS	(MAX_GENTITIES*MAX_ENT_CLUSTERS)
+
+typedef struct {
+	int			entityNum;
+	int			next;
+} snapshotIndexLink_t;
+
+typedef struct {
+	qboolean			valid;			// false if the index wasn't built this frame
+	int					numClusters;
+	int					*clusterHeads;	// [numClusters], -1 terminated lists into links
+	snapshotIndexLink_t	links[MAX_SNAPSHOT_INDEX_LINKS];
+	int					numLinks;
+	int					alwaysEntities[MAX_GENTITIES];	// must be checked from every viewpoint
+	int					numAlwaysEntities;
+} snapshotIndex_t;
+
+static snapshotIndex_t	svSnapshotIndex;
+
+/*
+===============
+SV_FreeSnapshotIndex
+===============
+*/
+void SV_FreeSnapshotIndex( void ) {
+	if ( svSnapshotIndex.clusterHeads ) {
+		delete[] svSnapshotIndex.clusterHeads;
+		svSnapshotIndex.clusterHeads = NULL;
+	}
+	svSnapshotIndex.numClusters = 0;
+	svSnapshotIndex.valid = qfalse;
+}
+
+/*
+===============
+SV_BuildSnapshotIndex
+
+Sorts every entity that could possibly be sent this frame into
+the clusters it is linked into.  Entities that don't depend on the
+PVS (broadcast, portal entities, overflowed cluster lists) go on a
+separate list that every viewpoint checks.
+===============
+*/
+static void SV_BuildSnapshotIndex( void ) {
+	int				e, i, l;
+	int				numClusters;
+	sharedEntity_t	*ent;
+	svEntity_t		*svEnt;
+	snapshotIndexLink_t	*link;
+
+	svSnapshotIndex.valid = qfalse;
+
+	// the RMG distance cull doesn't use the PVS at all
+	if ( !sv_snapshotIndex->integer || !sv.state || ( com_RMG && com_RMG->integer ) ) {
+		return;
+	}
+
+	numClusters = CM_NumClusters();
+	if ( numClusters <= 0 ) {
+		return;
+	}
+
+	if ( numClusters != svSnapshotIndex.numClusters ) {
+		SV_FreeSnapshotIndex();
+		svSnapshotIndex.clusterHeads = new int[numClusters];
+		svSnapshotIndex.numClusters = numClusters;
+	}
+
+	memset( svSnapshotIndex.clusterHeads, -1, numClusters * sizeof( int ) );
+	svSnapshotIndex.numLinks = 0;
+	svSnapshotIndex.numAlwaysEntities = 0;
+
+	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+		ent = SV_GentityNum(e);
+
+		// the same early outs as SV_AddEntitiesVisibleFromPoint,
+		// the per-client checks are still done there
+		if ( !ent->r.linked ) {
+			continue;
+		}
+		if ( ent->s.eFlags & EF_PERMANENT ) {
+			continue;
+		}
+		if ( ent->r.svFlags & SVF_NOCLIENT ) {
+			continue;
+		}
+
+		svEnt = &sv.svEntities[e];
+
+		if ( ( ent->r.svFlags & SVF_BROADCAST ) || ent->r.broadcastClients[0] || ent->r.broadcastClients[1]
+			|| ent->s.isPortalEnt || svEnt->lastCluster ) {
+			svSnapshotIndex.alwaysEntities[svSnapshotIndex.numAlwaysEntities++] = e;
+			continue;
+		}
+
+		for ( i = 0 ; i < svEnt->numClusters ; i++ ) {
+			l = svEnt->clusternums[i];
+			if ( l < 0 || l >= numClusters ) {
+				continue;
+			}
+			link = &svSnapshotIndex.links[svSnapshotIndex.numLinks];
+			link->entityNum = e;
+			link->next = svSnapshotIndex.clusterHeads[l];
+			svSnapshotIndex.clusterHeads[l] = svSnapshotIndex.numLinks++;
+		}
+	}
+
+	svSnapshotIndex.valid = qtrue;
+}
+
+/*
+===============
+SV_GatherSnapshotCandidates
+
+Fills in the entity numbers that need to be tested from a viewpoint
+with the given PVS row, each entity at most once.  Returns -1 if the
+index can't be used and every entity has to be checked.
+===============
+*/
+#ifdef _XBOX
+static int SV_GatherSnapshotCandidates( snapshotBuilder_t *builder, const byte *clientpvs, int clientNum, int *candidates ) {
+#else
+static int SV_GatherSnapshotCandidates( snapshotBuilder_t *builder, byte *clientpvs, int clientNum, int *candidates ) {
+#endif
+	int		i, bit, l, e;
+	int		numBytes, num;
+	int		link;
+	byte	b;
+
+	if ( !svSnapshotIndex.valid || !clientpvs ) {
+		return -1;
+	}
+
+	builder->gatherMarkCount++;
+	num = 0;
+
+	// the viewer's own entity is always sent, even when it isn't in
+	// a cluster its PVS row covers (noclipping outside the world)
+	if ( clientNum >= 0 && clientNum < sv.num_entities ) {
+		builder->gatherMarks[clientNum] = builder->gatherMarkCount;
+		candidates[num++] = clientNum;
+	}
+
+	for ( i = 0 ; i < svSnapshotIndex.numAlwaysEntities ; i++ ) {
+		e = svSnapshotIndex.alwaysEntities[i];
+		if ( builder->gatherMarks[e] == builder->gatherMarkCount ) {
+			continue;
+		}
+		builder->gatherMarks[e] = builder->gatherMarkCount;
+		candidates[num++] = e;
+	}
+
+	// skip whole bytes of the PVS row at a time
+	numBytes = ( svSnapshotIndex.numClusters + 7 ) >> 3;
+	for ( i = 0 ; i < numBytes ; i++ ) {
+		b = clientpvs[i];
+		if ( !b ) {
+			continue;
+		}
+		for ( bit = 0 ; bit < 8 ; bit++ ) {
+			if ( !( b & ( 1 << bit ) ) ) {
+				continue;
+			}
+			l = ( i << 3 ) + bit;
+			if ( l >= svSnapshotIndex.numClusters ) {
+				break;
+			}
+			for ( link = svSnapshotIndex.clusterHeads[l] ; link != -1 ; link = svSnapshotIndex.links[link].next ) {
+				e = svSnapshotIndex.links[link].entityNum;
+				if ( builder->gatherMarks[e] == builder->gatherMarkCount ) {
+					continue;
+				}
+				builder->gatherMarks[e] = builder->gatherMarkCount;
+				candidates[num++] = e;
+			}
+		}
+	}
+
+	return num;
+}
+
 /*
 ===============
 SV_AddEntitiesVisibleFromPoint
 ===============
 */
 float g_svCullDist = -1.0f;
-static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame, 
+static void SV_AddEntitiesVisibleFromPoint( snapshotBuilder_t *builder, vec3_t origin, clientSnapshot_t *frame, 
 									snapshotEntityNumbers_t *eNums, qboolean portal ) {
 	int		e, i;
+	int		c, numCandidates;
+	int		candidates[MAX_GENTITIES];
+	qboolean	useIndex;
 	sharedEntity_t *ent;
 	svEntity_t	*svEnt;
 	int		l;
@@ -335,7 +563,16 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 
 	c_fullsend = 0;
 
-	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+	// only look at the entities in clusters this viewpoint can see
+	numCandidates = SV_GatherSnapshotCandidates( builder, clientpvs, frame->ps.clientNum, candidates );
+	useIndex = (qboolean)( numCandidates >= 0 );
+	if ( !useIndex ) {
+		numCandidates = sv.num_entities;
+	}
+	builder->entitiesVisited += numCandidates;
+
+	for ( c = 0 ; c < numCandidates ; c++ ) {
+		e = useIndex ? candidates[c] : c;
 		ent = SV_GentityNum(e);
 
 		// never send entities that aren't linked in
@@ -374,20 +611,20 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		svEnt = SV_SvEntityForGentity( ent );
 
 		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+		if ( builder->entityMarks[e] == builder->entityMarkCount ) {
 			continue;
 		}
 
 		// broadcast entities are always sent, and so is the main player so we don't see noclip weirdness
 		if ( ent->r.svFlags & SVF_BROADCAST || (e == frame->ps.clientNum) || (ent->r.broadcastClients[frame->ps.clientNum/32] & (1<<(frame->ps.clientNum%32))))
 		{
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( builder, ent, eNums );
 			continue;
 		}
 
 		if (ent->s.isPortalEnt)
 		{ //rww - portal entities are always sent as well
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( builder, ent, eNums );
 			continue;
 		}
 
@@ -403,7 +640,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			radius = VectorLength(difference);
 			if (length-radius < /*sv_RMGDistanceCull->integer*/5000.0f)
 			{	// more of a diameter check
-				SV_AddEntToSnapshot( svEnt, ent, eNums );
+				SV_AddEntToSnapshot( builder, ent, eNums );
 			}
 		}
 		else
@@ -476,7 +713,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			}
 
 			// add it
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( builder, ent, eNums );
 
 			// if its a portal entity, add everything visible from its camera position
 			if ( ent->r.svFlags & SVF_PORTAL ) {
@@ -487,7 +724,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 						continue;
 					}
 				}
-				SV_AddEntitiesVisibleFromPoint( ent->s.origin2, frame, eNums, qtrue );
+				SV_AddEntitiesVisibleFromPoint( builder, ent->s.origin2, frame, eNums, qtrue );
 #ifdef _XBOX
 				//Must get clientpvs again since above call destroyed it.
 			clientpvs = CM_ClusterPVS (clientcluster);
@@ -502,40 +739,40 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 SV_BuildClientSnapshot
 
 Decides which entities are going to be visible to the client, and
-copies off the playerstate and areabits.
+copies off the playerstate and areabits.  Returns qfalse if the
+client has nothing to see.
 
 This properly handles multiple recursive portals, but the render
 currently doesn't.
 
 For viewing through other player's eyes, clent can be something other than client->gentity
+
+Only reads the game state, so it is safe to call from a send thread
+as long as each thread has its own builder.
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client ) {
+static qboolean SV_BuildClientSnapshot( client_t *client, snapshotBuilder_t *builder, snapshotEntityNumbers_t *entityNumbers ) {
 	vec3_t						org;
 	clientSnapshot_t			*frame;
-	snapshotEntityNumbers_t		entityNumbers;
 	int							i;
-	sharedEntity_t				*ent;
-	entityState_t				*state;
-	svEntity_t					*svEnt;
 	sharedEntity_t				*clent;
 	playerState_t				*ps;
 
 	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
+	builder->entityMarkCount++;
 
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
+	entityNumbers->numSnapshotEntities = 0;
 	Com_Memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
 	frame->num_entities = 0;
 
 	clent = client->gentity;
 	if ( !clent || client->state == CS_ZOMBIE ) {
-		return;
+		return qfalse;
 	}
 
 	// grab the current playerState_t
@@ -569,8 +806,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
 		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
 	}
-	svEnt = &sv.svEntities[ clientNum ];
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	builder->entityMarks[ clientNum ] = builder->entityMarkCount;
 
 	
 	// find the client's viewpoint
@@ -579,14 +815,14 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
-	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers, qfalse );
+	SV_AddEntitiesVisibleFromPoint( builder, org, frame, entityNumbers, qfalse );
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
 	// to work correctly.  This also catches the error condition
 	// of an entity being included twice.
-	qsort( entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities, 
-		sizeof( entityNumbers.snapshotEntities[0] ), SV_QsortEntityNumbers );
+	qsort( entityNumbers->snapshotEntities, entityNumbers->numSnapshotEntities, 
+		sizeof( entityNumbers->snapshotEntities[0] ), SV_QsortEntityNumbers );
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
@@ -594,11 +830,30 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		((int *)frame->areabits)[i] = ((int *)frame->areabits)[i] ^ -1;
 	}
 
+	return qtrue;
+}
+
+/*
+=============
+SV_CopySnapshotEntities
+
+Copies the entity states picked by SV_BuildClientSnapshot into the
+shared snapshot entity ring.  Clients must be copied one at a time.
+=============
+*/
+static void SV_CopySnapshotEntities( client_t *client, snapshotEntityNumbers_t *entityNumbers ) {
+	clientSnapshot_t			*frame;
+	int							i;
+	sharedEntity_t				*ent;
+	entityState_t				*state;
+
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	// copy the entity states out
 	frame->num_entities = 0;
 	frame->first_entity = svs.nextSnapshotEntities;
-	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
+	for ( i = 0 ; i < entityNumbers->numSnapshotEntities ; i++ ) {
+		ent = SV_GentityNum(entityNumbers->snapshotEntities[i]);
 		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
 		*state = ent->s;
 		svs.nextSnapshotEntities++;
@@ -709,59 +964,122 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 
 /*
 =======================
-SV_SendClientSnapshot
-
-Also called by SV_FinalMessage
+SV_SendClientGamedir
 
+rww - if the client hasn't been sent the gamedir yet, make sure
+there is an svc_setgame sent before the next snapshot
 =======================
 */
 extern cvar_t	*fs_gamedirvar;
-void SV_SendClientSnapshot( client_t *client ) {
+static void SV_SendClientGamedir( client_t *client ) {
 	byte		msg_buf[MAX_MSGLEN];
 	msg_t		msg;
+	int			i = 0;
 
-	if (!client->sentGamedir)
-	{ //rww - if this is the case then make sure there is an svc_setgame sent before this snap
-		int i = 0;
+	MSG_Init (&msg, msg_buf, sizeof(msg_buf));
 
-		MSG_Init (&msg, msg_buf, sizeof(msg_buf));
+	//have to include this for each message.
+	MSG_WriteLong( &msg, client->lastClientCommand );
 
-		//have to include this for each message.
-		MSG_WriteLong( &msg, client->lastClientCommand );
+	MSG_WriteByte (&msg, svc_setgame);
 
-		MSG_WriteByte (&msg, svc_setgame);
+	while (fs_gamedirvar->string[i])
+	{
+		MSG_WriteByte(&msg, fs_gamedirvar->string[i]);
+		i++;
+	}
+	MSG_WriteByte(&msg, 0);
 
-		while (fs_gamedirvar->string[i])
-		{
-			MSG_WriteByte(&msg, fs_gamedirvar->string[i]);
-			i++;
-		}
-		MSG_WriteByte(&msg, 0);
+	// MW - my attempt to fix illegible server message errors caused by 
+	// packet fragmentation of initial snapshot.
+	//rww - reusing this code here
+	while(client->state&&client->netchan.unsentFragments)
+	{
+		// send additional message fragments if the last message
+		// was too large to send at once
+		Com_Printf ("[ISM]SV_SendClientGameState() [1] for %s, writing out old fragments\n", client->name);
+		SV_Netchan_TransmitNextFragment(&client->netchan);
+	}
 
-		// MW - my attempt to fix illegible server message errors caused by 
-		// packet fragmentation of initial snapshot.
-		//rww - reusing this code here
-		while(client->state&&client->netchan.unsentFragments)
-		{
-			// send additional message fragments if the last message
-			// was too large to send at once
-			Com_Printf ("[ISM]SV_SendClientGameState() [1] for %s, writing out old fragments\n", client->name);
-			SV_Netchan_TransmitNextFragment(&client->netchan);
-		}
+	// record information about the message
+	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSize = msg.cursize;
+	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSent = svs.time;
+	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageAcked = -1;
+
+	// send the datagram
+	SV_Netchan_Transmit( client, &msg );	//msg->cursize, msg->data );
+
+	client->sentGamedir = qtrue;
+}
+
+/*
+=======================
+SV_BeginClientMessage
+
+Writes everything that goes in front of the snapshot
+=======================
+*/
+static void SV_BeginClientMessage( client_t *client, msg_t *msg, byte *msg_buf, int bufSize ) {
+	MSG_Init (msg, msg_buf, bufSize);
+	msg->allowoverflow = qtrue;
+
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( msg, client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( client, msg );
+}
 
-		// record information about the message
-		client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSize = msg.cursize;
-		client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSent = svs.time;
-		client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageAcked = -1;
+/*
+=======================
+SV_FinishClientMessage
 
-		// send the datagram
-		SV_Netchan_Transmit( client, &msg );	//msg->cursize, msg->data );
+Writes everything that goes after the snapshot and sends the message
+=======================
+*/
+static void SV_FinishClientMessage( client_t *client, msg_t *msg ) {
+	// Add any download data if the client is downloading
+#ifndef _XBOX	// No downloads on Xbox
+	SV_WriteDownloadToClient( client, msg );
+#endif
 
-		client->sentGamedir = qtrue;
+	// check for overflow
+	if ( msg->overflowed ) {
+		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
+		MSG_Clear (msg);
+	}
+
+	SV_SendMessageToClient( msg, client );
+}
+
+/*
+=======================
+SV_SendClientSnapshot
+
+Also called by SV_FinalMessage
+
+=======================
+*/
+void SV_SendClientSnapshot( client_t *client ) {
+	byte				msg_buf[MAX_MSGLEN];
+	msg_t				msg;
+	snapshotEntityNumbers_t	entityNumbers;
+	clientSnapshot_t	*oldframe;
+	int					lastframe;
+
+	if (!client->sentGamedir)
+	{
+		SV_SendClientGamedir( client );
 	}
 
 	// build the snapshot
-	SV_BuildClientSnapshot( client );
+	svSnapshotBuilders[0].entitiesVisited = 0;
+	if ( SV_BuildClientSnapshot( client, &svSnapshotBuilders[0], &entityNumbers ) ) {
+		SV_CopySnapshotEntities( client, &entityNumbers );
+	}
+	sv.snapshotsBuilt++;
+	sv.snapshotEntitiesVisited += svSnapshotBuilders[0].entitiesVisited;
 
 	// bots need to have their snapshots build, but
 	// the query them directly without needing to be sent
@@ -769,34 +1087,381 @@ void SV_SendClientSnapshot( client_t *client ) {
 		return;
 	}
 
-	MSG_Init (&msg, msg_buf, sizeof(msg_buf));
-	msg.allowoverflow = qtrue;
-
-	// NOTE, MRE: all server->client messages now acknowledge
-	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
-
-	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
+	SV_BeginClientMessage( client, &msg, msg_buf, sizeof( msg_buf ) );
 
 	// send over all the relevant entityState_t
 	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+	lastframe = SV_ChooseDeltaFrame( client, &oldframe );
+	SV_WriteSnapshotToClient( client, &msg, oldframe, lastframe, svSnapshotBuilders[0].deltaCache );
 
-	// Add any download data if the client is downloading
-#ifndef _XBOX	// No downloads on Xbox
-	SV_WriteDownloadToClient( client, &msg );
-#endif
+	SV_FinishClientMessage( client, &msg );
+}
 
-	// check for overflow
-	if ( msg.overflowed ) {
-		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
-		MSG_Clear (&msg);
+
+/*
+=============================================================================
+
+Threaded snapshot sending
+
+With sv_snapshotThreads set, SV_SendClientMessages builds and encodes the
+snapshots of all the clients due this frame on a pool of send threads:
+
+1. the send threads pick each client's visible entities
+2. the entity states are copied into the snapshot ring in client order
+3. the send threads delta encode each client's message
+4. downloads are added and the messages transmitted in client order
+
+Only steps 1 and 3 run on the send threads, and they never write
+anything other clients' steps read.
+
+=============================================================================
+*/
+
+typedef struct {
+	client_t				*client;
+	qboolean				built;				// SV_BuildClientSnapshot found a viewpoint
+	qboolean				sendMessage;		// bots only need the snapshot built
+	snapshotEntityNumbers_t	entityNumbers;
+	clientSnapshot_t		*oldframe;
+	int						lastframe;
+	msg_t					msg;
+	byte					msgBuf[MAX_MSGLEN];
+} snapshotJob_t;
+
+typedef void (*snapshotJobFunc_t)( snapshotJob_t *job, snapshotBuilder_t *builder );
+
+typedef struct {
+	int					requestedThreads;	// sv_snapshotThreads when the threads were started
+	int					numThreads;			// not counting the main thread, may be fewer than requested
+	void				*threads[MAX_SNAPSHOT_THREADS];
+	void				*startSemaphore;
+	void				*doneSemaphore;
+	qboolean			shutdown;
+
+	snapshotJob_t		*jobs;				// [maxJobs]
+	int					maxJobs;			// sv_maxclients when the threads were started
+	int					numJobs;
+	snapshotJobFunc_t	jobFunc;
+	volatile int		nextJob;
+	volatile int		runningThreads;
+} snapshotPool_t;
+
+static snapshotPool_t	svSnapshotPool;
+
+/*
+=======================
+SV_RunSnapshotJobs
+
+Runs jobs until they have all been taken
+=======================
+*/
+static void SV_RunSnapshotJobs( snapshotBuilder_t *builder ) {
+	int		job;
+
+	builder->error.code = 0;
+	Com_SetErrorTrap( &builder->error );
+
+	try {
+		while ( 1 ) {
+			job = Sys_AtomicAdd( &svSnapshotPool.nextJob, 1 ) - 1;
+			if ( job >= svSnapshotPool.numJobs ) {
+				break;
+			}
+			svSnapshotPool.jobFunc( &svSnapshotPool.jobs[job], builder );
+		}
+	}
+	catch ( const char * ) {
+		// the error is in builder->error, stop the other threads taking more jobs
+		svSnapshotPool.nextJob = svSnapshotPool.numJobs;
+	}
+
+	Com_SetErrorTrap( NULL );
+}
+
+/*
+=======================
+SV_SnapshotThread
+=======================
+*/
+static void SV_SnapshotThread( void *data ) {
+	snapshotBuilder_t	*builder = (snapshotBuilder_t *)data;
+
+	while ( 1 ) {
+		Sys_SemaphoreWait( svSnapshotPool.startSemaphore );
+		if ( svSnapshotPool.shutdown ) {
+			break;
+		}
+
+		SV_RunSnapshotJobs( builder );
+
+		if ( !Sys_AtomicAdd( &svSnapshotPool.runningThreads, -1 ) ) {
+			Sys_SemaphorePost( svSnapshotPool.doneSemaphore );
+		}
+	}
+}
+
+/*
+=======================
+SV_DispatchSnapshotJobs
+
+Runs jobFunc on every job, using the main thread as one of the workers
+=======================
+*/
+static void SV_DispatchSnapshotJobs( snapshotJobFunc_t jobFunc, int numJobs ) {
+	int		i;
+
+	svSnapshotPool.jobFunc = jobFunc;
+	svSnapshotPool.numJobs = numJobs;
+	svSnapshotPool.nextJob = 0;
+	svSnapshotPool.runningThreads = svSnapshotPool.numThreads;
+
+	for ( i = 0 ; i < svSnapshotPool.numThreads ; i++ ) {
+		Sys_SemaphorePost( svSnapshotPool.startSemaphore );
+	}
+
+	SV_RunSnapshotJobs( &svSnapshotBuilders[0] );
+
+	Sys_SemaphoreWait( svSnapshotPool.doneSemaphore );
+
+	// every thread is idle again, so it's safe to unwind now
+	for ( i = 0 ; i <= svSnapshotPool.numThreads ; i++ ) {
+		if ( svSnapshotBuilders[i].error.code ) {
+			Com_Error( svSnapshotBuilders[i].error.code, "%s", svSnapshotBuilders[i].error.message );
+		}
+	}
+}
+
+/*
+=======================
+SV_ShutdownSnapshotThreads
+=======================
+*/
+void SV_ShutdownSnapshotThreads( void ) {
+	int		i;
+
+	svSnapshotPool.shutdown = qtrue;
+	for ( i = 0 ; i < svSnapshotPool.numThreads ; i++ ) {
+		Sys_SemaphorePost( svSnapshotPool.startSemaphore );
+	}
+	for ( i = 0 ; i < svSnapshotPool.numThreads ; i++ ) {
+		Sys_JoinThread( svSnapshotPool.threads[i] );
+	}
+
+	if ( svSnapshotPool.startSemaphore ) {
+		Sys_DestroySemaphore( svSnapshotPool.startSemaphore );
+	}
+	if ( svSnapshotPool.doneSemaphore ) {
+		Sys_DestroySemaphore( svSnapshotPool.doneSemaphore );
+	}
+	if ( svSnapshotPool.jobs ) {
+		delete[] svSnapshotPool.jobs;
+	}
+
+	// the delta caches get allocated again for however many threads there are now
+	for ( i = 0 ; i <= MAX_SNAPSHOT_THREADS ; i++ ) {
+		if ( svSnapshotBuilders[i].deltaCacheAlloc ) {
+			MSG_FreeEntityDeltaCache( svSnapshotBuilders[i].deltaCacheAlloc );
+			svSnapshotBuilders[i].deltaCacheAlloc = NULL;
+		}
+		svSnapshotBuilders[i].deltaCache = NULL;
+	}
+
+	Com_Memset( &svSnapshotPool, 0, sizeof( svSnapshotPool ) );
+}
+
+/*
+=======================
+SV_StartSnapshotThreads
+=======================
+*/
+static void SV_StartSnapshotThreads( int numThreads ) {
+	int		i;
+
+	svSnapshotPool.requestedThreads = numThreads;
+	if ( numThreads > MAX_SNAPSHOT_THREADS ) {
+		numThreads = MAX_SNAPSHOT_THREADS;
+	}
+
+	svSnapshotPool.shutdown = qfalse;
+	svSnapshotPool.startSemaphore = Sys_CreateSemaphore( 0 );
+	svSnapshotPool.doneSemaphore = Sys_CreateSemaphore( 0 );
+	if ( !svSnapshotPool.startSemaphore || !svSnapshotPool.doneSemaphore ) {
+		Com_Printf( "WARNING: couldn't create snapshot thread semaphores\n" );
+		SV_ShutdownSnapshotThreads();
+		Cvar_Set( "sv_snapshotThreads", "0" );
+		return;
+	}
+
+	svSnapshotPool.jobs = new snapshotJob_t[sv_maxclients->integer];
+	svSnapshotPool.maxJobs = sv_maxclients->integer;
+
+	for ( i = 0 ; i < numThreads ; i++ ) {
+		svSnapshotPool.threads[i] = Sys_CreateThread( SV_SnapshotThread, &svSnapshotBuilders[i+1] );
+		if ( !svSnapshotPool.threads[i] ) {
+			Com_Printf( "WARNING: only started %i of %i snapshot threads\n", i, numThreads );
+			break;
+		}
+		svSnapshotPool.numThreads++;
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	if ( !svSnapshotPool.numThreads ) {
+		SV_ShutdownSnapshotThreads();
+		Cvar_Set( "sv_snapshotThreads", "0" );
+	}
 }
 
+/*
+=======================
+SV_BuildSnapshotJob
+=======================
+*/
+static void SV_BuildSnapshotJob( snapshotJob_t *job, snapshotBuilder_t *builder ) {
+	job->built = SV_BuildClientSnapshot( job->client, builder, &job->entityNumbers );
+}
+
+/*
+=======================
+SV_EncodeSnapshotJob
+=======================
+*/
+static void SV_EncodeSnapshotJob( snapshotJob_t *job, snapshotBuilder_t *builder ) {
+	if ( !job->sendMessage ) {
+		return;
+	}
+
+	SV_BeginClientMessage( job->client, &job->msg, job->msgBuf, sizeof( job->msgBuf ) );
+	SV_WriteSnapshotToClient( job->client, &job->msg, job->oldframe, job->lastframe, builder->deltaCache );
+}
+
+/*
+=======================
+SV_SendClientMessagesThreaded
+=======================
+*/
+static void SV_SendClientMessagesThreaded( void ) {
+	int				i, numJobs;
+	client_t		*c;
+	snapshotJob_t	*job;
+	sharedEntity_t	*ent;
+
+	// the checks SV_SendClientMessages does, but the snapshots
+	// are queued up instead of being sent right away
+	numJobs = 0;
+	for (i=0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++) {
+		if (!c->state) {
+			continue;		// not connected
+		}
+
+		if ( svs.time < c->nextSnapshotTime ) {
+			continue;		// not time yet
+		}
+
+		// send additional message fragments if the last message
+		// was too large to send at once
+		if ( c->netchan.unsentFragments ) {
+			c->nextSnapshotTime = svs.time + 
+				SV_RateMsec( c, c->netchan.unsentLength - c->netchan.unsentFragmentStart );
+			SV_Netchan_TransmitNextFragment( &c->netchan );
+			continue;
+		}
+
+		if (!c->sentGamedir)
+		{
+			SV_SendClientGamedir( c );
+		}
+
+		job = &svSnapshotPool.jobs[numJobs++];
+		job->client = c;
+		job->sendMessage = (qboolean)!( c->gentity && c->gentity->r.svFlags & SVF_BOT );
+	}
+
+	if ( !numJobs ) {
+		return;
+	}
+
+	// SV_AddEntitiesVisibleFromPoint repairs entity numbers as it goes,
+	// which the send threads can't be allowed to do
+	for ( i = 0 ; i < sv.num_entities ; i++ ) {
+		ent = SV_GentityNum(i);
+		if ( ent->s.number != i ) {
+			Com_DPrintf ("FIXING ENT->S.NUMBER!!!\n");
+			ent->s.number = i;
+		}
+	}
+
+	for ( i = 0 ; i <= svSnapshotPool.numThreads ; i++ ) {
+		svSnapshotBuilders[i].entitiesVisited = 0;
+	}
+
+	SV_DispatchSnapshotJobs( SV_BuildSnapshotJob, numJobs );
+
+	for ( i = 0 ; i <= svSnapshotPool.numThreads ; i++ ) {
+		sv.snapshotEntitiesVisited += svSnapshotBuilders[i].entitiesVisited;
+	}
+	sv.snapshotsBuilt += numJobs;
+
+	// reserve each client's range of the snapshot ring in client order,
+	// then pick delta frames now that the ring won't move again this frame
+	for ( i = 0, job = svSnapshotPool.jobs ; i < numJobs ; i++, job++ ) {
+		if ( job->built ) {
+			SV_CopySnapshotEntities( job->client, &job->entityNumbers );
+		}
+	}
+	for ( i = 0, job = svSnapshotPool.jobs ; i < numJobs ; i++, job++ ) {
+		if ( job->sendMessage ) {
+			job->lastframe = SV_ChooseDeltaFrame( job->client, &job->oldframe );
+		}
+	}
+
+	SV_DispatchSnapshotJobs( SV_EncodeSnapshotJob, numJobs );
+
+	for ( i = 0, job = svSnapshotPool.jobs ; i < numJobs ; i++, job++ ) {
+		if ( job->sendMessage ) {
+			SV_FinishClientMessage( job->client, &job->msg );
+		}
+	}
+}
+
+
+/*
+=======================
+SV_BeginDeltaCaches
+
+The game state has moved on since the last frame's snapshots, so
+every encoded entity delta has to be thrown away
+=======================
+*/
+static void SV_BeginDeltaCaches( void ) {
+	int					i;
+	snapshotBuilder_t	*builder;
+
+	for ( i = 0, builder = svSnapshotBuilders ; i <= svSnapshotPool.numThreads ; i++, builder++ ) {
+		if ( !sv_deltaCache->integer ) {
+			builder->deltaCache = NULL;
+			continue;
+		}
+		if ( !builder->deltaCacheAlloc ) {
+			builder->deltaCacheAlloc = MSG_AllocEntityDeltaCache();
+		}
+		MSG_ClearEntityDeltaCache( builder->deltaCacheAlloc );
+		builder->deltaCache = builder->deltaCacheAlloc;
+	}
+}
+
+/*
+=======================
+SV_EndDeltaCaches
+
+Snapshots sent from anywhere else don't use the caches
+=======================
+*/
+static void SV_EndDeltaCaches( void ) {
+	int		i;
+
+	for ( i = 0 ; i <= svSnapshotPool.numThreads ; i++ ) {
+		svSnapshotBuilders[i].deltaCache = NULL;
+	}
+}
 
 /*
 =======================
@@ -806,6 +1471,32 @@ SV_SendClientMessages
 void SV_SendClientMessages( void ) {
 	int			i;
 	client_t	*c;
+	int			requestedThreads;
+
+	PROFILE_ZONE( "SV_SendClientMessages" );
+
+	// sort the entities into clusters once for all of this frame's snapshots
+	SV_BuildSnapshotIndex();
+
+	// compared against what was asked for, a clamped or partial start
+	// would otherwise restart the threads every frame
+	requestedThreads = sv_snapshotThreads->integer > 0 ? sv_snapshotThreads->integer : 0;
+	if ( requestedThreads != svSnapshotPool.requestedThreads
+		|| ( svSnapshotPool.numThreads && svSnapshotPool.maxJobs != sv_maxclients->integer ) ) {
+		SV_ShutdownSnapshotThreads();
+		if ( requestedThreads ) {
+			SV_StartSnapshotThreads( requestedThreads );
+		}
+	}
+
+	SV_BeginDeltaCaches();
+
+	if ( svSnapshotPool.numThreads ) {
+		SV_SendClientMessagesThreaded();
+		SV_EndDeltaCaches();
+		svSnapshotIndex.valid = qfalse;
+		return;
+	}
 
 	// send a message to each connected client
 	for (i=0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++) {
@@ -829,5 +1520,8 @@ void SV_SendClientMessages( void ) {
 		// generate and send a new message
 		SV_SendClientSnapshot( c );
 	}
-}
 
+	// snapshots sent from anywhere else do a full scan
+	SV_EndDeltaCaches();
+	svSnapshotIndex.valid = qfalse;
+}
@@ -25,6 +25,7 @@
 #endif
 
 static cvar_t	*noudp;
+static cvar_t	*net_batch;
 
 netadr_t	net_local_adr;
 
@@ -132,6 +133,242 @@ qboolean	Sys_StringToAdr (const char *s, netadr_t *a)
 }
 
 
+//=============================================================================
+
+/*
+==============================================================================
+
+BATCHED UDP
+
+On Linux the dedicated server drains the socket with recvmmsg into a ring
+of packet buffers, so a burst of client usercmds costs one syscall instead
+of one per datagram.  Outgoing datagrams queued between
+NET_BeginPacketBatch and NET_FlushPacketBatch go out in a single sendmmsg.
+Neither path is thread safe; SV_Frame only sends from the main thread.
+
+==============================================================================
+*/
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define NET_BATCHING
+#endif
+
+#ifdef NET_BATCHING
+
+#define	NET_BATCH_RECV		32				// datagrams drained per recvmmsg
+#define	NET_BATCH_SEND		128				// datagrams queued per sendmmsg
+#define	NET_BATCH_SENDLEN	1400			// MAX_PACKETLEN in net_chan.cpp
+
+typedef struct {
+	byte				data[MAX_MSGLEN];
+	struct sockaddr_in	from;
+} netRecvPacket_t;
+
+typedef struct {
+	byte				data[NET_BATCH_SENDLEN];
+	struct sockaddr_in	to;
+	netadr_t			adr;
+} netSendPacket_t;
+
+static netRecvPacket_t	net_recvPackets[NET_BATCH_RECV];
+static struct mmsghdr	net_recvHdrs[NET_BATCH_RECV];
+static struct iovec		net_recvIov[NET_BATCH_RECV];
+static int				net_recvHead, net_recvCount;
+
+static netSendPacket_t	net_sendPackets[NET_BATCH_SEND];
+static struct mmsghdr	net_sendHdrs[NET_BATCH_SEND];
+static struct iovec		net_sendIov[NET_BATCH_SEND];
+static int				net_sendCount;
+static qboolean			net_sendBatching;
+
+// set when the running kernel doesn't provide the mmsg syscalls
+static qboolean			net_batchUnsupported;
+
+static qboolean NET_BatchActive( void ) {
+	return (qboolean)( net_batch && net_batch->integer && !net_batchUnsupported );
+}
+
+/*
+==================
+NET_FillRecvBatch
+
+Returns the number of datagrams read into the ring
+==================
+*/
+static int NET_FillRecvBatch( void ) {
+	int		i;
+	int		ret;
+
+	for ( i = 0 ; i < NET_BATCH_RECV ; i++ ) {
+		net_recvIov[i].iov_base = net_recvPackets[i].data;
+		net_recvIov[i].iov_len = sizeof( net_recvPackets[i].data );
+		memset( &net_recvHdrs[i], 0, sizeof( net_recvHdrs[i] ) );
+		net_recvHdrs[i].msg_hdr.msg_name = &net_recvPackets[i].from;
+		net_recvHdrs[i].msg_hdr.msg_namelen = sizeof( net_recvPackets[i].from );
+		net_recvHdrs[i].msg_hdr.msg_iov = &net_recvIov[i];
+		net_recvHdrs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	ret = recvmmsg( ip_socket, net_recvHdrs, NET_BATCH_RECV, MSG_DONTWAIT, NULL );
+	if ( ret == -1 ) {
+		if ( errno == ENOSYS ) {
+			Com_Printf( "NET_GetPacket: recvmmsg unsupported, using recvfrom\n" );
+			net_batchUnsupported = qtrue;
+		} else if ( errno != EWOULDBLOCK && errno != ECONNREFUSED && errno != EINTR ) {
+			Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
+		}
+		return 0;
+	}
+
+	net_recvHead = 0;
+	net_recvCount = ret;
+	return ret;
+}
+
+/*
+==================
+NET_GetBatchedPacket
+==================
+*/
+static qboolean NET_GetBatchedPacket( netadr_t *net_from, msg_t *net_message ) {
+	netRecvPacket_t	*p;
+	int				len;
+
+	while ( 1 ) {
+		if ( net_recvHead >= net_recvCount && ( !NET_BatchActive() || !NET_FillRecvBatch() ) ) {
+			return qfalse;
+		}
+
+		p = &net_recvPackets[net_recvHead];
+		len = net_recvHdrs[net_recvHead].msg_len;
+		net_recvHead++;
+
+		SockadrToNetadr( &p->from, net_from );
+		net_message->readcount = 0;
+
+		if ( len >= net_message->maxsize || len == (int)sizeof( p->data ) ) {
+			Com_Printf( "Oversize packet from %s\n", NET_AdrToString( *net_from ) );
+			continue;
+		}
+
+		Com_Memcpy( net_message->data, p->data, len );
+		net_message->cursize = len;
+		return qtrue;
+	}
+}
+
+/*
+==================
+NET_BeginPacketBatch
+
+Datagrams sent over IP after this are held until NET_FlushPacketBatch
+==================
+*/
+void NET_BeginPacketBatch( void ) {
+	if ( !ip_socket || !NET_BatchActive() ) {
+		return;
+	}
+	net_sendBatching = qtrue;
+}
+
+/*
+==================
+NET_FlushPacketBatch
+==================
+*/
+void NET_FlushPacketBatch( void ) {
+	int		i;
+	int		sent;
+	int		ret;
+
+	if ( net_sendCount ) {
+		for ( i = 0 ; i < net_sendCount ; i++ ) {
+			net_sendHdrs[i].msg_len = 0;
+		}
+
+		sent = 0;
+		while ( sent < net_sendCount ) {
+			ret = sendmmsg( ip_socket, &net_sendHdrs[sent], net_sendCount - sent, 0 );
+			if ( ret == -1 ) {
+				if ( errno == ENOSYS ) {
+					// fall back to one sendto per datagram for the rest of the session
+					net_batchUnsupported = qtrue;
+					for ( i = sent ; i < net_sendCount ; i++ ) {
+						if ( sendto( ip_socket, net_sendPackets[i].data, net_sendIov[i].iov_len, 0,
+							(struct sockaddr *)&net_sendPackets[i].to, sizeof( net_sendPackets[i].to ) ) == -1 ) {
+							Com_Printf( "NET_SendPacket ERROR: %s to %s\n", NET_ErrorString(),
+								NET_AdrToString( net_sendPackets[i].adr ) );
+						}
+					}
+					break;
+				}
+				// the datagram at the head failed, report it and carry on with the rest
+				Com_Printf( "NET_SendPacket ERROR: %s to %s\n", NET_ErrorString(),
+					NET_AdrToString( net_sendPackets[sent].adr ) );
+				sent++;
+				continue;
+			}
+			sent += ret;
+		}
+		net_sendCount = 0;
+	}
+
+	net_sendBatching = qfalse;
+}
+
+/*
+==================
+NET_QueuePacket
+
+Returns qfalse if the datagram has to be sent immediately
+==================
+*/
+static qboolean NET_QueuePacket( int net_socket, int length, const void *data, netadr_t to ) {
+	netSendPacket_t	*p;
+
+	if ( !net_sendBatching || net_socket != ip_socket ) {
+		return qfalse;
+	}
+
+	if ( length > NET_BATCH_SENDLEN ) {
+		// keep datagram order, then let the caller send this one directly
+		NET_FlushPacketBatch();
+		net_sendBatching = qtrue;
+		return qfalse;
+	}
+
+	if ( net_sendCount == NET_BATCH_SEND ) {
+		NET_FlushPacketBatch();
+		net_sendBatching = qtrue;
+	}
+
+	p = &net_sendPackets[net_sendCount];
+	Com_Memcpy( p->data, data, length );
+	NetadrToSockadr( &to, &p->to );
+	p->adr = to;
+
+	net_sendIov[net_sendCount].iov_base = p->data;
+	net_sendIov[net_sendCount].iov_len = length;
+	memset( &net_sendHdrs[net_sendCount], 0, sizeof( net_sendHdrs[net_sendCount] ) );
+	net_sendHdrs[net_sendCount].msg_hdr.msg_name = &p->to;
+	net_sendHdrs[net_sendCount].msg_hdr.msg_namelen = sizeof( p->to );
+	net_sendHdrs[net_sendCount].msg_hdr.msg_iov = &net_sendIov[net_sendCount];
+	net_sendHdrs[net_sendCount].msg_hdr.msg_iovlen = 1;
+	net_sendCount++;
+
+	return qtrue;
+}
+
+#else
+
+void NET_BeginPacketBatch( void ) {
+}
+
+void NET_FlushPacketBatch( void ) {
+}
+
+#endif	// NET_BATCHING
+
 //=============================================================================
 
 qboolean	Sys_GetPacket (netadr_t *net_from, msg_t *net_message)
@@ -141,9 +378,25 @@ qboolean	Sys_GetPacket (netadr_t *net_from, msg_t *net_message)
 	int		fromlen;
 	int		net_socket;
 	int		protocol;
+	int		firstProtocol;
 	int		err;
 
-	for (protocol = 0 ; protocol < 2 ; protocol++)
+	firstProtocol = 0;
+
+#ifdef NET_BATCHING
+	if ( ip_socket && ( NET_BatchActive() || net_recvHead < net_recvCount ) ) {
+		if ( NET_GetBatchedPacket( net_from, net_message ) ) {
+			return qtrue;
+		}
+		// the IP socket is drained, only IPX is left to read; otherwise
+		// fall back to recvfrom since net_batch was turned off or recvmmsg is missing
+		if ( NET_BatchActive() ) {
+			firstProtocol = 1;
+		}
+	}
+#endif
+
+	for (protocol = firstProtocol ; protocol < 2 ; protocol++)
 	{
 		if (protocol == 0)
 			net_socket = ip_socket;
@@ -217,6 +470,12 @@ void	Sys_SendPacket( int length, const void *data, netadr_t to )
 	if (!net_socket)
 		return;
 
+#ifdef NET_BATCHING
+	if ( NET_QueuePacket( net_socket, length, data, to ) ) {
+		return;
+	}
+#endif
+
 	NetadrToSockadr (&to, &addr);
 
 	ret = sendto (net_socket, data, length, 0, (struct sockaddr *)&addr, sizeof(addr) );
@@ -484,6 +743,7 @@ NET_Init
 void NET_Init (void)
 {
 	noudp = Cvar_Get ("net_noudp", "0", 0);
+	net_batch = Cvar_Get ("net_batch", "1", CVAR_ARCHIVE);
 	// open sockets
 	if (! noudp->value) {
 		NET_OpenIP ();
@@ -558,6 +818,7 @@ NET_Shutdown
 */
 void	NET_Shutdown (void)
 {
+	NET_FlushPacketBatch();
 	if (ip_socket) {
 		close(ip_socket);
 		ip_socket = 0;
@@ -588,6 +849,11 @@ void NET_Sleep(int msec)
 	if (!ip_socket || !com_dedicated->integer)
 		return; // we're not a server, just run full speed
 
+#ifdef NET_BATCHING
+	if (net_recvHead < net_recvCount)
+		return; // datagrams still waiting in the receive ring
+#endif
+
 	FD_ZERO(&fdset);
 	if (stdin_active)
 		FD_SET(0, &fdset); // stdin is processed too
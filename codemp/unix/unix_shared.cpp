@@ -4,9 +4,13 @@
 #include <stdio.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/time.h>
+#include <time.h>
 #include <pwd.h>
+#include <pthread.h>
+#include <semaphore.h>
 
 #include "../game/q_shared.h"
 #include "../qcommon/qcommon.h"
@@ -61,6 +65,37 @@ int Sys_Milliseconds (bool baseTime)
 
 }
 
+/*
+================
+Sys_Ticks
+
+Monotonic, so a clock adjustment can't turn a duration negative
+================
+*/
+sysTicks_t Sys_Ticks( void )
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (sysTicks_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	struct timeval tp;
+
+	gettimeofday( &tp, NULL );
+	return (sysTicks_t)tp.tv_sec * 1000000 + tp.tv_usec;
+#endif
+}
+
+sysTicks_t Sys_TicksPerSecond( void )
+{
+#ifdef CLOCK_MONOTONIC
+	return 1000000000;
+#else
+	return 1000000;
+#endif
+}
+
 
 //#if 0 // bk001215 - see snapvector.nasm for replacement
 #if (defined __APPLE__) // rcg010206 - using this for PPC builds...
@@ -348,3 +383,139 @@ char *Sys_GetCurrentUser( void )
 	}
 	return p->pw_name;
 }
+
+//============================================
+
+/*
+================
+Sys_ProcessorCount
+================
+*/
+unsigned int Sys_ProcessorCount()
+{
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+
+	if ( count < 1 ) {
+		return 1;
+	}
+	return (unsigned int)count;
+}
+
+/*
+================
+Sys_CreateThread
+
+Worker threads must not call Com_Error, Com_Printf or Z_Malloc
+================
+*/
+typedef struct {
+	threadFunc_t	function;
+	void			*data;
+} threadStart_t;
+
+static void *Sys_ThreadStart( void *arg )
+{
+	threadStart_t	start = *(threadStart_t *)arg;
+
+	free( arg );
+	start.function( start.data );
+	return NULL;
+}
+
+void *Sys_CreateThread( threadFunc_t function, void *data )
+{
+	pthread_t		*thread;
+	threadStart_t	*start;
+
+	thread = (pthread_t *)malloc( sizeof( *thread ) );
+	start = (threadStart_t *)malloc( sizeof( *start ) );
+	start->function = function;
+	start->data = data;
+
+	if ( pthread_create( thread, NULL, Sys_ThreadStart, start ) ) {
+		free( thread );
+		free( start );
+		return NULL;
+	}
+	return thread;
+}
+
+void Sys_JoinThread( void *thread )
+{
+	pthread_join( *(pthread_t *)thread, NULL );
+	free( thread );
+}
+
+void *Sys_CreateSemaphore( int initialCount )
+{
+	sem_t	*sem;
+
+	sem = (sem_t *)malloc( sizeof( *sem ) );
+	if ( sem_init( sem, 0, initialCount ) ) {
+		free( sem );
+		return NULL;
+	}
+	return sem;
+}
+
+void Sys_DestroySemaphore( void *semaphore )
+{
+	sem_destroy( (sem_t *)semaphore );
+	free( semaphore );
+}
+
+void Sys_SemaphoreWait( void *semaphore )
+{
+	while ( sem_wait( (sem_t *)semaphore ) && errno == EINTR ) {
+	}
+}
+
+void Sys_SemaphorePost( void *semaphore )
+{
+	sem_post( (sem_t *)semaphore );
+}
+
+int Sys_AtomicAdd( volatile int *value, int add )
+{
+	return __sync_add_and_fetch( value, add );
+}
+
+int Sys_AtomicCompareExchange( volatile int *value, int exchange, int comparand )
+{
+	return __sync_val_compare_and_swap( value, comparand, exchange );
+}
+
+/*
+================
+Sys_MapFile
+================
+*/
+void *Sys_MapFile( const char *osPath, int *length )
+{
+	struct stat	st;
+	void		*base;
+	int			fd;
+
+	fd = open( osPath, O_RDONLY );
+	if ( fd == -1 ) {
+		return NULL;
+	}
+	if ( fstat( fd, &st ) || st.st_size <= 0 || st.st_size > 0x7fffffff ) {
+		close( fd );
+		return NULL;
+	}
+
+	base = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );	// the mapping keeps its own reference
+	if ( base == MAP_FAILED ) {
+		return NULL;
+	}
+
+	*length = (int)st.st_size;
+	return base;
+}
+
+void Sys_UnmapFile( void *base, int length )
+{
+	munmap( base, length );
+}
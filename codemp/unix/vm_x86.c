@@ -3,6 +3,7 @@
 
 void VM_Compile( vm_t *vm, vmHeader_t *header ) {}
 int	VM_CallCompiled( vm_t *vm, int *args ) {}
+void VM_FreeCompiled( vm_t *vm ) {}
 
 
 
@@ -1212,6 +1212,20 @@ void NET_Sleep( int msec ) {
 }
 
 
+/*
+====================
+NET_BeginPacketBatch / NET_FlushPacketBatch
+
+datagrams are only batched on linux
+====================
+*/
+void NET_BeginPacketBatch( void ) {
+}
+
+void NET_FlushPacketBatch( void ) {
+}
+
+
 /*
 ====================
 NET_Restart_f
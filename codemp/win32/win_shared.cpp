@@ -33,6 +33,29 @@ int Sys_Milliseconds (bool baseTime)
 	return sys_curtime;
 }
 
+/*
+================
+Sys_Ticks
+================
+*/
+sysTicks_t Sys_Ticks( void )
+{
+	LARGE_INTEGER	t;
+
+	QueryPerformanceCounter( &t );
+	return t.QuadPart;
+}
+
+sysTicks_t Sys_TicksPerSecond( void )
+{
+	static LARGE_INTEGER	freq;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+	}
+	return freq.QuadPart;
+}
+
 /*
 ================
 Sys_SnapVector
@@ -545,3 +568,139 @@ int Sys_GetCPUSpeed()
 }
 #endif
 
+
+//============================================
+
+/*
+================
+Sys_ProcessorCount
+================
+*/
+unsigned int Sys_ProcessorCount()
+{
+	SYSTEM_INFO	info;
+
+	GetSystemInfo( &info );
+	if ( info.dwNumberOfProcessors < 1 ) {
+		return 1;
+	}
+	return info.dwNumberOfProcessors;
+}
+
+/*
+================
+Sys_CreateThread
+
+Worker threads must not call Com_Error, Com_Printf or Z_Malloc
+================
+*/
+typedef struct {
+	threadFunc_t	function;
+	void			*data;
+} threadStart_t;
+
+static DWORD WINAPI Sys_ThreadStart( LPVOID arg )
+{
+	threadStart_t	start = *(threadStart_t *)arg;
+
+	free( arg );
+	start.function( start.data );
+	return 0;
+}
+
+void *Sys_CreateThread( threadFunc_t function, void *data )
+{
+	HANDLE			thread;
+	DWORD			threadId;
+	threadStart_t	*start;
+
+	start = (threadStart_t *)malloc( sizeof( *start ) );
+	start->function = function;
+	start->data = data;
+
+	thread = CreateThread( NULL, 0, Sys_ThreadStart, start, 0, &threadId );
+	if ( !thread ) {
+		free( start );
+		return NULL;
+	}
+	return thread;
+}
+
+void Sys_JoinThread( void *thread )
+{
+	WaitForSingleObject( (HANDLE)thread, INFINITE );
+	CloseHandle( (HANDLE)thread );
+}
+
+void *Sys_CreateSemaphore( int initialCount )
+{
+	return CreateSemaphore( NULL, initialCount, 0x7fffffff, NULL );
+}
+
+void Sys_DestroySemaphore( void *semaphore )
+{
+	CloseHandle( (HANDLE)semaphore );
+}
+
+void Sys_SemaphoreWait( void *semaphore )
+{
+	WaitForSingleObject( (HANDLE)semaphore, INFINITE );
+}
+
+void Sys_SemaphorePost( void *semaphore )
+{
+	ReleaseSemaphore( (HANDLE)semaphore, 1, NULL );
+}
+
+int Sys_AtomicAdd( volatile int *value, int add )
+{
+	return InterlockedExchangeAdd( (volatile LONG *)value, add ) + add;
+}
+
+int Sys_AtomicCompareExchange( volatile int *value, int exchange, int comparand )
+{
+	return InterlockedCompareExchange( (volatile LONG *)value, exchange, comparand );
+}
+
+/*
+================
+Sys_MapFile
+================
+*/
+void *Sys_MapFile( const char *osPath, int *length )
+{
+	HANDLE	file, mapping;
+	DWORD	sizeHigh, sizeLow;
+	void	*base;
+
+	file = CreateFile( osPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return NULL;
+	}
+
+	sizeLow = GetFileSize( file, &sizeHigh );
+	if ( sizeLow == INVALID_FILE_SIZE || sizeHigh || !sizeLow || sizeLow > 0x7fffffff ) {
+		CloseHandle( file );
+		return NULL;
+	}
+
+	mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if ( !mapping ) {
+		return NULL;
+	}
+
+	base = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );	// the view keeps its own reference
+	if ( !base ) {
+		return NULL;
+	}
+
+	*length = (int)sizeLow;
+	return base;
+}
+
+void Sys_UnmapFile( void *base, int length )
+{
+	UnmapViewOfFile( base );
+}
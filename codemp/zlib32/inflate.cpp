@@ -15,7 +15,29 @@ int		totalInflateCount;
 // copyright string in the executable of your product.
 const char inflate_copyright[] = "Inflate 1.1.3 Copyright 1995-1998 Mark Adler ";
 
-static const char *inflate_error = "OK";
+// prefetch threads inflate at the same time as the main thread
+static THREADLOCAL const char *inflate_error = "OK";
+
+// streams opened with sysAlloc take their workspace from malloc rather than
+// the zone, so they can be run from a thread other than the main one
+static void *inflate_alloc(z_stream *z, int size, qboolean zero)
+{
+	if(z->istate->sysAlloc)
+	{
+		return(zero ? calloc(size, 1) : malloc(size));
+	}
+	return(Z_Malloc(size, TAG_INFLATE, zero));
+}
+
+static void inflate_free(z_stream *z, void *ptr)
+{
+	if(z->istate->sysAlloc)
+	{
+		free(ptr);
+		return;
+	}
+	Z_Free(ptr);
+}
 
 //	int inflate(z_stream *strm);
 //
@@ -331,11 +353,11 @@ static void inflate_blocks_reset(z_stream *z, inflate_blocks_state_t *s)
 {
 	if((s->mode == BTREE) || (s->mode == DTREE))
 	{
-		Z_Free(s->trees.blens);
+		inflate_free(z, s->trees.blens);
 	}
 	if(s->mode == CODES)
 	{
-		Z_Free(s->decode.codes);
+		inflate_free(z, s->decode.codes);
 	}
 	s->mode = TYPE;
 	s->bitk = 0;
@@ -351,9 +373,9 @@ static void inflate_blocks_reset(z_stream *z, inflate_blocks_state_t *s)
 static int inflate_blocks_free(z_stream *z, inflate_blocks_state_t *s)
 {
 	inflate_blocks_reset(z, s);
-	Z_Free(s->hufts);
+	inflate_free(z, s->hufts);
 	s->hufts = NULL;
-	Z_Free(s);
+	inflate_free(z, s);
 	return(Z_OK);
 }
 
@@ -364,8 +386,8 @@ static inflate_blocks_state_t *inflate_blocks_new(z_stream *z, check_func check)
 {
 	inflate_blocks_state_t *s;
 
-	s = (inflate_blocks_state_t *)Z_Malloc(sizeof(inflate_blocks_state_t), TAG_INFLATE, qtrue);
-	s->hufts = (inflate_huft_t *)Z_Malloc(sizeof(inflate_huft_t) * MANY, TAG_INFLATE, qtrue);
+	s = (inflate_blocks_state_t *)inflate_alloc(z, sizeof(inflate_blocks_state_t), qtrue);
+	s->hufts = (inflate_huft_t *)inflate_alloc(z, sizeof(inflate_huft_t) * MANY, qtrue);
 	s->end = s->window + WINDOW_SIZE;
 	s->mode = TYPE;
 	inflate_blocks_reset(z, s);
@@ -945,7 +967,7 @@ static inflate_codes_state_t *inflate_codes_new(z_stream *z, ulong bl, ulong bd,
 {
 	inflate_codes_state_t		*c;
 
-	c = (inflate_codes_state_t *)Z_Malloc(sizeof(inflate_codes_state_t), TAG_INFLATE, qtrue);
+	c = (inflate_codes_state_t *)inflate_alloc(z, sizeof(inflate_codes_state_t), qtrue);
 	c->mode = START;
 	c->lbits = (byte)bl;
 	c->dbits = (byte)bd;
@@ -1441,7 +1463,7 @@ static void inflate_blocks(inflate_blocks_state_t *s, z_stream *z)
 				return;
 			}
 			t = 258 + (t & 0x1f) + ((t >> 5) & 0x1f);
-			s->trees.blens = (ulong *)Z_Malloc(t * sizeof(ulong), TAG_INFLATE, qfalse);
+			s->trees.blens = (ulong *)inflate_alloc(z, t * sizeof(ulong), qfalse);
 			s->bitb >>= 14;
 			s->bitk -= 14;
 			s->trees.index = 0;
@@ -1465,7 +1487,7 @@ static void inflate_blocks(inflate_blocks_state_t *s, z_stream *z)
 			inflate_trees_bits(z, s->trees.blens, &s->trees.bb, &s->trees.tb, s->hufts);
 			if(z->error != Z_OK)
 			{
-				Z_Free(s->trees.blens);
+				inflate_free(z, s->trees.blens);
 				s->mode = BAD;
 				inflate_flush(z, s);
 				return;
@@ -1509,7 +1531,7 @@ static void inflate_blocks(inflate_blocks_state_t *s, z_stream *z)
 					t = s->trees.table;
 					if(i + j > 258 + (t & 0x1f) + ((t >> 5) & 0x1f) || (c == 16 && i < 1))
 					{
-						Z_Free(s->trees.blens);
+						inflate_free(z, s->trees.blens);
 						s->mode = BAD;
 						inflate_error = "Inflate data: Invalid bit length repeat";
 						z->error = Z_DATA_ERROR;
@@ -1530,7 +1552,7 @@ static void inflate_blocks(inflate_blocks_state_t *s, z_stream *z)
 			bd = 6; 					// must be <= 9 for lookahead assumptions
 			t = s->trees.table;
 			inflate_trees_dynamic(z, 257 + (t & 0x1f), 1 + ((t >> 5) & 0x1f), s->trees.blens, &bl, &bd, &lengthTree, &distTree, s->hufts);
-			Z_Free(s->trees.blens);
+			inflate_free(z, s->trees.blens);
 			if(z->error != Z_OK)
 			{
 				s->mode = BAD;
@@ -1548,7 +1570,7 @@ static void inflate_blocks(inflate_blocks_state_t *s, z_stream *z)
 				return;
 			}
 			z->error = Z_OK;
-			Z_Free(s->decode.codes);
+			inflate_free(z, s->decode.codes);
 			bytesToEnd = s->write < s->read ? s->read - s->write - 1 : s->end - s->write; 
 			if(!s->last)
 			{
@@ -1594,7 +1616,14 @@ EStatus inflateEnd(z_stream *z)
 	}
 	if(z->istate)
 	{
-		Z_Free(z->istate);
+		if(z->istate->sysAlloc)
+		{
+			free(z->istate);
+		}
+		else
+		{
+			Z_Free(z->istate);
+		}
 		z->istate = NULL;
 	}
 	return(Z_OK);
@@ -1603,14 +1632,22 @@ EStatus inflateEnd(z_stream *z)
 // ===============================================================================
 // ===============================================================================
 
-EStatus inflateInit(z_stream *z, EFlush flush, int noWrap)
+EStatus inflateInit(z_stream *z, EFlush flush, int noWrap, int sysAlloc)
 {
 	// initialize state
 	assert(z);
 
 	inflate_error = "OK";
 
-	z->istate = (inflate_state *)Z_Malloc(sizeof(inflate_state), TAG_INFLATE, qtrue);
+	if(sysAlloc)
+	{
+		z->istate = (inflate_state *)calloc(sizeof(inflate_state), 1);
+	}
+	else
+	{
+		z->istate = (inflate_state *)Z_Malloc(sizeof(inflate_state), TAG_INFLATE, qtrue);
+	}
+	z->istate->sysAlloc = sysAlloc;
 	z->istate->blocks = NULL;
 
 	// handle nowrap option (no zlib header or check)
@@ -1783,11 +1820,11 @@ const char *inflateError(void)
 // External calls
 // ===============================================================================
 
-bool InflateFile(byte *src, ulong compressedSize, byte *dst, ulong uncompressedSize, int noWrap)
+bool InflateFile(byte *src, ulong compressedSize, byte *dst, ulong uncompressedSize, int noWrap, int sysAlloc)
 {
 	z_stream	z = { 0 };
 
-	inflateInit(&z, Z_FINISH, noWrap);
+	inflateInit(&z, Z_FINISH, noWrap, sysAlloc);
 
 	z.next_in = src;
 	z.avail_in = compressedSize;
@@ -136,6 +136,7 @@ typedef struct inflate_state_s
 	int						nowrap;			// flag for no wrapper
 	ulong					wbits;			// log2(window size)  (8..15, defaults to 15)
 	inflate_blocks_state_t	*blocks;		// current inflate_blocks state
+	int						sysAlloc;		// workspace comes from malloc, not the zone
 
 	ulong					adler;
 	ulong					calcadler;
@@ -183,13 +183,13 @@ EStatus deflateEnd(z_stream *strm);
 const char *deflateError(void);
 
 // External calls to the deflate code
-EStatus inflateInit(z_stream *strm, EFlush flush, int noWrap = 0);
+EStatus inflateInit(z_stream *strm, EFlush flush, int noWrap = 0, int sysAlloc = 0);
 EStatus inflate(z_stream *z);
 EStatus inflateEnd(z_stream *strm);
 const char *inflateError(void);
 
 // External calls to the zipfile code
-bool InflateFile(byte *src, ulong compressedSize, byte *dst, ulong uncompressedSize, int noWrap = 0);
+bool InflateFile(byte *src, ulong compressedSize, byte *dst, ulong uncompressedSize, int noWrap = 0, int sysAlloc = 0);
 bool DeflateFile(byte *src, ulong uncompressedSize, byte *dst, ulong maxCompressedSize, ulong *compressedSize, ELevel level, int noWrap = 0);
 
 // end